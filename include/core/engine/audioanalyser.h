@@ -0,0 +1,121 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <array>
+#include <complex>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class QThread;
+
+namespace Fooyin {
+class AudioTap;
+
+/*!
+ * Levels and spectrum of the audio audible at the time it was analysed.
+ * Levels are linear, from 0 to 1 at full scale. The spectrum is of all channels mixed, in dBFS, split into bands
+ * spaced logarithmically from MinFrequency to MaxFrequency (or the Nyquist frequency, if lower).
+ */
+struct AudioAnalysis
+{
+    static constexpr int MaxChannels    = 20;
+    static constexpr int SpectrumBands  = 64;
+    static constexpr float MinFrequency = 20.0F;
+    static constexpr float MaxFrequency = 20000.0F;
+    static constexpr float MinDb        = -120.0F;
+
+    int channels{0};
+    int sampleRate{0};
+    // Track position of the end of the analysed audio, in ms
+    uint64_t position{0};
+
+    std::array<float, MaxChannels> peak{};
+    std::array<float, MaxChannels> rms{};
+    std::array<float, SpectrumBands> spectrum{};
+
+    [[nodiscard]] bool isValid() const
+    {
+        return channels > 0;
+    }
+};
+
+/*!
+ * Analyses what's audible from an AudioTap on a dedicated thread, so visualisations only need to draw the results.
+ * The thread only runs while the analyser has users; each should call @fn acquire when it starts drawing, and
+ * @fn release once it stops.
+ */
+class FYCORE_EXPORT AudioAnalyser
+{
+public:
+    /** How often the audible audio is analysed, in ms. */
+    static constexpr int Interval = 16;
+    /** Audio used for levels, in ms. */
+    static constexpr int LevelWindow = 50;
+    /** Frames used for the spectrum. */
+    static constexpr int FftSize = 2048;
+
+    explicit AudioAnalyser(std::shared_ptr<AudioTap> tap);
+    ~AudioAnalyser();
+
+    AudioAnalyser(const AudioAnalyser&)            = delete;
+    AudioAnalyser& operator=(const AudioAnalyser&) = delete;
+
+    void acquire();
+    void release();
+
+    /** Returns the most recent results, or invalid results if nothing is audible. */
+    [[nodiscard]] AudioAnalysis latest() const;
+
+    /*!
+     * Analyses the end of @p buffer: levels from its last LevelWindow ms, and the spectrum from its last FftSize
+     * frames. Only for use while the analyser has no users.
+     */
+    [[nodiscard]] AudioAnalysis analyse(const AudioBuffer& buffer);
+
+private:
+    void run();
+    void analyseLevels(const float* samples, int frames, int stride, AudioAnalysis& analysis);
+    void analyseSpectrum(const float* samples, int frames, int stride, AudioAnalysis& analysis);
+
+    std::shared_ptr<AudioTap> m_tap;
+    QThread* m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    int m_users;
+    bool m_quit;
+    AudioAnalysis m_latest;
+
+    // Only used by the analysing thread
+    AudioBuffer m_tapBuffer;
+    std::vector<float> m_samples;
+    std::vector<float> m_channel;
+    std::vector<float> m_window;
+    std::vector<std::complex<float>> m_fft;
+    std::vector<std::complex<float>> m_twiddles;
+};
+} // namespace Fooyin
@@ -76,4 +76,12 @@ private:
     QExplicitlySharedDataPointer<AudioBufferPrivate> p;
 };
 using AudioData = std::vector<AudioBuffer>;
+
+namespace Audio {
+/*!
+ * Scales the interleaved samples of @p format in @p data by @p volume in place.
+ * For outputs which render straight into driver memory, where there's no AudioBuffer to scale.
+ */
+FYCORE_EXPORT void scale(std::span<std::byte> data, SampleFormat format, double volume);
+} // namespace Audio
 } // namespace Fooyin
@@ -28,6 +28,7 @@
 Q_DECLARE_LOGGING_CATEGORY(ENGINE)
 
 namespace Fooyin {
+class AudioTap;
 class Track;
 
 class FYCORE_EXPORT AudioEngine : public QObject
@@ -84,6 +85,9 @@ public:
     virtual void setAudioOutput(const OutputCreator& output, const QString& device) = 0;
     virtual void setOutputDevice(const QString& device)                             = 0;
 
+    /** Returns the tap holding the audio most recently sent to the output. */
+    [[nodiscard]] virtual std::shared_ptr<AudioTap> audioTap() const = 0;
+
 signals:
     void deviceError(const QString& error);
 
@@ -93,7 +97,6 @@ signals:
     void positionChanged(const Fooyin::Track& track, uint64_t ms);
     void bitrateChanged(int bitrate);
 
-    void bufferPlayed(const Fooyin::AudioBuffer& buffer);
     void trackChanged(const Fooyin::Track& track);
     void trackAboutToFinish();
     void finished();
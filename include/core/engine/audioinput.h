@@ -57,6 +57,9 @@ public:
         // Support updating tracks on init.
         // Useful if properties like loop count can change duration.
         UpdateTracks = 1 << 3,
+        // Decoding isn't for playback (e.g. scanning or converting), so may use multiple threads where supported.
+        // Audio is returned with more latency and less predictable timing, so this shouldn't be used for playback.
+        ParallelDecoding = 1 << 4,
     };
     Q_DECLARE_FLAGS(DecoderOptions, DecoderFlag)
     Q_FLAG(DecoderOptions)
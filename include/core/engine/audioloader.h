@@ -22,6 +22,7 @@
 #include "fycore_export.h"
 
 #include <core/engine/audioinput.h>
+#include <core/engine/dspnode.h>
 #include <core/engine/inputplugin.h>
 
 namespace Fooyin {
@@ -41,6 +42,16 @@ public:
         T creator;
     };
 
+    /** Returns a pooled decoder to the AudioLoader it was acquired from. */
+    struct DecoderReleaser
+    {
+        AudioLoader* loader{nullptr};
+        QString name;
+
+        void operator()(AudioDecoder* decoder) const;
+    };
+    using PooledDecoder = std::unique_ptr<AudioDecoder, DecoderReleaser>;
+
     AudioLoader();
     ~AudioLoader();
 
@@ -59,6 +70,17 @@ public:
     [[nodiscard]] AudioReader* readerForTrack(const Track& track) const;
     [[nodiscard]] ArchiveReader* archiveReaderForFile(const QString& file) const;
 
+    /*!
+     * Checks out a decoder for @p file from a pool shared between threads, creating one if none are free.
+     * Unlike decoderForFile, the decoder isn't tied to the calling thread, so batch jobs running across a thread
+     * pool can reuse decoders from track to track. It's stopped and returned to the pool once the handle is
+     * destroyed, so must be released before the AudioLoader is destroyed.
+     */
+    [[nodiscard]] PooledDecoder acquireDecoder(const QString& file);
+    [[nodiscard]] PooledDecoder acquireDecoder(const Track& track);
+    /** Destroys all decoders not currently checked out. */
+    void clearDecoderPool();
+
     [[nodiscard]] bool readTrackMetadata(Track& track) const;
     [[nodiscard]] QByteArray readTrackCover(const Track& track, Track::Cover cover) const;
     [[nodiscard]] bool writeTrackMetadata(const Track& track, AudioReader::WriteOptions options) const;
@@ -67,10 +89,15 @@ public:
     void addDecoder(const QString& name, const DecoderCreator& creator, int priority = -1);
     void addReader(const QString& name, const ReaderCreator& creator, int priority = -1);
     void addArchiveReader(const QString& name, const ArchiveReaderCreator& creator, int priority = -1);
+    void addDsp(const QString& name, const DspCreator& creator);
 
     [[nodiscard]] std::vector<LoaderEntry<DecoderCreator>> decoders() const;
     [[nodiscard]] std::vector<LoaderEntry<ReaderCreator>> readers() const;
     [[nodiscard]] std::vector<LoaderEntry<ArchiveReaderCreator>> archiveReaders() const;
+    [[nodiscard]] std::vector<LoaderEntry<DspCreator>> dsps() const;
+
+    /** Creates a new instance of the DSP registered as @p name, or returns @c nullptr if there is none. */
+    [[nodiscard]] std::unique_ptr<DspNode> createDsp(const QString& name) const;
 
     void setDecoderEnabled(const QString& name, bool enabled);
     void changeDecoderIndex(const QString& name, int index);
@@ -27,14 +27,31 @@
 #include <QObject>
 #include <QString>
 
+#include <functional>
+
 namespace Fooyin {
 struct OutputState
 {
     int freeSamples{0};
     int queuedSamples{0};
-    double delay{0.0};
+    /*!
+     * Time until audio written next would be heard, in seconds, as reported by the driver or sound server.
+     * This includes any buffering beyond the output's own, so may be more than @c queuedSamples.
+     * Negative if unknown, in which case @c queuedSamples is used as an estimate.
+     */
+    double delay{-1.0};
+    // Buffer underruns since the output was initialised
+    int xruns{0};
 };
 
+/*!
+ * Used by outputs in pull mode to request audio from the renderer.
+ * Writes up to the size of @p data of interleaved audio in the output format.
+ * @p delay is the time until the start of @p data will be heard, in seconds, or negative if unknown.
+ * @returns the number of frames written, with any remainder left for the output to fill with silence.
+ */
+using AudioRenderCallback = std::function<int(std::span<std::byte> data, double delay)>;
+
 struct OutputDevice
 {
     QString name;
@@ -112,6 +129,34 @@ public:
      */
     virtual int write(const AudioBuffer& buffer) = 0;
 
+    /*!
+     * Sets the @p callback used to pull audio from the renderer.
+     * Outputs driven by their own (real-time) callback should reimplement this to request
+     * audio on demand, in which case @fn write and @fn currentState won't be used for playback.
+     * @note this will only be called before @fn init.
+     * @note the callback may be called from any thread, but must not be called after @fn uninit.
+     * @returns @c true if pulling audio is supported.
+     * @note the base class implementation of this function returns @c false.
+     */
+    virtual bool setRenderCallback(const AudioRenderCallback& /*callback*/)
+    {
+        return false;
+    }
+
+    /*!
+     * Requests that the device is opened at exactly the format passed to @fn init, without any conversion,
+     * resampling or mixing by the driver or sound server.
+     * If the format can't be used as is, @fn init should fail with a reason in @fn error, rather than fall back
+     * to a compatible format.
+     * @note this will only be called before @fn init.
+     * @returns @c true if bit-perfect output is supported.
+     * @note the base class implementation of this function returns @c false.
+     */
+    virtual bool setBitPerfect(bool /*enabled*/)
+    {
+        return false;
+    }
+
     virtual void setPaused(bool pause) = 0;
 
     /*!
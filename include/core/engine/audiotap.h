@@ -0,0 +1,92 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audiobuffer.h>
+#include <core/engine/audioformat.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Fooyin {
+/*!
+ * Keeps the audio most recently sent to the output, for visualisations.
+ * Each write is stamped with the time it's expected to be heard, on the same clock as the engine's AudioClock, so
+ * readers can fetch whatever is audible at the moment they draw, at their own rate.
+ *
+ * There's a single writer (the renderer), and any number of readers. Neither side takes a lock: readers copy
+ * straight out of the ring and retry if the writer caught up with them part way through.
+ */
+class FYCORE_EXPORT AudioTap
+{
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /** Audio kept for readers by default, in ms. */
+    static constexpr int DefaultLength = 2000;
+
+    explicit AudioTap(int length = DefaultLength);
+    ~AudioTap();
+
+    AudioTap(const AudioTap&)            = delete;
+    AudioTap& operator=(const AudioTap&) = delete;
+
+    /*!
+     * Sets the format of following writes.
+     * Readers carry on with the previous format until the first write in the new one.
+     */
+    void setFormat(const AudioFormat& format);
+    /*!
+     * Appends @p data, which starts at @p position (ms) in the track, and is expected to be heard from @p playTime.
+     * @note only one thread may write at a time.
+     */
+    void write(std::span<const std::byte> data, uint64_t position, TimePoint playTime);
+    /** Discards everything written so far, e.g. when stopping or seeking. */
+    void clear();
+
+    /** Returns the format of the audio currently available to readers. */
+    [[nodiscard]] AudioFormat format() const;
+
+    /*!
+     * Fills @p buffer with the @p frames frames leading up to what's audible at @p now.
+     * @p buffer is reused where its format matches, so a reader can read repeatedly without allocating.
+     * The buffer's start time is the track position of its first frame.
+     * @returns false if there's no audio for that time.
+     */
+    bool readAudible(int frames, AudioBuffer& buffer, TimePoint now = Clock::now()) const;
+
+private:
+    struct Ring;
+
+    Ring* ringForFormat(const AudioFormat& format);
+
+    int m_length;
+    // Rings are never freed while the tap exists, as a reader may still be using one after a format change
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    Ring* m_writeRing;
+    std::atomic<Ring*> m_readRing;
+};
+} // namespace Fooyin
@@ -0,0 +1,118 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/track.h>
+
+#include <QObject>
+
+#include <memory>
+
+namespace Fooyin {
+class AudioLoader;
+class BatchConverterPrivate;
+
+struct ConversionOptions
+{
+    enum class Format : uint8_t
+    {
+        Flac = 0,
+        Opus,
+        Mp3,
+    };
+
+    Format format{Format::Flac};
+    // Directory converted files are written to, keeping the layout of the directories tracks come from
+    QString outputDir;
+    // 0 to keep each track's sample rate (where the encoder supports it)
+    int sampleRate{0};
+    // In kbps for lossy formats, 0 for the encoder's default
+    int bitrate{0};
+    // Codec specific, -1 for the encoder's default
+    int compressionLevel{-1};
+    // Files converted at once, 0 to use one per core
+    int jobs{0};
+    bool overwrite{false};
+};
+
+/** Progress of a single worker, through the track it's currently converting. */
+struct ConversionProgress
+{
+    int worker{0};
+    QString filepath;
+    // Fraction of the track converted
+    double progress{0.0};
+    // Audio converted per second of work, for this worker's tracks so far
+    double speed{0.0};
+    int tracksConverted{0};
+};
+
+struct ConversionResult
+{
+    Track track;
+    QString outputFile;
+    bool success{false};
+    QString error;
+};
+
+/*!
+ * Converts tracks to FLAC, Opus or MP3 files, carrying over their metadata.
+ * Tracks are decoded with decoders pooled by the AudioLoader, resampled or converted to the format the encoder takes,
+ * and encoded as they're decoded. Several tracks are converted at once, with idle workers taking the next track
+ * left, so a long track doesn't hold up the rest.
+ * Entirely separate from playback, so can be used without the rest of the application.
+ */
+class FYCORE_EXPORT BatchConverter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatchConverter(std::shared_ptr<AudioLoader> audioLoader, QObject* parent = nullptr);
+    ~BatchConverter() override;
+
+    /*!
+     * Returns an AudioLoader with only the built-in decoders and tag readers, in the order the user has set.
+     * Used to convert without starting the application.
+     */
+    static std::shared_ptr<AudioLoader> standaloneLoader();
+    /** Returns the file extension used for @p format. */
+    static QString extension(ConversionOptions::Format format);
+
+    [[nodiscard]] bool isRunning() const;
+
+    /*!
+     * Starts converting @p tracks in the background.
+     * Does nothing if a conversion is already running.
+     */
+    void convert(const TrackList& tracks, const ConversionOptions& options);
+    /** Stops converting, removing any partly written files, and waits for the workers to finish. */
+    void cancel();
+
+signals:
+    void progressChanged(const Fooyin::ConversionProgress& progress);
+    void trackConverted(const Fooyin::ConversionResult& result);
+    void finished(int succeeded, int failed);
+
+private:
+    std::unique_ptr<BatchConverterPrivate> p;
+};
+} // namespace Fooyin
@@ -0,0 +1,87 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <QByteArray>
+#include <QString>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Fooyin {
+/*!
+ * A single stage of audio processing, run by the renderer on decoded audio before resampling.
+ * All nodes in a chain process audio in a common sample format, chosen from the formats each node supports.
+ */
+class FYCORE_EXPORT DspNode
+{
+public:
+    virtual ~DspNode() = default;
+
+    [[nodiscard]] virtual QString name() const = 0;
+
+    /*!
+     * Returns the sample formats this node can process, in order of preference.
+     * @note the base class implementation of this function returns F32.
+     */
+    [[nodiscard]] virtual std::vector<SampleFormat> supportedFormats() const;
+    /*!
+     * Returns the delay in frames this node adds to audio passing through it.
+     * @note the base class implementation of this function returns 0.
+     */
+    [[nodiscard]] virtual int latency() const;
+
+    /*!
+     * Setup the node to process audio in @p format.
+     * Called before any call to @fn process and whenever the format changes, so any buffers should be
+     * allocated here.
+     */
+    virtual void prepare(const AudioFormat& format) = 0;
+    /*!
+     * Process @p buffer in place. The buffer will be in the format passed to @fn prepare.
+     * @note this is called on the audio thread, so must not block or allocate.
+     */
+    virtual void process(AudioBuffer& buffer) = 0;
+    /*!
+     * Clear any internal state such as filter history, for example after a seek.
+     * @note the base class implementation of this function does nothing.
+     */
+    virtual void reset();
+
+    /*!
+     * Returns the settings of this node, to be restored using @fn loadSettings.
+     * @note the base class implementation of this function returns an empty array.
+     */
+    [[nodiscard]] virtual QByteArray saveSettings() const;
+    /*!
+     * Restore settings previously returned from @fn saveSettings.
+     * @note this is only called before the node is added to a chain.
+     * @note the base class implementation of this function returns @c true.
+     */
+    virtual bool loadSettings(const QByteArray& settings);
+};
+using DspNodeList = std::vector<std::unique_ptr<DspNode>>;
+using DspCreator  = std::function<std::unique_ptr<DspNode>()>;
+} // namespace Fooyin
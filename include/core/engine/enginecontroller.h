@@ -27,6 +27,8 @@
 #include <QObject>
 
 namespace Fooyin {
+class AudioAnalyser;
+class AudioTap;
 struct AudioOutputBuilder;
 
 using OutputNames = std::vector<QString>;
@@ -54,6 +56,17 @@ public:
      */
     virtual void addOutput(const QString& name, OutputCreator output) = 0;
 
+    /*!
+     * Returns the audio most recently sent to the output, for visualisations.
+     * Readers should pull from it at their own rate, e.g. on each frame drawn.
+     */
+    [[nodiscard]] virtual std::shared_ptr<AudioTap> audioTap() const = 0;
+    /*!
+     * Returns levels and a spectrum of what's audible, worked out away from the GUI thread.
+     * @see AudioAnalyser::acquire
+     */
+    [[nodiscard]] virtual AudioAnalyser* audioAnalyser() const = 0;
+
 signals:
     void outputChanged(const QString& output, const QString& device);
     void deviceChanged(const QString& device);
@@ -62,8 +75,6 @@ signals:
     void engineStateChanged(AudioEngine::PlaybackState state);
     void trackStatusChanged(AudioEngine::TrackStatus status);
 
-    void bufferPlayed(const Fooyin::AudioBuffer& buffer);
-
     void trackChanged(const Fooyin::Track& track);
     void trackAboutToFinish();
     void finished();
@@ -0,0 +1,75 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <QFile>
+#include <QIODevice>
+
+namespace Fooyin {
+/*!
+ * A read-only device over a memory-mapped local file.
+ * The kernel is told the file will be read sequentially, and the region just ahead of the current position is
+ * prefetched as it's read, so decoding avoids a syscall per read.
+ *
+ * The file can still be truncated or rewritten in place while it's open, by our own tag writer or another program.
+ * Reads past the new end of the file would then fault, so copies out of the mapping are guarded, and once one
+ * faults the device drops the mapping and carries on reading the file normally.
+ */
+class FYCORE_EXPORT MappedFile : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit MappedFile(const QString& filepath, QObject* parent = nullptr);
+    ~MappedFile() override;
+
+    /*!
+     * Returns @c true if @p filepath is on a local filesystem which can be mapped safely.
+     * Files on network shares may be truncated by another host, which would crash a reader of the mapping.
+     */
+    [[nodiscard]] static bool canMap(const QString& filepath);
+
+    /** Maps the file. Only QIODevice::ReadOnly is supported. */
+    bool open(OpenMode mode) override;
+    void close() override;
+
+    [[nodiscard]] bool isSequential() const override;
+    [[nodiscard]] qint64 size() const override;
+    bool seek(qint64 pos) override;
+
+    /** Returns @c true while reads are served from the mapping rather than the file itself. */
+    [[nodiscard]] bool isMapped() const;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    void prefetch(qint64 pos);
+    void unmap();
+
+    QFile m_file;
+    const std::byte* m_data;
+    qint64 m_size;
+    qint64 m_prefetchedTo;
+};
+} // namespace Fooyin
@@ -90,6 +90,7 @@ public:
 
     [[nodiscard]] int id() const;
     [[nodiscard]] QString hash() const;
+    [[nodiscard]] QString fingerprint() const;
     [[nodiscard]] QString albumHash() const;
     [[nodiscard]] QString filepath() const;
     [[nodiscard]] QString uniqueFilepath() const;
@@ -185,6 +186,7 @@ public:
     void setIsEnabled(bool enabled);
     void setId(int id);
     void setHash(const QString& hash);
+    void setFingerprint(const QString& fingerprint);
     void setFilePath(const QString& path);
     void setTitle(const QString& title);
     void setArtists(const QStringList& artists);
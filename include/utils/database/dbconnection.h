@@ -22,6 +22,9 @@
 #include "fyutils_export.h"
 
 #include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include <unordered_map>
 
 namespace Fooyin {
 class FYUTILS_EXPORT DbConnection
@@ -51,7 +54,16 @@ public:
 
     [[nodiscard]] QSqlDatabase db() const;
 
+    /*!
+     * Returns the query previously prepared for @p statement on this connection, or nullptr.
+     * Cached queries are owned by the connection and released when it's closed.
+     */
+    [[nodiscard]] QSqlQuery* cachedQuery(const QString& statement);
+    QSqlQuery* cacheQuery(const QString& statement, QSqlQuery query);
+    void clearCachedQueries();
+
 private:
     QString m_name;
+    std::unordered_map<QString, QSqlQuery> m_cachedQueries;
 };
 } // namespace Fooyin
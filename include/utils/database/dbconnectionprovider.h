@@ -31,6 +31,7 @@ public:
     explicit DbConnectionProvider(DbConnectionPoolPtr pool);
 
     [[nodiscard]] QSqlDatabase db() const;
+    [[nodiscard]] DbConnection* connection() const;
 
 private:
     DbConnectionPoolPtr m_connectionPool;
@@ -0,0 +1,56 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fyutils_export.h"
+
+#include <QSqlDatabase>
+
+namespace Fooyin {
+/*!
+ * Tunes an SQLite connection for bulk writes (WAL journal, relaxed syncing, larger page cache and
+ * in-memory temporary storage) for the lifetime of the object, then restores the previous settings.
+ * Must not be created while a transaction is open on the connection.
+ */
+class FYUTILS_EXPORT DbFastImport
+{
+public:
+    explicit DbFastImport(const QSqlDatabase& database);
+    ~DbFastImport();
+
+    DbFastImport(const DbFastImport& other)            = delete;
+    DbFastImport& operator=(const DbFastImport& other) = delete;
+    DbFastImport(DbFastImport&& other)                 = delete;
+    DbFastImport& operator=(DbFastImport&& other)      = delete;
+
+    explicit operator bool() const;
+
+    void restore();
+
+private:
+    QSqlDatabase m_database;
+    bool m_isActive;
+
+    QString m_journalMode;
+    QString m_synchronous;
+    QString m_tempStore;
+    QString m_cacheSize;
+};
+} // namespace Fooyin
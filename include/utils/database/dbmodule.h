@@ -37,6 +37,11 @@ public:
         return m_dbProvider.db();
     }
 
+    [[nodiscard]] DbConnection* connection() const
+    {
+        return m_dbProvider.connection();
+    }
+
 private:
     DbConnectionProvider m_dbProvider;
 };
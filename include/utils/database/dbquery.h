@@ -24,6 +24,8 @@
 #include <QSqlQuery>
 
 namespace Fooyin {
+class DbConnection;
+
 class FYUTILS_EXPORT DbQuery
 {
 public:
@@ -38,10 +40,16 @@ public:
 
     DbQuery();
     DbQuery(const QSqlDatabase& database, const QString& statement);
+    /*!
+     * Uses the query cached by @p connection for @p statement, preparing and caching it on first use.
+     * @note only one instance of a cached statement should be in use at a time.
+     */
+    DbQuery(DbConnection* connection, const QString& statement);
+    ~DbQuery();
 
-    DbQuery(const DbQuery& other)       = delete;
-    DbQuery(DbQuery&& other)            = default;
-    DbQuery& operator=(DbQuery&& other) = default;
+    DbQuery(const DbQuery& other) = delete;
+    DbQuery(DbQuery&& other) noexcept;
+    DbQuery& operator=(DbQuery&& other) noexcept;
 
     [[nodiscard]] Status status() const;
     [[nodiscard]] QSqlError lastError() const;
@@ -56,7 +64,13 @@ public:
     [[nodiscard]] QVariant value(int index) const;
 
 private:
+    void handlePrepareError(const QString& statement);
+
+    [[nodiscard]] QSqlQuery& query();
+    [[nodiscard]] const QSqlQuery& query() const;
+
     QSqlQuery m_query;
+    QSqlQuery* m_cachedQuery;
     Status m_status;
 };
 } // namespace Fooyin
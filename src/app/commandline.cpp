@@ -35,16 +35,20 @@ CommandLine::CommandLine(int argc, char** argv)
     , m_argv{argv}
     , m_skipSingle{false}
     , m_playerAction{PlayerAction::None}
+    , m_bitrate{0}
+    , m_jobs{0}
 { }
 
 bool CommandLine::parse()
 {
     static constexpr option cmdOptions[]
-        = {{"help", no_argument, nullptr, 'h'},        {"version", no_argument, nullptr, 'v'},
-           {"skip-single", no_argument, nullptr, 'x'}, {"play-pause", no_argument, nullptr, 't'},
-           {"play", no_argument, nullptr, 'p'},        {"pause", no_argument, nullptr, 'u'},
-           {"stop", no_argument, nullptr, 's'},        {"next", no_argument, nullptr, 'f'},
-           {"previous", no_argument, nullptr, 'r'},    {nullptr, 0, nullptr, 0}};
+        = {{"help", no_argument, nullptr, 'h'},         {"version", no_argument, nullptr, 'v'},
+           {"skip-single", no_argument, nullptr, 'x'},  {"play-pause", no_argument, nullptr, 't'},
+           {"play", no_argument, nullptr, 'p'},         {"pause", no_argument, nullptr, 'u'},
+           {"stop", no_argument, nullptr, 's'},         {"next", no_argument, nullptr, 'f'},
+           {"previous", no_argument, nullptr, 'r'},     {"convert", required_argument, nullptr, 'c'},
+           {"output", required_argument, nullptr, 'o'}, {"bitrate", required_argument, nullptr, 'b'},
+           {"jobs", required_argument, nullptr, 'j'},   {nullptr, 0, nullptr, 0}};
 
     static const auto help = u"%1: fooyin [%2] [%3]\n"
                              "\n"
@@ -61,10 +65,16 @@ bool CommandLine::parse()
                              "  -r, --previous    %13\n"
                              "\n"
                              "%14:\n"
-                             "  urls            %15\n"_s;
+                             "  urls            %15\n"
+                             "\n"
+                             "%16:\n"
+                             "  -c, --convert=FORMAT  %17\n"
+                             "  -o, --output=DIR      %18\n"
+                             "  -b, --bitrate=KBPS    %19\n"
+                             "  -j, --jobs=COUNT      %20\n"_s;
 
     for(;;) {
-        const int c = getopt_long(m_argc, m_argv, "hvxtpusfr", cmdOptions, nullptr);
+        const int c = getopt_long(m_argc, m_argv, "hvxtpusfrc:o:b:j:", cmdOptions, nullptr);
         if(c == -1) {
             break;
         }
@@ -76,7 +86,11 @@ bool CommandLine::parse()
                     QObject::tr("Display help on command line options"), QObject::tr("Display version information"),
                     QObject::tr("Player options"), QObject::tr("Toggle playback"), QObject::tr("Start playback"),
                     QObject::tr("Pause playback"), QObject::tr("Stop playback"), QObject::tr("Skip to next track"),
-                    QObject::tr("Skip to previous track"), QObject::tr("Arguments"), QObject::tr("Files to open"));
+                    QObject::tr("Skip to previous track"), QObject::tr("Arguments"), QObject::tr("Files to open"),
+                    QObject::tr("Conversion options"),
+                    QObject::tr("Convert files to FORMAT (flac, opus or mp3) without starting the GUI"),
+                    QObject::tr("Directory to write converted files to"),
+                    QObject::tr("Bitrate of lossy formats"), QObject::tr("Files to convert at once"));
                 std::cout << helpText.toLocal8Bit().constData() << '\n';
                 return false;
             }
@@ -106,6 +120,23 @@ bool CommandLine::parse()
             case('r'):
                 m_playerAction = PlayerAction::Previous;
                 break;
+            case('c'):
+                m_convertFormat = QString::fromLocal8Bit(optarg).toLower();
+                if(m_convertFormat != "flac"_L1 && m_convertFormat != "opus"_L1 && m_convertFormat != "mp3"_L1) {
+                    std::cerr << QObject::tr("Unsupported format").toLocal8Bit().constData() << ": "
+                              << m_convertFormat.toLocal8Bit().constData() << '\n';
+                    return false;
+                }
+                break;
+            case('o'):
+                m_outputDir = QFile::decodeName(optarg);
+                break;
+            case('b'):
+                m_bitrate = QString::fromLocal8Bit(optarg).toInt();
+                break;
+            case('j'):
+                m_jobs = QString::fromLocal8Bit(optarg).toInt();
+                break;
             default:
                 return false;
         }
@@ -141,6 +172,31 @@ CommandLine::PlayerAction CommandLine::playerAction() const
     return m_playerAction;
 }
 
+bool CommandLine::isConverting() const
+{
+    return !m_convertFormat.isEmpty();
+}
+
+QString CommandLine::convertFormat() const
+{
+    return m_convertFormat;
+}
+
+QString CommandLine::outputDir() const
+{
+    return m_outputDir;
+}
+
+int CommandLine::bitrate() const
+{
+    return m_bitrate;
+}
+
+int CommandLine::jobs() const
+{
+    return m_jobs;
+}
+
 QByteArray CommandLine::saveOptions() const
 {
     QByteArray out;
@@ -45,6 +45,12 @@ public:
     [[nodiscard]] bool skipSingleApp() const;
     [[nodiscard]] PlayerAction playerAction() const;
 
+    [[nodiscard]] bool isConverting() const;
+    [[nodiscard]] QString convertFormat() const;
+    [[nodiscard]] QString outputDir() const;
+    [[nodiscard]] int bitrate() const;
+    [[nodiscard]] int jobs() const;
+
     [[nodiscard]] QByteArray saveOptions() const;
     void loadOptions(const QByteArray& options);
 
@@ -54,4 +60,9 @@ private:
     QList<QUrl> m_files;
     bool m_skipSingle;
     PlayerAction m_playerAction;
+
+    QString m_convertFormat;
+    QString m_outputDir;
+    int m_bitrate;
+    int m_jobs;
 };
@@ -22,6 +22,8 @@
 #include "commandline.h"
 
 #include <core/application.h>
+#include <core/engine/audioloader.h>
+#include <core/engine/batchconverter.h>
 #include <core/playlist/playlisthandler.h>
 #include <core/player/playercontroller.h>
 #include <gui/guiapplication.h>
@@ -29,8 +31,12 @@
 #include <kdsingleapplication.h>
 
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 #include <QLoggingCategory>
 
+#include <iostream>
+
 using namespace Qt::StringLiterals;
 
 namespace {
@@ -68,6 +74,63 @@ void parseCmdOptions(Fooyin::Application& app, Fooyin::GuiApplication& guiApp, C
         guiApp.openFiles(files);
     }
 }
+
+// Converts the files passed without starting the GUI, or the rest of the application
+int convertFiles(const CommandLine& cmdLine)
+{
+    using Format = Fooyin::ConversionOptions::Format;
+
+    const auto audioLoader = Fooyin::BatchConverter::standaloneLoader();
+
+    Fooyin::TrackList tracks;
+    for(const QUrl& url : cmdLine.files()) {
+        Fooyin::Track track{url.toLocalFile()};
+        if(audioLoader->readTrackMetadata(track)) {
+            tracks.push_back(track);
+        }
+        else {
+            std::cerr << "Skipping " << url.toLocalFile().toLocal8Bit().constData() << '\n';
+        }
+    }
+
+    Fooyin::ConversionOptions options;
+    options.format    = cmdLine.convertFormat() == "opus"_L1 ? Format::Opus
+                      : cmdLine.convertFormat() == "mp3"_L1  ? Format::Mp3
+                                                             : Format::Flac;
+    options.outputDir = cmdLine.outputDir().isEmpty() ? QDir::currentPath() : cmdLine.outputDir();
+    options.bitrate   = cmdLine.bitrate();
+    options.jobs      = cmdLine.jobs();
+
+    Fooyin::BatchConverter converter{audioLoader};
+
+    QObject::connect(&converter, &Fooyin::BatchConverter::progressChanged, &converter,
+                     [](const Fooyin::ConversionProgress& progress) {
+                         std::cout << "[" << progress.worker << "] "
+                                   << QFileInfo{progress.filepath}.fileName().toLocal8Bit().constData() << " "
+                                   << static_cast<int>(progress.progress * 100) << "% (" << progress.speed
+                                   << "x)\n";
+                     });
+    QObject::connect(&converter, &Fooyin::BatchConverter::trackConverted, &converter,
+                     [](const Fooyin::ConversionResult& result) {
+                         if(result.success) {
+                             std::cout << result.outputFile.toLocal8Bit().constData() << '\n';
+                         }
+                         else {
+                             std::cerr << result.track.filepath().toLocal8Bit().constData() << ": "
+                                       << result.error.toLocal8Bit().constData() << '\n';
+                         }
+                     });
+    QObject::connect(&converter, &Fooyin::BatchConverter::finished, &converter, [](int succeeded, int failed) {
+        std::cout << "Converted " << succeeded << " of " << (succeeded + failed) << " tracks\n";
+        QCoreApplication::exit(failed > 0 ? 1 : 0);
+    });
+
+    // Once the event loop is running, so finishing early still quits
+    QMetaObject::invokeMethod(
+        &converter, [&converter, &tracks, &options]() { converter.convert(tracks, options); }, Qt::QueuedConnection);
+
+    return QCoreApplication::exec();
+}
 } // namespace
 
 int main(int argc, char** argv)
@@ -101,11 +164,16 @@ int main(int argc, char** argv)
 
     {
         const QCoreApplication app{argc, argv};
-        KDSingleApplication instance{QCoreApplication::applicationName(),
-                                     KDSingleApplication::Option::IncludeUsernameInSocketName};
         if(!commandLine.parse()) {
             return 1;
         }
+        if(commandLine.isConverting()) {
+            // Checked before the single instance is set up, so conversions never become (or message) the primary
+            return convertFiles(commandLine);
+        }
+
+        KDSingleApplication instance{QCoreApplication::applicationName(),
+                                     KDSingleApplication::Option::IncludeUsernameInSocketName};
         if(!checkInstance(instance)) {
             return 0;
         }
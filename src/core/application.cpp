@@ -22,10 +22,10 @@
 #include "corepaths.h"
 #include "database/database.h"
 #include "database/settingsdatabase.h"
-#include "engine/archiveinput.h"
+#include "engine/builtininputs.h"
+#include "engine/dsp/equaliser.h"
+#include "engine/dsp/limiter.h"
 #include "engine/enginehandler.h"
-#include "engine/ffmpeg/ffmpeginput.h"
-#include "engine/taglibparser.h"
 #include "internalcoresettings.h"
 #include "library/librarymanager.h"
 #include "library/sortingregistry.h"
@@ -39,6 +39,7 @@
 
 #include <core/coresettings.h>
 #include <core/engine/audioloader.h>
+#include <core/engine/dspplugin.h>
 #include <core/engine/outputplugin.h>
 #include <core/network/networkaccessmanager.h>
 #include <core/player/playercontroller.h>
@@ -91,6 +92,7 @@ public:
     void initialise();
     void registerPlaylistParsers();
     void registerInputs();
+    void registerDsps();
 
     void setupConnections();
     void markTrack(const Track& track) const;
@@ -159,6 +161,7 @@ void ApplicationPrivate::initialise()
 
     registerTypes();
     registerInputs();
+    registerDsps();
     registerPlaylistParsers();
     setupConnections();
     loadPlugins();
@@ -178,16 +181,13 @@ void ApplicationPrivate::registerPlaylistParsers()
 
 void ApplicationPrivate::registerInputs()
 {
-    m_audioLoader->addDecoder(u"Archive"_s, [this]() { return std::make_unique<ArchiveDecoder>(m_audioLoader); });
-    m_audioLoader->addReader(u"Archive"_s, [this]() { return std::make_unique<GeneralArchiveReader>(m_audioLoader); });
-    m_audioLoader->addReader(u"TagLib"_s, {[]() {
-                                 return std::make_unique<TagLibReader>();
-                             }});
-    m_audioLoader->addDecoder(u"FFmpeg"_s, []() { return std::make_unique<FFmpegDecoder>(); }, 99);
-    m_audioLoader->addReader(u"FFmpeg"_s, {[]() {
-                                 return std::make_unique<FFmpegReader>();
-                             }},
-                             99);
+    registerBuiltinInputs(m_audioLoader);
+}
+
+void ApplicationPrivate::registerDsps()
+{
+    m_audioLoader->addDsp(u"Equaliser"_s, []() { return std::make_unique<Equaliser>(); });
+    m_audioLoader->addDsp(u"Limiter"_s, []() { return std::make_unique<Limiter>(); });
 }
 
 void ApplicationPrivate::setupConnections()
@@ -261,6 +261,9 @@ void ApplicationPrivate::loadPlugins()
             m_audioLoader->addArchiveReader(plugin->inputName(), creator.archiveReader);
         }
     });
+
+    m_pluginManager.initialisePlugins<DspPlugin>(
+        [this](DspPlugin* plugin) { m_audioLoader->addDsp(plugin->name(), plugin->creator()); });
 }
 
 void ApplicationPrivate::startSaveTimer()
@@ -20,6 +20,7 @@
 #include "librarydatabase.h"
 
 #include <utils/database/dbquery.h>
+#include <utils/database/dbtransaction.h>
 
 using namespace Qt::StringLiterals;
 
@@ -71,13 +72,30 @@ bool LibraryDatabase::removeLibrary(int id)
         return false;
     }
 
+    DbTransaction transaction{db()};
+
+    if(!transaction) {
+        return false;
+    }
+
+    DbQuery dirQuery{db(), u"DELETE FROM LibraryDirectories WHERE LibraryID = :id;"_s};
+    dirQuery.bindValue(u":id"_s, id);
+
+    if(!dirQuery.exec()) {
+        return false;
+    }
+
     const QString statement = u"DELETE FROM Libraries WHERE LibraryID = :id;"_s;
 
     DbQuery query{db(), statement};
 
     query.bindValue(u":id"_s, id);
 
-    return query.exec();
+    if(!query.exec()) {
+        return false;
+    }
+
+    return transaction.commit();
 }
 
 bool LibraryDatabase::renameLibrary(int id, const QString& name)
@@ -95,4 +113,91 @@ bool LibraryDatabase::renameLibrary(int id, const QString& name)
 
     return query.exec();
 }
+
+bool LibraryDatabase::getDirectories(int libraryId, IndexedDirectoryMap& directories)
+{
+    const QString statement
+        = u"SELECT Path, ModifiedDate, Inode, EntryCount FROM LibraryDirectories WHERE LibraryID = :id;"_s;
+
+    DbQuery query{db(), statement};
+
+    query.bindValue(u":id"_s, libraryId);
+
+    if(!query.exec()) {
+        return false;
+    }
+
+    while(query.next()) {
+        IndexedDirectory dir;
+        dir.path         = query.value(0).toString();
+        dir.modifiedTime = query.value(1).toULongLong();
+        dir.inode        = query.value(2).toULongLong();
+        dir.entryCount   = query.value(3).toInt();
+
+        directories.emplace(dir.path, dir);
+    }
+
+    return true;
+}
+
+bool LibraryDatabase::storeDirectories(int libraryId, const std::vector<IndexedDirectory>& directories)
+{
+    if(directories.empty()) {
+        return true;
+    }
+
+    DbTransaction transaction{db()};
+
+    if(!transaction) {
+        return false;
+    }
+
+    const QString statement
+        = u"INSERT OR REPLACE INTO LibraryDirectories (LibraryID, Path, ModifiedDate, Inode, EntryCount) "
+          "VALUES (:id, :path, :modifiedDate, :inode, :entryCount);"_s;
+
+    for(const IndexedDirectory& dir : directories) {
+        DbQuery query{db(), statement};
+
+        query.bindValue(u":id"_s, libraryId);
+        query.bindValue(u":path"_s, dir.path);
+        query.bindValue(u":modifiedDate"_s, static_cast<quint64>(dir.modifiedTime));
+        query.bindValue(u":inode"_s, static_cast<quint64>(dir.inode));
+        query.bindValue(u":entryCount"_s, dir.entryCount);
+
+        if(!query.exec()) {
+            return false;
+        }
+    }
+
+    return transaction.commit();
+}
+
+bool LibraryDatabase::removeDirectories(int libraryId, const QStringList& paths)
+{
+    if(paths.empty()) {
+        return true;
+    }
+
+    DbTransaction transaction{db()};
+
+    if(!transaction) {
+        return false;
+    }
+
+    const QString statement = u"DELETE FROM LibraryDirectories WHERE LibraryID = :id AND Path = :path;"_s;
+
+    for(const QString& path : paths) {
+        DbQuery query{db(), statement};
+
+        query.bindValue(u":id"_s, libraryId);
+        query.bindValue(u":path"_s, path);
+
+        if(!query.exec()) {
+            return false;
+        }
+    }
+
+    return transaction.commit();
+}
 } // namespace Fooyin
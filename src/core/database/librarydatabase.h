@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include "library/directoryindex.h"
+
 #include <core/library/libraryinfo.h>
 #include <utils/database/dbmodule.h>
 
@@ -32,5 +34,9 @@ public:
 
     bool removeLibrary(int id);
     bool renameLibrary(int id, const QString& name);
+
+    bool getDirectories(int libraryId, IndexedDirectoryMap& directories);
+    bool storeDirectories(int libraryId, const std::vector<IndexedDirectory>& directories);
+    bool removeDirectories(int libraryId, const QStringList& paths);
 };
 } // namespace Fooyin
@@ -28,6 +28,8 @@
 #include <QFileInfo>
 #include <QLoggingCategory>
 
+#include <unordered_map>
+
 Q_LOGGING_CATEGORY(TRK_DB, "fy.trackdb")
 
 using namespace Qt::StringLiterals;
@@ -79,7 +81,8 @@ QString fetchTrackColumns()
                                    "FirstPlayed,"
                                    "LastPlayed,"
                                    "PlayCount,"
-                                   "Rating"_s;
+                                   "Rating,"
+                                   "Fingerprint"_s;
 
     return columns;
 }
@@ -122,7 +125,144 @@ BindingsMap trackBindings(const Fooyin::Track& track)
             {u":rgTrackGain"_s, track.rgTrackGain()},
             {u":rgAlbumGain"_s, track.rgAlbumGain()},
             {u":rgTrackPeak"_s, track.rgTrackPeak()},
-            {u":rgAlbumPeak"_s, track.rgAlbumPeak()}};
+            {u":rgAlbumPeak"_s, track.rgAlbumPeak()},
+            {u":fingerprint"_s, track.fingerprint()}};
+}
+
+// SQLite limits a statement to 999 bound parameters before 3.32
+constexpr size_t MaxBoundParameters = 999;
+constexpr size_t StatsColumnCount   = 6;
+
+struct InsertColumn
+{
+    QString column;
+    QString placeholder;
+};
+
+// Columns written when inserting tracks, bound from trackBindings()
+const std::vector<InsertColumn>& insertColumns()
+{
+    static const std::vector<InsertColumn> columns{
+        {.column = u"FilePath"_s, .placeholder = u":filePath"_s},
+        {.column = u"Subsong"_s, .placeholder = u":subsong"_s},
+        {.column = u"Title"_s, .placeholder = u":title"_s},
+        {.column = u"TrackNumber"_s, .placeholder = u":trackNumber"_s},
+        {.column = u"TrackTotal"_s, .placeholder = u":trackTotal"_s},
+        {.column = u"Artists"_s, .placeholder = u":artists"_s},
+        {.column = u"AlbumArtist"_s, .placeholder = u":albumArtist"_s},
+        {.column = u"Album"_s, .placeholder = u":album"_s},
+        {.column = u"DiscNumber"_s, .placeholder = u":discNumber"_s},
+        {.column = u"DiscTotal"_s, .placeholder = u":discTotal"_s},
+        {.column = u"Date"_s, .placeholder = u":date"_s},
+        {.column = u"Composer"_s, .placeholder = u":composer"_s},
+        {.column = u"Performer"_s, .placeholder = u":performer"_s},
+        {.column = u"Genres"_s, .placeholder = u":genres"_s},
+        {.column = u"Comment"_s, .placeholder = u":comment"_s},
+        {.column = u"CuePath"_s, .placeholder = u":cuePath"_s},
+        {.column = u"Offset"_s, .placeholder = u":offset"_s},
+        {.column = u"Duration"_s, .placeholder = u":duration"_s},
+        {.column = u"FileSize"_s, .placeholder = u":fileSize"_s},
+        {.column = u"BitRate"_s, .placeholder = u":bitRate"_s},
+        {.column = u"SampleRate"_s, .placeholder = u":sampleRate"_s},
+        {.column = u"Channels"_s, .placeholder = u":channels"_s},
+        {.column = u"BitDepth"_s, .placeholder = u":bitDepth"_s},
+        {.column = u"Codec"_s, .placeholder = u":codec"_s},
+        {.column = u"CodecProfile"_s, .placeholder = u":codecProfile"_s},
+        {.column = u"Tool"_s, .placeholder = u":tool"_s},
+        {.column = u"TagTypes"_s, .placeholder = u":tagTypes"_s},
+        {.column = u"Encoding"_s, .placeholder = u":encoding"_s},
+        {.column = u"ExtraTags"_s, .placeholder = u":extraTags"_s},
+        {.column = u"ExtraProperties"_s, .placeholder = u":extraProperties"_s},
+        {.column = u"ModifiedDate"_s, .placeholder = u":modifiedDate"_s},
+        {.column = u"TrackHash"_s, .placeholder = u":trackHash"_s},
+        {.column = u"LibraryID"_s, .placeholder = u":libraryID"_s},
+        {.column = u"RGTrackGain"_s, .placeholder = u":rgTrackGain"_s},
+        {.column = u"RGAlbumGain"_s, .placeholder = u":rgAlbumGain"_s},
+        {.column = u"RGTrackPeak"_s, .placeholder = u":rgTrackPeak"_s},
+        {.column = u"RGAlbumPeak"_s, .placeholder = u":rgAlbumPeak"_s},
+        {.column = u"Fingerprint"_s, .placeholder = u":fingerprint"_s}};
+    return columns;
+}
+
+size_t tracksPerInsert()
+{
+    return MaxBoundParameters / insertColumns().size();
+}
+
+QString rowPlaceholder(const QString& placeholder, size_t row)
+{
+    return placeholder + u'_' + QString::number(row);
+}
+
+QString insertTracksStatement(size_t rowCount)
+{
+    QStringList columns;
+    for(const auto& column : insertColumns()) {
+        columns.append(column.column);
+    }
+
+    QStringList rows;
+    for(size_t row{0}; row < rowCount; ++row) {
+        QStringList placeholders;
+        for(const auto& column : insertColumns()) {
+            placeholders.append(rowPlaceholder(column.placeholder, row));
+        }
+        rows.append(u"("_s + placeholders.join(u',') + u")"_s);
+    }
+
+    return u"INSERT INTO Tracks (%1) VALUES %2;"_s.arg(columns.join(u','), rows.join(u','));
+}
+
+struct TrackStats
+{
+    uint64_t added{0};
+    uint64_t firstPlayed{0};
+    uint64_t lastPlayed{0};
+    int playCount{0};
+    float rating{0};
+};
+
+// Merges the stats of @p track into @p stats, returning true if they changed
+bool mergeStats(const Fooyin::Track& track, TrackStats& stats)
+{
+    bool dbNeedsUpdate{false};
+
+    const uint64_t trackAdded       = track.addedTime();
+    const uint64_t trackFirstPlayed = track.firstPlayed();
+    const uint64_t trackLastPlayed  = track.lastPlayed();
+    const int trackPlayCount        = track.playCount();
+    const float trackRating         = track.rating();
+
+    if(trackAdded != stats.added) {
+        if(stats.added == 0 || (trackAdded > 0 && trackAdded < stats.added)) {
+            stats.added   = trackAdded;
+            dbNeedsUpdate = true;
+        }
+    }
+    if(trackFirstPlayed != stats.firstPlayed) {
+        if(stats.firstPlayed == 0 || (trackFirstPlayed > 0 && trackFirstPlayed < stats.firstPlayed)) {
+            stats.firstPlayed = trackFirstPlayed;
+            dbNeedsUpdate     = true;
+        }
+    }
+    if(trackLastPlayed != stats.lastPlayed) {
+        if(trackLastPlayed > stats.lastPlayed) {
+            stats.lastPlayed = trackLastPlayed;
+            dbNeedsUpdate    = true;
+        }
+    }
+    if(trackPlayCount != stats.playCount) {
+        if(trackPlayCount > stats.playCount) {
+            stats.playCount = trackPlayCount;
+            dbNeedsUpdate   = true;
+        }
+    }
+    if(trackRating != stats.rating) {
+        stats.rating  = trackRating;
+        dbNeedsUpdate = true;
+    }
+
+    return dbNeedsUpdate;
 }
 
 Fooyin::Track readToTrack(const Fooyin::DbQuery& q)
@@ -183,6 +323,7 @@ Fooyin::Track readToTrack(const Fooyin::DbQuery& q)
     track.setLastPlayed(q.value(40).toULongLong());
     track.setPlayCount(q.value(41).toInt());
     track.setRating(q.value(42).toFloat());
+    track.setFingerprint(q.value(43).toString());
 
     track.generateHash();
 
@@ -203,12 +344,34 @@ bool TrackDatabase::storeTracks(TrackList& tracks)
         return false;
     }
 
+    std::vector<Track*> newTracks;
     for(auto& track : tracks) {
         if(track.id() < 0) {
-            insertTrack(track);
+            newTracks.push_back(&track);
+        }
+    }
+
+    const size_t batchSize = tracksPerInsert();
+
+    for(size_t start{0}; start < newTracks.size(); start += batchSize) {
+        const std::span batch{newTracks.data() + start, std::min(batchSize, newTracks.size() - start)};
+        if(!insertTracks(batch)) {
+            // A single failing row fails the whole statement, so retry the batch one track at a time
+            for(Track*& track : batch) {
+                insertTracks({&track, 1});
+            }
         }
     }
 
+    TrackList insertedTracks;
+    for(const Track* track : newTracks) {
+        if(track->id() >= 0) {
+            insertedTracks.push_back(*track);
+        }
+    }
+
+    insertOrUpdateStats(insertedTracks);
+
     return transaction.commit();
 }
 
@@ -385,10 +548,11 @@ bool TrackDatabase::updateTrack(const Track& track)
                            "RGTrackGain = :rgTrackGain,"
                            "RGAlbumGain = :rgAlbumGain,"
                            "RGTrackPeak = :rgTrackPeak,"
-                           "RGAlbumPeak = :rgAlbumPeak"
+                           "RGAlbumPeak = :rgAlbumPeak,"
+                           "Fingerprint = :fingerprint"
                            " WHERE TrackID = :trackId;"_s;
 
-    DbQuery query{db(), statement};
+    DbQuery query{connection(), statement};
 
     query.bindValue(u":trackId"_s, track.id());
 
@@ -402,20 +566,14 @@ bool TrackDatabase::updateTrack(const Track& track)
 
 bool TrackDatabase::updateTrackStats(const Track& track)
 {
-    return insertOrUpdateStats(track);
+    return insertOrUpdateStats({track});
 }
 
 bool TrackDatabase::updateTrackStats(const TrackList& tracks)
 {
-    bool success{true};
-
     DbTransaction transaction{db()};
 
-    for(const Track& track : tracks) {
-        if(!insertOrUpdateStats(track)) {
-            success = false;
-        }
-    }
+    const bool success = insertOrUpdateStats(tracks);
 
     return success && transaction.commit();
 }
@@ -561,7 +719,8 @@ void TrackDatabase::insertViews(const QSqlDatabase& db)
                            "TrackStats.FirstPlayed,"
                            "TrackStats.LastPlayed,"
                            "TrackStats.PlayCount,"
-                           "TrackStats.Rating"
+                           "TrackStats.Rating,"
+                           "Tracks.Fingerprint"
                            " FROM Tracks "
                            "LEFT JOIN TrackStats ON Tracks.TrackHash = TrackStats.TrackHash;"_s;
 
@@ -587,192 +746,124 @@ int TrackDatabase::trackCount() const
     return -1;
 }
 
-bool TrackDatabase::insertTrack(Track& track) const
-{
-    const auto statement = u"INSERT INTO Tracks ("
-                           "FilePath,"
-                           "Subsong,"
-                           "Title,"
-                           "TrackNumber,"
-                           "TrackTotal,"
-                           "Artists,"
-                           "AlbumArtist,"
-                           "Album,"
-                           "DiscNumber,"
-                           "DiscTotal,"
-                           "Date,"
-                           "Composer,"
-                           "Performer,"
-                           "Genres,"
-                           "Comment,"
-                           "CuePath,"
-                           "Offset,"
-                           "Duration,"
-                           "FileSize,"
-                           "BitRate,"
-                           "SampleRate,"
-                           "Channels,"
-                           "BitDepth,"
-                           "Codec,"
-                           "CodecProfile,"
-                           "Tool,"
-                           "TagTypes,"
-                           "Encoding,"
-                           "ExtraTags,"
-                           "ExtraProperties,"
-                           "ModifiedDate,"
-                           "TrackHash,"
-                           "LibraryID,"
-                           "RGTrackGain,"
-                           "RGAlbumGain,"
-                           "RGTrackPeak,"
-                           "RGAlbumPeak"
-                           ") "
-                           "VALUES ("
-                           ":filePath,"
-                           ":subsong,"
-                           ":title, "
-                           ":trackNumber,"
-                           ":trackTotal,"
-                           ":artists,"
-                           ":albumArtist,"
-                           ":album,"
-                           ":discNumber,"
-                           ":discTotal,"
-                           ":date, "
-                           ":composer,"
-                           ":performer,"
-                           ":genres,"
-                           ":comment,"
-                           ":cuePath,"
-                           ":offset,"
-                           ":duration,"
-                           ":fileSize,"
-                           ":bitRate,"
-                           ":sampleRate,"
-                           ":channels,"
-                           ":bitDepth,"
-                           ":codec,"
-                           ":codecProfile,"
-                           ":tool,"
-                           ":tagTypes,"
-                           ":encoding,"
-                           ":extraTags,"
-                           ":extraProperties,"
-                           ":modifiedDate,"
-                           ":trackHash,"
-                           ":libraryID,"
-                           ":rgTrackGain,"
-                           ":rgAlbumGain,"
-                           ":rgTrackPeak,"
-                           ":rgAlbumPeak"
-                           ");"_s;
+bool TrackDatabase::insertTracks(std::span<Track*> tracks) const
+{
+    const QString statement = insertTracksStatement(tracks.size());
 
-    DbQuery query{db(), statement};
+    // Only full batches are cached, as the final batch of each write can be any size
+    DbQuery query = tracks.size() == tracksPerInsert() ? DbQuery{connection(), statement} : DbQuery{db(), statement};
 
-    const auto bindings = trackBindings(track);
-    for(const auto& [name, value] : bindings) {
-        query.bindValue(name, value);
+    for(size_t row{0}; row < tracks.size(); ++row) {
+        const auto bindings = trackBindings(*tracks[row]);
+        for(const auto& column : insertColumns()) {
+            query.bindValue(rowPlaceholder(column.placeholder, row), bindings.at(column.placeholder));
+        }
     }
 
     if(!query.exec()) {
         return false;
     }
 
-    track.setId(query.lastInsertId().toInt());
+    // Rows inserted by a single statement are assigned consecutive ids
+    const int lastId = query.lastInsertId().toInt();
+    for(size_t row{0}; row < tracks.size(); ++row) {
+        tracks[row]->setId(lastId - static_cast<int>(tracks.size() - 1 - row));
+    }
 
-    return insertOrUpdateStats(track);
+    return true;
 }
 
-bool TrackDatabase::insertOrUpdateStats(const Track& track) const
+bool TrackDatabase::insertOrUpdateStats(const TrackList& tracks) const
 {
-    if(track.hash().isEmpty()) {
-        qCWarning(TRK_DB) << "Cannot insert/update track stats (Hash empty)";
-        return false;
+    bool success{true};
+
+    std::unordered_map<QString, TrackStats> stats;
+    std::vector<QString> hashes;
+
+    for(const Track& track : tracks) {
+        if(track.hash().isEmpty()) {
+            qCWarning(TRK_DB) << "Cannot insert/update track stats (Hash empty)";
+            success = false;
+        }
+        else if(stats.emplace(track.hash(), TrackStats{}).second) {
+            hashes.push_back(track.hash());
+        }
     }
 
-    uint64_t added{0};
-    uint64_t firstPlayed{0};
-    uint64_t lastPlayed{0};
-    int playCount{0};
-    float rating{0};
+    for(size_t start{0}; start < hashes.size(); start += MaxBoundParameters) {
+        const size_t count = std::min<size_t>(MaxBoundParameters, hashes.size() - start);
 
-    {
-        const auto statement = u"SELECT AddedDate, FirstPlayed, LastPlayed, PlayCount, Rating FROM "
-                               "TrackStats WHERE TrackHash = :trackHash;"_s;
+        QStringList placeholders;
+        for(size_t row{0}; row < count; ++row) {
+            placeholders.append(rowPlaceholder(u":trackHash"_s, row));
+        }
+
+        const auto statement = u"SELECT TrackHash, AddedDate, FirstPlayed, LastPlayed, PlayCount, Rating FROM "
+                               "TrackStats WHERE TrackHash IN (%1);"_s.arg(placeholders.join(u','));
 
         DbQuery query{db(), statement};
 
-        query.bindValue(u":trackHash"_s, track.hash());
+        for(size_t row{0}; row < count; ++row) {
+            query.bindValue(placeholders.at(static_cast<qsizetype>(row)), hashes.at(start + row));
+        }
 
         if(!query.exec()) {
             return false;
         }
 
-        if(query.next()) {
-            added       = query.value(0).toULongLong();
-            firstPlayed = query.value(1).toULongLong();
-            lastPlayed  = query.value(2).toULongLong();
-            playCount   = query.value(3).toInt();
-            rating      = query.value(4).toFloat();
+        while(query.next()) {
+            auto& trackStats       = stats[query.value(0).toString()];
+            trackStats.added       = query.value(1).toULongLong();
+            trackStats.firstPlayed = query.value(2).toULongLong();
+            trackStats.lastPlayed  = query.value(3).toULongLong();
+            trackStats.playCount   = query.value(4).toInt();
+            trackStats.rating      = query.value(5).toFloat();
         }
     }
 
-    bool dbNeedsUpdate{false};
-
-    const uint64_t trackAdded       = track.addedTime();
-    const uint64_t trackFirstPlayed = track.firstPlayed();
-    const uint64_t trackLastPlayed  = track.lastPlayed();
-    const int trackPlayCount        = track.playCount();
-    const float trackRating         = track.rating();
-
-    if(trackAdded != added) {
-        if(added == 0 || (trackAdded > 0 && trackAdded < added)) {
-            added         = trackAdded;
-            dbNeedsUpdate = true;
-        }
-    }
-    if(trackFirstPlayed != firstPlayed) {
-        if(firstPlayed == 0 || (trackFirstPlayed > 0 && trackFirstPlayed < firstPlayed)) {
-            firstPlayed   = trackFirstPlayed;
-            dbNeedsUpdate = true;
-        }
-    }
-    if(trackLastPlayed != lastPlayed) {
-        if(trackLastPlayed > lastPlayed) {
-            lastPlayed    = trackLastPlayed;
-            dbNeedsUpdate = true;
+    // Merged in order so tracks sharing a hash behave as if written one at a time
+    std::set<QString> changedHashes;
+    for(const Track& track : tracks) {
+        if(!track.hash().isEmpty() && mergeStats(track, stats.at(track.hash()))) {
+            changedHashes.emplace(track.hash());
         }
     }
-    if(trackPlayCount != playCount) {
-        if(trackPlayCount > playCount) {
-            playCount     = trackPlayCount;
-            dbNeedsUpdate = true;
+
+    std::erase_if(hashes, [&changedHashes](const QString& hash) { return !changedHashes.contains(hash); });
+
+    const size_t statsPerInsert = MaxBoundParameters / StatsColumnCount;
+
+    for(size_t start{0}; start < hashes.size(); start += statsPerInsert) {
+        const size_t count = std::min(statsPerInsert, hashes.size() - start);
+
+        QStringList rows;
+        for(size_t row{0}; row < count; ++row) {
+            rows.append(u"(:trackHash_%1, :addedDate_%1, :firstPlayed_%1, :lastPlayed_%1, :playCount_%1, :rating_%1)"_s
+                            .arg(row));
         }
-    }
-    if(trackRating != rating) {
-        rating        = trackRating;
-        dbNeedsUpdate = true;
-    }
 
-    if(!dbNeedsUpdate) {
-        return true;
-    }
+        const auto statement = u"INSERT OR REPLACE INTO TrackStats (TrackHash, AddedDate, FirstPlayed, LastPlayed, "
+                               u"PlayCount, Rating) VALUES %1;"_s.arg(rows.join(u','));
 
-    const auto statement = u"INSERT OR REPLACE INTO TrackStats (TrackHash, AddedDate, FirstPlayed, LastPlayed, "
-                           u"PlayCount, Rating) VALUES "
-                           "(:trackHash, :addedDate, :firstPlayed, :lastPlayed, :playCount, :rating);"_s;
+        DbQuery query = count == statsPerInsert ? DbQuery{connection(), statement} : DbQuery{db(), statement};
 
-    DbQuery query{db(), statement};
+        for(size_t row{0}; row < count; ++row) {
+            const QString& hash          = hashes.at(start + row);
+            const TrackStats& trackStats = stats.at(hash);
+            query.bindValue(rowPlaceholder(u":trackHash"_s, row), hash);
+            query.bindValue(rowPlaceholder(u":addedDate"_s, row), QVariant::fromValue(trackStats.added));
+            query.bindValue(rowPlaceholder(u":firstPlayed"_s, row), QVariant::fromValue(trackStats.firstPlayed));
+            query.bindValue(rowPlaceholder(u":lastPlayed"_s, row), QVariant::fromValue(trackStats.lastPlayed));
+            query.bindValue(rowPlaceholder(u":playCount"_s, row), trackStats.playCount);
+            query.bindValue(rowPlaceholder(u":rating"_s, row), trackStats.rating);
+        }
 
-    query.bindValue(u":trackHash"_s, track.hash());
-    query.bindValue(u":addedDate"_s, QVariant::fromValue(added));
-    query.bindValue(u":firstPlayed"_s, QVariant::fromValue(firstPlayed));
-    query.bindValue(u":lastPlayed"_s, QVariant::fromValue(lastPlayed));
-    query.bindValue(u":playCount"_s, playCount);
-    query.bindValue(u":rating"_s, rating);
+        if(!query.exec()) {
+            success = false;
+        }
+    }
 
-    return query.exec();
+    return success;
 }
 
 void TrackDatabase::removeUnmanagedTracks() const
@@ -25,6 +25,7 @@
 #include <utils/database/dbmodule.h>
 
 #include <set>
+#include <span>
 
 namespace Fooyin {
 class FYCORE_EXPORT TrackDatabase : public DbModule
@@ -54,8 +55,8 @@ public:
 
 private:
     [[nodiscard]] int trackCount() const;
-    bool insertTrack(Track& track) const;
-    bool insertOrUpdateStats(const Track& track) const;
+    bool insertTracks(std::span<Track*> tracks) const;
+    bool insertOrUpdateStats(const TrackList& tracks) const;
     void removeUnmanagedTracks() const;
     void updateLastSeenStats() const;
     void deleteExpiredStats() const;
@@ -0,0 +1,305 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/audioanalyser.h>
+
+#include <core/engine/audioconverter.h>
+#include <core/engine/audiotap.h>
+
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if(defined(__GNUC__) && defined(__x86_64__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace Qt::StringLiterals;
+
+namespace {
+struct Levels
+{
+    float peak{0.0F};
+    float sumSquares{0.0F};
+};
+
+// Measures @p count contiguous samples
+Levels measure(const float* samples, int count)
+{
+    int i{0};
+    Levels levels;
+
+#if(defined(__GNUC__) && defined(__x86_64__))
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 peaks         = _mm_setzero_ps();
+    __m128 squares       = _mm_setzero_ps();
+
+    for(; i + 4 <= count; i += 4) {
+        const __m128 block = _mm_loadu_ps(samples + i);
+        peaks              = _mm_max_ps(peaks, _mm_and_ps(block, absMask));
+        squares            = _mm_add_ps(squares, _mm_mul_ps(block, block));
+    }
+
+    peaks             = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+    peaks             = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+    squares           = _mm_add_ps(squares, _mm_movehl_ps(squares, squares));
+    squares           = _mm_add_ss(squares, _mm_shuffle_ps(squares, squares, 1));
+    levels.peak       = _mm_cvtss_f32(peaks);
+    levels.sumSquares = _mm_cvtss_f32(squares);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    float32x4_t peaks   = vdupq_n_f32(0.0F);
+    float32x4_t squares = vdupq_n_f32(0.0F);
+
+    for(; i + 4 <= count; i += 4) {
+        const float32x4_t block = vld1q_f32(samples + i);
+        peaks                   = vmaxq_f32(peaks, vabsq_f32(block));
+        squares                 = vmlaq_f32(squares, block, block);
+    }
+
+    levels.peak       = vmaxvq_f32(peaks);
+    levels.sumSquares = vaddvq_f32(squares);
+#endif
+
+    for(; i < count; ++i) {
+        levels.peak = std::max(levels.peak, std::abs(samples[i]));
+        levels.sumSquares += samples[i] * samples[i];
+    }
+
+    return levels;
+}
+
+// In-place radix-2 FFT, with @p twiddles holding the first half of the unit circle
+void fft(std::vector<std::complex<float>>& data, const std::vector<std::complex<float>>& twiddles)
+{
+    const auto size = data.size();
+
+    for(size_t i{1}, j{0}; i < size; ++i) {
+        size_t bit = size >> 1;
+        for(; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for(size_t length{2}; length <= size; length <<= 1) {
+        const size_t step = size / length;
+        const size_t half = length / 2;
+        for(size_t start{0}; start < size; start += length) {
+            for(size_t k{0}; k < half; ++k) {
+                const std::complex<float> even = data[start + k];
+                const std::complex<float> odd  = data[start + k + half] * twiddles[k * step];
+                data[start + k]                = even + odd;
+                data[start + k + half]         = even - odd;
+            }
+        }
+    }
+}
+} // namespace
+
+namespace Fooyin {
+AudioAnalyser::AudioAnalyser(std::shared_ptr<AudioTap> tap)
+    : m_tap{std::move(tap)}
+    , m_thread{QThread::create([this]() { run(); })}
+    , m_users{0}
+    , m_quit{false}
+    , m_window(FftSize)
+    , m_fft(FftSize)
+    , m_twiddles(FftSize / 2)
+{
+    constexpr auto twoPi = 2.0 * std::numbers::pi;
+
+    for(int i{0}; i < FftSize; ++i) {
+        m_window[i] = static_cast<float>(0.5 * (1.0 - std::cos(twoPi * i / (FftSize - 1))));
+    }
+    for(int i{0}; i < FftSize / 2; ++i) {
+        m_twiddles[i] = std::polar(1.0F, static_cast<float>(-twoPi * i / FftSize));
+    }
+
+    m_thread->setObjectName(u"Analyser"_s);
+    m_thread->start(QThread::LowPriority);
+}
+
+AudioAnalyser::~AudioAnalyser()
+{
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_quit = true;
+    }
+    m_cond.notify_all();
+
+    m_thread->wait();
+    delete m_thread;
+}
+
+void AudioAnalyser::acquire()
+{
+    {
+        const std::scoped_lock lock{m_mutex};
+        ++m_users;
+    }
+    m_cond.notify_all();
+}
+
+void AudioAnalyser::release()
+{
+    const std::scoped_lock lock{m_mutex};
+    m_users = std::max(m_users - 1, 0);
+    if(m_users == 0) {
+        m_latest = {};
+    }
+}
+
+AudioAnalysis AudioAnalyser::latest() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_latest;
+}
+
+AudioAnalysis AudioAnalyser::analyse(const AudioBuffer& buffer)
+{
+    AudioAnalysis analysis;
+
+    const AudioFormat format = buffer.format();
+    const int frames         = buffer.frameCount();
+    const int stride         = format.channelCount();
+    if(frames <= 0 || stride <= 0) {
+        return analysis;
+    }
+
+    AudioFormat floatFormat{format};
+    floatFormat.setSampleFormat(SampleFormat::F32);
+
+    m_samples.resize(static_cast<size_t>(frames) * stride);
+    if(!Audio::convert(format, buffer.constData().data(), floatFormat, reinterpret_cast<std::byte*>(m_samples.data()),
+                       frames)) {
+        return analysis;
+    }
+
+    analysis.channels   = std::min(stride, AudioAnalysis::MaxChannels);
+    analysis.sampleRate = format.sampleRate();
+    analysis.position   = buffer.startTime() + format.durationForFrames(frames);
+
+    const int levelFrames = std::clamp(format.framesForDuration(LevelWindow), 1, frames);
+    analyseLevels(m_samples.data() + (static_cast<size_t>(frames - levelFrames) * stride), levelFrames, stride,
+                  analysis);
+
+    const int fftFrames = std::min(frames, FftSize);
+    analyseSpectrum(m_samples.data() + (static_cast<size_t>(frames - fftFrames) * stride), fftFrames, stride,
+                    analysis);
+
+    return analysis;
+}
+
+void AudioAnalyser::run()
+{
+    std::unique_lock lock{m_mutex};
+
+    while(true) {
+        m_cond.wait(lock, [this]() { return m_quit || m_users > 0; });
+        if(m_quit) {
+            return;
+        }
+
+        lock.unlock();
+
+        AudioAnalysis analysis;
+        const int frames = std::max(m_tap ? m_tap->format().framesForDuration(LevelWindow) : 0, FftSize);
+        if(m_tap && m_tap->readAudible(frames, m_tapBuffer)) {
+            analysis = analyse(m_tapBuffer);
+        }
+
+        lock.lock();
+        // Last user may have gone in the meantime
+        m_latest = m_users > 0 ? analysis : AudioAnalysis{};
+
+        m_cond.wait_for(lock, std::chrono::milliseconds{Interval}, [this]() { return m_quit; });
+    }
+}
+
+void AudioAnalyser::analyseLevels(const float* samples, int frames, int stride, AudioAnalysis& analysis)
+{
+    m_channel.resize(static_cast<size_t>(frames));
+
+    for(int channel{0}; channel < analysis.channels; ++channel) {
+        // Deinterleave, so each channel can be measured in one pass
+        for(int frame{0}; frame < frames; ++frame) {
+            m_channel[frame] = samples[(static_cast<size_t>(frame) * stride) + channel];
+        }
+
+        const Levels levels       = measure(m_channel.data(), frames);
+        analysis.peak.at(channel) = std::min(levels.peak, 1.0F);
+        analysis.rms.at(channel)  = std::sqrt(levels.sumSquares / static_cast<float>(frames));
+    }
+}
+
+void AudioAnalyser::analyseSpectrum(const float* samples, int frames, int stride, AudioAnalysis& analysis)
+{
+    // Mix down, and zero-pad the start if there's less than a full window
+    const int padding = FftSize - frames;
+    const float scale = 1.0F / static_cast<float>(stride);
+
+    for(int i{0}; i < FftSize; ++i) {
+        float sample{0.0F};
+        if(i >= padding) {
+            const float* frame = samples + (static_cast<size_t>(i - padding) * stride);
+            for(int channel{0}; channel < stride; ++channel) {
+                sample += frame[channel];
+            }
+            sample *= scale;
+        }
+        m_fft[i] = {sample * m_window[i], 0.0F};
+    }
+
+    fft(m_fft, m_twiddles);
+
+    // A full-scale sine reads as 0dB
+    constexpr float windowGain = static_cast<float>(FftSize) / 4.0F;
+
+    const float binWidth = static_cast<float>(analysis.sampleRate) / FftSize;
+    const float maxFreq  = std::min(AudioAnalysis::MaxFrequency, static_cast<float>(analysis.sampleRate) / 2.0F);
+    const float range    = maxFreq / AudioAnalysis::MinFrequency;
+
+    for(int band{0}; band < AudioAnalysis::SpectrumBands; ++band) {
+        const auto edge = [range](int index) {
+            return AudioAnalysis::MinFrequency
+                 * std::pow(range, static_cast<float>(index) / static_cast<float>(AudioAnalysis::SpectrumBands));
+        };
+        const float low  = edge(band);
+        const float high = edge(band + 1);
+
+        const int firstBin = std::clamp(static_cast<int>(low / binWidth), 1, (FftSize / 2) - 1);
+        const int lastBin  = std::clamp(static_cast<int>(std::ceil(high / binWidth)), firstBin + 1, FftSize / 2);
+
+        float magnitude{0.0F};
+        for(int bin{firstBin}; bin < lastBin; ++bin) {
+            magnitude = std::max(magnitude, std::abs(m_fft[bin]));
+        }
+
+        analysis.spectrum.at(band)
+            = std::max(20.0F * std::log10(std::max(magnitude / windowGain, 1e-7F)), AudioAnalysis::MinDb);
+    }
+}
+} // namespace Fooyin
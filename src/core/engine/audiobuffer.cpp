@@ -19,9 +19,14 @@
 
 #include <core/engine/audiobuffer.h>
 
+#include "audiobufferpool.h"
+#include "gainprocessor.h"
+
 #include <QDebug>
 #include <QLoggingCategory>
 
+#include <algorithm>
+
 Q_LOGGING_CATEGORY(AUD_BUFF, "fy.audiobuffer")
 
 namespace Fooyin {
@@ -29,20 +34,62 @@ class AudioBufferPrivate : public QSharedData
 {
 public:
     AudioBufferPrivate(std::span<const std::byte> data, AudioFormat format, uint64_t startTime)
-        : m_format{format}
+        : m_buffer{AudioBufferPool::instance().acquire(data.size())}
+        , m_format{format}
         , m_startTime{startTime}
     {
         m_buffer.assign(data.begin(), data.end());
     }
 
     AudioBufferPrivate(const uint8_t* data, size_t size, AudioFormat format, uint64_t startTime)
-        : m_format{format}
+        : m_buffer{AudioBufferPool::instance().acquire(size)}
+        , m_format{format}
         , m_startTime{startTime}
     {
         m_buffer.resize(size);
         std::memmove(m_buffer.data(), data, size);
     }
 
+    AudioBufferPrivate(const AudioBufferPrivate& other)
+        : QSharedData{other}
+        , m_buffer{AudioBufferPool::instance().acquire(other.m_buffer.size())}
+        , m_format{other.m_format}
+        , m_startTime{other.m_startTime}
+    {
+        m_buffer.assign(other.m_buffer.cbegin(), other.m_buffer.cend());
+    }
+
+    ~AudioBufferPrivate()
+    {
+        AudioBufferPool::instance().release(std::move(m_buffer));
+    }
+
+    AudioBufferPrivate& operator=(const AudioBufferPrivate&) = delete;
+
+    static void* operator new(size_t /*size*/)
+    {
+        return AudioBufferPool::instance().allocateObject();
+    }
+
+    static void operator delete(void* data)
+    {
+        AudioBufferPool::instance().releaseObject(data);
+    }
+
+    void reserve(size_t size)
+    {
+        AudioBufferPool::instance().reserve(m_buffer, size);
+    }
+
+    void resize(size_t size)
+    {
+        if(size > m_buffer.capacity()) {
+            // Grow geometrically so repeated appends stay cheap
+            reserve(std::max(size, m_buffer.capacity() * 2));
+        }
+        m_buffer.resize(size);
+    }
+
     void fillSilence()
     {
         const bool unsignedFormat = m_format.sampleFormat() == SampleFormat::U8;
@@ -56,24 +103,11 @@ public:
                   unsignedFormat ? std::byte{0x80} : std::byte{0});
     }
 
-    template <typename T>
-    void scale(const double volume)
-    {
-        const auto bytes = static_cast<int>(m_buffer.size());
-        const int bps    = m_format.bytesPerSample();
-
-        for(int i{0}; i < bytes; i += bps) {
-            T sample;
-            std::memcpy(&sample, m_buffer.data() + i, bps);
-            sample *= volume;
-            std::memcpy(m_buffer.data() + i, &sample, bps);
-        }
-    }
-
     std::vector<std::byte> m_buffer;
     AudioFormat m_format;
     uint64_t m_startTime;
 };
+static_assert(sizeof(AudioBufferPrivate) <= AudioBufferPool::ObjectSize);
 
 AudioBuffer::AudioBuffer() = default;
 
@@ -98,14 +132,14 @@ AudioBuffer::AudioBuffer(AudioBuffer&& other) noexcept        = default;
 void AudioBuffer::reserve(size_t size)
 {
     if(isValid()) {
-        p->m_buffer.reserve(size);
+        p->reserve(size);
     }
 }
 
 void AudioBuffer::resize(size_t size)
 {
     if(isValid()) {
-        p->m_buffer.resize(size);
+        p->resize(size);
     }
 }
 
@@ -120,7 +154,7 @@ void AudioBuffer::append(const std::byte* data, size_t size)
 {
     if(isValid()) {
         const size_t index = p->m_buffer.size();
-        p->m_buffer.resize(index + size);
+        p->resize(index + size);
         std::memcpy(p->m_buffer.data() + index, data, size);
     }
 }
@@ -243,35 +277,28 @@ void AudioBuffer::fillRemainingWithSilence()
 
 void AudioBuffer::scale(double volume)
 {
-    if(!isValid() || volume == 1.0) {
+    if(isValid()) {
+        Audio::scale({data(), static_cast<size_t>(byteCount())}, format().sampleFormat(), volume);
+    }
+}
+
+void Audio::scale(std::span<std::byte> data, SampleFormat format, double volume)
+{
+    if(data.empty() || volume == 1.0) {
         return;
     }
 
     if(volume == 0.0) {
-        fillSilence();
+        std::ranges::fill(data, format == SampleFormat::U8 ? std::byte{0x80} : std::byte{0});
         return;
     }
 
-    switch(format().sampleFormat()) {
-        case(SampleFormat::U8):
-            p->scale<uint8_t>(volume);
-            break;
-        case(SampleFormat::S16):
-            p->scale<int16_t>(volume);
-            break;
-        case(SampleFormat::S24):
-        case(SampleFormat::S32):
-            p->scale<int32_t>(volume);
-            break;
-        case(SampleFormat::F32):
-            p->scale<float>(volume);
-            break;
-        case(SampleFormat::F64):
-            p->scale<double>(volume);
-            break;
-        case(SampleFormat::Unknown):
-        default:
-            qCWarning(AUD_BUFF) << "Unable to scale samples of unsupported format";
+    if(format == SampleFormat::Unknown) {
+        qCWarning(AUD_BUFF) << "Unable to scale samples of unsupported format";
+        return;
     }
+
+    const int bytesPerSample = AudioFormat{format, 1, 1}.bytesPerSample();
+    applyGain(data.data(), format, static_cast<int>(data.size()) / bytesPerSample, static_cast<float>(volume));
 }
 } // namespace Fooyin
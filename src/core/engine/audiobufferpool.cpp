@@ -0,0 +1,204 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audiobufferpool.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+Q_LOGGING_CATEGORY(BUFFER_POOL, "fy.bufferpool", QtWarningMsg)
+
+namespace Fooyin {
+AudioBufferPool::AudioBufferPool(size_t maxBytes)
+    : m_maxBytes{maxBytes}
+{
+    // Reserve up front so returning storage never allocates
+    for(auto& storageClass : m_classes) {
+        storageClass.reserve(MaxPerClass);
+    }
+    m_objects.reserve(MaxObjects);
+}
+
+AudioBufferPool::~AudioBufferPool()
+{
+    for(void* object : m_objects) {
+        ::operator delete(object);
+    }
+}
+
+AudioBufferPool& AudioBufferPool::instance()
+{
+    // Never destroyed, as buffers held by other static objects may be released after it would be
+    static auto* pool = new AudioBufferPool();
+    return *pool;
+}
+
+AudioBufferPool::Storage AudioBufferPool::acquire(size_t capacity)
+{
+    if(capacity == 0) {
+        return {};
+    }
+
+    const size_t index = classForRequest(capacity);
+
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        // Accept storage one class larger rather than allocating
+        const size_t lastIndex = std::min(index + 2, ClassCount);
+        for(size_t i{index}; i < lastIndex; ++i) {
+            auto& storageClass = m_classes.at(i);
+            if(!storageClass.empty()) {
+                Storage storage = std::move(storageClass.back());
+                storageClass.pop_back();
+
+                --m_stats.pooledBuffers;
+                m_stats.pooledBytes -= storage.capacity();
+                ++m_stats.reuses;
+
+                return storage;
+            }
+        }
+
+        ++m_stats.allocations;
+    }
+
+    Storage storage;
+    storage.reserve(index < ClassCount ? classCapacity(index) : capacity);
+    return storage;
+}
+
+void AudioBufferPool::release(Storage&& storage)
+{
+    const size_t capacity = storage.capacity();
+    const size_t index    = classForStorage(capacity);
+    if(index >= ClassCount) {
+        return;
+    }
+
+    storage.clear();
+
+    const std::scoped_lock lock{m_mutex};
+
+    auto& storageClass = m_classes.at(index);
+    if(storageClass.size() < MaxPerClass && m_stats.pooledBytes + capacity <= m_maxBytes) {
+        storageClass.push_back(std::move(storage));
+        ++m_stats.pooledBuffers;
+        m_stats.pooledBytes += capacity;
+    }
+}
+
+void AudioBufferPool::reserve(Storage& storage, size_t capacity)
+{
+    if(storage.capacity() >= capacity) {
+        return;
+    }
+
+    Storage larger = acquire(capacity);
+    larger.assign(storage.cbegin(), storage.cend());
+    storage.swap(larger);
+    release(std::move(larger));
+}
+
+void* AudioBufferPool::allocateObject()
+{
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        if(!m_objects.empty()) {
+            void* object = m_objects.back();
+            m_objects.pop_back();
+            ++m_stats.reuses;
+            return object;
+        }
+
+        ++m_stats.allocations;
+    }
+
+    return ::operator new(ObjectSize);
+}
+
+void AudioBufferPool::releaseObject(void* object)
+{
+    if(!object) {
+        return;
+    }
+
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        if(m_objects.size() < MaxObjects) {
+            m_objects.push_back(object);
+            return;
+        }
+    }
+
+    ::operator delete(object);
+}
+
+AudioBufferPool::Stats AudioBufferPool::stats() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_stats;
+}
+
+void AudioBufferPool::clear()
+{
+    std::array<std::vector<Storage>, ClassCount> classes;
+
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        for(size_t i{0}; i < ClassCount; ++i) {
+            classes.at(i).swap(m_classes.at(i));
+            m_classes.at(i).reserve(MaxPerClass);
+        }
+        m_stats.pooledBuffers = 0;
+        m_stats.pooledBytes   = 0;
+    }
+
+    // Storage is freed here, outside the lock
+}
+
+size_t AudioBufferPool::classForRequest(size_t capacity)
+{
+    if(capacity <= MinCapacity) {
+        return 0;
+    }
+
+    const auto index = static_cast<size_t>(std::bit_width(std::bit_ceil(capacity) / MinCapacity)) - 1;
+    return std::min(index, ClassCount);
+}
+
+size_t AudioBufferPool::classForStorage(size_t capacity)
+{
+    if(capacity < MinCapacity) {
+        return ClassCount;
+    }
+
+    const auto index = static_cast<size_t>(std::bit_width(capacity / MinCapacity)) - 1;
+    return std::min(index, ClassCount - 1);
+}
+
+size_t AudioBufferPool::classCapacity(size_t index)
+{
+    return MinCapacity << index;
+}
+} // namespace Fooyin
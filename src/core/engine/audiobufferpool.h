@@ -0,0 +1,101 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <QLoggingCategory>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+Q_DECLARE_LOGGING_CATEGORY(BUFFER_POOL)
+
+namespace Fooyin {
+/*!
+ * Recycles the sample storage of AudioBuffers.
+ * Storage is grouped by capacity into power of two classes, so a buffer of a similar size to one which has been
+ * released is served without touching the heap. Once playback reaches a steady state, decoding, converting and
+ * rendering should no longer allocate at all, which can be confirmed using @fn stats.
+ * All functions are thread-safe.
+ */
+class FYCORE_EXPORT AudioBufferPool
+{
+public:
+    using Storage = std::vector<std::byte>;
+
+    // Size of the blocks handed out by @fn allocateObject
+    static constexpr size_t ObjectSize = 64;
+
+    struct Stats
+    {
+        // Requests which had to allocate from the heap
+        uint64_t allocations{0};
+        // Requests served from the pool
+        uint64_t reuses{0};
+        size_t pooledBuffers{0};
+        size_t pooledBytes{0};
+    };
+
+    explicit AudioBufferPool(size_t maxBytes = DefaultMaxBytes);
+    ~AudioBufferPool();
+
+    AudioBufferPool(const AudioBufferPool&)            = delete;
+    AudioBufferPool& operator=(const AudioBufferPool&) = delete;
+
+    /** Returns the pool shared by all AudioBuffers. */
+    static AudioBufferPool& instance();
+
+    /** Returns empty storage with a capacity of at least @p capacity. */
+    [[nodiscard]] Storage acquire(size_t capacity);
+    /** Returns @p storage to the pool. It may be freed instead if the pool is full. */
+    void release(Storage&& storage);
+    /** Ensures @p storage has a capacity of at least @p capacity, keeping its contents. */
+    void reserve(Storage& storage, size_t capacity);
+
+    /** Returns a block of ObjectSize bytes for a small object, such as the shared data of an AudioBuffer. */
+    [[nodiscard]] void* allocateObject();
+    void releaseObject(void* object);
+
+    [[nodiscard]] Stats stats() const;
+    /** Frees all pooled storage. */
+    void clear();
+
+private:
+    static constexpr size_t DefaultMaxBytes = 64UL * 1024 * 1024;
+    static constexpr size_t MinCapacity     = 1024;
+    static constexpr size_t ClassCount      = 20;
+    static constexpr size_t MaxPerClass     = 32;
+    static constexpr size_t MaxObjects      = 512;
+
+    [[nodiscard]] static size_t classForRequest(size_t capacity);
+    [[nodiscard]] static size_t classForStorage(size_t capacity);
+    [[nodiscard]] static size_t classCapacity(size_t index);
+
+    mutable std::mutex m_mutex;
+    size_t m_maxBytes;
+    std::array<std::vector<Storage>, ClassCount> m_classes;
+    std::vector<void*> m_objects;
+    Stats m_stats;
+};
+} // namespace Fooyin
@@ -19,9 +19,24 @@
 
 #include "audioclock.h"
 
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Errors below this are corrected gradually
+constexpr auto MaxDrift = 50.0; // ms
+// Errors above this can't be drift, so are from a different stream position
+constexpr auto MaxCorrection = 5000.0; // ms
+// Time taken to work off drift
+constexpr auto DriftPeriod = 1000.0; // ms
+// Furthest the clock's rate can be from real time while correcting drift
+constexpr auto MaxRateAdjustment = 0.05;
+} // namespace
+
 namespace Fooyin {
 AudioClock::AudioClock()
     : m_paused{true}
+    , m_rate{1.0}
 {
     sync();
 }
@@ -33,8 +48,33 @@ void AudioClock::sync(uint64_t position)
 
 void AudioClock::sync(const TimePoint& tp, uint64_t position)
 {
-    m_position  = TrackTime{position};
+    m_position  = TrackTime{static_cast<double>(position)};
     m_timePoint = tp;
+    m_rate      = 1.0;
+}
+
+bool AudioClock::correct(const TimePoint& tp, uint64_t position)
+{
+    if(m_paused) {
+        return false;
+    }
+
+    const double error = static_cast<double>(position) - trackTimeAt(tp).count();
+    if(std::abs(error) > MaxCorrection) {
+        return false;
+    }
+
+    rebase(tp);
+
+    if(std::abs(error) > MaxDrift) {
+        m_position = TrackTime{static_cast<double>(position)};
+        m_rate     = 1.0;
+    }
+    else {
+        m_rate = 1.0 + std::clamp(error / DriftPeriod, -MaxRateAdjustment, MaxRateAdjustment);
+    }
+
+    return true;
 }
 
 uint64_t AudioClock::currentPosition() const
@@ -47,24 +87,32 @@ void AudioClock::setPaused(bool paused)
     if(m_paused == paused) {
         return;
     }
-    const auto now = Clock::now();
-    if(!m_paused) {
-        m_position = m_position + toTrackTime(now - m_timePoint);
-    }
-    m_timePoint = now;
-    m_paused    = paused;
+    rebase(Clock::now());
+    m_paused = paused;
 }
 
 uint64_t AudioClock::positionFromTime(TimePoint tp, bool ignorePause) const
 {
-    tp                  = m_paused && !ignorePause ? m_timePoint : tp;
-    const TrackTime pos = m_position + toTrackTime(tp - m_timePoint);
-    return pos.count();
+    const TrackTime pos = m_paused && !ignorePause ? m_position : trackTimeAt(tp);
+    return static_cast<uint64_t>(std::max(pos.count(), 0.0));
 }
 
 AudioClock::TimePoint AudioClock::timeFromPosition(uint64_t position, bool ignorePause) const
 {
-    auto pos = m_paused && !ignorePause ? m_position : TrackTime{position};
-    return m_timePoint + toClockTime(pos - m_position);
+    const TrackTime pos = m_paused && !ignorePause ? m_position : TrackTime{static_cast<double>(position)};
+    return m_timePoint + toClockTime((pos - m_position) / m_rate);
+}
+
+AudioClock::TrackTime AudioClock::trackTimeAt(TimePoint tp) const
+{
+    return m_position + (toTrackTime(tp - m_timePoint) * m_rate);
+}
+
+void AudioClock::rebase(TimePoint tp)
+{
+    if(!m_paused) {
+        m_position = trackTimeAt(tp);
+    }
+    m_timePoint = tp;
 }
 } // namespace Fooyin
@@ -33,6 +33,15 @@ public:
     void sync(uint64_t position = 0);
     void sync(const TimePoint& tp, uint64_t position);
 
+    /*!
+     * Corrects the clock using @p position, measured from the output as being heard at @p tp.
+     * Small drift is worked off gradually by running the clock slightly faster or slower, so the position never
+     * jumps; larger errors, such as the output's delay straight after a sync, are corrected immediately.
+     * Measurements too far out to be drift (e.g. from before a seek) are ignored.
+     * @returns true if @p position was used.
+     */
+    bool correct(const TimePoint& tp, uint64_t position);
+
     [[nodiscard]] uint64_t currentPosition() const;
 
     void setPaused(bool paused);
@@ -41,7 +50,7 @@ public:
     [[nodiscard]] uint64_t positionFromTime(TimePoint tp, bool ignorePause = false) const;
 
 private:
-    using TrackTime = std::chrono::milliseconds;
+    using TrackTime = std::chrono::duration<double, std::milli>;
 
     template <typename T>
     static Clock::duration toClockTime(const T& t)
@@ -55,7 +64,12 @@ private:
         return std::chrono::duration_cast<TrackTime>(t);
     }
 
+    [[nodiscard]] TrackTime trackTimeAt(TimePoint tp) const;
+    void rebase(TimePoint tp);
+
     bool m_paused;
+    // Rate the clock runs at relative to real time, adjusted to correct drift
+    double m_rate;
     TrackTime m_position;
     TimePoint m_timePoint;
 };
@@ -0,0 +1,201 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audiofader.h"
+
+#include "sampleconverters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace {
+// Level of the erf curve at either end, used to normalise it to 0-1
+const double ErfEdge = std::erf(1.5);
+
+double inverseCurveLevel(Fooyin::FadeCurve curve, float level)
+{
+    if(level <= 0.0F) {
+        return 0.0;
+    }
+    if(level >= 1.0F) {
+        return 1.0;
+    }
+
+    // Only needed when a fade changes direction, so a bisection is fast enough for any curve
+    double low{0.0};
+    double high{1.0};
+    for(int i{0}; i < 24; ++i) {
+        const double mid = (low + high) / 2.0;
+        if(Fooyin::AudioFader::curveLevel(curve, mid) < level) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return (low + high) / 2.0;
+}
+} // namespace
+
+namespace Fooyin {
+AudioFader::AudioFader()
+    : m_channels{0}
+    , m_curve{FadeCurve::Linear}
+    , m_fadingIn{true}
+    , m_length{0}
+    , m_position{0}
+    , m_level{1.0F}
+    , m_block{}
+{ }
+
+void AudioFader::setFormat(const AudioFormat& format)
+{
+    m_format   = format;
+    m_channels = format.channelCount();
+}
+
+void AudioFader::fadeIn(int frames, FadeCurve curve)
+{
+    startFade(true, frames, curve);
+}
+
+void AudioFader::fadeOut(int frames, FadeCurve curve)
+{
+    startFade(false, frames, curve);
+}
+
+void AudioFader::reset()
+{
+    m_fadingIn = true;
+    m_length   = 0;
+    m_position = 0;
+    m_level    = 1.0F;
+}
+
+bool AudioFader::isFading() const
+{
+    return m_position < m_length;
+}
+
+bool AudioFader::isFadingOut() const
+{
+    return isFading() && !m_fadingIn;
+}
+
+bool AudioFader::isSilent() const
+{
+    return !isFading() && !m_fadingIn && m_level <= 0.0F;
+}
+
+float AudioFader::level() const
+{
+    return m_level;
+}
+
+int AudioFader::framesRemaining() const
+{
+    return m_length - m_position;
+}
+
+void AudioFader::process(std::byte* data, int frameCount)
+{
+    if(!data || frameCount <= 0 || m_channels <= 0 || (!isFading() && m_level == 1.0F)) {
+        return;
+    }
+
+    const auto toFloat   = Audio::findSampleConverter(m_format.sampleFormat(), SampleFormat::F32);
+    const auto fromFloat = Audio::findSampleConverter(SampleFormat::F32, m_format.sampleFormat());
+    if(!toFloat || !fromFloat) {
+        return;
+    }
+
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int blockFrames   = BlockSamples / m_channels;
+    auto* blockData         = reinterpret_cast<std::byte*>(m_block.data());
+
+    for(int offset{0}; offset < frameCount;) {
+        const int frames   = std::min(blockFrames, frameCount - offset);
+        const int samples  = frames * m_channels;
+        std::byte* current = data + static_cast<ptrdiff_t>(offset) * bytesPerFrame;
+
+        toFloat(current, blockData, samples);
+        processBlock(frames);
+        fromFloat(blockData, current, samples);
+
+        offset += frames;
+    }
+}
+
+float AudioFader::curveLevel(FadeCurve curve, double position)
+{
+    position = std::clamp(position, 0.0, 1.0);
+
+    switch(curve) {
+        case(FadeCurve::Erf):
+            return static_cast<float>((std::erf(3.0 * position - 1.5) + ErfEdge) / (2.0 * ErfEdge));
+        case(FadeCurve::EqualPower):
+            return static_cast<float>(std::sin(position * std::numbers::pi / 2.0));
+        case(FadeCurve::Linear):
+        default:
+            return static_cast<float>(position);
+    }
+}
+
+void AudioFader::startFade(bool fadeIn, int frames, FadeCurve curve)
+{
+    const float startLevel = (fadeIn && !isFading()) ? 0.0F : m_level;
+
+    m_fadingIn = fadeIn;
+    m_curve    = curve;
+    m_length   = std::max(frames, 0);
+
+    if(m_length == 0) {
+        m_position = 0;
+        m_level    = fadeIn ? 1.0F : 0.0F;
+        return;
+    }
+
+    // Continue from the point on the new fade which matches the current level
+    const double position = inverseCurveLevel(curve, startLevel);
+    m_position = static_cast<int>(std::lround((fadeIn ? position : 1.0 - position) * m_length));
+    m_level    = startLevel;
+}
+
+float AudioFader::levelAt(int position) const
+{
+    const double progress = static_cast<double>(position) / m_length;
+    return curveLevel(m_curve, m_fadingIn ? progress : 1.0 - progress);
+}
+
+void AudioFader::processBlock(int frameCount)
+{
+    for(int frame{0}; frame < frameCount; ++frame) {
+        if(isFading()) {
+            ++m_position;
+            m_level = isFading() ? levelAt(m_position) : (m_fadingIn ? 1.0F : 0.0F);
+        }
+
+        float* samples = m_block.data() + static_cast<ptrdiff_t>(frame) * m_channels;
+        for(int ch{0}; ch < m_channels; ++ch) {
+            samples[ch] *= m_level;
+        }
+    }
+}
+} // namespace Fooyin
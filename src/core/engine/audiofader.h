@@ -0,0 +1,90 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audioformat.h>
+
+#include <array>
+#include <cstddef>
+
+namespace Fooyin {
+enum class FadeCurve : uint8_t
+{
+    Linear = 0,
+    // S-shaped curve, slow at either end
+    Erf,
+    // Keeps the combined power constant when crossfading uncorrelated audio
+    EqualPower
+};
+
+/*!
+ * Fades interleaved samples in their native format.
+ * Fade state is kept in frames, so a fade ends on an exact sample regardless of how the audio is split
+ * across calls to @fn process. Starting a fade while another is in progress continues from the current level.
+ */
+class FYCORE_EXPORT AudioFader
+{
+public:
+    AudioFader();
+
+    void setFormat(const AudioFormat& format);
+
+    /*!
+     * Fades towards full level over @p frames.
+     * If not already fading, the fade starts from silence.
+     */
+    void fadeIn(int frames, FadeCurve curve);
+    /** Fades towards silence over @p frames. */
+    void fadeOut(int frames, FadeCurve curve);
+    /** Stops any fade and returns to full level. */
+    void reset();
+
+    [[nodiscard]] bool isFading() const;
+    [[nodiscard]] bool isFadingOut() const;
+    /** Returns @c true if a fade out has completed. */
+    [[nodiscard]] bool isSilent() const;
+    [[nodiscard]] float level() const;
+    /** Returns the number of frames until the current fade completes. */
+    [[nodiscard]] int framesRemaining() const;
+
+    void process(std::byte* data, int frameCount);
+
+    /** Returns the level of a fade in using @p curve at @p position (0 to 1). */
+    [[nodiscard]] static float curveLevel(FadeCurve curve, double position);
+
+private:
+    static constexpr int BlockSamples = 1024;
+
+    void startFade(bool fadeIn, int frames, FadeCurve curve);
+    [[nodiscard]] float levelAt(int position) const;
+    void processBlock(int frameCount);
+
+    AudioFormat m_format;
+    int m_channels;
+    FadeCurve m_curve;
+    bool m_fadingIn;
+    int m_length;
+    int m_position;
+    float m_level;
+    std::array<float, BlockSamples> m_block;
+};
+} // namespace Fooyin
@@ -25,6 +25,7 @@
 
 #include <QFileInfo>
 #include <QLoggingCategory>
+#include <QThreadPool>
 #include <QThreadStorage>
 
 #include <mutex>
@@ -50,24 +51,90 @@ namespace Fooyin {
 using DecoderInstances       = std::unordered_map<QString, std::unique_ptr<AudioDecoder>>;
 using ReaderInstances        = std::unordered_map<QString, std::unique_ptr<AudioReader>>;
 using ArchiveReaderInstances = std::unordered_map<QString, std::unique_ptr<ArchiveReader>>;
+using DecoderPool            = std::unordered_map<QString, std::vector<std::unique_ptr<AudioDecoder>>>;
 
 class AudioLoaderPrivate
 {
 public:
+    // Both require m_mutex to be held
+    int decoderIndexForFile(const QString& file);
+    void invalidateProbes();
+
     std::vector<AudioLoader::LoaderEntry<DecoderCreator>> m_defaultDecoders;
     std::vector<AudioLoader::LoaderEntry<ReaderCreator>> m_defaultReaders;
 
     std::vector<AudioLoader::LoaderEntry<DecoderCreator>> m_decoders;
     std::vector<AudioLoader::LoaderEntry<ReaderCreator>> m_readers;
     std::vector<AudioLoader::LoaderEntry<ArchiveReaderCreator>> m_archiveReaders;
+    std::vector<AudioLoader::LoaderEntry<DspCreator>> m_dsps;
 
     QThreadStorage<DecoderInstances*> m_decoderInstances;
     QThreadStorage<ReaderInstances*> m_readerInstances;
     QThreadStorage<ArchiveReaderInstances*> m_archiveReaderInstances;
 
     std::shared_mutex m_mutex;
+
+    // Index into m_decoders of the decoder used for each extension (-1 if none), so batch jobs over many files
+    // don't search every decoder's extensions each time
+    std::mutex m_probeMutex;
+    std::unordered_map<QString, int> m_decoderProbes;
+
+    std::mutex m_poolMutex;
+    DecoderPool m_decoderPool;
 };
 
+int AudioLoaderPrivate::decoderIndexForFile(const QString& file)
+{
+    const QString ext      = QFileInfo{file}.suffix().toLower();
+    const bool isInArchive = Track::isArchivePath(file);
+
+    if(!isInArchive) {
+        const std::scoped_lock lock{m_probeMutex};
+        if(const auto probe = m_decoderProbes.find(ext); probe != m_decoderProbes.cend()) {
+            return probe->second;
+        }
+    }
+
+    const auto loader = std::ranges::find_if(m_decoders, [isInArchive, &ext](const auto& entry) {
+        return entry.enabled
+            && ((isInArchive && entry.name == "Archive"_L1) || (!isInArchive && entry.extensions.contains(ext)));
+    });
+    const int index
+        = loader != m_decoders.cend() ? static_cast<int>(std::distance(m_decoders.cbegin(), loader)) : -1;
+
+    if(!isInArchive) {
+        const std::scoped_lock lock{m_probeMutex};
+        m_decoderProbes.emplace(ext, index);
+    }
+
+    return index;
+}
+
+void AudioLoaderPrivate::invalidateProbes()
+{
+    const std::scoped_lock lock{m_probeMutex};
+    m_decoderProbes.clear();
+}
+
+void AudioLoader::DecoderReleaser::operator()(AudioDecoder* decoder) const
+{
+    std::unique_ptr<AudioDecoder> instance{decoder};
+    if(!instance || !loader) {
+        return;
+    }
+
+    instance->stop();
+
+    // Enough to go round the thread pool batch jobs are run on
+    const auto maxPooled = static_cast<size_t>(std::max(QThreadPool::globalInstance()->maxThreadCount(), 1));
+
+    const std::scoped_lock lock{loader->p->m_poolMutex};
+    auto& pooled = loader->p->m_decoderPool[name];
+    if(pooled.size() < maxPooled) {
+        pooled.push_back(std::move(instance));
+    }
+}
+
 AudioLoader::AudioLoader()
     : p{std::make_unique<AudioLoaderPrivate>()}
 { }
@@ -141,6 +208,7 @@ void AudioLoader::restoreState()
 
     restoreLoaders(p->m_decoders, p->m_defaultDecoders, DecoderState);
     restoreLoaders(p->m_readers, p->m_defaultReaders, ReaderState);
+    p->invalidateProbes();
 }
 
 AudioLoader::~AudioLoader() = default;
@@ -219,27 +287,22 @@ AudioDecoder* AudioLoader::decoderForFile(const QString& file) const
 {
     const std::shared_lock lock{p->m_mutex};
 
-    const QString ext      = QFileInfo{file}.suffix().toLower();
-    const bool isInArchive = Track::isArchivePath(file);
+    const int index = p->decoderIndexForFile(file);
+    if(index < 0) {
+        return nullptr;
+    }
 
-    for(const auto& loader : p->m_decoders) {
-        if(!loader.enabled) {
-            continue;
-        }
-        if((isInArchive && loader.name == "Archive"_L1) || (!isInArchive && loader.extensions.contains(ext))) {
-            if(p->m_decoderInstances.hasLocalData()) {
-                auto& readers = p->m_decoderInstances.localData();
-                if(readers->contains(loader.name)) {
-                    return readers->at(loader.name).get();
-                }
-                return readers->emplace(loader.name, loader.creator()).first->second.get();
-            }
-            p->m_decoderInstances.setLocalData(new DecoderInstances());
-            return p->m_decoderInstances.localData()->emplace(loader.name, loader.creator()).first->second.get();
+    const auto& loader = p->m_decoders.at(index);
+
+    if(p->m_decoderInstances.hasLocalData()) {
+        auto& readers = p->m_decoderInstances.localData();
+        if(readers->contains(loader.name)) {
+            return readers->at(loader.name).get();
         }
+        return readers->emplace(loader.name, loader.creator()).first->second.get();
     }
-
-    return nullptr;
+    p->m_decoderInstances.setLocalData(new DecoderInstances());
+    return p->m_decoderInstances.localData()->emplace(loader.name, loader.creator()).first->second.get();
 }
 
 AudioDecoder* AudioLoader::decoderForTrack(const Track& track) const
@@ -309,6 +372,41 @@ ArchiveReader* AudioLoader::archiveReaderForFile(const QString& file) const
     return nullptr;
 }
 
+AudioLoader::PooledDecoder AudioLoader::acquireDecoder(const QString& file)
+{
+    const std::shared_lock lock{p->m_mutex};
+
+    const int index = p->decoderIndexForFile(file);
+    if(index < 0) {
+        return {};
+    }
+
+    const auto& loader = p->m_decoders.at(index);
+
+    {
+        const std::scoped_lock poolLock{p->m_poolMutex};
+        auto& pooled = p->m_decoderPool[loader.name];
+        if(!pooled.empty()) {
+            PooledDecoder decoder{pooled.back().release(), {this, loader.name}};
+            pooled.pop_back();
+            return decoder;
+        }
+    }
+
+    return {loader.creator().release(), {this, loader.name}};
+}
+
+AudioLoader::PooledDecoder AudioLoader::acquireDecoder(const Track& track)
+{
+    return acquireDecoder(track.filepath());
+}
+
+void AudioLoader::clearDecoderPool()
+{
+    const std::scoped_lock lock{p->m_poolMutex};
+    p->m_decoderPool.clear();
+}
+
 bool AudioLoader::readTrackMetadata(Track& track) const
 {
     const std::shared_lock lock{p->m_mutex};
@@ -440,6 +538,7 @@ void AudioLoader::addDecoder(const QString& name, const DecoderCreator& creator,
     loader.creator    = creator;
 
     p->m_decoders.push_back(loader);
+    p->invalidateProbes();
 }
 
 void AudioLoader::addReader(const QString& name, const ReaderCreator& creator, int priority)
@@ -492,6 +591,28 @@ void AudioLoader::addArchiveReader(const QString& name, const ArchiveReaderCreat
     p->m_archiveReaders.push_back(loader);
 }
 
+void AudioLoader::addDsp(const QString& name, const DspCreator& creator)
+{
+    if(!creator) {
+        qCWarning(AUD_LDR) << "DSP" << name << "cannot be created";
+        return;
+    }
+
+    const std::unique_lock lock{p->m_mutex};
+
+    if(std::ranges::any_of(p->m_dsps, [&name](const auto& loader) { return loader.name == name; })) {
+        qCWarning(AUD_LDR) << "DSP" << name << "already registered";
+        return;
+    }
+
+    LoaderEntry<DspCreator> loader;
+    loader.name    = name;
+    loader.index   = static_cast<int>(p->m_dsps.size());
+    loader.creator = creator;
+
+    p->m_dsps.push_back(loader);
+}
+
 std::vector<AudioLoader::LoaderEntry<DecoderCreator>> AudioLoader::decoders() const
 {
     const std::shared_lock lock{p->m_mutex};
@@ -510,6 +631,24 @@ std::vector<AudioLoader::LoaderEntry<ArchiveReaderCreator>> AudioLoader::archive
     return p->m_archiveReaders;
 }
 
+std::vector<AudioLoader::LoaderEntry<DspCreator>> AudioLoader::dsps() const
+{
+    const std::shared_lock lock{p->m_mutex};
+    return p->m_dsps;
+}
+
+std::unique_ptr<DspNode> AudioLoader::createDsp(const QString& name) const
+{
+    const std::shared_lock lock{p->m_mutex};
+
+    auto loader = std::ranges::find_if(p->m_dsps, [&name](const auto& entry) { return entry.name == name; });
+    if(loader == p->m_dsps.cend() || !loader->enabled) {
+        return nullptr;
+    }
+
+    return loader->creator();
+}
+
 void AudioLoader::setDecoderEnabled(const QString& name, bool enabled)
 {
     const std::unique_lock lock{p->m_mutex};
@@ -517,6 +656,7 @@ void AudioLoader::setDecoderEnabled(const QString& name, bool enabled)
     if(decoder != p->m_decoders.end()) {
         decoder->enabled = enabled;
     }
+    p->invalidateProbes();
 }
 
 void AudioLoader::changeDecoderIndex(const QString& name, int index)
@@ -527,6 +667,7 @@ void AudioLoader::changeDecoderIndex(const QString& name, int index)
         Utils::move(p->m_decoders, decoder->index, index);
     }
     std::ranges::for_each(p->m_decoders, [i = 0](auto& loader) mutable { loader.index = i++; });
+    p->invalidateProbes();
 }
 
 void AudioLoader::setReaderEnabled(const QString& name, bool enabled)
@@ -557,6 +698,7 @@ void AudioLoader::reloadDecoderExtensions(const QString& name)
             decoder->extensions = instance->extensions();
         }
     }
+    p->invalidateProbes();
 }
 
 void AudioLoader::reloadReaderExtensions(const QString& name)
@@ -579,6 +721,7 @@ void AudioLoader::reset()
     const std::unique_lock lock{p->m_mutex};
     p->m_decoders = p->m_defaultDecoders;
     p->m_readers  = p->m_defaultReaders;
+    p->invalidateProbes();
 }
 
 void AudioLoader::destroyThreadInstance()
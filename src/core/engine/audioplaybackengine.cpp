@@ -21,10 +21,13 @@
 
 #include "audioclock.h"
 #include "audiorenderer.h"
+#include "gainprocessor.h"
 #include "internalcoresettings.h"
 
 #include <core/coresettings.h>
 #include <core/engine/audiobuffer.h>
+#include <core/engine/audioconverter.h>
+#include <core/engine/mappedfile.h>
 #include <core/track.h>
 #include <utils/settings/settingsmanager.h>
 
@@ -37,14 +40,61 @@
 using namespace std::chrono_literals;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-constexpr auto BufferInterval   = 5ms;
-constexpr auto PositionInterval = 50ms;
+constexpr auto BufferInterval    = 5ms;
+constexpr auto PositionInterval  = 50ms;
+constexpr auto PoolStatsInterval = 1000ms;
 #else
-constexpr auto BufferInterval   = 5;
-constexpr auto PositionInterval = 50;
+constexpr auto BufferInterval    = 5;
+constexpr auto PositionInterval  = 50;
+constexpr auto PoolStatsInterval = 1000;
 #endif
 
 constexpr auto MaxDecodeLength = 100;
+// Audio from the next track's read-ahead written to the buffer before output starts
+constexpr auto PrerollLength = 300;
+
+namespace {
+std::unique_ptr<QIODevice> openTrackFile(const QString& filepath)
+{
+    // Local files are mapped to save a syscall and copy per read
+    if(Fooyin::MappedFile::canMap(filepath)) {
+        auto file = std::make_unique<Fooyin::MappedFile>(filepath);
+        if(file->open(QIODevice::ReadOnly)) {
+            return file;
+        }
+    }
+
+    auto file = std::make_unique<QFile>(filepath);
+    if(!file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    return file;
+}
+
+std::shared_ptr<Fooyin::FFmpegResampler> makeResampler(const Fooyin::AudioFormat& decoderFormat,
+                                                       const QHash<int, int>& outputRates, bool bitPerfect,
+                                                       Fooyin::ResamplerQuality quality)
+{
+    // The output must get the decoded audio untouched in bit-perfect mode
+    if(bitPerfect) {
+        return {};
+    }
+
+    const auto outputRate = outputRates.constFind(decoderFormat.sampleRate());
+    if(outputRate == outputRates.cend()) {
+        return {};
+    }
+
+    Fooyin::AudioFormat format{decoderFormat};
+    format.setSampleRate(outputRate.value());
+
+    auto resampler = std::make_shared<Fooyin::FFmpegResampler>(decoderFormat, format, 0, quality);
+    if(!resampler->canResample()) {
+        return {};
+    }
+    return resampler;
+}
+} // namespace
 
 namespace Fooyin {
 AudioPlaybackEngine::AudioPlaybackEngine(std::shared_ptr<AudioLoader> audioLoader, SettingsManager* settings,
@@ -56,7 +106,6 @@ AudioPlaybackEngine::AudioPlaybackEngine(std::shared_ptr<AudioLoader> audioLoade
     , m_startPosition{0}
     , m_endPosition{0}
     , m_lastPosition{0}
-    , m_totalBufferTime{0}
     , m_bufferLength{static_cast<uint64_t>(m_settings->value<Settings::Core::BufferLength>())}
     , m_duration{0}
     , m_volume{1.0}
@@ -64,16 +113,24 @@ AudioPlaybackEngine::AudioPlaybackEngine(std::shared_ptr<AudioLoader> audioLoade
     , m_decoding{false}
     , m_updatingTrack{false}
     , m_pauseNextTrack{false}
+    , m_dspsLoaded{false}
+    , m_nextStarted{false}
+    , m_loadWhenPrepared{false}
     , m_decoder{nullptr}
     , m_nextDecoder{nullptr}
+    , m_decodeWorker{std::make_unique<DecodeWorker>()}
+    , m_nextWorker{std::make_unique<DecodeWorker>()}
     , m_outputThread{new QThread(this)}
     , m_renderer{settings}
+    , m_tap{std::make_shared<AudioTap>()}
     , m_fadeIntervals{m_settings->value<Settings::Core::Internal::FadingIntervals>().value<FadingIntervals>()}
+    , m_crossfadeState{CrossfadeState::None}
+    , m_pendingEndFrames{-1}
 {
+    m_renderer.setTap(m_tap);
     m_renderer.moveToThread(m_outputThread);
 
     QObject::connect(&m_renderer, &AudioRenderer::requestOutputReload, this, &AudioPlaybackEngine::reloadOutput);
-    QObject::connect(&m_renderer, &AudioRenderer::bufferProcessed, this, &AudioPlaybackEngine::onBufferProcessed);
     QObject::connect(&m_renderer, &AudioRenderer::finished, this, &AudioPlaybackEngine::onRendererFinished);
     QObject::connect(&m_renderer, &AudioRenderer::outputStateChanged, this, &AudioPlaybackEngine::handleOutputState);
     QObject::connect(&m_renderer, &AudioRenderer::error, this, &AudioPlaybackEngine::deviceError);
@@ -86,6 +143,18 @@ AudioPlaybackEngine::AudioPlaybackEngine(std::shared_ptr<AudioLoader> audioLoade
     });
     m_settings->subscribe<Settings::Core::Internal::FadingIntervals>(
         this, [this](const QVariant& fading) { m_fadeIntervals = fading.value<FadingIntervals>(); });
+    m_settings->subscribe<Settings::Core::Internal::ActiveDsps>(this, &AudioPlaybackEngine::updateDsps);
+    m_settings->subscribe<Settings::Core::Internal::DecodeReadAhead>(this, [this](const int length) {
+        m_decodeWorker->setReadAhead(static_cast<uint64_t>(length));
+        m_nextWorker->setReadAhead(static_cast<uint64_t>(length));
+    });
+    m_settings->subscribe<Settings::Core::Internal::DecodeRealtime>(this, [this](const bool enabled) {
+        m_decodeWorker->setRealtime(enabled);
+        m_nextWorker->setRealtime(enabled);
+    });
+
+    setupWorker(m_decodeWorker.get());
+    setupWorker(m_nextWorker.get());
 
     m_outputThread->start();
 }
@@ -93,6 +162,7 @@ AudioPlaybackEngine::AudioPlaybackEngine(std::shared_ptr<AudioLoader> audioLoade
 AudioPlaybackEngine::~AudioPlaybackEngine()
 {
     stopWorkers(true);
+    resetNextTrack();
 
     m_outputThread->quit();
     m_outputThread->wait();
@@ -114,7 +184,18 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
 
     qCDebug(ENGINE) << "Loading track:" << track.filenameExt();
 
+    if(!m_dspsLoaded) {
+        // DSP plugins are only registered after the engine is created
+        updateDsps();
+    }
+
+    if(m_crossfadeState == CrossfadeState::Active && m_nextTrack == track) {
+        switchToCrossfadedTrack();
+        return;
+    }
+
     std::optional<AudioFormat> format;
+    bool prepared{false};
 
     if(m_nextDecoder && m_nextTrack == track) {
         stopWorkers();
@@ -124,7 +205,16 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
 
         updateTrackStatus(TrackStatus::Loading);
 
-        format = loadPreparedTrack();
+        if(!m_nextFormat.isValid()) {
+            // Still being opened, so finish loading once it's ready
+            m_loadWhenPrepared = true;
+            return;
+        }
+
+        // The next track's worker has been decoding it, so carries on as the current one
+        std::swap(m_decodeWorker, m_nextWorker);
+        format   = loadPreparedTrack();
+        prepared = true;
     }
     else {
         resetNextTrack();
@@ -144,6 +234,10 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
             emit positionChanged(m_currentTrack, 0);
             m_ending = false;
             m_clock.sync(0);
+            m_renderer.invalidatePosition();
+            QMetaObject::invokeMethod(&m_renderer, [this, offset = m_endPosition - m_startPosition]() {
+                m_renderer.rebasePosition(offset);
+            });
             setupDuration();
             updateTrackStatus(TrackStatus::Buffered);
             if(playbackState() == PlaybackState::Playing) {
@@ -168,6 +262,11 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
             updateTrackStatus(TrackStatus::Invalid);
             return;
         }
+
+        m_resampler = createResampler(format.value());
+        if(m_resampler) {
+            format = m_resampler->outputFormat();
+        }
     }
 
     if(!format) {
@@ -185,14 +284,16 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
     const auto finaliseTrack = [this, track](const bool success) {
         if(!success) {
             m_format = {};
+            m_resampler.reset();
             updateState(PlaybackState::Error);
             updateTrackStatus(TrackStatus::NoTrack);
         }
         else {
+            updateOutputRate();
             setupDuration();
             updateTrackStatus(TrackStatus::Loaded);
             if(track.offset() > 0) {
-                m_decoder->seek(track.offset());
+                seekDecoder(track.offset());
             }
 
             if(const auto pendingState = std::exchange(m_pendingState, {})) {
@@ -213,11 +314,51 @@ void AudioPlaybackEngine::loadTrack(const Track& track)
         }
     };
 
+    setupBuffer();
+    if(prepared) {
+        // Start of the track was decoded while the previous one played, so it's ready as soon as output starts
+        const auto preroll = m_decodeWorker->read(static_cast<size_t>(m_format.bytesForDuration(PrerollLength)));
+        if(preroll.isValid()) {
+            m_buffer->write(preroll);
+        }
+    }
+
     QObject::connect(&m_renderer, &AudioRenderer::initialised, this, finaliseTrack, Qt::SingleShotConnection);
-    QMetaObject::invokeMethod(&m_renderer, [this]() { m_renderer.init(m_currentTrack, m_format); });
+    QMetaObject::invokeMethod(&m_renderer, [this, buffer = m_buffer]() {
+        m_renderer.setBuffer(buffer);
+        m_renderer.init(m_currentTrack, m_format);
+    });
 }
 
 void AudioPlaybackEngine::prepareNextTrack(const Track& track)
+{
+    prepareNextDecoder(track);
+
+    if(!m_nextDecoder && m_crossfadeState == CrossfadeState::Waiting) {
+        // Nothing to crossfade into
+        releaseCrossfadeTail();
+    }
+}
+
+void AudioPlaybackEngine::setupWorker(DecodeWorker* worker)
+{
+    worker->setReadAhead(m_settings->value<Settings::Core::Internal::DecodeReadAhead>());
+    worker->setRealtime(m_settings->value<Settings::Core::Internal::DecodeRealtime>());
+
+    // Move decoded audio along as soon as it arrives, rather than waiting for the next buffer interval
+    QObject::connect(worker, &DecodeWorker::bufferReady, this, [this, worker]() {
+        if(worker == m_decodeWorker.get() && m_bufferTimer.isActive()) {
+            readNextBuffer();
+        }
+    });
+    QObject::connect(worker, &DecodeWorker::prepared, this, [this, worker]() {
+        if(worker == m_nextWorker.get()) {
+            nextTrackPrepared();
+        }
+    });
+}
+
+void AudioPlaybackEngine::prepareNextDecoder(const Track& track)
 {
     resetNextTrack();
 
@@ -235,24 +376,96 @@ void AudioPlaybackEngine::prepareNextTrack(const Track& track)
         return;
     }
 
-    if(!track.isInArchive()) {
-        m_nextFile = std::make_unique<QFile>(track.filepath());
-        if(!m_nextFile->open(QIODevice::ReadOnly)) {
-            return;
-        }
-        m_nextSource.device   = m_nextFile.get();
-        m_nextSource.filepath = track.filepath();
+    if(m_nextDecoder == m_decodeWorker->decoder()) {
+        // Same decoder instance as the current track, which has finished decoding by now
+        m_decodeWorker->stop();
     }
 
     m_nextTrack = track;
 
-    const auto format = m_nextDecoder->init(m_nextSource, track, AudioDecoder::UpdateTracks);
-    if(!format) {
+    const bool bitPerfect = m_settings->value<Settings::Core::Internal::BitPerfect>();
+    const auto quality
+        = static_cast<ResamplerQuality>(m_settings->value<Settings::Core::Internal::ResamplerQuality>());
+
+    // Opening can be slow (archives, probing containers, network storage), so it's left to the next track's
+    // decode thread, which then decodes the start of the track ahead of it being needed.
+    // The file is handed back with the result, and only becomes m_nextFile on this thread in nextTrackPrepared.
+    m_nextWorker->prepare(m_nextDecoder, [track, decoder = m_nextDecoder, engineThread = thread(),
+                                          rates = m_outputRates, bitPerfect,
+                                          quality]() -> std::optional<DecodeWorker::Prepared> {
+        std::unique_ptr<QIODevice> file;
+        AudioSource source;
+
+        if(!track.isInArchive()) {
+            file = openTrackFile(track.filepath());
+            if(!file) {
+                return {};
+            }
+            file->moveToThread(engineThread);
+            source.device   = file.get();
+            source.filepath = track.filepath();
+        }
+
+        const auto format = decoder->init(source, track, AudioDecoder::UpdateTracks);
+        if(!format) {
+            return {};
+        }
+
+        DecodeWorker::Prepared prepared;
+        prepared.resampler = makeResampler(format.value(), rates, bitPerfect, quality);
+        prepared.format    = prepared.resampler ? prepared.resampler->outputFormat() : format.value();
+        prepared.file      = std::move(file);
+        // Decoder is only seeked to the start of the track once it's loaded
+        prepared.decode = track.offset() == 0;
+        if(prepared.decode) {
+            decoder->start();
+        }
+        return prepared;
+    });
+}
+
+void AudioPlaybackEngine::nextTrackPrepared()
+{
+    if(!m_nextDecoder || m_nextFormat.isValid() || m_nextWorker->isPreparing()
+       || m_nextWorker->decoder() != m_nextDecoder) {
+        return;
+    }
+
+    const AudioFormat format = m_nextWorker->format();
+    if(!format.isValid()) {
+        qCDebug(ENGINE) << "Unable to prepare next track:" << m_nextTrack.filenameExt();
+
+        const Track track = m_nextTrack;
+        const bool load   = m_loadWhenPrepared;
         resetNextTrack();
+
+        if(load) {
+            // Try again from scratch, reporting the error as usual
+            loadTrack(track);
+        }
+        else if(m_crossfadeState == CrossfadeState::Waiting) {
+            releaseCrossfadeTail();
+        }
         return;
     }
 
-    m_nextFormat = format.value();
+    m_nextFormat    = format;
+    m_nextResampler = m_nextWorker->resampler();
+    m_nextFile      = m_nextWorker->takeFile();
+    m_nextStarted   = m_nextTrack.offset() == 0;
+
+    if(m_nextFile) {
+        m_nextSource.device   = m_nextFile.get();
+        m_nextSource.filepath = m_nextTrack.filepath();
+    }
+
+    QMetaObject::invokeMethod(&m_renderer, [this, format]() { m_renderer.prepareFormat(format); });
+
+    if(std::exchange(m_loadWhenPrepared, false)) {
+        const Track track = m_nextTrack;
+        loadTrack(track);
+    }
+    // Otherwise any crossfade starts once enough of the track has been decoded
 }
 
 void AudioPlaybackEngine::play()
@@ -280,20 +493,23 @@ void AudioPlaybackEngine::play()
         if(!m_decoding) {
             m_decoding = true;
             m_decoder->start();
+            if(m_resampler) {
+                m_resampler->reset();
+            }
         }
 
         if(m_pendingSeek) {
-            resetWorkers();
-            m_decoder->seek(m_pendingSeek.value());
+            resetWorkers(true, m_pendingSeek.value() - m_startPosition);
+            seekDecoder(m_pendingSeek.value());
             m_pendingSeek = {};
         }
 
-        m_bufferTimer.start(BufferInterval, this);
-
         if(playbackState() == PlaybackState::Stopped && m_currentTrack.offset() > 0) {
-            m_decoder->seek(m_currentTrack.offset());
+            seekDecoder(m_currentTrack.offset());
         }
 
+        startDecoding(m_decoder, m_resampler);
+
         const bool canFade = m_settings->value<Settings::Core::Internal::EngineFading>()
                           && (playbackState() == PlaybackState::Paused || isFading());
         const int fadeLength = canFade ? calculateFadeLength(m_fadeIntervals.inPauseStop) : 0;
@@ -365,7 +581,7 @@ void AudioPlaybackEngine::pause()
                              ? calculateFadeLength(m_fadeIntervals.outPauseStop)
                              : 0;
     if(fadeLength > 0) {
-        if(fadeLength < m_fadeIntervals.outPauseStop) {
+        if(fadeLength < m_fadeIntervals.outPauseStop && m_crossfadeState != CrossfadeState::Active) {
             m_pauseNextTrack = true;
         }
         QMetaObject::invokeMethod(&m_renderer, [this, fadeLength]() { m_renderer.pause(fadeLength); });
@@ -399,7 +615,7 @@ void AudioPlaybackEngine::stop()
                       && m_volume > 0.0;
     if(canFade) {
         const int fadeLength = calculateFadeLength(m_fadeIntervals.outPauseStop);
-        if(fadeLength > 0 && fadeLength < m_fadeIntervals.outPauseStop) {
+        if(fadeLength > 0 && fadeLength < m_fadeIntervals.outPauseStop && m_crossfadeState != CrossfadeState::Active) {
             m_pauseNextTrack = true;
         }
 
@@ -426,6 +642,13 @@ void AudioPlaybackEngine::seek(uint64_t pos)
         return;
     }
 
+    cancelCrossfade();
+
+    if(m_nextDecoder == m_decoder) {
+        // Seeking would undo preparing the next track with the same decoder instance
+        resetNextTrack();
+    }
+
     if(playbackState() != PlaybackState::Playing || m_pendingSeek) {
         m_pendingSeek = pos + m_startPosition;
         m_clock.setPaused(true);
@@ -434,13 +657,13 @@ void AudioPlaybackEngine::seek(uint64_t pos)
         return;
     }
 
-    resetWorkers(false);
-    m_decoder->seek(pos + m_startPosition);
+    resetWorkers(false, pos);
+    seekDecoder(pos + m_startPosition);
     m_clock.sync(pos);
 
     if(playbackState() == PlaybackState::Playing) {
         m_clock.setPaused(false);
-        m_bufferTimer.start(BufferInterval, this);
+        startDecoding(m_decoder, m_resampler);
         QMetaObject::invokeMethod(&m_renderer, &AudioRenderer::start);
     }
     else {
@@ -448,6 +671,11 @@ void AudioPlaybackEngine::seek(uint64_t pos)
     }
 }
 
+std::shared_ptr<AudioTap> AudioPlaybackEngine::audioTap() const
+{
+    return m_tap;
+}
+
 void AudioPlaybackEngine::setVolume(double volume)
 {
     m_volume = volume;
@@ -464,6 +692,7 @@ void AudioPlaybackEngine::setAudioOutput(const OutputCreator& output, const QStr
     }
 
     QMetaObject::invokeMethod(&m_renderer, [this, output, device]() { m_renderer.updateOutput(output, device); });
+    m_outputRates.clear();
 
     if(outputActive) {
         QObject::connect(
@@ -496,6 +725,7 @@ void AudioPlaybackEngine::setOutputDevice(const QString& device)
     }
 
     QMetaObject::invokeMethod(&m_renderer, [this, device]() { m_renderer.updateDevice(device); });
+    m_outputRates.clear();
 
     if(outputActive) {
         QObject::connect(&m_renderer, &AudioRenderer::initialised, this, [this](bool success) {
@@ -522,6 +752,9 @@ void AudioPlaybackEngine::timerEvent(QTimerEvent* event)
     else if(event->timerId() == m_bitrateTimer.timerId()) {
         updateBitrate();
     }
+    else if(event->timerId() == m_poolStatsTimer.timerId()) {
+        logBufferStats();
+    }
 
     QObject::timerEvent(event);
 }
@@ -530,15 +763,34 @@ AudioEngine::PlaybackState AudioPlaybackEngine::updateState(AudioEngine::Playbac
 {
     const auto prevState = AudioEngine::updateState(state);
     m_clock.setPaused(state != PlaybackState::Playing && !isFading());
+
+    if(state == PlaybackState::Playing && BUFFER_POOL().isDebugEnabled()) {
+        if(!m_poolStatsTimer.isActive()) {
+            m_lastPoolStats = AudioBufferPool::instance().stats();
+            m_poolStatsElapsed.start();
+            m_poolStatsTimer.start(PoolStatsInterval, this);
+        }
+    }
+    else {
+        m_poolStatsTimer.stop();
+    }
+
     return prevState;
 }
 
 void AudioPlaybackEngine::resetNextTrack()
 {
+    // Waits for any preparing to finish, discarding a file it opened that hasn't been taken yet
+    m_nextWorker->clear();
+
     m_nextDecoder = nullptr;
     m_nextTrack   = {};
     m_nextSource  = {};
     m_nextFormat  = {};
+    m_nextFile.reset();
+    m_nextResampler.reset();
+    m_nextStarted      = false;
+    m_loadWhenPrepared = false;
 }
 
 AudioFormat AudioPlaybackEngine::loadPreparedTrack()
@@ -546,23 +798,115 @@ AudioFormat AudioPlaybackEngine::loadPreparedTrack()
     m_decoder      = std::exchange(m_nextDecoder, nullptr);
     m_currentTrack = std::exchange(m_nextTrack, {});
     m_source       = std::exchange(m_nextSource, {});
+    m_decoding     = std::exchange(m_nextStarted, false);
     m_file         = std::move(m_nextFile);
+    m_resampler    = std::move(m_nextResampler);
 
     AudioFormat format = std::exchange(m_nextFormat, {});
     return format;
 }
 
-void AudioPlaybackEngine::resetWorkers(bool resetFade)
+void AudioPlaybackEngine::switchToCrossfadedTrack()
+{
+    // The renderer is already playing the start of the track, so switch without interrupting output
+    m_crossfadeState = CrossfadeState::None;
+    m_ending         = false;
+
+    if(m_decoder && m_decoder != m_nextDecoder) {
+        m_decoder->stop();
+    }
+
+    m_format = loadPreparedTrack();
+    setupDuration();
+
+    if(m_decoder->trackHasChanged()) {
+        m_updatingTrack = true;
+        m_currentTrack  = m_decoder->changedTrack();
+        emit trackChanged(m_currentTrack);
+    }
+
+    QMetaObject::invokeMethod(&m_renderer, [this, track = m_currentTrack]() { m_renderer.updateTrack(track); });
+
+    updateTrackStatus(TrackStatus::Loaded);
+    if(playbackState() == PlaybackState::Playing) {
+        m_bufferTimer.start(BufferInterval, this);
+        m_posTimer.start(PositionInterval, Qt::PreciseTimer, this);
+    }
+}
+
+void AudioPlaybackEngine::logBufferStats()
+{
+    const auto stats     = AudioBufferPool::instance().stats();
+    const auto elapsed   = static_cast<double>(std::max<qint64>(m_poolStatsElapsed.restart(), 1)) / 1000.0;
+    const auto perSecond = [elapsed](uint64_t current, uint64_t previous) {
+        return static_cast<double>(current - previous) / elapsed;
+    };
+
+    // Steady state playback should show no allocations
+    qCDebug(BUFFER_POOL) << "Allocations/s:" << perSecond(stats.allocations, m_lastPoolStats.allocations)
+                         << "Reuses/s:" << perSecond(stats.reuses, m_lastPoolStats.reuses)
+                         << "Pooled:" << stats.pooledBuffers << "buffers," << stats.pooledBytes << "bytes";
+
+    m_lastPoolStats = stats;
+}
+
+void AudioPlaybackEngine::updateDsps()
+{
+    m_dspsLoaded = true;
+
+    const auto preset = m_settings->value<Settings::Core::Internal::ActiveDsps>().value<DspPreset>();
+
+    auto nodes = std::make_shared<DspNodeList>();
+    for(const auto& entry : preset) {
+        auto node = m_audioLoader->createDsp(entry.name);
+        if(!node) {
+            qCWarning(ENGINE) << "DSP" << entry.name << "is not available";
+            continue;
+        }
+        if(!node->loadSettings(entry.settings)) {
+            qCWarning(ENGINE) << "Unable to load settings for DSP" << entry.name;
+            continue;
+        }
+        nodes->push_back(std::move(node));
+    }
+
+    QMetaObject::invokeMethod(&m_renderer, [this, nodes]() { m_renderer.updateDspNodes(std::move(*nodes)); });
+}
+
+void AudioPlaybackEngine::setupBuffer()
+{
+    uint64_t length = m_bufferLength + MaxDecodeLength;
+    if(m_settings->value<Settings::Core::Internal::EngineCrossfading>()) {
+        // Leave room to write the held back tail of a track in one go
+        length += static_cast<uint64_t>(std::max(m_fadeIntervals.outChange, 0)) + MaxDecodeLength;
+    }
+
+    const int frames = m_format.framesForDuration(length);
+
+    if(m_buffer && m_buffer->format() == m_format && m_buffer->frameCapacity() >= frames) {
+        m_buffer->flush();
+        return;
+    }
+
+    m_buffer = std::make_shared<AudioRingBuffer>(m_format, frames);
+}
+
+void AudioPlaybackEngine::resetWorkers(bool resetFade, uint64_t position)
 {
     m_bufferTimer.stop();
+    m_decodeWorker->clear();
     m_clock.setPaused(true);
-    QMetaObject::invokeMethod(&m_renderer, [this, resetFade]() { m_renderer.reset(resetFade); });
-    m_totalBufferTime = 0;
+    if(m_buffer) {
+        m_buffer->flush();
+    }
+    m_renderer.invalidatePosition();
+    QMetaObject::invokeMethod(&m_renderer, [this, resetFade, position]() { m_renderer.reset(resetFade, position); });
 }
 
 void AudioPlaybackEngine::stopWorkers(bool full)
 {
     m_bufferTimer.stop();
+    m_decodeWorker->clear();
     m_posTimer.stop();
     m_bitrateTimer.stop();
 
@@ -572,17 +916,62 @@ void AudioPlaybackEngine::stopWorkers(bool full)
     m_pendingSeek = {};
     m_decoding    = false;
 
+    cancelCrossfade();
+
+    m_renderer.invalidatePosition();
     QMetaObject::invokeMethod(&m_renderer, &AudioRenderer::stop);
 
     if(full) {
         QMetaObject::invokeMethod(&m_renderer, &AudioRenderer::closeOutput);
         m_outputState = AudioOutput::State::Disconnected;
     }
-    if(m_decoder && (full || playbackState() != PlaybackState::Stopped)) {
+    // The prepared next track may share the decoder instance
+    if(m_decoder && m_decoder != m_nextDecoder && (full || playbackState() != PlaybackState::Stopped)) {
         m_decoder->stop();
     }
 
-    m_totalBufferTime = 0;
+    if(m_buffer) {
+        m_buffer->flush();
+    }
+}
+
+void AudioPlaybackEngine::startDecoding(AudioDecoder* decoder, std::shared_ptr<FFmpegResampler> resampler)
+{
+    m_decodeWorker->start(decoder, m_format, std::move(resampler));
+    m_bufferTimer.start(BufferInterval, this);
+}
+
+void AudioPlaybackEngine::seekDecoder(uint64_t pos)
+{
+    m_decoder->seek(pos);
+    if(m_resampler) {
+        // Samples held back from before the seek would otherwise be played after it
+        m_resampler->reset();
+    }
+}
+
+std::shared_ptr<FFmpegResampler> AudioPlaybackEngine::createResampler(const AudioFormat& decoderFormat) const
+{
+    const auto quality
+        = static_cast<ResamplerQuality>(m_settings->value<Settings::Core::Internal::ResamplerQuality>());
+    return makeResampler(decoderFormat, m_outputRates, m_settings->value<Settings::Core::Internal::BitPerfect>(),
+                         quality);
+}
+
+void AudioPlaybackEngine::updateOutputRate()
+{
+    if(m_resampler || m_settings->value<Settings::Core::Internal::BitPerfect>()) {
+        return;
+    }
+
+    // The renderer resamples to whatever rate the output chose, which is left to the decode thread from the next
+    // track at this rate onwards
+    const AudioFormat outputFormat = m_renderer.outputFormat();
+    if(outputFormat.isValid() && outputFormat.sampleRate() != m_format.sampleRate()) {
+        qCDebug(ENGINE) << "Resampling" << m_format.sampleRate() << "Hz tracks to" << outputFormat.sampleRate()
+                        << "Hz when decoding";
+        m_outputRates.insert(m_format.sampleRate(), outputFormat.sampleRate());
+    }
 }
 
 void AudioPlaybackEngine::startBitrateTimer()
@@ -603,6 +992,8 @@ void AudioPlaybackEngine::handleOutputState(AudioOutput::State outState)
 
 void AudioPlaybackEngine::reloadOutput()
 {
+    m_outputRates.clear();
+
     const bool outputActive = playbackState() != PlaybackState::Stopped;
 
     if(outputActive) {
@@ -631,8 +1022,8 @@ bool AudioPlaybackEngine::checkOpenSource()
         return true;
     }
 
-    m_file = std::make_unique<QFile>(m_currentTrack.filepath());
-    if(!m_file->open(QIODevice::ReadOnly)) {
+    m_file = openTrackFile(m_currentTrack.filepath());
+    if(!m_file) {
         updateTrackStatus(TrackStatus::Invalid);
         return false;
     }
@@ -662,6 +1053,10 @@ bool AudioPlaybackEngine::checkReadyToDecode()
         return false;
     }
 
+    if(m_nextDecoder == m_decoder) {
+        resetNextTrack();
+    }
+
     if(!checkOpenSource()) {
         return false;
     }
@@ -674,28 +1069,253 @@ bool AudioPlaybackEngine::checkReadyToDecode()
     return true;
 }
 
+bool AudioPlaybackEngine::canCrossfade() const
+{
+    // Tracks sharing a file are already continuous, and bit-perfect playback can't mix tracks
+    return m_settings->value<Settings::Core::Internal::EngineCrossfading>() && m_fadeIntervals.outChange > 0
+        && !m_settings->value<Settings::Core::Internal::BitPerfect>()
+        && playbackState() == PlaybackState::Playing && !m_currentTrack.hasCue() && m_currentTrack.offset() == 0
+        && m_duration != std::numeric_limits<uint64_t>::max();
+}
+
+void AudioPlaybackEngine::holdCrossfadeTail(const AudioBuffer& buffer)
+{
+    if(!m_crossfadeTail.isValid()) {
+        m_crossfadeTail = {m_format, buffer.startTime()};
+    }
+    m_crossfadeTail.append(buffer.constData());
+
+    // Track may run longer than its reported duration, so only keep what's needed for the fade
+    const int maxFrames = m_format.framesForDuration(m_fadeIntervals.outChange + MaxDecodeLength);
+    const int excess    = m_crossfadeTail.frameCount() - maxFrames;
+    if(excess > 0) {
+        const int written = m_buffer->write(m_crossfadeTail.constData().data(), excess);
+        m_crossfadeTail.erase(static_cast<size_t>(m_format.bytesForFrames(written)));
+    }
+}
+
+void AudioPlaybackEngine::startCrossfade()
+{
+    if(!m_nextDecoder || m_nextFormat != m_format || m_nextTrack.hasCue() || m_nextTrack.offset() > 0
+       || !m_crossfadeTail.isValid()) {
+        releaseCrossfadeTail();
+        return;
+    }
+
+    const int tailFrames    = m_crossfadeTail.frameCount();
+    const int fadeOutFrames = std::min(tailFrames, m_format.framesForDuration(m_fadeIntervals.outChange));
+    const int fadeStart     = tailFrames - fadeOutFrames;
+
+    // Already decoded ahead by the next track's worker, so this never waits on the decoder
+    AudioBuffer incoming = m_nextWorker->read(static_cast<size_t>(m_format.bytesForFrames(fadeOutFrames)));
+    if(!incoming.isValid()) {
+        incoming = {m_format, 0};
+    }
+
+    std::byte* fadeData = m_crossfadeTail.data() + m_format.bytesForFrames(fadeStart);
+
+    AudioFader fadeOut;
+    fadeOut.setFormat(m_format);
+    fadeOut.fadeOut(fadeOutFrames, FadeCurve::EqualPower);
+    fadeOut.process(fadeData, fadeOutFrames);
+
+    // Anything beyond the mix is faded in as it's decoded
+    m_crossfadeFader.setFormat(m_format);
+    m_crossfadeFader.fadeIn(m_format.framesForDuration(std::max(m_fadeIntervals.inChange, 0)),
+                            FadeCurve::EqualPower);
+    m_crossfadeFader.process(incoming.data(), incoming.frameCount());
+
+    const int mixFrames = std::min(fadeOutFrames, incoming.frameCount());
+    Audio::mixSamples(incoming.constData().data(), fadeData, m_format.sampleFormat(),
+                      mixFrames * m_format.channelCount());
+
+    if(incoming.frameCount() > mixFrames) {
+        m_crossfadeTail.append(incoming.constData().subspan(static_cast<size_t>(m_format.bytesForFrames(mixFrames))));
+    }
+
+    // Everything after the unmixed part of the tail is played as part of the next track. The buffer may not have
+    // room for all of it yet, so anything left over is written first as it drains.
+    m_pendingAudio     = std::exchange(m_crossfadeTail, {});
+    m_pendingEndFrames = fadeStart;
+    writePending();
+
+    qCDebug(ENGINE) << "Crossfading into track:" << m_nextTrack.filenameExt();
+
+    // The next track's worker carries on decoding it as the current one
+    std::swap(m_decodeWorker, m_nextWorker);
+    m_nextWorker->clear();
+
+    m_crossfadeState = CrossfadeState::Active;
+    startDecoding(m_nextDecoder, m_nextResampler);
+}
+
+void AudioPlaybackEngine::releaseCrossfadeTail()
+{
+    const auto state = std::exchange(m_crossfadeState, CrossfadeState::None);
+    if(state != CrossfadeState::Holding && state != CrossfadeState::Waiting) {
+        return;
+    }
+
+    if(m_crossfadeTail.isValid()) {
+        m_pendingAudio = std::exchange(m_crossfadeTail, {});
+    }
+
+    if(state == CrossfadeState::Waiting) {
+        m_pendingEndFrames = m_pendingAudio.frameCount();
+    }
+
+    if(!writePending()) {
+        if(state == CrossfadeState::Waiting) {
+            // Keep the buffer timer going until the rest of the tail and the end of the track are written
+            m_crossfadeState = CrossfadeState::Releasing;
+        }
+        return;
+    }
+
+    if(state == CrossfadeState::Waiting) {
+        m_bufferTimer.stop();
+    }
+}
+
+void AudioPlaybackEngine::cancelCrossfade()
+{
+    const auto state = std::exchange(m_crossfadeState, CrossfadeState::None);
+
+    m_crossfadeTail.reset();
+    m_crossfadeFader.reset();
+    m_pendingAudio.reset();
+    m_pendingEndFrames = -1;
+
+    if(state == CrossfadeState::Active) {
+        // Next track has been partly decoded, so it will need preparing again
+        resetNextTrack();
+    }
+}
+
+bool AudioPlaybackEngine::writePending()
+{
+    while(true) {
+        if(m_pendingEndFrames == 0) {
+            m_buffer->markEnd();
+            m_pendingEndFrames = -1;
+        }
+
+        const int available = m_pendingAudio.frameCount();
+        const int frames    = m_pendingEndFrames > 0 ? std::min(available, m_pendingEndFrames) : available;
+        if(frames <= 0) {
+            break;
+        }
+
+        const int written = m_buffer->write(m_pendingAudio.constData().data(), frames);
+        m_pendingAudio.erase(static_cast<size_t>(m_format.bytesForFrames(written)));
+        if(m_pendingEndFrames > 0) {
+            m_pendingEndFrames -= written;
+        }
+
+        if(written < frames) {
+            break;
+        }
+    }
+
+    if(m_pendingAudio.isValid() && m_pendingAudio.frameCount() == 0) {
+        m_pendingAudio.reset();
+    }
+
+    return !m_pendingAudio.isValid() && m_pendingEndFrames < 0;
+}
+
 void AudioPlaybackEngine::readNextBuffer()
 {
-    if(!m_decoder || m_totalBufferTime >= m_bufferLength) {
+    if(m_crossfadeState == CrossfadeState::Releasing) {
+        if(m_buffer && writePending()) {
+            m_crossfadeState = CrossfadeState::None;
+            m_bufferTimer.stop();
+        }
+        return;
+    }
+
+    if(m_crossfadeState == CrossfadeState::Waiting) {
+        // Mix once the next track's worker has decoded the whole fade, so mixing never waits on its decoder
+        if(m_nextFormat.isValid()
+           && (!m_nextWorker->isActive()
+               || m_nextWorker->hasBuffered(static_cast<uint64_t>(std::max(m_fadeIntervals.outChange, 0))))) {
+            startCrossfade();
+            return;
+        }
+        // Give up on crossfading if the next track isn't ready before the buffer runs out
+        if(m_buffer && m_format.durationForFrames(m_buffer->framesAvailable()) < MaxDecodeLength) {
+            releaseCrossfadeTail();
+        }
+        return;
+    }
+
+    const bool crossfading = m_crossfadeState == CrossfadeState::Active;
+
+    if(!m_decodeWorker->decoder() || !m_buffer) {
+        return;
+    }
+
+    // Anything left over from mixing comes before newly decoded audio
+    if(!writePending()) {
         return;
     }
 
-    const auto bytesToEnd = static_cast<size_t>(m_format.bytesForDuration(m_endPosition - m_lastPosition));
+    const uint64_t bufferedTime = m_format.durationForFrames(m_buffer->framesAvailable());
+    const int freeBytes         = m_format.bytesForFrames(m_buffer->framesFree());
+
+    if(bufferedTime >= m_bufferLength || freeBytes <= 0) {
+        return;
+    }
+
+    const auto bytesToEnd
+        = crossfading ? std::numeric_limits<size_t>::max()
+                      : static_cast<size_t>(m_format.bytesForDuration(m_endPosition - m_lastPosition));
     const auto bytesLeft
-        = std::min(bytesToEnd, static_cast<size_t>(m_format.bytesForDuration(m_bufferLength - m_totalBufferTime)));
-    const auto maxBytes = std::min(bytesLeft, static_cast<size_t>(m_format.bytesForDuration(MaxDecodeLength)));
+        = std::min(bytesToEnd, static_cast<size_t>(m_format.bytesForDuration(m_bufferLength - bufferedTime)));
+    const auto maxBytes = std::min({bytesLeft, static_cast<size_t>(m_format.bytesForDuration(MaxDecodeLength)),
+                                    static_cast<size_t>(freeBytes)});
+
+    // Decoded ahead on the worker thread, so this never waits on the decoder
+    auto buffer = m_decodeWorker->read(maxBytes);
+    if(!buffer.isValid() && !m_decodeWorker->atEnd()) {
+        return;
+    }
 
-    const auto buffer = m_decoder->readBuffer(maxBytes);
     if(buffer.isValid()) {
-        m_totalBufferTime += buffer.duration();
-        QMetaObject::invokeMethod(&m_renderer, [this, buffer]() { m_renderer.queueBuffer(buffer); });
+        if(crossfading && m_crossfadeFader.isFading()) {
+            m_crossfadeFader.process(buffer.data(), buffer.frameCount());
+        }
+
+        if(m_crossfadeState == CrossfadeState::None && canCrossfade()
+           && buffer.endTime() + m_fadeIntervals.outChange >= m_endPosition) {
+            m_crossfadeState = CrossfadeState::Holding;
+        }
+
+        if(m_crossfadeState == CrossfadeState::Holding) {
+            holdCrossfadeTail(buffer);
+        }
+        else {
+            m_buffer->write(buffer);
+        }
     }
 
     const bool endOfCueTrack = (m_currentTrack.hasCue() && buffer.endTime() >= m_endPosition);
 
     if(!buffer.isValid() || endOfCueTrack) {
-        m_bufferTimer.stop();
-        QMetaObject::invokeMethod(&m_renderer, [this]() { m_renderer.queueBuffer({}); });
+        if(crossfading) {
+            // Next track is shorter than the buffer, so wait until it's current to mark its end
+            m_bufferTimer.stop();
+            return;
+        }
+
+        if(m_crossfadeState == CrossfadeState::Holding) {
+            // Keep checking the buffer in case the next track is never prepared
+            m_crossfadeState = CrossfadeState::Waiting;
+        }
+        else {
+            m_bufferTimer.stop();
+            m_buffer->markEnd();
+        }
         m_ending = true;
         emit trackAboutToFinish();
     }
@@ -703,7 +1323,13 @@ void AudioPlaybackEngine::readNextBuffer()
 
 void AudioPlaybackEngine::updatePosition()
 {
-    const auto currentPosition = m_startPosition + m_clock.currentPosition();
+    const auto now = AudioClock::Clock::now();
+    // Keep the clock in step with what the output says is being heard
+    if(const auto audible = m_renderer.audiblePosition(now)) {
+        m_clock.correct(now, audible.value());
+    }
+
+    const auto currentPosition = m_startPosition + m_clock.positionFromTime(now);
     if(std::exchange(m_lastPosition, currentPosition) != m_lastPosition) {
         emit positionChanged(m_currentTrack, m_lastPosition - m_startPosition);
     }
@@ -712,18 +1338,22 @@ void AudioPlaybackEngine::updatePosition()
 void AudioPlaybackEngine::updateBitrate()
 {
     if(m_decoder) {
-        AudioEngine::updateBitrate(m_decoder->bitrate());
+        // The decoder is busy on the decode thread, which keeps a copy of its bitrate for us
+        AudioEngine::updateBitrate(m_decodeWorker->bitrate());
     }
 }
 
-void AudioPlaybackEngine::onBufferProcessed(const AudioBuffer& buffer)
-{
-    m_totalBufferTime -= buffer.duration();
-    emit bufferPlayed(buffer);
-}
-
 void AudioPlaybackEngine::onRendererFinished()
 {
+    if(m_crossfadeState == CrossfadeState::Active) {
+        // The next track is already playing, and will be switched to without stopping output
+        m_pauseNextTrack = false;
+        m_posTimer.stop();
+        m_clock.sync(0);
+        updateTrackStatus(TrackStatus::End);
+        return;
+    }
+
     if(m_pauseNextTrack) {
         m_pauseNextTrack = false;
         if(playbackState() == PlaybackState::FadingOut) {
@@ -19,16 +19,25 @@
 
 #pragma once
 
+#include "audiobufferpool.h"
 #include "audioclock.h"
+#include "audiofader.h"
 #include "audiorenderer.h"
+#include "audioringbuffer.h"
+#include "decodeworker.h"
+#include "ffmpeg/ffmpegresampler.h"
 #include "internalcoresettings.h"
 
+#include <core/engine/audiobuffer.h>
 #include <core/engine/audioengine.h>
 #include <core/engine/audioloader.h>
+#include <core/engine/audiotap.h>
 #include <core/track.h>
 
 #include <QBasicTimer>
-#include <QFile>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIODevice>
 
 namespace Fooyin {
 class SettingsManager;
@@ -52,6 +61,8 @@ public:
     void seek(uint64_t pos) override;
     void setVolume(double volume) override;
 
+    [[nodiscard]] std::shared_ptr<AudioTap> audioTap() const override;
+
     void setAudioOutput(const OutputCreator& output, const QString& device) override;
     void setOutputDevice(const QString& device) override;
 
@@ -61,11 +72,35 @@ protected:
     PlaybackState updateState(PlaybackState state) override;
 
 private:
+    enum class CrossfadeState : uint8_t
+    {
+        None = 0,
+        // Decoded audio near the end of the track is being held back to fade out
+        Holding,
+        // Track has finished decoding, waiting for the next track to be prepared
+        Waiting,
+        // Tracks have been mixed, and the next track is being decoded ahead of the switch
+        Active,
+        // Not crossfading, but the held back tail is still waiting for room in the buffer
+        Releasing
+    };
+
+    void setupWorker(DecodeWorker* worker);
+    void prepareNextDecoder(const Track& track);
+    void nextTrackPrepared();
     void resetNextTrack();
     AudioFormat loadPreparedTrack();
-    void resetWorkers(bool resetFade = true);
+    void switchToCrossfadedTrack();
+    void setupBuffer();
+    void resetWorkers(bool resetFade = true, uint64_t position = 0);
     void stopWorkers(bool full = false);
+    void startDecoding(AudioDecoder* decoder, std::shared_ptr<FFmpegResampler> resampler);
+    void seekDecoder(uint64_t pos);
+    [[nodiscard]] std::shared_ptr<FFmpegResampler> createResampler(const AudioFormat& decoderFormat) const;
+    void updateOutputRate();
     void startBitrateTimer();
+    void logBufferStats();
+    void updateDsps();
 
     void handleOutputState(AudioOutput::State outState);
     void reloadOutput();
@@ -74,10 +109,16 @@ private:
     void setupDuration();
     bool checkReadyToDecode();
 
+    [[nodiscard]] bool canCrossfade() const;
+    void holdCrossfadeTail(const AudioBuffer& buffer);
+    void startCrossfade();
+    void releaseCrossfadeTail();
+    void cancelCrossfade();
+    bool writePending();
+
     void readNextBuffer();
     void updatePosition();
     void updateBitrate();
-    void onBufferProcessed(const AudioBuffer& buffer);
     void onRendererFinished();
 
     [[nodiscard]] bool trackIsValid() const;
@@ -96,7 +137,6 @@ private:
     uint64_t m_endPosition;
     uint64_t m_lastPosition;
 
-    uint64_t m_totalBufferTime;
     uint64_t m_bufferLength;
 
     uint64_t m_duration;
@@ -105,30 +145,53 @@ private:
     bool m_decoding;
     bool m_updatingTrack;
     bool m_pauseNextTrack;
+    bool m_dspsLoaded;
+    bool m_nextStarted;
+    bool m_loadWhenPrepared;
     std::optional<PlaybackState> m_pendingState;
 
     AudioDecoder* m_decoder;
     AudioDecoder* m_nextDecoder;
     AudioFormat m_format;
     AudioFormat m_nextFormat;
+    std::shared_ptr<FFmpegResampler> m_resampler;
+    std::shared_ptr<FFmpegResampler> m_nextResampler;
+    // Sample rate the output ended up using for each decoder sample rate
+    QHash<int, int> m_outputRates;
 
     Track m_currentTrack;
     Track m_nextTrack;
     AudioSource m_source;
     AudioSource m_nextSource;
-    std::unique_ptr<QFile> m_file;
-    std::unique_ptr<QFile> m_nextFile;
+    std::unique_ptr<QIODevice> m_file;
+    std::unique_ptr<QIODevice> m_nextFile;
 
+    // Current track's decoding, and the next track's while it's being prepared
+    std::unique_ptr<DecodeWorker> m_decodeWorker;
+    std::unique_ptr<DecodeWorker> m_nextWorker;
+    std::shared_ptr<AudioRingBuffer> m_buffer;
     QThread* m_outputThread;
     AudioRenderer m_renderer;
+    std::shared_ptr<AudioTap> m_tap;
     QMetaObject::Connection m_pausedConnection;
 
     QBasicTimer m_posTimer;
     QBasicTimer m_bitrateTimer;
     QBasicTimer m_bufferTimer;
     QBasicTimer m_pauseTimer;
+    QBasicTimer m_poolStatsTimer;
+    QElapsedTimer m_poolStatsElapsed;
+    AudioBufferPool::Stats m_lastPoolStats;
 
     FadingIntervals m_fadeIntervals;
     std::optional<uint64_t> m_pendingSeek;
+
+    CrossfadeState m_crossfadeState;
+    AudioBuffer m_crossfadeTail;
+    AudioFader m_crossfadeFader;
+    // Audio which didn't fit in the buffer, written before anything else as room frees up
+    AudioBuffer m_pendingAudio;
+    // Frames of m_pendingAudio to write before marking the end of the track, or -1 if not ending
+    int m_pendingEndFrames;
 };
 } // namespace Fooyin
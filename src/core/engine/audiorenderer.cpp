@@ -26,9 +26,9 @@
 #include <core/engine/audioconverter.h>
 #include <core/engine/audioengine.h>
 #include <core/engine/audiooutput.h>
+#include <core/engine/audiotap.h>
 #include <core/playlist/playlist.h>
 #include <utils/settings/settingsmanager.h>
-#include <utils/threadqueue.h>
 
 #include <QBasicTimer>
 #include <QDebug>
@@ -36,6 +36,7 @@
 #include <QTimer>
 #include <QTimerEvent>
 
+#include <cstring>
 #include <utility>
 
 Q_LOGGING_CATEGORY(RENDERER, "fy.renderer")
@@ -43,15 +44,36 @@ Q_LOGGING_CATEGORY(RENDERER, "fy.renderer")
 using namespace std::chrono_literals;
 using namespace Qt::StringLiterals;
 
-constexpr auto FadeInterval = 10;
+// Attempts at reading the audible position while it's being written
+constexpr auto MaxPositionReads = 4;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+constexpr auto EventInterval = 10ms;
+#else
+constexpr auto EventInterval = 10;
+#endif
 
 namespace {
-void alignBufferOffset(int& bufferOffset, int oldBps, int newBps)
+Fooyin::FadeCurve fadeCurve(int fadeLength)
+{
+    // Short fades are too quick to benefit from easing in and out
+    return fadeLength >= 1000 ? Fooyin::FadeCurve::Erf : Fooyin::FadeCurve::Linear;
+}
+
+void prepareBuffer(Fooyin::AudioBuffer& buffer, const Fooyin::AudioFormat& format, int frames)
+{
+    if(!buffer.isValid() || buffer.format() != format) {
+        buffer = {format, 0};
+    }
+    buffer.resize(static_cast<size_t>(format.bytesForFrames(frames)));
+}
+
+void reserveBuffer(Fooyin::AudioBuffer& buffer, const Fooyin::AudioFormat& format, int frames)
 {
-    if(bufferOffset > 0 && oldBps > 0 && newBps > 0) {
-        const int frameIndex = bufferOffset / oldBps;
-        bufferOffset         = frameIndex * newBps;
+    if(!buffer.isValid() || buffer.format() != format) {
+        buffer = {format, 0};
     }
+    buffer.reserve(static_cast<size_t>(format.bytesForFrames(frames)));
 }
 } // namespace
 
@@ -60,20 +82,25 @@ AudioRenderer::AudioRenderer(SettingsManager* settings, QObject* parent)
     : QObject{parent}
     , m_settings{settings}
     , m_volume{0.0}
-    , m_gainScale{1.0}
     , m_bufferSize{0}
     , m_bufferPrefilled{false}
     , m_samplePos{0}
+    , m_framesRead{0}
     , m_currentBufferOffset{0}
+    , m_basePosition{0}
+    , m_framesRendered{0}
+    , m_positionSequence{0}
+    , m_positionValid{false}
+    , m_writtenPosition{0.0}
+    , m_writtenTime{0}
+    , m_positionStale{false}
     , m_isRunning{false}
+    , m_pullMode{false}
+    , m_bitPerfect{m_settings->value<Settings::Core::Internal::BitPerfect>()}
+    , m_bitPerfectSupported{false}
+    , m_tracksEnded{0}
+    , m_fadeOutEnded{false}
     , m_writeInterval{100}
-    , m_fadeLength{0}
-    , m_fadingOut{false}
-    , m_flipFade{false}
-    , m_fadeSteps{0}
-    , m_currentFadeStep{0}
-    , m_volumeChange{0.0}
-    , m_fadeVolume{-1}
 {
     setObjectName(u"Renderer"_s);
 
@@ -82,16 +109,20 @@ AudioRenderer::AudioRenderer(SettingsManager* settings, QObject* parent)
     m_settings->subscribe<Settings::Core::RGType>(this, &AudioRenderer::recalculateGain);
     m_settings->subscribe<Settings::Core::RGPreAmp>(this, &AudioRenderer::recalculateGain);
     m_settings->subscribe<Settings::Core::NonRGPreAmp>(this, &AudioRenderer::recalculateGain);
+    m_settings->subscribe<Settings::Core::Internal::BitPerfect>(this, &AudioRenderer::updateBitPerfect);
 }
 
 void AudioRenderer::init(const Track& track, const AudioFormat& format, bool forceReload)
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     const auto prevFormat = std::exchange(m_format, format);
 
-    m_currentTrack           = track;
-    m_currentBufferResampled = false;
-    m_bufferPrefilled        = false;
+    m_currentTrack    = track;
+    m_bufferPrefilled = false;
 
+    m_gainProcessor.setFormat(m_format);
+    m_dspChain.setFormat(m_format);
     calculateGain(false);
     const bool isGapless
         = !forceReload && m_settings->value<Settings::Core::GaplessPlayback>() && prevFormat == m_format;
@@ -104,37 +135,75 @@ void AudioRenderer::init(const Track& track, const AudioFormat& format, bool for
         m_audioOutput->uninit();
     }
 
-    for(auto& buffer : m_bufferQueue) {
-        buffer = Audio::convert(buffer, m_format);
-    }
-
     const bool success = (isGapless && m_audioOutput->initialised() && resetResampler()) || initOutput();
 
-    // Align offset in case format was changed
-    alignBufferOffset(m_currentBufferOffset, prevFormat.bytesPerFrame(), m_format.bytesPerFrame());
+    if(success && m_pendingBuffer.isValid() && m_pendingBuffer.format() != m_outputFormat) {
+        // Keep any processed samples not yet written in case the output format was changed
+        const auto remaining = m_pendingBuffer.constData().subspan(static_cast<size_t>(m_currentBufferOffset));
+        const AudioBuffer remainingBuffer{remaining, m_pendingBuffer.format(), m_pendingBuffer.startTime()};
+
+        m_pendingBuffer       = Audio::convert(remainingBuffer, m_outputFormat);
+        m_currentBufferOffset = 0;
+    }
+
+    if(success) {
+        reserveBuffers();
+    }
 
     emit initialised(success);
 }
 
+void AudioRenderer::updateTrack(const Track& track)
+{
+    const std::scoped_lock lock{m_renderMutex};
+
+    // Track was switched without reinitialising, so ramp to the new gain rather than jumping
+    m_currentTrack = track;
+    calculateGain(true);
+}
+
 void AudioRenderer::start()
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     m_isRunning = true;
+
+    if(m_pullMode) {
+        // Rendering can't signal from the output's thread, so check in on it from here
+        m_eventTimer.start(EventInterval, this);
+
+        // Output will request audio as needed
+        if(!m_bufferPrefilled && m_audioOutput && m_audioOutput->initialised()) {
+            m_bufferPrefilled = true;
+            m_audioOutput->start();
+        }
+        return;
+    }
+
     m_writeTimer.start(m_writeInterval, Qt::PreciseTimer, this);
 }
 
 void AudioRenderer::stop()
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     m_samplePos = 0;
     m_isRunning = false;
     m_writeTimer.stop();
+    m_eventTimer.stop();
+    m_tracksEnded.store(0, std::memory_order_relaxed);
+    m_fadeOutEnded.store(false, std::memory_order_relaxed);
 
-    resetFade(0);
+    m_fader.reset();
+    m_dspChain.reset();
     resetBuffer();
-    m_fadeVolume = -1;
+    m_basePosition = 0;
 }
 
 void AudioRenderer::closeOutput()
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     if(validOutputState()) {
         m_audioOutput->uninit();
     }
@@ -148,25 +217,47 @@ void AudioRenderer::drainOutput()
     }
 }
 
-void AudioRenderer::reset(bool stopFade)
+void AudioRenderer::reset(bool stopFade, uint64_t position)
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     if(validOutputState()) {
         m_audioOutput->reset();
     }
 
     resetBuffer();
+    m_dspChain.reset();
+    m_basePosition = static_cast<int64_t>(position);
+    // Anything rendered before the reset no longer applies
+    m_tracksEnded.store(0, std::memory_order_relaxed);
 
     if(stopFade) {
-        resetFade(0);
-        m_fadeVolume = -1;
+        m_fader.reset();
     }
 }
 
+void AudioRenderer::rebasePosition(uint64_t offset)
+{
+    const std::scoped_lock lock{m_renderMutex};
+
+    m_basePosition -= static_cast<int64_t>(offset);
+
+    publishPosition(m_positionValid.load(std::memory_order_relaxed),
+                    m_writtenPosition.load(std::memory_order_relaxed) - static_cast<double>(offset),
+                    TimePoint{Clock::duration{m_writtenTime.load(std::memory_order_relaxed)}});
+    m_positionStale.store(false, std::memory_order_release);
+}
+
 void AudioRenderer::play()
 {
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        m_fader.reset();
+    }
+
     if(validOutputState()) {
         m_audioOutput->setPaused(false);
-        m_audioOutput->setVolume(m_volume);
+        m_audioOutput->setVolume(outputVolume());
     }
 
     start();
@@ -174,72 +265,92 @@ void AudioRenderer::play()
 
 void AudioRenderer::play(int fadeLength)
 {
-    resetFade(fadeLength);
-    m_fadingOut = false;
+    if(m_bitPerfect) {
+        play();
+        return;
+    }
+
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        m_fader.fadeIn(m_outputFormat.framesForDuration(fadeLength), fadeCurve(fadeLength));
+    }
 
     if(validOutputState()) {
         m_audioOutput->setPaused(false);
     }
 
     start();
-
-    if(!m_flipFade && fadeLength > 0) {
-        m_fadeVolume   = std::max(m_fadeVolume, 0.0);
-        m_volumeChange = std::abs(m_fadeVolume - m_volume) / m_fadeSteps;
-    }
-    else {
-        m_volumeChange = -m_volumeChange;
-    }
-
-    m_fadeTimer.start(FadeInterval, this);
 }
 
 void AudioRenderer::pause()
 {
-    resetFade(0);
-    m_fadingOut = false;
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        m_fader.reset();
+    }
 
     pauseOutput();
 }
 
 void AudioRenderer::pause(int fadeLength)
 {
-    resetFade(fadeLength);
-    m_fadingOut = true;
+    if(m_bitPerfect) {
+        pause();
+        return;
+    }
 
-    if(!m_flipFade) {
-        if(m_fadeVolume <= 0) {
-            m_fadeVolume = m_volume;
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        if(m_isRunning) {
+            m_fader.fadeOut(m_outputFormat.framesForDuration(fadeLength), fadeCurve(fadeLength));
+            if(!m_fader.isSilent()) {
+                // Output is paused once the fade has been rendered
+                return;
+            }
+        }
+        else {
+            // Nothing is being rendered, so there's nothing to fade
+            m_fader.fadeOut(0, FadeCurve::Linear);
         }
-        m_volumeChange = -(m_fadeVolume / m_fadeSteps);
-    }
-    else {
-        m_volumeChange = -m_volumeChange;
     }
 
-    m_fadeTimer.start(FadeInterval, this);
+    pauseOutput();
 }
 
-void AudioRenderer::queueBuffer(const AudioBuffer& buffer)
+void AudioRenderer::setBuffer(std::shared_ptr<AudioRingBuffer> buffer)
 {
-    if(!buffer.isValid()) {
-        m_bufferQueue.push_back(buffer);
-        return;
-    }
+    const std::scoped_lock lock{m_renderMutex};
 
-    auto convertedBuffer = Audio::convert(buffer, m_format);
-    if(convertedBuffer.isValid()) {
-        m_bufferQueue.push_back(convertedBuffer);
-    }
+    resetBuffer();
+    m_buffer = std::move(buffer);
+    reserveBuffers();
+}
+
+void AudioRenderer::setTap(std::shared_ptr<AudioTap> tap)
+{
+    const std::scoped_lock lock{m_renderMutex};
+    m_tap = std::move(tap);
 }
 
 bool AudioRenderer::resetResampler()
 {
     m_outputFormat = m_audioOutput->format();
+    m_fader.setFormat(m_outputFormat);
+    if(m_tap) {
+        m_tap->setFormat(m_outputFormat);
+    }
 
     if(m_outputFormat.isValid() && m_outputFormat != m_format) {
-        m_resampler
-            = std::make_unique<FFmpegResampler>(m_format, m_outputFormat, m_format.durationForFrames(m_samplePos));
+        const uint64_t startTime = m_format.durationForFrames(m_samplePos);
+        if(m_preparedResampler && m_preparedResampler->inputFormat() == m_format
+           && m_preparedResampler->outputFormat() == m_outputFormat
+           && m_preparedResampler->quality() == resamplerQuality()) {
+            m_resampler = std::move(m_preparedResampler);
+            m_resampler->setStartTime(startTime);
+        }
+        else {
+            m_resampler = std::make_unique<FFmpegResampler>(m_format, m_outputFormat, startTime, resamplerQuality());
+        }
         if(!m_resampler->canResample()) {
             m_resampler.reset();
             return false;
@@ -252,6 +363,17 @@ bool AudioRenderer::resetResampler()
     return true;
 }
 
+ResamplerQuality AudioRenderer::resamplerQuality() const
+{
+    return static_cast<ResamplerQuality>(m_settings->value<Settings::Core::Internal::ResamplerQuality>());
+}
+
+double AudioRenderer::outputVolume() const
+{
+    // Volume is left to the device in bit-perfect mode
+    return m_bitPerfect ? 1.0 : m_volume;
+}
+
 void AudioRenderer::updateOutput(const OutputCreator& output, const QString& device)
 {
     auto newOutput = output();
@@ -259,6 +381,8 @@ void AudioRenderer::updateOutput(const OutputCreator& output, const QString& dev
         return;
     }
 
+    const std::scoped_lock lock{m_renderMutex};
+
     if(m_audioOutput && m_audioOutput->initialised()) {
         m_audioOutput->uninit();
         QObject::disconnect(m_audioOutput.get(), nullptr, this, nullptr);
@@ -270,6 +394,14 @@ void AudioRenderer::updateOutput(const OutputCreator& output, const QString& dev
     }
 
     m_bufferPrefilled = false;
+    m_pullMode = m_audioOutput->setRenderCallback(
+        [this](std::span<std::byte> data, double delay) { return pullAudio(data, delay); });
+    m_writeTimer.stop();
+
+    m_bitPerfectSupported = m_audioOutput->setBitPerfect(m_bitPerfect);
+
+    qCDebug(RENDERER) << "Using" << (m_pullMode ? "pull" : "push") << "mode for output";
+
     QObject::connect(m_audioOutput.get(), &AudioOutput::stateChanged, this, &AudioRenderer::handleStateChanged);
 }
 
@@ -279,6 +411,8 @@ void AudioRenderer::updateDevice(const QString& device)
         return;
     }
 
+    const std::scoped_lock lock{m_renderMutex};
+
     m_bufferPrefilled = false;
 
     if(m_audioOutput->initialised()) {
@@ -293,17 +427,97 @@ void AudioRenderer::updateVolume(double volume)
     m_volume = volume;
 
     if(validOutputState()) {
-        m_audioOutput->setVolume(m_volume);
+        m_audioOutput->setVolume(outputVolume());
+    }
+}
+
+void AudioRenderer::updateBitPerfect(bool enabled)
+{
+    {
+        const std::scoped_lock lock{m_renderMutex};
+
+        if(std::exchange(m_bitPerfect, enabled) == enabled) {
+            return;
+        }
+
+        qCInfo(RENDERER) << "Bit-perfect playback" << (enabled ? "enabled" : "disabled");
+
+        if(m_audioOutput) {
+            // Outputs only take this before being initialised
+            if(m_audioOutput->initialised()) {
+                m_audioOutput->uninit();
+            }
+            m_bitPerfectSupported = m_audioOutput->setBitPerfect(enabled);
+        }
+
+        m_bufferPrefilled = false;
+        m_fader.reset();
+        calculateGain(false);
     }
+
+    emit requestOutputReload();
+}
+
+void AudioRenderer::updateDspNodes(DspNodeList nodes)
+{
+    // Prepare outside the lock so rendering isn't held up by any allocations
+    auto stage = m_dspChain.prepareNodes(std::move(nodes));
+
+    // Nodes replaced previously are destroyed once the lock is released
+    DspNodeList retired;
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        m_dspChain.replaceNodes(std::move(stage));
+        retired = m_dspChain.takeRetiredNodes();
+    }
+}
+
+void AudioRenderer::prepareFormat(const AudioFormat& format)
+{
+    AudioFormat outputFormat;
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        if(!m_audioOutput || !m_audioOutput->initialised()) {
+            return;
+        }
+        outputFormat = m_audioOutput->format();
+    }
+
+    if(!outputFormat.isValid() || outputFormat == format) {
+        return;
+    }
+
+    // Build outside the lock, so setting up the resampler doesn't hold up rendering
+    auto resampler = std::make_unique<FFmpegResampler>(format, outputFormat, 0, resamplerQuality());
+    if(!resampler->canResample()) {
+        return;
+    }
+
+    // Any previously prepared resampler is destroyed once the lock is released
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        std::swap(m_preparedResampler, resampler);
+    }
+}
+
+AudioFormat AudioRenderer::outputFormat()
+{
+    const std::scoped_lock lock{m_renderMutex};
+
+    if(!m_audioOutput || !m_audioOutput->initialised()) {
+        return {};
+    }
+    return m_audioOutput->format();
 }
 
 void AudioRenderer::timerEvent(QTimerEvent* event)
 {
     if(event->timerId() == m_writeTimer.timerId()) {
         writeNext();
+        handleRenderEvents();
     }
-    else if(event->timerId() == m_fadeTimer.timerId()) {
-        handleFading();
+    else if(event->timerId() == m_eventTimer.timerId()) {
+        handleRenderEvents();
     }
 
     QObject::timerEvent(event);
@@ -311,71 +525,62 @@ void AudioRenderer::timerEvent(QTimerEvent* event)
 
 void AudioRenderer::resetBuffer()
 {
-    m_bufferPrefilled        = false;
-    m_samplePos              = 0;
-    m_currentBufferOffset    = 0;
-    m_currentBufferResampled = false;
-    m_bufferQueue            = {};
+    // The ring buffer itself is flushed by the producer
+    m_bufferPrefilled     = false;
+    m_samplePos           = 0;
+    m_framesRead          = 0;
+    m_currentBufferOffset = 0;
+    m_pendingBuffer.clear();
     m_tempBuffer.reset();
+    if(m_tap) {
+        m_tap->clear();
+    }
+    resetPosition();
 }
 
-void AudioRenderer::resetFade(int length)
+void AudioRenderer::reserveBuffers()
 {
-    if(m_fadeTimer.isActive()) {
-        m_fadeTimer.stop();
+    if(!m_format.isValid() || !m_outputFormat.isValid() || m_bufferSize <= 0) {
+        return;
     }
 
-    m_flipFade   = !m_flipFade && m_currentFadeStep > 0 && length > 0;
-    m_fadeLength = length;
+    // Rendering may happen on the output's real-time thread, so make sure it never has to allocate.
+    // Outputs may ask for more than their buffer size at once, so leave plenty of headroom.
+    const int outputFrames = m_bufferSize * 2;
+    const int inputFrames
+        = static_cast<int>(static_cast<int64_t>(outputFrames) * m_format.sampleRate() / m_outputFormat.sampleRate())
+        + 1;
+    const int frames = std::max(outputFrames, inputFrames);
 
-    if(!m_flipFade) {
-        m_fadeSteps       = static_cast<int>(static_cast<double>(length) / FadeInterval);
-        m_currentFadeStep = 0;
-        m_volumeChange    = 0;
+    if(m_buffer && m_buffer->format() != m_format) {
+        reserveBuffer(m_readBuffer, m_buffer->format(), frames);
     }
+    reserveBuffer(m_processBuffer, m_format, frames);
+    reserveBuffer(m_pendingBuffer, m_outputFormat, frames);
 }
 
-void AudioRenderer::handleFading()
+void AudioRenderer::finishFadeOut()
 {
-    auto updateOutputVolume = [this]() {
-        if(validOutputState()) {
-            m_audioOutput->setVolume(m_fadeSteps > 0 && m_fadeVolume >= 0 ? m_fadeVolume : m_volume);
+    {
+        const std::scoped_lock lock{m_renderMutex};
+        if(!m_fader.isSilent()) {
+            // Playback resumed before the fade out was handled
+            return;
         }
-    };
-
-    const auto currentStep = m_currentFadeStep;
-    const bool inFade      = m_flipFade ? m_currentFadeStep-- >= 0 : m_currentFadeStep++ <= m_fadeSteps;
+    }
 
-    if(inFade) {
-        if(m_fadeLength >= 1000) {
-            const auto step = static_cast<double>(currentStep) / m_fadeSteps;
-            m_fadeVolume    = m_volume * ((1.0 + std::erf(3.0 * step - 1.5)) / 2.0);
-            if(m_flipFade ^ m_fadingOut) {
-                m_fadeVolume = m_volume - m_fadeVolume;
-            }
-        }
-        else {
-            m_fadeVolume += m_volumeChange;
-        }
+    pauseOutput();
+}
 
-        m_fadeVolume = std::clamp(m_fadeVolume, 0.0, 1.0);
-        updateOutputVolume();
-        return;
+void AudioRenderer::handleRenderEvents()
+{
+    for(int ended = m_tracksEnded.exchange(0, std::memory_order_acq_rel); ended > 0; --ended) {
+        emit finished();
     }
 
-    if(m_volumeChange < 0.0) {
-        // Faded out
-        pauseOutput();
-    }
-    else {
-        m_fadeVolume = -1;
+    if(m_fadeOutEnded.exchange(false, std::memory_order_acq_rel)) {
+        finishFadeOut();
     }
-
-    m_currentFadeStep = 0;
-    m_flipFade        = false;
-
-    updateOutputVolume();
-    m_fadeTimer.stop();
 }
 
 bool AudioRenderer::canWrite() const
@@ -385,15 +590,32 @@ bool AudioRenderer::canWrite() const
 
 bool AudioRenderer::initOutput()
 {
+    if(m_bitPerfect && !m_bitPerfectSupported) {
+        const QString message = tr("Bit-perfect playback isn't supported by the current output");
+        qCWarning(RENDERER) << message;
+        emit error(message);
+        return false;
+    }
+
     if(!m_audioOutput->init(m_format)) {
         return false;
     }
 
+    if(m_bitPerfect && m_audioOutput->format() != m_format) {
+        // Shouldn't happen, but never let the output's fallback slip through
+        const QString message = tr("Bit-perfect playback isn't possible: the device offered %1 for %2")
+                                    .arg(m_audioOutput->format().prettyFormat(), m_format.prettyFormat());
+        qCWarning(RENDERER) << message;
+        emit error(message);
+        m_audioOutput->uninit();
+        return false;
+    }
+
     if(!resetResampler()) {
         return false;
     }
 
-    m_audioOutput->setVolume(m_volume);
+    m_audioOutput->setVolume(outputVolume());
     m_bufferSize = m_audioOutput->bufferSize();
     updateInterval();
 
@@ -425,14 +647,18 @@ void AudioRenderer::updateInterval()
 
 void AudioRenderer::recalculateGain()
 {
+    const std::scoped_lock lock{m_renderMutex};
     calculateGain(true);
 }
 
-void AudioRenderer::calculateGain(bool reloadIfChanged)
+void AudioRenderer::calculateGain(bool ramp)
 {
-    const double prevGain = std::exchange(m_gainScale, 1.0);
+    double gainScale{1.0};
+    bool limit{false};
 
-    if(!m_currentTrack.isValid()) {
+    if(m_bitPerfect || !m_currentTrack.isValid()) {
+        m_gainProcessor.setGain(gainScale, !ramp);
+        m_gainProcessor.setLimiterEnabled(limit);
         return;
     }
 
@@ -491,35 +717,35 @@ void AudioRenderer::calculateGain(bool reloadIfChanged)
                          : m_settings->value<Settings::Core::NonRGPreAmp>();
 
         if(mode & AudioEngine::ApplyGain) {
-            m_gainScale = std::pow(10.0, gain / 20.0);
+            gainScale = std::pow(10.0, gain / 20.0);
         }
 
         if((mode & AudioEngine::PreventClipping) && havePeak) {
-            m_gainScale = (m_gainScale * peak) > 1.0 ? (1.0 / peak) : m_gainScale;
+            gainScale = (gainScale * peak) > 1.0 ? (1.0 / peak) : gainScale;
         }
 
-        m_gainScale = std::clamp(m_gainScale, 0.1, 10.0); // Clamp to +-20 dB
-    }
+        gainScale = std::clamp(gainScale, 0.1, 10.0); // Clamp to +-20 dB
 
-    if(m_gainScale != 1.0) {
-        m_format.setSampleFormat(SampleFormat::F64);
+        // Catch anything the stored peak misses, or tracks without one
+        limit = (mode & AudioEngine::PreventClipping) && gainScale > 1.0;
     }
 
-    if(reloadIfChanged && (prevGain == 1.0) ^ (m_gainScale == 1.0)) {
-        emit requestOutputReload();
-    }
+    m_gainProcessor.setGain(gainScale, !ramp);
+    m_gainProcessor.setLimiterEnabled(limit);
 }
 
 void AudioRenderer::pauseOutput()
 {
+    const std::scoped_lock lock{m_renderMutex};
+
     m_isRunning = false;
     m_writeTimer.stop();
-
-    m_fadeVolume = -1;
+    m_eventTimer.stop();
 
     if(validOutputState()) {
         const auto state       = m_audioOutput->currentState();
-        const uint64_t durLeft = m_outputFormat.durationForFrames(state.queuedSamples);
+        const uint64_t durLeft = state.delay >= 0 ? static_cast<uint64_t>(state.delay * 1000)
+                                                  : m_outputFormat.durationForFrames(state.queuedSamples);
 
         emit paused(durLeft);
         drainOutput();
@@ -537,16 +763,20 @@ void AudioRenderer::writeNext()
         return;
     }
 
-    if(m_bufferQueue.empty()) {
-        qCDebug(RENDERER) << "Unable to write next buffer: Empty buffer queue";
+    if(!hasBufferedAudio()) {
+        qCDebug(RENDERER) << "Unable to write next buffer: Empty buffer";
         return;
     }
 
+    const auto state      = m_audioOutput->currentState();
     const int bps         = m_outputFormat.bytesPerFrame();
-    const int freeSamples = (m_audioOutput->currentState().freeSamples / bps) * bps;
+    const int freeSamples = (state.freeSamples / bps) * bps;
+    // Fall back to what's queued if the output can't say how long it'll be until what's written next is heard
+    const double delay = state.delay >= 0 ? state.delay
+                                          : static_cast<double>(state.queuedSamples) / m_outputFormat.sampleRate();
 
     const bool hasPrevWrite = (freeSamples == 0 && m_samplePos > 0);
-    const bool bufferFilled = (freeSamples > 0 && renderAudio(freeSamples) == freeSamples);
+    const bool bufferFilled = (freeSamples > 0 && renderAudio(freeSamples, delay) == freeSamples);
 
     if(hasPrevWrite || bufferFilled) {
         if(canWrite() && !m_bufferPrefilled) {
@@ -556,68 +786,153 @@ void AudioRenderer::writeNext()
     }
 }
 
-int AudioRenderer::writeAudioSamples(int samples)
+bool AudioRenderer::hasBufferedAudio() const
 {
-    m_tempBuffer = {};
-    int samplesBuffered{0};
+    if(m_pendingBuffer.byteCount() - m_currentBufferOffset > 0) {
+        return true;
+    }
 
-    while(m_isRunning && !m_bufferQueue.empty() && samplesBuffered < samples) {
-        AudioBuffer& buffer = m_bufferQueue.front();
+    return m_buffer && (m_buffer->framesAvailable() > 0 || m_buffer->hasEnd());
+}
 
-        if(!buffer.isValid()) {
-            // End of file
-            m_currentBufferOffset    = 0;
-            m_currentBufferResampled = false;
-            m_bufferQueue.pop_front();
-            emit finished();
-            return samplesBuffered;
-        }
+bool AudioRenderer::readNextChunk(int samples)
+{
+    if(!m_buffer) {
+        return false;
+    }
 
-        if(!m_currentBufferResampled) {
-            m_currentBufferResampled = true;
-            buffer.scale(m_gainScale);
+    const AudioFormat inputFormat = m_buffer->format();
 
-            if(m_resampler) {
-                buffer = m_resampler->resample(buffer);
-            }
-        }
+    // Only read as much as needed to fill the requested output samples
+    int frames = samples;
+    if(m_resampler && m_outputFormat.sampleRate() > 0) {
+        const auto inputSamples = static_cast<int64_t>(samples) * inputFormat.sampleRate();
+        frames                  = static_cast<int>(inputSamples / m_outputFormat.sampleRate()) + 1;
+    }
+    frames = std::min(frames, m_buffer->framesAvailable());
 
-        const int bytesLeft = buffer.byteCount() - m_currentBufferOffset;
+    if(frames <= 0) {
+        return false;
+    }
 
-        if(bytesLeft <= 0) {
-            m_currentBufferOffset    = 0;
-            m_currentBufferResampled = false;
-            emit bufferProcessed(buffer);
-            m_bufferQueue.pop_front();
-            continue;
+    const bool needsConversion = inputFormat != m_format;
+    AudioBuffer& target        = needsConversion ? m_readBuffer : m_processBuffer;
+
+    prepareBuffer(target, inputFormat, frames);
+    frames = m_buffer->read(target.data(), frames);
+    if(frames <= 0) {
+        return false;
+    }
+
+    if(needsConversion) {
+        prepareBuffer(m_processBuffer, m_format, frames);
+        if(!Audio::convert(inputFormat, m_readBuffer.constData().data(), m_format, m_processBuffer.data(), frames)) {
+            return false;
         }
+    }
+    else {
+        m_processBuffer.resize(static_cast<size_t>(m_format.bytesForFrames(frames)));
+    }
+
+    m_processBuffer.setStartTime(inputFormat.durationForFrames(m_framesRead));
+    m_framesRead += frames;
+
+    if(!m_bitPerfect) {
+        m_gainProcessor.process(m_processBuffer);
+        m_dspChain.process(m_processBuffer);
+    }
+
+    // Both buffers keep their storage, so nothing is allocated here once they've been reserved
+    if(m_resampler) {
+        m_resampler->resample(m_processBuffer, m_pendingBuffer);
+    }
+    else {
+        std::swap(m_pendingBuffer, m_processBuffer);
+    }
+    m_currentBufferOffset = 0;
+
+    return true;
+}
+
+int AudioRenderer::renderSamples(std::byte* data, int samples)
+{
+    const int sstride = m_outputFormat.bytesPerFrame();
+    if(!data || sstride <= 0) {
+        return 0;
+    }
 
-        const int sstride     = m_outputFormat.bytesPerFrame();
-        const int sampleCount = std::min(bytesLeft / sstride, samples - samplesBuffered);
-        const int bytes       = sampleCount * sstride;
-        const auto fdata      = buffer.constData().subspan(m_currentBufferOffset, static_cast<size_t>(bytes));
+    int samplesBuffered{0};
 
-        if(!m_tempBuffer.isValid()) {
-            m_tempBuffer = {fdata, buffer.format(), buffer.startTime()};
+    while(m_isRunning && !m_fader.isSilent() && samplesBuffered < samples) {
+        const int bytesLeft = m_pendingBuffer.byteCount() - m_currentBufferOffset;
+
+        if(bytesLeft < sstride) {
+            if(!readNextChunk(samples - samplesBuffered)) {
+                if(m_buffer && m_buffer->takeEnd()) {
+                    // End of track
+                    m_pendingBuffer.clear();
+                    m_currentBufferOffset = 0;
+                    m_framesRead          = 0;
+                    m_basePosition        = 0;
+                    m_framesRendered      = 0;
+                    m_tracksEnded.fetch_add(1, std::memory_order_release);
+
+                    if(m_fader.isFadingOut()) {
+                        // Nothing left to fade
+                        m_fader.fadeOut(0, FadeCurve::Linear);
+                    }
+                    else if(m_buffer->framesAvailable() > 0) {
+                        // Crossfading into the next track
+                        continue;
+                    }
+                }
+                break;
+            }
+            continue;
         }
-        else {
-            m_tempBuffer.append(fdata);
+
+        int sampleCount = std::min(bytesLeft / sstride, samples - samplesBuffered);
+        if(m_fader.isFadingOut()) {
+            // Stop on the last sample of the fade, keeping the rest for when playback resumes
+            sampleCount = std::min(sampleCount, m_fader.framesRemaining());
         }
 
+        const int bytes   = sampleCount * sstride;
+        std::byte* output = data + static_cast<ptrdiff_t>(samplesBuffered) * sstride;
+
+        std::memcpy(output, m_pendingBuffer.constData().data() + m_currentBufferOffset, static_cast<size_t>(bytes));
+        m_fader.process(output, sampleCount);
+
         samplesBuffered += sampleCount;
         m_currentBufferOffset += bytes;
+        m_framesRendered += static_cast<uint64_t>(sampleCount);
     }
 
-    m_tempBuffer.fillRemainingWithSilence();
+    if(m_isRunning && m_fader.isSilent()) {
+        m_isRunning = false;
+        // May be called from the output's thread, so leave pausing to ours
+        m_fadeOutEnded.store(true, std::memory_order_release);
+    }
 
-    if(!m_tempBuffer.isValid()) {
+    return samplesBuffered;
+}
+
+int AudioRenderer::writeAudioSamples(int samples)
+{
+    if(!m_outputFormat.isValid() || samples <= 0) {
         return 0;
     }
 
+    m_tempBuffer = {m_outputFormat, m_pendingBuffer.isValid() ? m_pendingBuffer.startTime() : 0};
+    m_tempBuffer.resize(static_cast<size_t>(m_outputFormat.bytesForFrames(samples)));
+
+    const int samplesBuffered = renderSamples(m_tempBuffer.data(), samples);
+    m_tempBuffer.resize(static_cast<size_t>(m_outputFormat.bytesForFrames(samplesBuffered)));
+
     return samplesBuffered;
 }
 
-int AudioRenderer::renderAudio(int samples)
+int AudioRenderer::renderAudio(int samples, double delay)
 {
     if(writeAudioSamples(samples) == 0) {
         return 0;
@@ -630,8 +945,141 @@ int AudioRenderer::renderAudio(int samples)
     const int samplesWritten = m_audioOutput->write(m_tempBuffer);
     m_samplePos += samplesWritten;
 
+    if(samplesWritten > 0) {
+        const auto bytes = static_cast<size_t>(m_outputFormat.bytesForFrames(samplesWritten));
+        audioWritten(m_tempBuffer.constData().first(bytes), delay);
+    }
+
     return samplesWritten;
 }
+
+int AudioRenderer::pullAudio(std::span<std::byte> data, double delay)
+{
+    // Called from the output's thread, so never wait on the renderer
+    const std::unique_lock lock{m_renderMutex, std::try_to_lock};
+    if(!lock.owns_lock() || !m_isRunning) {
+        return 0;
+    }
+
+    const int sstride = m_outputFormat.bytesPerFrame();
+    if(sstride <= 0) {
+        return 0;
+    }
+
+    const int samples = renderSamples(data.data(), static_cast<int>(data.size()) / sstride);
+
+    if(samples > 0) {
+        m_samplePos += samples;
+        if(delay < 0 && m_outputFormat.sampleRate() > 0) {
+            // What's asked for is heard once the rest of the output's buffer has played
+            delay = static_cast<double>(std::max(m_bufferSize - samples, 0)) / m_outputFormat.sampleRate();
+        }
+        audioWritten(data.first(static_cast<size_t>(samples) * sstride), delay);
+    }
+
+    return samples;
+}
+
+double AudioRenderer::renderedPosition() const
+{
+    double rendered = static_cast<double>(m_framesRendered) * 1000.0 / m_outputFormat.sampleRate();
+
+    // Nodes such as the limiter hold audio back, so what's coming out is behind what's been rendered
+    if(!m_bitPerfect && m_format.sampleRate() > 0) {
+        rendered -= static_cast<double>(m_dspChain.latency()) * 1000.0 / m_format.sampleRate();
+    }
+
+    return static_cast<double>(m_basePosition) + std::max(rendered, 0.0);
+}
+
+void AudioRenderer::audioWritten(std::span<const std::byte> data, double delay)
+{
+    const int sampleRate = m_outputFormat.sampleRate();
+    const int bps        = m_outputFormat.bytesPerFrame();
+    if(sampleRate <= 0 || bps <= 0) {
+        return;
+    }
+
+    const auto frames = static_cast<double>(data.size() / static_cast<size_t>(bps));
+    const auto now    = Clock::now();
+
+    const auto toClock = [](double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{seconds});
+    };
+
+    // Data was rendered up to the current position, and starts being heard once the delay has passed
+    const double endPosition = renderedPosition();
+    const TimePoint playTime = now + toClock(std::max(delay, 0.0));
+    const TimePoint endTime  = playTime + toClock(frames / sampleRate);
+
+    if(!m_positionStale.load(std::memory_order_acquire)) {
+        publishPosition(true, endPosition, endTime);
+    }
+
+    if(m_tap) {
+        const double startPosition = endPosition - (frames * 1000.0 / sampleRate);
+        m_tap->write(data, static_cast<uint64_t>(std::max(startPosition, 0.0)), playTime);
+    }
+}
+
+void AudioRenderer::resetPosition()
+{
+    m_framesRendered = 0;
+
+    publishPosition(false, 0.0, {});
+    m_positionStale.store(false, std::memory_order_release);
+}
+
+void AudioRenderer::publishPosition(bool valid, double position, TimePoint time)
+{
+    const uint32_t sequence = m_positionSequence.load(std::memory_order_relaxed);
+    m_positionSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_positionValid.store(valid, std::memory_order_relaxed);
+    m_writtenPosition.store(position, std::memory_order_relaxed);
+    m_writtenTime.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+    m_positionSequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::optional<uint64_t> AudioRenderer::audiblePosition(TimePoint now) const
+{
+    for(int attempt{0}; attempt < MaxPositionReads; ++attempt) {
+        const uint32_t sequence = m_positionSequence.load(std::memory_order_acquire);
+        if(sequence % 2 != 0) {
+            continue;
+        }
+        const bool valid             = m_positionValid.load(std::memory_order_relaxed);
+        const double writtenPosition = m_writtenPosition.load(std::memory_order_relaxed);
+        const TimePoint writtenTime{Clock::duration{m_writtenTime.load(std::memory_order_relaxed)}};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(m_positionSequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if(!valid || m_positionStale.load(std::memory_order_acquire)) {
+            return {};
+        }
+
+        // Everything written so far has been heard once the end time has passed
+        const auto untilEnd
+            = std::chrono::duration<double, std::milli>{std::max(writtenTime - now, Clock::duration{})};
+        const double position = writtenPosition - untilEnd.count();
+        if(position < 0) {
+            // Still hearing the end of the previous track
+            return {};
+        }
+
+        return static_cast<uint64_t>(position);
+    }
+
+    // Kept being written to, so try again next time
+    return {};
+}
+
+void AudioRenderer::invalidatePosition()
+{
+    m_positionStale.store(true, std::memory_order_release);
+}
 } // namespace Fooyin
 
 #include "moc_audiorenderer.cpp"
@@ -22,16 +22,24 @@
 #include <core/engine/audiooutput.h>
 #include <core/track.h>
 
+#include "audiofader.h"
+#include "audioringbuffer.h"
+#include "dspchain.h"
 #include "ffmpeg/ffmpegresampler.h"
+#include "gainprocessor.h"
 
 #include <QBasicTimer>
 #include <QObject>
 
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
 
 namespace Fooyin {
 class AudioBuffer;
 class AudioFormat;
+class AudioTap;
 class SettingsManager;
 
 class AudioRenderer : public QObject
@@ -39,26 +47,61 @@ class AudioRenderer : public QObject
     Q_OBJECT
 
 public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
     explicit AudioRenderer(SettingsManager* settings, QObject* parent = nullptr);
 
     void init(const Track& track, const AudioFormat& format, bool forceReload = false);
+    void updateTrack(const Track& track);
     void start();
     void stop();
     void closeOutput();
     void drainOutput();
-    void reset(bool stopFade);
+    /** Discards buffered audio, with what's rendered next starting at @p position (ms) in the track. */
+    void reset(bool stopFade, uint64_t position = 0);
+    /*!
+     * Moves the start of the track @p offset ms further into the stream, for when a new track starts part way
+     * through it (e.g. the next track of a cue sheet).
+     */
+    void rebasePosition(uint64_t offset);
 
     void play();
     void play(int fadeLength);
     void pause();
     void pause(int fadeLength);
 
-    void queueBuffer(const AudioBuffer& buffer);
+    void setBuffer(std::shared_ptr<AudioRingBuffer> buffer);
+    /** Sets the tap which is given everything sent to the output. */
+    void setTap(std::shared_ptr<AudioTap> tap);
 
-    bool resetResampler();
     void updateOutput(const OutputCreator& output, const QString& device);
     void updateDevice(const QString& device);
     void updateVolume(double volume);
+    void updateDspNodes(DspNodeList nodes);
+    /*!
+     * Plays audio exactly as decoded: the output is opened at the track's format, and gain, DSPs, fades and
+     * software volume are bypassed. Playback fails with an error if the output can't provide this.
+     */
+    void updateBitPerfect(bool enabled);
+    /** Builds a resampler for @p format ahead of the track which uses it. */
+    void prepareFormat(const AudioFormat& format);
+
+    /** Returns the format the output was opened with, or an invalid format if it isn't initialised. */
+    [[nodiscard]] AudioFormat outputFormat();
+
+    /*!
+     * Returns the position (ms) in the track of what's heard at @p now, worked out from the delay reported by
+     * the output, or nothing if it isn't known yet.
+     * @note this is thread-safe.
+     */
+    [[nodiscard]] std::optional<uint64_t> audiblePosition(TimePoint now = Clock::now()) const;
+    /*!
+     * Stops reporting an audible position until the next reset, so a caller which has just queued one doesn't
+     * pick up positions from before it.
+     * @note this is thread-safe.
+     */
+    void invalidatePosition();
 
 signals:
     void initialised(bool success);
@@ -66,7 +109,6 @@ signals:
     void outputClosed();
     void outputStateChanged(AudioOutput::State state);
     void requestOutputReload();
-    void bufferProcessed(const Fooyin::AudioBuffer& buffer);
     void error(const QString& error);
     void finished();
 
@@ -75,24 +117,36 @@ protected:
 
 private:
     void resetBuffer();
-    void resetFade(int length);
-    void handleFading();
+    void reserveBuffers();
+    void finishFadeOut();
+    void handleRenderEvents();
 
     [[nodiscard]] bool canWrite() const;
 
     bool initOutput();
+    bool resetResampler();
+    [[nodiscard]] double outputVolume() const;
+    [[nodiscard]] ResamplerQuality resamplerQuality() const;
 
     [[nodiscard]] bool validOutputState() const;
     void handleStateChanged(AudioOutput::State state);
     void updateInterval();
     void recalculateGain();
-    void calculateGain(bool reloadIfChanged);
+    void calculateGain(bool ramp);
     void checkNeedResampling();
 
     void pauseOutput();
     void writeNext();
+    [[nodiscard]] bool hasBufferedAudio() const;
+    bool readNextChunk(int samples);
+    int renderSamples(std::byte* data, int samples);
     int writeAudioSamples(int samples);
-    int renderAudio(int samples);
+    int renderAudio(int samples, double delay);
+    int pullAudio(std::span<std::byte> data, double delay);
+    [[nodiscard]] double renderedPosition() const;
+    void audioWritten(std::span<const std::byte> data, double delay);
+    void resetPosition();
+    void publishPosition(bool valid, double position, TimePoint time);
 
     SettingsManager* m_settings;
     std::unique_ptr<AudioOutput> m_audioOutput;
@@ -100,30 +154,52 @@ private:
     AudioFormat m_format;
     AudioFormat m_outputFormat;
     double m_volume;
-    double m_gainScale;
+    GainProcessor m_gainProcessor;
+    DspChain m_dspChain;
+    AudioFader m_fader;
     int m_bufferSize;
     bool m_bufferPrefilled;
     std::unique_ptr<FFmpegResampler> m_resampler;
+    std::unique_ptr<FFmpegResampler> m_preparedResampler;
 
-    std::deque<AudioBuffer> m_bufferQueue;
+    std::shared_ptr<AudioRingBuffer> m_buffer;
+    std::shared_ptr<AudioTap> m_tap;
+    AudioBuffer m_readBuffer;
+    AudioBuffer m_processBuffer;
+    AudioBuffer m_pendingBuffer;
     AudioBuffer m_tempBuffer;
     int m_samplePos;
+    int m_framesRead;
     int m_currentBufferOffset;
-    bool m_currentBufferResampled;
+
+    // Track position (ms) at the start of the stream, and output frames rendered since
+    int64_t m_basePosition;
+    uint64_t m_framesRendered;
+
+    // Track position (ms) at the end of the last write, and when it will be heard.
+    // Written while rendering (possibly on the output's real-time thread), so guarded by a sequence count rather
+    // than a lock. Only written with the render mutex held.
+    std::atomic<uint32_t> m_positionSequence;
+    std::atomic<bool> m_positionValid;
+    std::atomic<double> m_writtenPosition;
+    std::atomic<Clock::rep> m_writtenTime;
+    // Set from other threads to ignore positions until the next reset
+    std::atomic<bool> m_positionStale;
 
     bool m_isRunning;
+    bool m_pullMode;
+    bool m_bitPerfect;
+    bool m_bitPerfectSupported;
     QString m_lastDeviceError;
+    // Guards render state when audio is pulled from the output's thread
+    std::mutex m_renderMutex;
+
+    // Set while rendering, which may be on the output's real-time thread, and handled on ours
+    std::atomic<int> m_tracksEnded;
+    std::atomic<bool> m_fadeOutEnded;
 
     QBasicTimer m_writeTimer;
+    QBasicTimer m_eventTimer;
     int m_writeInterval;
-
-    QBasicTimer m_fadeTimer;
-    int m_fadeLength;
-    bool m_fadingOut;
-    bool m_flipFade;
-    int m_fadeSteps;
-    int m_currentFadeStep;
-    double m_volumeChange;
-    double m_fadeVolume;
 };
 } // namespace Fooyin
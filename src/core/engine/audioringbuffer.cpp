@@ -0,0 +1,191 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audioringbuffer.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Fooyin {
+AudioRingBuffer::AudioRingBuffer(const AudioFormat& format, int frameCapacity)
+    : m_format{format}
+    , m_bytesPerFrame{format.bytesPerFrame()}
+    , m_capacity{static_cast<uint64_t>(std::max(frameCapacity, 0)) * m_bytesPerFrame}
+    , m_writePos{0}
+    , m_readPos{0}
+    , m_flushPos{NoPosition}
+    , m_endPos{NoPosition}
+{
+    m_data.resize(m_capacity);
+}
+
+AudioFormat AudioRingBuffer::format() const
+{
+    return m_format;
+}
+
+int AudioRingBuffer::frameCapacity() const
+{
+    return m_bytesPerFrame > 0 ? static_cast<int>(m_capacity / m_bytesPerFrame) : 0;
+}
+
+int AudioRingBuffer::framesAvailable() const
+{
+    if(m_bytesPerFrame <= 0) {
+        return 0;
+    }
+
+    const uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    uint64_t readPos        = m_readPos.load(std::memory_order_acquire);
+
+    // Frames before a pending flush will never be read
+    const uint64_t flushPos = m_flushPos.load(std::memory_order_acquire);
+    if(flushPos != NoPosition) {
+        readPos = std::max(readPos, flushPos);
+    }
+
+    return static_cast<int>((writePos - std::min(readPos, writePos)) / m_bytesPerFrame);
+}
+
+int AudioRingBuffer::framesFree() const
+{
+    if(m_bytesPerFrame <= 0) {
+        return 0;
+    }
+
+    const uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    const uint64_t readPos  = m_readPos.load(std::memory_order_acquire);
+
+    return static_cast<int>((m_capacity - (writePos - readPos)) / m_bytesPerFrame);
+}
+
+bool AudioRingBuffer::hasEnd() const
+{
+    return m_endPos.load(std::memory_order_acquire) != NoPosition;
+}
+
+int AudioRingBuffer::write(const AudioBuffer& buffer)
+{
+    if(!buffer.isValid() || buffer.format() != m_format) {
+        return 0;
+    }
+
+    return write(buffer.data(), buffer.frameCount());
+}
+
+int AudioRingBuffer::write(const std::byte* data, int frameCount)
+{
+    if(!data || frameCount <= 0) {
+        return 0;
+    }
+
+    const uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+    const uint64_t readPos  = m_readPos.load(std::memory_order_acquire);
+
+    const uint64_t free  = m_capacity - (writePos - readPos);
+    const uint64_t bytes = std::min(free, static_cast<uint64_t>(frameCount) * m_bytesPerFrame);
+
+    if(bytes == 0) {
+        return 0;
+    }
+
+    const uint64_t offset = writePos % m_capacity;
+    const uint64_t first  = std::min(bytes, m_capacity - offset);
+
+    std::memcpy(m_data.data() + offset, data, first);
+    if(first < bytes) {
+        std::memcpy(m_data.data(), data + first, bytes - first);
+    }
+
+    m_writePos.store(writePos + bytes, std::memory_order_release);
+
+    return static_cast<int>(bytes / m_bytesPerFrame);
+}
+
+void AudioRingBuffer::markEnd()
+{
+    m_endPos.store(m_writePos.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void AudioRingBuffer::flush()
+{
+    m_endPos.store(NoPosition, std::memory_order_release);
+    m_flushPos.store(m_writePos.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+int AudioRingBuffer::read(std::byte* data, int frameCount)
+{
+    if(!data || frameCount <= 0) {
+        return 0;
+    }
+
+    applyFlush();
+
+    const uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+    uint64_t writePos      = m_writePos.load(std::memory_order_acquire);
+
+    // Don't read past the end of a track so the consumer sees the boundary, even if more follows
+    const uint64_t endPos = m_endPos.load(std::memory_order_acquire);
+    if(endPos != NoPosition && endPos >= readPos) {
+        writePos = std::min(writePos, endPos);
+    }
+
+    const uint64_t bytes = std::min(writePos - readPos, static_cast<uint64_t>(frameCount) * m_bytesPerFrame);
+
+    if(bytes == 0) {
+        return 0;
+    }
+
+    const uint64_t offset = readPos % m_capacity;
+    const uint64_t first  = std::min(bytes, m_capacity - offset);
+
+    std::memcpy(data, m_data.data() + offset, first);
+    if(first < bytes) {
+        std::memcpy(data + first, m_data.data(), bytes - first);
+    }
+
+    m_readPos.store(readPos + bytes, std::memory_order_release);
+
+    return static_cast<int>(bytes / m_bytesPerFrame);
+}
+
+bool AudioRingBuffer::takeEnd()
+{
+    applyFlush();
+
+    uint64_t endPos = m_endPos.load(std::memory_order_acquire);
+    if(endPos == NoPosition || m_readPos.load(std::memory_order_relaxed) < endPos) {
+        return false;
+    }
+
+    // A flush from the producer may have cleared the marker in the meantime
+    return m_endPos.compare_exchange_strong(endPos, NoPosition, std::memory_order_acq_rel);
+}
+
+void AudioRingBuffer::applyFlush()
+{
+    const uint64_t flushPos = m_flushPos.exchange(NoPosition, std::memory_order_acq_rel);
+    if(flushPos != NoPosition) {
+        const uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+        m_readPos.store(std::max(readPos, flushPos), std::memory_order_release);
+    }
+}
+} // namespace Fooyin
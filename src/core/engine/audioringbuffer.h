@@ -0,0 +1,98 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <core/engine/audioformat.h>
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+namespace Fooyin {
+class AudioBuffer;
+
+/*!
+ * A preallocated, lock-free single-producer/single-consumer ring of interleaved samples.
+ *
+ * The decoding thread is the only producer and may call @fn write, @fn markEnd and @fn flush.
+ * The renderer is the only consumer and may call @fn read and @fn takeEnd.
+ * All other functions are safe to call from either side.
+ */
+class AudioRingBuffer
+{
+public:
+    AudioRingBuffer(const AudioFormat& format, int frameCapacity);
+
+    [[nodiscard]] AudioFormat format() const;
+    [[nodiscard]] int frameCapacity() const;
+
+    /** Returns the number of frames which can currently be read. */
+    [[nodiscard]] int framesAvailable() const;
+    /** Returns the number of frames which can currently be written. */
+    [[nodiscard]] int framesFree() const;
+    /** Returns @c true if the end of the stream has been written. */
+    [[nodiscard]] bool hasEnd() const;
+
+    /*!
+     * Writes as many frames from @p buffer as will fit.
+     * @returns the number of frames written.
+     */
+    int write(const AudioBuffer& buffer);
+    int write(const std::byte* data, int frameCount);
+    /*!
+     * Marks the current write position as the end of the track.
+     * Frames written afterwards belong to the next track, and are only read once the end has been taken.
+     */
+    void markEnd();
+    /*!
+     * Discards everything written so far, including any end marker.
+     * Frames written after this call are kept, so the producer can continue
+     * writing immediately without waiting for the consumer.
+     */
+    void flush();
+
+    /*!
+     * Reads up to @p frameCount frames into @p data, stopping at any end marker.
+     * @returns the number of frames read.
+     */
+    int read(std::byte* data, int frameCount);
+    /*!
+     * Returns @c true once, if all frames up to the end marker have been read.
+     */
+    bool takeEnd();
+
+private:
+    static constexpr uint64_t NoPosition = std::numeric_limits<uint64_t>::max();
+
+    void applyFlush();
+
+    AudioFormat m_format;
+    int m_bytesPerFrame;
+    uint64_t m_capacity;
+    std::vector<std::byte> m_data;
+
+    // Monotonic byte positions, wrapped into m_data on access
+    alignas(64) std::atomic<uint64_t> m_writePos;
+    alignas(64) std::atomic<uint64_t> m_readPos;
+
+    alignas(64) std::atomic<uint64_t> m_flushPos;
+    std::atomic<uint64_t> m_endPos;
+};
+} // namespace Fooyin
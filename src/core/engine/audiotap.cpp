@@ -0,0 +1,234 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/audiotap.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Attempts at a read before giving up on a writer which keeps overtaking
+constexpr auto MaxReadAttempts = 4;
+} // namespace
+
+namespace Fooyin {
+struct AudioTap::Ring
+{
+    Ring(const AudioFormat& format_, int capacity_)
+        : format{format_}
+        , capacity{static_cast<uint64_t>(capacity_)}
+        , frameSize{static_cast<size_t>(format_.bytesPerFrame())}
+        , data(capacity * frameSize)
+    { }
+
+    void copyOut(uint64_t start, uint64_t frames, std::byte* out) const
+    {
+        const uint64_t offset = start % capacity;
+        const uint64_t first  = std::min(frames, capacity - offset);
+
+        std::memcpy(out, data.data() + (offset * frameSize), first * frameSize);
+        if(first < frames) {
+            std::memcpy(out + (first * frameSize), data.data(), (frames - first) * frameSize);
+        }
+    }
+
+    void copyIn(uint64_t start, std::span<const std::byte> in)
+    {
+        const uint64_t frames = in.size() / frameSize;
+        const uint64_t offset = start % capacity;
+        const uint64_t first  = std::min(frames, capacity - offset);
+
+        std::memcpy(data.data() + (offset * frameSize), in.data(), first * frameSize);
+        if(first < frames) {
+            std::memcpy(data.data(), in.data() + (first * frameSize), (frames - first) * frameSize);
+        }
+    }
+
+    const AudioFormat format;
+    const uint64_t capacity;
+    const size_t frameSize;
+    std::vector<std::byte> data;
+
+    // Frames fully written, and written up to once the current write finishes
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> writing{0};
+    // Anything before this frame has been cleared
+    std::atomic<uint64_t> validFrom{0};
+
+    // Where and when the most recent write will be heard, guarded by a sequence count
+    std::atomic<uint32_t> anchorSequence{0};
+    std::atomic<uint64_t> anchorFrame{0};
+    std::atomic<uint64_t> anchorPosition{0};
+    std::atomic<Clock::rep> anchorTime{0};
+};
+
+AudioTap::AudioTap(int length)
+    : m_length{std::max(length, 1)}
+    , m_writeRing{nullptr}
+    , m_readRing{nullptr}
+{ }
+
+AudioTap::~AudioTap() = default;
+
+void AudioTap::setFormat(const AudioFormat& format)
+{
+    if(!format.isValid() || (m_writeRing && m_writeRing->format == format)) {
+        return;
+    }
+
+    m_writeRing = ringForFormat(format);
+}
+
+void AudioTap::write(std::span<const std::byte> data, uint64_t position, TimePoint playTime)
+{
+    Ring* ring = m_writeRing;
+    if(!ring) {
+        return;
+    }
+
+    auto frames = static_cast<uint64_t>(data.size() / ring->frameSize);
+    if(frames == 0) {
+        return;
+    }
+
+    if(frames > ring->capacity) {
+        // Only the end would survive anyway
+        const uint64_t skip = frames - ring->capacity;
+        const auto skipped  = static_cast<int>(skip);
+
+        data = data.subspan(skip * ring->frameSize);
+        position += ring->format.durationForFrames(skipped);
+        playTime += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>{static_cast<double>(skip) / ring->format.sampleRate()});
+        frames = ring->capacity;
+    }
+
+    const uint64_t start = ring->written.load(std::memory_order_relaxed);
+    const uint64_t end   = start + frames;
+
+    // Let readers know this region is about to be overwritten before touching it
+    ring->writing.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ring->copyIn(start, data.first(frames * ring->frameSize));
+
+    const uint32_t sequence = ring->anchorSequence.load(std::memory_order_relaxed);
+    ring->anchorSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->anchorFrame.store(start, std::memory_order_relaxed);
+    ring->anchorPosition.store(position, std::memory_order_relaxed);
+    ring->anchorTime.store(playTime.time_since_epoch().count(), std::memory_order_relaxed);
+    ring->anchorSequence.store(sequence + 2, std::memory_order_release);
+
+    ring->written.store(end, std::memory_order_release);
+
+    if(m_readRing.load(std::memory_order_relaxed) != ring) {
+        m_readRing.store(ring, std::memory_order_release);
+    }
+}
+
+void AudioTap::clear()
+{
+    for(const auto& ring : m_rings) {
+        ring->validFrom.store(ring->written.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+}
+
+AudioFormat AudioTap::format() const
+{
+    const Ring* ring = m_readRing.load(std::memory_order_acquire);
+    return ring ? ring->format : AudioFormat{};
+}
+
+bool AudioTap::readAudible(int frames, AudioBuffer& buffer, TimePoint now) const
+{
+    const Ring* ring = m_readRing.load(std::memory_order_acquire);
+    if(!ring || frames <= 0) {
+        return false;
+    }
+
+    const int sampleRate = ring->format.sampleRate();
+
+    for(int attempt{0}; attempt < MaxReadAttempts; ++attempt) {
+        const uint32_t sequence = ring->anchorSequence.load(std::memory_order_acquire);
+        if(sequence % 2 != 0) {
+            continue;
+        }
+        const uint64_t anchorFrame    = ring->anchorFrame.load(std::memory_order_relaxed);
+        const uint64_t anchorPosition = ring->anchorPosition.load(std::memory_order_relaxed);
+        const TimePoint anchorTime{Clock::duration{ring->anchorTime.load(std::memory_order_relaxed)}};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(ring->anchorSequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+
+        // Anything written before the most recent write has been heard earlier, anything after it later
+        const double elapsed = std::chrono::duration<double>{now - anchorTime}.count();
+        const auto audible   = static_cast<int64_t>(anchorFrame) + static_cast<int64_t>(elapsed * sampleRate);
+        const auto end       = static_cast<uint64_t>(std::clamp<int64_t>(audible, 0, static_cast<int64_t>(written)));
+
+        const uint64_t oldest = std::max(ring->validFrom.load(std::memory_order_acquire),
+                                         written > ring->capacity ? written - ring->capacity : 0);
+        const uint64_t wanted = std::min(static_cast<uint64_t>(frames), ring->capacity);
+        const uint64_t start  = std::max(end > wanted ? end - wanted : 0, oldest);
+        if(start >= end) {
+            return false;
+        }
+
+        const auto count = static_cast<int>(end - start);
+        if(buffer.format() != ring->format) {
+            buffer = AudioBuffer{ring->format, 0};
+        }
+        buffer.resize(static_cast<size_t>(ring->format.bytesForFrames(count)));
+        ring->copyOut(start, end - start, buffer.data());
+
+        // Make sure the writer didn't start overwriting what was just copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(ring->writing.load(std::memory_order_relaxed) > start + ring->capacity) {
+            continue;
+        }
+
+        const int64_t offset = static_cast<int64_t>(start) - static_cast<int64_t>(anchorFrame);
+        const int64_t startTime
+            = static_cast<int64_t>(anchorPosition) + (offset * 1000 / static_cast<int64_t>(sampleRate));
+        buffer.setStartTime(static_cast<uint64_t>(std::max<int64_t>(startTime, 0)));
+
+        return true;
+    }
+
+    return false;
+}
+
+AudioTap::Ring* AudioTap::ringForFormat(const AudioFormat& format)
+{
+    const auto existing
+        = std::ranges::find_if(m_rings, [&format](const auto& ring) { return ring->format == format; });
+    if(existing != m_rings.cend()) {
+        Ring* ring = existing->get();
+        // Whatever's left from the last time this format was used is long gone
+        ring->validFrom.store(ring->written.load(std::memory_order_relaxed), std::memory_order_release);
+        return ring;
+    }
+
+    const int capacity = std::max(format.framesForDuration(static_cast<uint64_t>(m_length)), 1);
+    return m_rings.emplace_back(std::make_unique<Ring>(format, capacity)).get();
+}
+} // namespace Fooyin
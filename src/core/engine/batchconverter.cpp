@@ -0,0 +1,465 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/batchconverter.h>
+
+#include "engine/builtininputs.h"
+#include "engine/ffmpeg/ffmpegencoder.h"
+#include "engine/ffmpeg/ffmpegresampler.h"
+
+#include <core/engine/audioconverter.h>
+#include <core/engine/audioloader.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+Q_LOGGING_CATEGORY(CONVERTER, "fy.converter")
+
+using namespace std::chrono_literals;
+using namespace Qt::StringLiterals;
+
+namespace {
+// Audio decoded at a time, in ms
+constexpr auto ReadLength       = 100;
+constexpr auto ProgressInterval = 250ms;
+
+using Clock = std::chrono::steady_clock;
+
+// Encoders to try for each format, in order of preference
+QStringList encodersForFormat(Fooyin::ConversionOptions::Format format)
+{
+    switch(format) {
+        case(Fooyin::ConversionOptions::Format::Flac):
+            return {u"flac"_s};
+        case(Fooyin::ConversionOptions::Format::Opus):
+            return {u"libopus"_s, u"opus"_s};
+        case(Fooyin::ConversionOptions::Format::Mp3):
+            return {u"libmp3lame"_s};
+    }
+    return {};
+}
+
+QString outputName(const Fooyin::Track& track)
+{
+    // Tracks sharing a file (cue sheets, subsongs) need a name of their own
+    QString name = track.hasCue() || track.subsong() > 0
+                     ? u"%1 - %2"_s.arg(track.trackNumber(), track.effectiveTitle())
+                     : track.filename();
+    name.replace(u'/', u'_');
+
+    return name;
+}
+
+// Works out every output file up front, so workers never write to the same one.
+// Directories below the one all tracks share are mirrored, as albums often have tracks with the same name
+// (e.g. "01 - Intro"), and any names still shared are numbered.
+std::vector<QString> outputFiles(const Fooyin::TrackList& tracks, const QString& outputDir, const QString& extension)
+{
+    QStringList dirs;
+    dirs.reserve(static_cast<qsizetype>(tracks.size()));
+    for(const auto& track : tracks) {
+        dirs.append(QDir::cleanPath(track.path()));
+    }
+
+    QStringList root = dirs.front().split(u'/');
+    for(const QString& dir : std::as_const(dirs)) {
+        const QStringList parts = dir.split(u'/');
+        qsizetype common{0};
+        while(common < root.size() && common < parts.size() && root.at(common) == parts.at(common)) {
+            ++common;
+        }
+        root.resize(common);
+    }
+    const QDir rootDir{root.join(u'/') + u'/'};
+    const QDir outDir{outputDir};
+
+    std::vector<QString> files;
+    files.reserve(tracks.size());
+    QSet<QString> used;
+
+    for(size_t i{0}; i < tracks.size(); ++i) {
+        const QString relative = rootDir.relativeFilePath(dirs.at(static_cast<qsizetype>(i)));
+        const QDir dir{relative.isEmpty() || relative == "."_L1 ? outputDir : outDir.filePath(relative)};
+        const QString name = outputName(tracks.at(i));
+
+        QString file = dir.filePath(name + u'.' + extension);
+        // Compare ignoring case, as not all filesystems tell the difference
+        for(int n{2}; used.contains(file.toCaseFolded()); ++n) {
+            file = dir.filePath(u"%1 (%2).%3"_s.arg(name).arg(n).arg(extension));
+        }
+
+        used.insert(file.toCaseFolded());
+        files.push_back(file);
+    }
+
+    return files;
+}
+
+struct WorkerStats
+{
+    int tracksConverted{0};
+    double audioSecs{0.0};
+    Clock::duration busy{0};
+
+    [[nodiscard]] double speed() const
+    {
+        const double busySecs = std::chrono::duration<double>{busy}.count();
+        return busySecs > 0 ? audioSecs / busySecs : 0.0;
+    }
+};
+} // namespace
+
+namespace Fooyin {
+class BatchConverterPrivate
+{
+public:
+    BatchConverterPrivate(BatchConverter* self, std::shared_ptr<AudioLoader> audioLoader)
+        : m_self{self}
+        , m_audioLoader{std::move(audioLoader)}
+    { }
+
+    void runWorker(int worker);
+    ConversionResult convertTrack(const Track& track, const QString& outputFile, int worker, WorkerStats& stats);
+
+    BatchConverter* m_self;
+    std::shared_ptr<AudioLoader> m_audioLoader;
+    QThreadPool m_pool;
+
+    // Only changed while no workers are running
+    TrackList m_tracks;
+    // Unique output file for each of m_tracks
+    std::vector<QString> m_outputFiles;
+    ConversionOptions m_options;
+
+    std::atomic<size_t> m_nextTrack{0};
+    std::atomic<int> m_runningWorkers{0};
+    std::atomic<int> m_succeeded{0};
+    std::atomic<int> m_failed{0};
+    std::atomic<bool> m_cancelled{false};
+};
+
+void BatchConverterPrivate::runWorker(int worker)
+{
+    WorkerStats stats;
+
+    while(!m_cancelled.load(std::memory_order_relaxed)) {
+        // Whichever worker is free takes the next track
+        const size_t index = m_nextTrack.fetch_add(1, std::memory_order_relaxed);
+        if(index >= m_tracks.size()) {
+            break;
+        }
+
+        const ConversionResult result = convertTrack(m_tracks.at(index), m_outputFiles.at(index), worker, stats);
+        if(result.success) {
+            m_succeeded.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+            qCWarning(CONVERTER) << "Failed to convert" << result.track.prettyFilepath() << "-" << result.error;
+        }
+        emit m_self->trackConverted(result);
+    }
+
+    qCDebug(CONVERTER) << "Worker" << worker << "converted" << stats.tracksConverted << "tracks at" << stats.speed()
+                       << "x realtime";
+
+    if(m_runningWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        emit m_self->finished(m_succeeded.load(), m_failed.load());
+    }
+}
+
+ConversionResult BatchConverterPrivate::convertTrack(const Track& track, const QString& outputFile, int worker,
+                                                    WorkerStats& stats)
+{
+    ConversionResult result;
+    result.track      = track;
+    result.outputFile = outputFile;
+
+    auto failed = [&result](const QString& error) {
+        result.error = error;
+        return result;
+    };
+
+    // Only files from before the conversion can exist, as no two tracks share an output file
+    if(!m_options.overwrite && QFile::exists(result.outputFile)) {
+        return failed(u"%1 already exists"_s.arg(result.outputFile));
+    }
+
+    AudioSource source;
+    source.filepath = track.filepath();
+    QFile file{track.filepath()};
+    if(!track.isInArchive()) {
+        if(!file.open(QIODevice::ReadOnly)) {
+            return failed(u"Failed to open file"_s);
+        }
+        source.device = &file;
+    }
+
+    // Stopped and returned to the pool for the next track once done, before the file is closed
+    const auto decoder = m_audioLoader->acquireDecoder(track);
+    if(!decoder) {
+        return failed(u"No decoder available"_s);
+    }
+
+    AudioDecoder::DecoderOptions decoderOptions{AudioDecoder::NoInfiniteLooping | AudioDecoder::ParallelDecoding};
+    if(track.offset() == 0) {
+        decoderOptions |= AudioDecoder::NoSeeking;
+    }
+
+    const auto format = decoder->init(source, track, decoderOptions);
+    if(!format) {
+        return failed(u"Unable to decode"_s);
+    }
+
+    AudioFormat requestedFormat{*format};
+    if(m_options.sampleRate > 0) {
+        requestedFormat.setSampleRate(m_options.sampleRate);
+    }
+
+    FFmpegEncoder encoder;
+    const QStringList encoders = encodersForFormat(m_options.format);
+    if(std::ranges::none_of(encoders, [&](const QString& name) {
+           return encoder.open(result.outputFile, name, requestedFormat, m_options.bitrate,
+                               m_options.compressionLevel);
+       })) {
+        QFile::remove(result.outputFile);
+        return failed(encoder.error());
+    }
+
+    const AudioFormat encoderFormat = encoder.inputFormat();
+
+    // Convert samples first, so the resampler only has to change the rate
+    AudioFormat decodedFormat{*format};
+    decodedFormat.setSampleFormat(encoderFormat.sampleFormat());
+
+    std::unique_ptr<FFmpegResampler> resampler;
+    if(decodedFormat.sampleRate() != encoderFormat.sampleRate()) {
+        resampler = std::make_unique<FFmpegResampler>(decodedFormat, encoderFormat, 0, ResamplerQuality::High);
+        if(!resampler->canResample()) {
+            QFile::remove(result.outputFile);
+            return failed(u"Unable to resample"_s);
+        }
+    }
+
+    decoder->start();
+    if(track.offset() > 0) {
+        decoder->seek(track.offset());
+    }
+
+    // Tracks in a cue sheet (or otherwise part way into a file) end where the next starts, rather than at the end of
+    // the file. Anything else is decoded to the end, as durations from tags can be estimates (e.g. VBR MP3s).
+    const bool partOfFile = track.hasCue() || track.offset() > 0;
+    const auto trackFrames
+        = static_cast<int64_t>(track.duration() * static_cast<uint64_t>(format->sampleRate()) / 1000);
+    const int64_t maxFrames = partOfFile ? trackFrames : 0;
+    const auto readBytes    = static_cast<size_t>(format->bytesForDuration(ReadLength));
+
+    int64_t framesDecoded{0};
+    bool success{true};
+    auto lastProgress = Clock::now();
+
+    while(!m_cancelled.load(std::memory_order_relaxed)) {
+        const auto start = Clock::now();
+
+        AudioBuffer buffer = decoder->readBuffer(readBytes);
+        if(!buffer.isValid()) {
+            break;
+        }
+
+        int frames = buffer.frameCount();
+        if(maxFrames > 0 && framesDecoded + frames > maxFrames) {
+            frames = static_cast<int>(maxFrames - framesDecoded);
+            buffer.resize(static_cast<size_t>(format->bytesForFrames(frames)));
+        }
+        framesDecoded += frames;
+
+        if(buffer.format() != decodedFormat) {
+            buffer = Audio::convert(buffer, decodedFormat);
+        }
+        if(resampler) {
+            buffer = resampler->resample(buffer);
+        }
+
+        if(buffer.isValid() && buffer.frameCount() > 0 && !encoder.write(buffer)) {
+            success = false;
+            break;
+        }
+
+        const auto now = Clock::now();
+        stats.busy += now - start;
+        stats.audioSecs += static_cast<double>(frames) / format->sampleRate();
+
+        if(now - lastProgress >= ProgressInterval) {
+            lastProgress = now;
+
+            // Only an estimate when decoding to the end of the file
+            const double fraction = static_cast<double>(framesDecoded) / static_cast<double>(trackFrames);
+
+            ConversionProgress progress;
+            progress.worker          = worker;
+            progress.filepath        = track.filepath();
+            progress.progress        = trackFrames > 0 ? std::min(fraction, 1.0) : 0.0;
+            progress.speed           = stats.speed();
+            progress.tracksConverted = stats.tracksConverted;
+            emit m_self->progressChanged(progress);
+        }
+
+        if(maxFrames > 0 && framesDecoded >= maxFrames) {
+            break;
+        }
+    }
+
+    if(m_cancelled.load(std::memory_order_relaxed)) {
+        QFile::remove(result.outputFile);
+        return failed(u"Cancelled"_s);
+    }
+
+    // The resampler holds on to the last few samples until it's told there's nothing more coming
+    while(success && resampler) {
+        const AudioBuffer buffer = resampler->flush();
+        if(!buffer.isValid()) {
+            break;
+        }
+        success = encoder.write(buffer);
+    }
+
+    if(!success || !encoder.finish()) {
+        QFile::remove(result.outputFile);
+        return failed(encoder.error());
+    }
+
+    Track convertedTrack{track};
+    convertedTrack.setFilePath(result.outputFile);
+    if(!m_audioLoader->writeTrackMetadata(convertedTrack, AudioReader::Metadata)) {
+        qCInfo(CONVERTER) << "Unable to write metadata to" << result.outputFile;
+    }
+
+    ++stats.tracksConverted;
+    result.success = true;
+
+    return result;
+}
+
+BatchConverter::BatchConverter(std::shared_ptr<AudioLoader> audioLoader, QObject* parent)
+    : QObject{parent}
+    , p{std::make_unique<BatchConverterPrivate>(this, std::move(audioLoader))}
+{ }
+
+BatchConverter::~BatchConverter()
+{
+    cancel();
+}
+
+std::shared_ptr<AudioLoader> BatchConverter::standaloneLoader()
+{
+    auto loader = std::make_shared<AudioLoader>();
+    registerBuiltinInputs(loader);
+    loader->restoreState();
+    return loader;
+}
+
+QString BatchConverter::extension(ConversionOptions::Format format)
+{
+    switch(format) {
+        case(ConversionOptions::Format::Flac):
+            return u"flac"_s;
+        case(ConversionOptions::Format::Opus):
+            return u"opus"_s;
+        case(ConversionOptions::Format::Mp3):
+            return u"mp3"_s;
+    }
+    return {};
+}
+
+bool BatchConverter::isRunning() const
+{
+    return p->m_runningWorkers.load(std::memory_order_acquire) > 0;
+}
+
+void BatchConverter::convert(const TrackList& tracks, const ConversionOptions& options)
+{
+    if(isRunning()) {
+        qCWarning(CONVERTER) << "Conversion already running";
+        return;
+    }
+
+    if(tracks.empty()) {
+        emit finished(0, 0);
+        return;
+    }
+
+    if(!QDir{}.mkpath(options.outputDir)) {
+        qCWarning(CONVERTER) << "Unable to create output directory" << options.outputDir;
+        emit finished(0, static_cast<int>(tracks.size()));
+        return;
+    }
+
+    p->m_pool.waitForDone();
+
+    p->m_tracks      = tracks;
+    p->m_outputFiles = outputFiles(tracks, options.outputDir, extension(options.format));
+    p->m_options     = options;
+
+    QSet<QString> outputDirs;
+    for(const QString& file : p->m_outputFiles) {
+        outputDirs.insert(QFileInfo{file}.path());
+    }
+    for(const QString& dir : std::as_const(outputDirs)) {
+        if(!QDir{}.mkpath(dir)) {
+            // Tracks going here will fail to open their output
+            qCWarning(CONVERTER) << "Unable to create output directory" << dir;
+        }
+    }
+
+    p->m_nextTrack.store(0);
+    p->m_succeeded.store(0);
+    p->m_failed.store(0);
+    p->m_cancelled.store(false);
+
+    const int jobs    = options.jobs > 0 ? options.jobs : QThread::idealThreadCount();
+    const int workers = std::clamp(jobs, 1, static_cast<int>(tracks.size()));
+
+    qCDebug(CONVERTER) << "Converting" << tracks.size() << "tracks using" << workers << "workers";
+
+    p->m_pool.setMaxThreadCount(workers);
+    p->m_runningWorkers.store(workers, std::memory_order_release);
+
+    for(int worker{0}; worker < workers; ++worker) {
+        p->m_pool.start([this, worker]() { p->runWorker(worker); });
+    }
+}
+
+void BatchConverter::cancel()
+{
+    p->m_cancelled.store(true, std::memory_order_relaxed);
+    p->m_pool.waitForDone();
+}
+} // namespace Fooyin
+
+#include "core/engine/moc_batchconverter.cpp"
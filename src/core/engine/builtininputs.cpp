@@ -0,0 +1,48 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "builtininputs.h"
+
+#include "engine/archiveinput.h"
+#include "engine/ffmpeg/ffmpeginput.h"
+#include "engine/taglibparser.h"
+
+#include <core/engine/audioloader.h>
+
+using namespace Qt::StringLiterals;
+
+namespace Fooyin {
+void registerBuiltinInputs(const std::shared_ptr<AudioLoader>& loader)
+{
+    // Archive inputs look up the decoders for files inside archives, so can't own the loader
+    const std::weak_ptr<AudioLoader> weakLoader{loader};
+
+    loader->addDecoder(u"Archive"_s, [weakLoader]() { return std::make_unique<ArchiveDecoder>(weakLoader.lock()); });
+    loader->addReader(u"Archive"_s,
+                      [weakLoader]() { return std::make_unique<GeneralArchiveReader>(weakLoader.lock()); });
+    loader->addReader(u"TagLib"_s, {[]() {
+                          return std::make_unique<TagLibReader>();
+                      }});
+    loader->addDecoder(u"FFmpeg"_s, []() { return std::make_unique<FFmpegDecoder>(); }, 99);
+    loader->addReader(u"FFmpeg"_s, {[]() {
+                          return std::make_unique<FFmpegReader>();
+                      }},
+                      99);
+}
+} // namespace Fooyin
@@ -0,0 +1,484 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "decodeworker.h"
+
+#include "ffmpeg/ffmpegresampler.h"
+
+#include <core/engine/audioconverter.h>
+#include <core/engine/audioinput.h>
+
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+Q_LOGGING_CATEGORY(DECODE_WORKER, "fy.decodeworker")
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr auto NoTime = std::numeric_limits<uint64_t>::max();
+// Longest single read from the decoder
+constexpr auto ChunkLength      = 100;
+constexpr auto DefaultReadAhead = 5000;
+} // namespace
+
+namespace Fooyin {
+DecodeWorker::DecodeWorker(QObject* parent)
+    : QObject{parent}
+    , m_thread{QThread::create([this]() { run(); })}
+    , m_decoder{nullptr}
+    , m_readAheadLength{DefaultReadAhead}
+    , m_generation{0}
+    , m_active{false}
+    , m_preparing{false}
+    , m_reading{false}
+    , m_quit{false}
+    , m_priorityChanged{false}
+    , m_realtime{false}
+    , m_framesRead{0}
+    , m_decoderEnded{false}
+    , m_startTime{NoTime}
+    , m_bitrate{0}
+{
+    m_thread->setObjectName(u"Decoder"_s);
+    m_thread->start();
+}
+
+DecodeWorker::~DecodeWorker()
+{
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_quit = true;
+    }
+    m_cond.notify_all();
+
+    m_thread->wait();
+    delete m_thread;
+}
+
+void DecodeWorker::setReadAhead(uint64_t length)
+{
+    const std::scoped_lock lock{m_mutex};
+    m_readAheadLength = std::clamp(length, MinReadAhead, MaxReadAhead);
+    // Takes effect from the next call to start
+}
+
+void DecodeWorker::setRealtime(bool enabled)
+{
+    {
+        const std::scoped_lock lock{m_mutex};
+        if(std::exchange(m_realtime, enabled) == enabled) {
+            return;
+        }
+        m_priorityChanged = true;
+    }
+    m_cond.notify_all();
+}
+
+AudioDecoder* DecodeWorker::decoder() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_decoder;
+}
+
+bool DecodeWorker::isActive() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_active;
+}
+
+bool DecodeWorker::isPreparing() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_preparing;
+}
+
+AudioFormat DecodeWorker::format() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_format;
+}
+
+std::shared_ptr<FFmpegResampler> DecodeWorker::resampler() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_resampler;
+}
+
+std::unique_ptr<QIODevice> DecodeWorker::takeFile()
+{
+    const std::scoped_lock lock{m_mutex};
+    return std::move(m_file);
+}
+
+void DecodeWorker::start(AudioDecoder* decoder, const AudioFormat& format, std::shared_ptr<FFmpegResampler> resampler)
+{
+    if(!decoder || !format.isValid()) {
+        return;
+    }
+
+    std::unique_lock lock{m_mutex};
+
+    // A prepared decoder may have already been read to the end, but its audio still needs to be played
+    if(m_decoder == decoder && m_resampler == resampler && m_format == format && m_readAhead
+       && (!m_decoderEnded || m_readAhead->framesAvailable() > 0)) {
+        m_active = true;
+        lock.unlock();
+        m_cond.notify_all();
+        return;
+    }
+
+    m_cond.wait(lock, [this]() { return !m_reading; });
+
+    resetReadAhead(format);
+    m_file.reset();
+
+    ++m_generation;
+    m_decoder   = decoder;
+    m_resampler = std::move(resampler);
+    m_format    = format;
+    m_active    = true;
+    m_preparing = false;
+    m_prepare   = {};
+    m_decoderEnded.store(false, std::memory_order_release);
+    m_startTime.store(NoTime, std::memory_order_release);
+    m_bitrate.store(0, std::memory_order_relaxed);
+    m_framesRead = 0;
+
+    lock.unlock();
+    m_cond.notify_all();
+}
+
+void DecodeWorker::prepare(AudioDecoder* decoder, PrepareFunc func)
+{
+    if(!decoder || !func) {
+        return;
+    }
+
+    std::unique_lock lock{m_mutex};
+
+    m_active = false;
+    m_cond.wait(lock, [this]() { return !m_reading; });
+
+    if(m_readAhead) {
+        m_readAhead->flush();
+        m_readAhead->takeEnd();
+    }
+
+    ++m_generation;
+    m_decoder = decoder;
+    m_resampler.reset();
+    m_file.reset();
+    m_format    = {};
+    m_preparing = true;
+    m_prepare   = std::move(func);
+    m_decoderEnded.store(false, std::memory_order_release);
+    m_startTime.store(NoTime, std::memory_order_release);
+    m_bitrate.store(0, std::memory_order_relaxed);
+    m_framesRead = 0;
+
+    lock.unlock();
+    m_cond.notify_all();
+}
+
+void DecodeWorker::stop()
+{
+    std::unique_lock lock{m_mutex};
+    m_active = false;
+    m_cond.wait(lock, [this]() { return !m_reading; });
+}
+
+void DecodeWorker::clear()
+{
+    std::unique_lock lock{m_mutex};
+
+    m_active = false;
+    m_cond.wait(lock, [this]() { return !m_reading; });
+
+    ++m_generation;
+    m_decoder = nullptr;
+    m_resampler.reset();
+    m_file.reset();
+    m_preparing = false;
+    m_prepare   = {};
+    if(m_readAhead) {
+        m_readAhead->flush();
+        m_readAhead->takeEnd();
+    }
+    m_decoderEnded.store(false, std::memory_order_release);
+    m_startTime.store(NoTime, std::memory_order_release);
+    m_bitrate.store(0, std::memory_order_relaxed);
+    m_framesRead = 0;
+}
+
+AudioBuffer DecodeWorker::read(size_t maxBytes)
+{
+    // The decode thread only holds the lock while storing a chunk, and may replace the read-ahead while preparing
+    std::unique_lock lock{m_mutex};
+
+    if(!m_readAhead || maxBytes == 0) {
+        return {};
+    }
+
+    const auto maxFrames = m_format.framesForBytes(static_cast<int>(std::min<size_t>(maxBytes, INT32_MAX)));
+    const int frames     = std::min(m_readAhead->framesAvailable(), maxFrames);
+    if(frames <= 0) {
+        return {};
+    }
+
+    const uint64_t startTime = m_startTime.load(std::memory_order_acquire);
+    const uint64_t offset    = m_framesRead * 1000 / static_cast<uint64_t>(m_format.sampleRate());
+
+    AudioBuffer buffer{m_format, startTime == NoTime ? 0 : startTime + offset};
+    buffer.resize(static_cast<size_t>(m_format.bytesForFrames(frames)));
+
+    const int read = m_readAhead->read(buffer.data(), frames);
+    buffer.resize(static_cast<size_t>(m_format.bytesForFrames(read)));
+    m_framesRead += static_cast<uint64_t>(read);
+
+    lock.unlock();
+    // Wake the decode thread now there's room
+    m_cond.notify_all();
+
+    if(read <= 0) {
+        return {};
+    }
+
+    return buffer;
+}
+
+bool DecodeWorker::atEnd() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_decoderEnded.load(std::memory_order_acquire) && (!m_readAhead || m_readAhead->framesAvailable() == 0);
+}
+
+uint64_t DecodeWorker::bufferedDuration() const
+{
+    const std::scoped_lock lock{m_mutex};
+    return m_readAhead ? m_format.durationForFrames(m_readAhead->framesAvailable()) : 0;
+}
+
+bool DecodeWorker::hasBuffered(uint64_t duration) const
+{
+    const std::scoped_lock lock{m_mutex};
+
+    if(m_preparing || !m_readAhead || !m_format.isValid()) {
+        return false;
+    }
+
+    return m_decoderEnded.load(std::memory_order_acquire) || framesWanted() == 0
+        || m_format.durationForFrames(m_readAhead->framesAvailable()) >= duration;
+}
+
+int DecodeWorker::bitrate() const
+{
+    return m_bitrate.load(std::memory_order_relaxed);
+}
+
+void DecodeWorker::run()
+{
+    std::unique_lock lock{m_mutex};
+
+    applyPriority();
+
+    while(true) {
+        m_cond.wait(lock, [this]() {
+            return m_quit || m_priorityChanged || m_prepare
+                || (m_active && m_decoder && !m_decoderEnded.load(std::memory_order_relaxed) && framesWanted() > 0);
+        });
+
+        if(m_quit) {
+            return;
+        }
+
+        if(std::exchange(m_priorityChanged, false)) {
+            applyPriority();
+            continue;
+        }
+
+        if(m_prepare) {
+            runPrepare(lock);
+            continue;
+        }
+
+        AudioDecoder* decoder          = m_decoder;
+        const auto resampler           = m_resampler;
+        const AudioFormat format       = m_format;
+        const AudioFormat decodeFormat = resampler ? resampler->inputFormat() : format;
+        const int generation           = m_generation;
+        const bool wasEmpty            = m_readAhead->framesAvailable() == 0;
+
+        // Ask for the decoder's equivalent of what's wanted, so resampling doesn't overshoot the read-ahead
+        const auto frames = std::max<int64_t>(
+            static_cast<int64_t>(framesWanted()) * decodeFormat.sampleRate() / format.sampleRate(), 1);
+        const auto bytes = static_cast<size_t>(decodeFormat.bytesForFrames(static_cast<int>(frames)));
+
+        m_reading = true;
+        lock.unlock();
+
+        // Any blocking I/O happens here, without holding up the engine
+        AudioBuffer buffer = decoder->readBuffer(bytes);
+        // Decoders update their bitrate as they read, so it's only safe to ask from this thread
+        const int bitrate = decoder->bitrate();
+        if(buffer.isValid() && resampler) {
+            if(buffer.format() != decodeFormat) {
+                buffer = Audio::convert(buffer, decodeFormat);
+            }
+            // Resampling happens here rather than when rendering, so its cost stays off the output's thread
+            buffer = resampler->resample(buffer);
+        }
+        else if(buffer.isValid() && buffer.format() != format) {
+            buffer = Audio::convert(buffer, format);
+        }
+
+        lock.lock();
+        m_reading = false;
+
+        bool notify{false};
+
+        // Discard the result if decoding was restarted in the meantime
+        if(generation == m_generation) {
+            m_bitrate.store(bitrate, std::memory_order_relaxed);
+            if(buffer.isValid()) {
+                if(m_startTime.load(std::memory_order_relaxed) == NoTime) {
+                    m_startTime.store(buffer.startTime(), std::memory_order_release);
+                }
+                const int written = m_readAhead->write(buffer);
+                if(written < buffer.frameCount()) {
+                    qCWarning(DECODE_WORKER) << "Read-ahead overflowed, dropped"
+                                             << buffer.frameCount() - written << "frames";
+                }
+                notify = wasEmpty;
+            }
+            else {
+                m_decoderEnded.store(true, std::memory_order_release);
+                notify = true;
+            }
+        }
+
+        // Anyone waiting for the read to finish
+        m_cond.notify_all();
+
+        if(notify) {
+            lock.unlock();
+            emit bufferReady();
+            lock.lock();
+        }
+    }
+}
+
+void DecodeWorker::runPrepare(std::unique_lock<std::mutex>& lock)
+{
+    const auto prepare   = std::exchange(m_prepare, {});
+    const int generation = m_generation;
+
+    m_reading = true;
+    lock.unlock();
+
+    // Opening may block on slow storage or archives, so keep it off the caller's thread too
+    auto result = prepare();
+
+    lock.lock();
+    m_reading = false;
+
+    const bool current = generation == m_generation;
+    if(current) {
+        m_preparing = false;
+        if(result && result->format.isValid()) {
+            resetReadAhead(result->format);
+            m_resampler = std::move(result->resampler);
+            m_file      = std::move(result->file);
+            m_format    = result->format;
+            m_active    = result->decode;
+        }
+    }
+
+    m_cond.notify_all();
+
+    if(current) {
+        lock.unlock();
+        emit prepared();
+        lock.lock();
+    }
+}
+
+void DecodeWorker::resetReadAhead(const AudioFormat& format)
+{
+    const int frames = format.framesForDuration(m_readAheadLength + (2 * ChunkLength));
+    if(!m_readAhead || m_readAhead->format() != format || m_readAhead->frameCapacity() < frames) {
+        m_readAhead = std::make_unique<AudioRingBuffer>(format, frames);
+    }
+    else {
+        m_readAhead->flush();
+        // Nothing is reading while this is called, so apply the flush straight away
+        m_readAhead->takeEnd();
+    }
+}
+
+void DecodeWorker::applyPriority()
+{
+#ifdef Q_OS_LINUX
+    if(m_realtime) {
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+
+        const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if(error == 0) {
+            qCDebug(DECODE_WORKER) << "Using real-time scheduling for decoding";
+            return;
+        }
+        qCInfo(DECODE_WORKER) << "Unable to use real-time scheduling for decoding:" << std::strerror(error);
+    }
+    else {
+        // Drop back to normal scheduling
+        sched_param param{};
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    }
+#endif
+
+    QThread::currentThread()->setPriority(m_realtime ? QThread::TimeCriticalPriority : QThread::HighPriority);
+}
+
+int DecodeWorker::framesWanted() const
+{
+    if(!m_readAhead) {
+        return 0;
+    }
+
+    const int target   = m_format.framesForDuration(m_readAheadLength);
+    const int buffered = m_readAhead->framesAvailable();
+    if(buffered >= target) {
+        return 0;
+    }
+
+    return std::min(target - buffered, m_format.framesForDuration(ChunkLength));
+}
+} // namespace Fooyin
+
+#include "moc_decodeworker.cpp"
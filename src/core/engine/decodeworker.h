@@ -0,0 +1,174 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include "audioringbuffer.h"
+
+#include <core/engine/audiobuffer.h>
+#include <core/engine/audioformat.h>
+
+#include <QIODevice>
+#include <QLoggingCategory>
+#include <QObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+Q_DECLARE_LOGGING_CATEGORY(DECODE_WORKER)
+
+class QThread;
+
+namespace Fooyin {
+class AudioDecoder;
+class FFmpegResampler;
+
+/*!
+ * Decodes ahead of playback on a dedicated thread.
+ * Decoded audio is kept in a read-ahead buffer, so slow reads (e.g. from network storage) stall this thread
+ * rather than the engine. The thread sleeps whenever the read-ahead is full, and is woken as audio is read.
+ *
+ * Functions other than @fn read, @fn atEnd and @fn bufferedDuration must not be called while another thread
+ * may be using the decoder passed to @fn start.
+ */
+class FYCORE_EXPORT DecodeWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr uint64_t MinReadAhead = 2000;
+    static constexpr uint64_t MaxReadAhead = 10000;
+
+    struct Prepared
+    {
+        AudioFormat format;
+        std::shared_ptr<FFmpegResampler> resampler;
+        // The file opened for the decoder, if any, handed over through @fn takeFile
+        std::unique_ptr<QIODevice> file;
+        // Start decoding into the read-ahead straight away
+        bool decode{true};
+    };
+    using PrepareFunc = std::function<std::optional<Prepared>()>;
+
+    explicit DecodeWorker(QObject* parent = nullptr);
+    ~DecodeWorker() override;
+
+    /** Sets how much audio (in ms) to decode ahead, clamped to MinReadAhead and MaxReadAhead. */
+    void setReadAhead(uint64_t length);
+    /** Requests real-time scheduling for the decode thread where the platform allows it. */
+    void setRealtime(bool enabled);
+
+    [[nodiscard]] AudioDecoder* decoder() const;
+    [[nodiscard]] bool isActive() const;
+    /** Returns @c true while a job passed to @fn prepare is yet to finish. */
+    [[nodiscard]] bool isPreparing() const;
+    /** Returns the format being decoded to, or an invalid format if preparing failed. */
+    [[nodiscard]] AudioFormat format() const;
+    [[nodiscard]] std::shared_ptr<FFmpegResampler> resampler() const;
+    /*!
+     * Returns the file opened by the last job passed to @fn prepare, passing ownership to the caller.
+     * It's discarded if not taken before decoding is cleared or restarted.
+     */
+    [[nodiscard]] std::unique_ptr<QIODevice> takeFile();
+
+    /*!
+     * Starts decoding from @p decoder, converting to @p format.
+     * If given, @p resampler is used for the conversion, so resampling happens on the decode thread. It's kept
+     * alive until decoding is cleared or restarted, but mustn't be used elsewhere until decoding has stopped.
+     * Resumes if stopped part way through @p decoder, otherwise any previously decoded audio is discarded.
+     */
+    void start(AudioDecoder* decoder, const AudioFormat& format, std::shared_ptr<FFmpegResampler> resampler = {});
+    /*!
+     * Runs @p func on the decode thread to set up @p decoder (opening, initialising etc.), so slow opens don't
+     * hold up the caller. Decoding then starts using the returned format and resampler, unless told otherwise.
+     * @fn prepared is emitted once done, and @fn format is invalid if @p func returned nothing.
+     * Any previously decoded audio is discarded.
+     */
+    void prepare(AudioDecoder* decoder, PrepareFunc func);
+    /*!
+     * Stops decoding, waiting for any read in progress to finish.
+     * Once returned, the decoder is free to be used by the caller. Decoded audio is kept.
+     */
+    void stop();
+    /** Stops decoding and discards all decoded audio. */
+    void clear();
+
+    /*!
+     * Returns up to @p maxBytes of decoded audio, or an invalid buffer if none is available.
+     * Never blocks on the decoder, only on the decode thread briefly storing what it has decoded.
+     */
+    AudioBuffer read(size_t maxBytes);
+    /** Returns @c true if the decoder has finished, and all of its audio has been read. */
+    [[nodiscard]] bool atEnd() const;
+    /** Returns the duration of decoded audio waiting to be read. */
+    [[nodiscard]] uint64_t bufferedDuration() const;
+    /*!
+     * Returns @c true if at least @p duration of audio is waiting to be read, or as much as there will be
+     * (the read-ahead is full or the decoder has ended). Always @c false while preparing.
+     */
+    [[nodiscard]] bool hasBuffered(uint64_t duration) const;
+    /** Returns the decoder's bitrate as of its last read. */
+    [[nodiscard]] int bitrate() const;
+
+signals:
+    /** Emitted from the decode thread when audio becomes available after running dry, or the decoder ends. */
+    void bufferReady();
+    /** Emitted from the decode thread once a job passed to @fn prepare has finished. */
+    void prepared();
+
+private:
+    void run();
+    void runPrepare(std::unique_lock<std::mutex>& lock);
+    void resetReadAhead(const AudioFormat& format);
+    void applyPriority();
+    [[nodiscard]] int framesWanted() const;
+
+    QThread* m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    AudioDecoder* m_decoder;
+    std::shared_ptr<FFmpegResampler> m_resampler;
+    AudioFormat m_format;
+    std::unique_ptr<QIODevice> m_file;
+    // Replaced when the format changes, so only used with m_mutex held
+    std::unique_ptr<AudioRingBuffer> m_readAhead;
+    uint64_t m_readAheadLength;
+    PrepareFunc m_prepare;
+    int m_generation;
+    bool m_active;
+    bool m_preparing;
+    bool m_reading;
+    bool m_quit;
+    bool m_priorityChanged;
+    bool m_realtime;
+    uint64_t m_framesRead;
+
+    std::atomic<bool> m_decoderEnded;
+    std::atomic<uint64_t> m_startTime;
+    std::atomic<int> m_bitrate;
+};
+} // namespace Fooyin
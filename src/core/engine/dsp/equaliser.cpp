@@ -0,0 +1,224 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "equaliser.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr double LowestBand = 31.25;
+// One octave bandwidth
+constexpr double BandQ = std::numbers::sqrt2;
+// Filters too close to Nyquist become unstable
+constexpr double MaxBandRatio = 0.45;
+
+double dbToScale(double gain)
+{
+    return std::pow(10.0, gain / 20.0);
+}
+} // namespace
+
+namespace Fooyin {
+Equaliser::Equaliser()
+    : m_preamp{0.0}
+    , m_preampScale{1.0}
+    , m_gains{}
+{ }
+
+QString Equaliser::name() const
+{
+    return u"Equaliser"_s;
+}
+
+std::vector<SampleFormat> Equaliser::supportedFormats() const
+{
+    return {SampleFormat::F32, SampleFormat::F64};
+}
+
+void Equaliser::prepare(const AudioFormat& format)
+{
+    m_format = format;
+    updateFilters();
+}
+
+void Equaliser::process(AudioBuffer& buffer)
+{
+    if(!buffer.isValid() || buffer.format() != m_format || (m_filters.empty() && m_preampScale == 1.0)) {
+        return;
+    }
+
+    if(m_format.sampleFormat() == SampleFormat::F64) {
+        processSamples(reinterpret_cast<double*>(buffer.data()), buffer.frameCount());
+    }
+    else if(m_format.sampleFormat() == SampleFormat::F32) {
+        processSamples(reinterpret_cast<float*>(buffer.data()), buffer.frameCount());
+    }
+}
+
+void Equaliser::reset()
+{
+    std::ranges::fill(m_state, 0.0);
+}
+
+QByteArray Equaliser::saveSettings() const
+{
+    QByteArray settings;
+    QDataStream stream{&settings, QIODevice::WriteOnly};
+
+    stream << m_preamp;
+    for(const double gain : m_gains) {
+        stream << gain;
+    }
+
+    return settings;
+}
+
+bool Equaliser::loadSettings(const QByteArray& settings)
+{
+    if(settings.isEmpty()) {
+        return true;
+    }
+
+    QDataStream stream{settings};
+
+    double preamp{0.0};
+    Gains gains{};
+
+    stream >> preamp;
+    for(double& gain : gains) {
+        stream >> gain;
+    }
+
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    m_preamp = std::clamp(preamp, -MaxGain, MaxGain);
+    std::ranges::transform(gains, m_gains.begin(), [](double gain) { return std::clamp(gain, -MaxGain, MaxGain); });
+    updateFilters();
+
+    return true;
+}
+
+double Equaliser::preamp() const
+{
+    return m_preamp;
+}
+
+void Equaliser::setPreamp(double gain)
+{
+    m_preamp = std::clamp(gain, -MaxGain, MaxGain);
+    updateFilters();
+}
+
+Equaliser::Gains Equaliser::gains() const
+{
+    return m_gains;
+}
+
+void Equaliser::setGains(const Gains& gains)
+{
+    std::ranges::transform(gains, m_gains.begin(), [](double gain) { return std::clamp(gain, -MaxGain, MaxGain); });
+    updateFilters();
+}
+
+double Equaliser::bandFrequency(int band)
+{
+    return LowestBand * std::pow(2.0, band);
+}
+
+void Equaliser::updateFilters()
+{
+    m_preampScale = dbToScale(m_preamp);
+    m_filters.clear();
+
+    const int sampleRate = m_format.sampleRate();
+    if(sampleRate <= 0) {
+        m_state.clear();
+        return;
+    }
+
+    for(int band{0}; band < BandCount; ++band) {
+        const double gain      = m_gains.at(band);
+        const double frequency = bandFrequency(band);
+        if(gain == 0.0 || frequency >= sampleRate * MaxBandRatio) {
+            continue;
+        }
+
+        // Peaking filter from the RBJ audio EQ cookbook
+        const double a     = std::pow(10.0, gain / 40.0);
+        const double w0    = 2.0 * std::numbers::pi * frequency / sampleRate;
+        const double alpha = std::sin(w0) / (2.0 * BandQ);
+        const double cosW0 = std::cos(w0);
+        const double a0    = 1.0 + alpha / a;
+
+        Filter filter;
+        filter.b0 = (1.0 + alpha * a) / a0;
+        filter.b1 = (-2.0 * cosW0) / a0;
+        filter.b2 = (1.0 - alpha * a) / a0;
+        filter.a1 = (-2.0 * cosW0) / a0;
+        filter.a2 = (1.0 - alpha / a) / a0;
+        m_filters.push_back(filter);
+    }
+
+    m_state.assign(m_filters.size() * 2 * static_cast<size_t>(std::max(m_format.channelCount(), 0)), 0.0);
+}
+
+template <typename T>
+void Equaliser::processSamples(T* samples, int frameCount)
+{
+    const int channels = m_format.channelCount();
+    double* state      = m_state.data();
+
+    for(int ch{0}; ch < channels; ++ch) {
+        if(m_preampScale != 1.0) {
+            for(int frame{0}; frame < frameCount; ++frame) {
+                T& sample = samples[static_cast<ptrdiff_t>(frame) * channels + ch];
+                sample    = static_cast<T>(sample * m_preampScale);
+            }
+        }
+
+        for(const Filter& filter : m_filters) {
+            // Transposed direct form II, keeping the state in registers for the whole buffer
+            double s1 = state[0];
+            double s2 = state[1];
+
+            for(int frame{0}; frame < frameCount; ++frame) {
+                T& sample      = samples[static_cast<ptrdiff_t>(frame) * channels + ch];
+                const double x = sample;
+                const double y = filter.b0 * x + s1;
+                s1             = filter.b1 * x - filter.a1 * y + s2;
+                s2             = filter.b2 * x - filter.a2 * y;
+                sample         = static_cast<T>(y);
+            }
+
+            state[0] = s1;
+            state[1] = s2;
+            state += 2;
+        }
+    }
+}
+} // namespace Fooyin
@@ -0,0 +1,86 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/dspnode.h>
+
+#include <array>
+
+namespace Fooyin {
+/*!
+ * A 10 band graphic equaliser, using a peaking filter an octave wide for each band.
+ * Bands with no gain are skipped, so a flat equaliser leaves audio untouched.
+ */
+class FYCORE_EXPORT Equaliser : public DspNode
+{
+public:
+    static constexpr int BandCount = 10;
+    static constexpr double MaxGain = 20.0;
+
+    // Gain of each band in dB
+    using Gains = std::array<double, BandCount>;
+
+    Equaliser();
+
+    [[nodiscard]] QString name() const override;
+    [[nodiscard]] std::vector<SampleFormat> supportedFormats() const override;
+
+    void prepare(const AudioFormat& format) override;
+    void process(AudioBuffer& buffer) override;
+    void reset() override;
+
+    [[nodiscard]] QByteArray saveSettings() const override;
+    bool loadSettings(const QByteArray& settings) override;
+
+    [[nodiscard]] double preamp() const;
+    void setPreamp(double gain);
+    [[nodiscard]] Gains gains() const;
+    void setGains(const Gains& gains);
+
+    /** Returns the centre frequency of @p band in Hz. */
+    [[nodiscard]] static double bandFrequency(int band);
+
+private:
+    struct Filter
+    {
+        double b0{1.0};
+        double b1{0.0};
+        double b2{0.0};
+        double a1{0.0};
+        double a2{0.0};
+    };
+
+    void updateFilters();
+    template <typename T>
+    void processSamples(T* samples, int frameCount);
+
+    AudioFormat m_format;
+    double m_preamp;
+    double m_preampScale;
+    Gains m_gains;
+
+    // Only bands which are in use
+    std::vector<Filter> m_filters;
+    // Two delay elements per filter per channel
+    std::vector<double> m_state;
+};
+} // namespace Fooyin
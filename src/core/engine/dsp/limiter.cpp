@@ -0,0 +1,232 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "limiter.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr auto LookaheadDuration = 5;
+constexpr auto DefaultThreshold  = -0.3;
+constexpr auto DefaultRelease    = 100;
+constexpr auto MinRelease        = 1;
+constexpr auto MaxRelease        = 5000;
+} // namespace
+
+namespace Fooyin {
+Limiter::Limiter()
+    : m_threshold{DefaultThreshold}
+    , m_release{DefaultRelease}
+    , m_ceiling{1.0}
+    , m_attackCoeff{0.0}
+    , m_releaseCoeff{0.0}
+    , m_gain{1.0}
+    , m_lookahead{1}
+    , m_delayPos{0}
+    , m_frame{0}
+    , m_minStart{0}
+    , m_minCount{0}
+{
+    updateCoefficients();
+}
+
+QString Limiter::name() const
+{
+    return u"Limiter"_s;
+}
+
+std::vector<SampleFormat> Limiter::supportedFormats() const
+{
+    return {SampleFormat::F32, SampleFormat::F64};
+}
+
+int Limiter::latency() const
+{
+    return m_lookahead;
+}
+
+void Limiter::prepare(const AudioFormat& format)
+{
+    m_format    = format;
+    m_lookahead = std::max(format.framesForDuration(LookaheadDuration), 1);
+
+    const auto lookahead = static_cast<size_t>(m_lookahead);
+    m_delay.assign(lookahead * static_cast<size_t>(std::max(format.channelCount(), 0)), 0.0);
+    m_delayGains.assign(lookahead, 1.0);
+    // The window covers the frame leaving the delay line, and every frame still in it
+    m_minFrames.assign(lookahead + 1, 0);
+    m_minGains.assign(lookahead + 1, 1.0);
+
+    updateCoefficients();
+    reset();
+}
+
+void Limiter::process(AudioBuffer& buffer)
+{
+    if(!buffer.isValid() || buffer.format() != m_format || m_delay.empty()) {
+        return;
+    }
+
+    if(m_format.sampleFormat() == SampleFormat::F64) {
+        processSamples(reinterpret_cast<double*>(buffer.data()), buffer.frameCount());
+    }
+    else if(m_format.sampleFormat() == SampleFormat::F32) {
+        processSamples(reinterpret_cast<float*>(buffer.data()), buffer.frameCount());
+    }
+}
+
+void Limiter::reset()
+{
+    std::ranges::fill(m_delay, 0.0);
+    std::ranges::fill(m_delayGains, 1.0);
+
+    m_gain     = 1.0;
+    m_delayPos = 0;
+    m_frame    = 0;
+    m_minStart = 0;
+    m_minCount = 0;
+}
+
+QByteArray Limiter::saveSettings() const
+{
+    QByteArray settings;
+    QDataStream stream{&settings, QIODevice::WriteOnly};
+
+    stream << m_threshold << m_release;
+
+    return settings;
+}
+
+bool Limiter::loadSettings(const QByteArray& settings)
+{
+    if(settings.isEmpty()) {
+        return true;
+    }
+
+    QDataStream stream{settings};
+
+    double threshold{DefaultThreshold};
+    int release{DefaultRelease};
+    stream >> threshold >> release;
+
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    setThreshold(threshold);
+    setRelease(release);
+
+    return true;
+}
+
+double Limiter::threshold() const
+{
+    return m_threshold;
+}
+
+void Limiter::setThreshold(double threshold)
+{
+    m_threshold = std::min(threshold, 0.0);
+    updateCoefficients();
+}
+
+int Limiter::release() const
+{
+    return m_release;
+}
+
+void Limiter::setRelease(int release)
+{
+    m_release = std::clamp(release, MinRelease, MaxRelease);
+    updateCoefficients();
+}
+
+void Limiter::updateCoefficients()
+{
+    m_ceiling = std::pow(10.0, m_threshold / 20.0);
+
+    const double sampleRate = std::max(m_format.sampleRate(), 1);
+    // Reach the required gain reduction well within the lookahead
+    m_attackCoeff  = std::exp(-3.0 / m_lookahead);
+    m_releaseCoeff = std::exp(-1000.0 / (m_release * sampleRate));
+}
+
+void Limiter::pushRequiredGain(double gain)
+{
+    const int capacity = static_cast<int>(m_minGains.size());
+
+    // Drop any gains which can no longer be the minimum
+    while(m_minCount > 0 && m_minGains[(m_minStart + m_minCount - 1) % capacity] >= gain) {
+        --m_minCount;
+    }
+
+    const int back    = (m_minStart + m_minCount) % capacity;
+    m_minGains[back]  = gain;
+    m_minFrames[back] = m_frame;
+    ++m_minCount;
+
+    // Drop the oldest once it falls out of the window
+    if(m_minFrames[m_minStart] <= m_frame - capacity) {
+        m_minStart = (m_minStart + 1) % capacity;
+        --m_minCount;
+    }
+}
+
+template <typename T>
+void Limiter::processSamples(T* samples, int frameCount)
+{
+    const int channels = m_format.channelCount();
+
+    for(int frame{0}; frame < frameCount; ++frame) {
+        T* current    = samples + static_cast<ptrdiff_t>(frame) * channels;
+        double* delay = m_delay.data() + static_cast<ptrdiff_t>(m_delayPos) * channels;
+
+        double peak{0.0};
+        for(int ch{0}; ch < channels; ++ch) {
+            peak = std::max(peak, std::abs(static_cast<double>(current[ch])));
+        }
+
+        const double required = peak > m_ceiling ? m_ceiling / peak : 1.0;
+        pushRequiredGain(required);
+        ++m_frame;
+
+        const double target = m_minGains[m_minStart];
+        const double coeff  = target < m_gain ? m_attackCoeff : m_releaseCoeff;
+        m_gain              = target + (m_gain - target) * coeff;
+
+        // The smoothed gain may lag behind a sudden peak, so never apply more than the delayed frame allows
+        const double gain         = std::min(m_gain, m_delayGains[m_delayPos]);
+        m_delayGains[m_delayPos] = required;
+
+        for(int ch{0}; ch < channels; ++ch) {
+            const double sample = delay[ch];
+            delay[ch]           = current[ch];
+            current[ch]         = static_cast<T>(sample * gain);
+        }
+
+        m_delayPos = (m_delayPos + 1) % m_lookahead;
+    }
+}
+} // namespace Fooyin
@@ -0,0 +1,83 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/dspnode.h>
+
+namespace Fooyin {
+/*!
+ * A lookahead peak limiter.
+ * Audio is delayed by a few milliseconds so gain reduction can start before a peak arrives, rather than
+ * cutting in abruptly. No output sample exceeds the threshold.
+ */
+class FYCORE_EXPORT Limiter : public DspNode
+{
+public:
+    Limiter();
+
+    [[nodiscard]] QString name() const override;
+    [[nodiscard]] std::vector<SampleFormat> supportedFormats() const override;
+    [[nodiscard]] int latency() const override;
+
+    void prepare(const AudioFormat& format) override;
+    void process(AudioBuffer& buffer) override;
+    void reset() override;
+
+    [[nodiscard]] QByteArray saveSettings() const override;
+    bool loadSettings(const QByteArray& settings) override;
+
+    /** Returns the maximum output level in dBFS. */
+    [[nodiscard]] double threshold() const;
+    void setThreshold(double threshold);
+    /** Returns the time in ms taken to recover from gain reduction. */
+    [[nodiscard]] int release() const;
+    void setRelease(int release);
+
+private:
+    void updateCoefficients();
+    void pushRequiredGain(double gain);
+    template <typename T>
+    void processSamples(T* samples, int frameCount);
+
+    AudioFormat m_format;
+    double m_threshold;
+    int m_release;
+
+    double m_ceiling;
+    double m_attackCoeff;
+    double m_releaseCoeff;
+    double m_gain;
+
+    int m_lookahead;
+    int m_delayPos;
+    // Delayed samples, and the gain each delayed frame needs to stay below the ceiling
+    std::vector<double> m_delay;
+    std::vector<double> m_delayGains;
+
+    // Monotonic queue giving the lowest required gain over the lookahead window
+    int64_t m_frame;
+    int m_minStart;
+    int m_minCount;
+    std::vector<int64_t> m_minFrames;
+    std::vector<double> m_minGains;
+};
+} // namespace Fooyin
@@ -0,0 +1,251 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dspchain.h"
+
+#include "gainprocessor.h"
+
+#include <core/engine/audioconverter.h>
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+Q_LOGGING_CATEGORY(DSP_CHAIN, "fy.dspchain")
+
+namespace {
+// Enough for the largest chunk the renderer processes at once
+constexpr auto ReserveDuration    = 500;
+constexpr auto TransitionDuration = 10;
+
+constexpr std::array PreferredFormats
+    = {Fooyin::SampleFormat::F32, Fooyin::SampleFormat::F64, Fooyin::SampleFormat::S32, Fooyin::SampleFormat::S16};
+
+bool supportsFormat(const Fooyin::DspNodeList& nodes, Fooyin::SampleFormat format)
+{
+    return std::ranges::all_of(nodes, [format](const auto& node) {
+        const auto formats = node->supportedFormats();
+        return std::ranges::find(formats, format) != formats.cend();
+    });
+}
+
+void reserveFrames(Fooyin::AudioBuffer& buffer, const Fooyin::AudioFormat& format)
+{
+    buffer.reserve(static_cast<size_t>(format.bytesForFrames(format.framesForDuration(ReserveDuration))));
+}
+} // namespace
+
+namespace Fooyin {
+DspChain::DspChain() = default;
+
+void DspChain::setFormat(const AudioFormat& format)
+{
+    if(std::exchange(m_format, format) == format) {
+        return;
+    }
+
+    retirePrevious();
+    prepareStage(m_current);
+
+    m_fadeIn.setFormat(m_format);
+    m_fadeOut.setFormat(m_format);
+    m_fadeIn.reset();
+
+    m_transitionBuffer = {m_format, 0};
+    reserveFrames(m_transitionBuffer, m_format);
+}
+
+AudioFormat DspChain::format() const
+{
+    return m_format;
+}
+
+AudioFormat DspChain::workingFormat() const
+{
+    return m_current.workingFormat;
+}
+
+bool DspChain::isEmpty() const
+{
+    return m_current.nodes.empty();
+}
+
+int DspChain::latency() const
+{
+    int total{0};
+    for(const auto& node : m_current.nodes) {
+        total += node->latency();
+    }
+    return total;
+}
+
+DspChain::Stage DspChain::prepareNodes(DspNodeList nodes) const
+{
+    Stage stage;
+    stage.nodes = std::move(nodes);
+    prepareStage(stage);
+    return stage;
+}
+
+void DspChain::replaceNodes(Stage stage)
+{
+    if(stage.inputFormat != m_format) {
+        // The format changed since the stage was prepared
+        prepareStage(stage);
+    }
+
+    retirePrevious();
+
+    m_previous = std::move(m_current);
+    m_current  = std::move(stage);
+
+    if(!m_format.isValid()) {
+        return;
+    }
+
+    // Continue from the level of any transition already in progress
+    std::swap(m_fadeIn, m_fadeOut);
+    m_fadeIn.reset();
+
+    const int frames = m_format.framesForDuration(TransitionDuration);
+    m_fadeOut.fadeOut(frames, FadeCurve::Linear);
+    m_fadeIn.fadeIn(frames, FadeCurve::Linear);
+}
+
+DspNodeList DspChain::takeRetiredNodes()
+{
+    return std::exchange(m_retired, {});
+}
+
+void DspChain::reset()
+{
+    for(const auto& node : m_current.nodes) {
+        node->reset();
+    }
+    m_fadeIn.reset();
+}
+
+void DspChain::process(AudioBuffer& buffer)
+{
+    if(!buffer.isValid() || buffer.format() != m_format) {
+        return;
+    }
+
+    const int frames = buffer.frameCount();
+    if(frames <= 0) {
+        return;
+    }
+
+    if(!m_fadeIn.isFading()) {
+        processStage(m_current, buffer);
+        return;
+    }
+
+    // Run the old nodes on a copy of the input, then fade between the two outputs
+    const auto bytes = static_cast<size_t>(buffer.byteCount());
+    m_transitionBuffer.resize(bytes);
+    m_transitionBuffer.setStartTime(buffer.startTime());
+    std::memcpy(m_transitionBuffer.data(), buffer.constData().data(), bytes);
+
+    processStage(m_previous, m_transitionBuffer);
+    processStage(m_current, buffer);
+
+    m_fadeOut.process(m_transitionBuffer.data(), frames);
+    m_fadeIn.process(buffer.data(), frames);
+    Audio::mixSamples(m_transitionBuffer.constData().data(), buffer.data(), m_format.sampleFormat(),
+                      frames * m_format.channelCount());
+}
+
+AudioFormat DspChain::negotiateFormat(const DspNodeList& nodes, const AudioFormat& inputFormat)
+{
+    AudioFormat format{inputFormat};
+
+    if(nodes.empty() || supportsFormat(nodes, inputFormat.sampleFormat())) {
+        return format;
+    }
+
+    for(const auto sampleFormat : PreferredFormats) {
+        if(supportsFormat(nodes, sampleFormat)) {
+            format.setSampleFormat(sampleFormat);
+            return format;
+        }
+    }
+
+    qCWarning(DSP_CHAIN) << "No sample format is supported by every node; using F32";
+    format.setSampleFormat(SampleFormat::F32);
+    return format;
+}
+
+void DspChain::prepareStage(Stage& stage) const
+{
+    stage.inputFormat   = m_format;
+    stage.workingFormat = negotiateFormat(stage.nodes, m_format);
+
+    if(!m_format.isValid()) {
+        return;
+    }
+
+    for(const auto& node : stage.nodes) {
+        node->prepare(stage.workingFormat);
+    }
+
+    if(stage.workingFormat != m_format) {
+        stage.workBuffer = {stage.workingFormat, 0};
+        reserveFrames(stage.workBuffer, stage.workingFormat);
+    }
+    else {
+        stage.workBuffer = {};
+    }
+}
+
+void DspChain::processStage(Stage& stage, AudioBuffer& buffer)
+{
+    if(stage.nodes.empty()) {
+        return;
+    }
+
+    if(!stage.workBuffer.isValid()) {
+        for(const auto& node : stage.nodes) {
+            node->process(buffer);
+        }
+        return;
+    }
+
+    const int frames = buffer.frameCount();
+    stage.workBuffer.resize(static_cast<size_t>(stage.workingFormat.bytesForFrames(frames)));
+    stage.workBuffer.setStartTime(buffer.startTime());
+
+    Audio::convert(m_format, buffer.constData().data(), stage.workingFormat, stage.workBuffer.data(), frames);
+    for(const auto& node : stage.nodes) {
+        node->process(stage.workBuffer);
+    }
+    Audio::convert(stage.workingFormat, stage.workBuffer.constData().data(), m_format, buffer.data(), frames);
+}
+
+void DspChain::retirePrevious()
+{
+    std::ranges::move(m_previous.nodes, std::back_inserter(m_retired));
+    m_previous = {};
+}
+} // namespace Fooyin
@@ -0,0 +1,100 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include "audiofader.h"
+
+#include <core/engine/audiobuffer.h>
+#include <core/engine/dspnode.h>
+
+namespace Fooyin {
+/*!
+ * Runs a list of DspNodes over audio in place.
+ * Every node processes the same working format, chosen from the formats all nodes support, so audio is
+ * converted at most once on the way in and once on the way out. If the working format matches the input,
+ * nodes process the buffer passed to @fn process directly.
+ * All buffers are allocated when the format or nodes change, never while processing.
+ */
+class FYCORE_EXPORT DspChain
+{
+public:
+    /*!
+     * A set of nodes prepared for a format, ready to be swapped into the chain.
+     * Preparing may allocate, so is done separately from @fn replaceNodes.
+     */
+    struct Stage
+    {
+        DspNodeList nodes;
+        AudioFormat inputFormat;
+        AudioFormat workingFormat;
+        AudioBuffer workBuffer;
+    };
+
+    DspChain();
+
+    void setFormat(const AudioFormat& format);
+    [[nodiscard]] AudioFormat format() const;
+    [[nodiscard]] AudioFormat workingFormat() const;
+
+    [[nodiscard]] bool isEmpty() const;
+    /** Returns the total latency of all nodes in frames. */
+    [[nodiscard]] int latency() const;
+
+    /*!
+     * Prepares @p nodes to process audio in the current format.
+     * This doesn't modify the chain, so can be done without blocking processing.
+     */
+    [[nodiscard]] Stage prepareNodes(DspNodeList nodes) const;
+    /*!
+     * Replaces the current nodes with a stage returned from @fn prepareNodes.
+     * The output of the old and new nodes is crossfaded over a few milliseconds to avoid clicks.
+     */
+    void replaceNodes(Stage stage);
+    /** Returns nodes which have been replaced and are no longer used, so they can be destroyed. */
+    DspNodeList takeRetiredNodes();
+
+    /** Clears the state of all nodes and ends any transition. */
+    void reset();
+
+    void process(AudioBuffer& buffer);
+
+    /*!
+     * Returns the format all of @p nodes will process given @p inputFormat.
+     * The input format is preferred, followed by the common formats from most to least precise.
+     */
+    [[nodiscard]] static AudioFormat negotiateFormat(const DspNodeList& nodes, const AudioFormat& inputFormat);
+
+private:
+    void prepareStage(Stage& stage) const;
+    void processStage(Stage& stage, AudioBuffer& buffer);
+    void retirePrevious();
+
+    AudioFormat m_format;
+    Stage m_current;
+    Stage m_previous;
+    DspNodeList m_retired;
+
+    AudioFader m_fadeIn;
+    AudioFader m_fadeOut;
+    AudioBuffer m_transitionBuffer;
+};
+} // namespace Fooyin
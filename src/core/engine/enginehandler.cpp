@@ -22,6 +22,7 @@
 #include "audioplaybackengine.h"
 
 #include <core/coresettings.h>
+#include <core/engine/audioanalyser.h>
 #include <core/engine/audioengine.h>
 #include <core/player/playercontroller.h>
 #include <core/track.h>
@@ -57,6 +58,7 @@ public:
 
     QThread m_engineThread;
     AudioEngine* m_engine;
+    AudioAnalyser m_analyser;
 
     std::map<QString, OutputCreator> m_outputs;
 
@@ -74,6 +76,7 @@ EngineHandlerPrivate::EngineHandlerPrivate(EngineHandler* self, std::shared_ptr<
     , m_playerController{playerController}
     , m_settings{settings}
     , m_engine{new AudioPlaybackEngine(std::move(decoderProvider), m_settings)}
+    , m_analyser{m_engine->audioTap()}
 {
     m_engine->moveToThread(&m_engineThread);
     m_engineThread.start();
@@ -88,7 +91,6 @@ EngineHandlerPrivate::EngineHandlerPrivate(EngineHandler* self, std::shared_ptr<
     QObject::connect(m_engine, &AudioEngine::stateChanged, m_self,
                      [this](AudioEngine::PlaybackState state) { handleStateChange(state); });
     QObject::connect(m_engine, &AudioEngine::deviceError, m_self, &EngineController::engineError);
-    QObject::connect(m_engine, &AudioEngine::bufferPlayed, m_self, &EngineController::bufferPlayed);
     QObject::connect(m_engine, &AudioEngine::trackChanged, m_self, &EngineController::trackChanged);
     QObject::connect(m_engine, &AudioEngine::trackStatusChanged, m_self,
                      [this](AudioEngine::TrackStatus status) { handleTrackStatus(status); });
@@ -300,6 +302,17 @@ void EngineHandler::addOutput(const QString& name, OutputCreator output)
     }
     p->m_outputs.emplace(name, std::move(output));
 }
+
+std::shared_ptr<AudioTap> EngineHandler::audioTap() const
+{
+    // Created with the engine and never replaced, so safe to hand out from this thread
+    return p->m_engine->audioTap();
+}
+
+AudioAnalyser* EngineHandler::audioAnalyser() const
+{
+    return &p->m_analyser;
+}
 } // namespace Fooyin
 
 #include "moc_enginehandler.cpp"
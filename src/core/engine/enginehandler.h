@@ -49,6 +49,9 @@ public:
     [[nodiscard]] OutputDevices getOutputDevices(const QString& output) const override;
     void addOutput(const QString& name, OutputCreator output) override;
 
+    [[nodiscard]] std::shared_ptr<AudioTap> audioTap() const override;
+    [[nodiscard]] AudioAnalyser* audioAnalyser() const override;
+
 private:
     std::unique_ptr<EngineHandlerPrivate> p;
 };
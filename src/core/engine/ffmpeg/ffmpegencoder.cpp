@@ -0,0 +1,378 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ffmpegencoder.h"
+
+#if defined(__GNUG__)
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#elif defined(__clang__)
+#pragma clang diagnostic ignored "-Wold-style-cast"
+#endif
+
+extern "C"
+{
+#include <libavformat/avio.h>
+#include <libavutil/opt.h>
+}
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// Used for encoders which take frames of any size
+constexpr auto DefaultFrameSize = 4096;
+
+std::span<const AVSampleFormat> supportedSampleFormats(const AVCodecContext* context, const AVCodec* codec)
+{
+    const AVSampleFormat* formats{nullptr};
+    int count{0};
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    const void* config{nullptr};
+    if(avcodec_get_supported_config(context, codec, AV_CODEC_CONFIG_SAMPLE_FORMAT, 0, &config, &count) >= 0) {
+        formats = static_cast<const AVSampleFormat*>(config);
+    }
+#else
+    (void)context;
+    formats = codec->sample_fmts;
+    while(formats && formats[count] != AV_SAMPLE_FMT_NONE) {
+        ++count;
+    }
+#endif
+    return formats ? std::span{formats, static_cast<size_t>(count)} : std::span<const AVSampleFormat>{};
+}
+
+std::span<const int> supportedSampleRates(const AVCodecContext* context, const AVCodec* codec)
+{
+    const int* rates{nullptr};
+    int count{0};
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    const void* config{nullptr};
+    if(avcodec_get_supported_config(context, codec, AV_CODEC_CONFIG_SAMPLE_RATE, 0, &config, &count) >= 0) {
+        rates = static_cast<const int*>(config);
+    }
+#else
+    (void)context;
+    rates = codec->supported_samplerates;
+    while(rates && rates[count] != 0) {
+        ++count;
+    }
+#endif
+    return rates ? std::span{rates, static_cast<size_t>(count)} : std::span<const int>{};
+}
+
+// Keeps the input's sample type if the encoder takes it, otherwise uses the most precise one it does
+AVSampleFormat chooseSampleFormat(std::span<const AVSampleFormat> supported, const Fooyin::AudioFormat& format)
+{
+    const AVSampleFormat packed = Fooyin::Utils::sampleFormat(format.sampleFormat());
+    if(supported.empty()) {
+        return packed;
+    }
+
+    const auto same = std::ranges::find_if(
+        supported, [packed](AVSampleFormat candidate) { return av_get_packed_sample_fmt(candidate) == packed; });
+    if(same != supported.end()) {
+        return *same;
+    }
+
+    return *std::ranges::max_element(supported, {}, [](AVSampleFormat candidate) {
+        // Prefer float over integer of the same size
+        return (av_get_bytes_per_sample(candidate) * 2)
+             + (av_get_packed_sample_fmt(candidate) == AV_SAMPLE_FMT_FLT ? 1 : 0);
+    });
+}
+
+// Keeps the input's rate if possible, otherwise uses the closest higher rate, or the highest available
+int chooseSampleRate(std::span<const int> supported, int sampleRate)
+{
+    if(supported.empty() || std::ranges::find(supported, sampleRate) != supported.end()) {
+        return sampleRate;
+    }
+
+    int higher{0};
+    for(const int rate : supported) {
+        if(rate > sampleRate && (higher == 0 || rate < higher)) {
+            higher = rate;
+        }
+    }
+    return higher > 0 ? higher : std::ranges::max(supported);
+}
+} // namespace
+
+void OutputContextDeleter::operator()(AVFormatContext* context) const
+{
+    if(context) {
+        if(context->pb && !(context->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&context->pb);
+        }
+        avformat_free_context(context);
+    }
+}
+
+namespace Fooyin {
+FFmpegEncoder::FFmpegEncoder()
+    : m_stream{nullptr}
+    , m_planar{false}
+    , m_frameSize{0}
+    , m_samplesEncoded{0}
+{ }
+
+FFmpegEncoder::~FFmpegEncoder() = default;
+
+bool FFmpegEncoder::open(const QString& filepath, const QString& encoder, const AudioFormat& format, int bitrate,
+                         int compressionLevel)
+{
+    if(!format.isValid()) {
+        return fail(u"Invalid input format"_s);
+    }
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(encoder.toUtf8().constData());
+    if(!codec) {
+        return fail(u"Encoder %1 is not available"_s.arg(encoder));
+    }
+
+    const QByteArray path = filepath.toUtf8();
+
+    AVFormatContext* context{nullptr};
+    if(avformat_alloc_output_context2(&context, nullptr, nullptr, path.constData()) < 0 || !context) {
+        return fail(u"No container found for %1"_s.arg(filepath));
+    }
+    m_context.reset(context);
+
+    m_codec.reset(avcodec_alloc_context3(codec));
+    if(!m_codec) {
+        return fail(u"Could not allocate encoder context"_s);
+    }
+
+    const AVSampleFormat sampleFormat = chooseSampleFormat(supportedSampleFormats(m_codec.get(), codec), format);
+    const int sampleRate = chooseSampleRate(supportedSampleRates(m_codec.get(), codec), format.sampleRate());
+
+    m_codec->sample_fmt  = sampleFormat;
+    m_codec->sample_rate = sampleRate;
+    m_codec->time_base   = {1, sampleRate};
+#if OLD_CHANNEL_LAYOUT
+    m_codec->channels       = format.channelCount();
+    m_codec->channel_layout = av_get_default_channel_layout(format.channelCount());
+#else
+    av_channel_layout_default(&m_codec->ch_layout, format.channelCount());
+#endif
+
+    if(av_get_packed_sample_fmt(sampleFormat) == AV_SAMPLE_FMT_S32) {
+        // Lossless encoders only support full 32 bit samples as an experimental feature
+        m_codec->bits_per_raw_sample = 24;
+    }
+    if(bitrate > 0) {
+        m_codec->bit_rate = static_cast<int64_t>(bitrate) * 1000;
+    }
+    if(compressionLevel >= 0) {
+        m_codec->compression_level = compressionLevel;
+    }
+    if(m_context->oformat->flags & AVFMT_GLOBALHEADER) {
+        m_codec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if(const int ret = avcodec_open2(m_codec.get(), codec, nullptr); ret < 0) {
+        return fail(ret);
+    }
+
+    m_stream = avformat_new_stream(m_context.get(), nullptr);
+    if(!m_stream) {
+        return fail(u"Could not create output stream"_s);
+    }
+    if(const int ret = avcodec_parameters_from_context(m_stream->codecpar, m_codec.get()); ret < 0) {
+        return fail(ret);
+    }
+    m_stream->time_base = m_codec->time_base;
+
+    if(!(m_context->oformat->flags & AVFMT_NOFILE)) {
+        if(const int ret = avio_open(&m_context->pb, path.constData(), AVIO_FLAG_WRITE); ret < 0) {
+            return fail(ret);
+        }
+    }
+    if(const int ret = avformat_write_header(m_context.get(), nullptr); ret < 0) {
+        return fail(ret);
+    }
+
+    m_frame.reset(av_frame_alloc());
+    m_packet.reset(av_packet_alloc());
+    if(!m_frame || !m_packet) {
+        return fail(u"Could not allocate frame"_s);
+    }
+
+    m_inputFormat = {Utils::sampleFormat(av_get_packed_sample_fmt(sampleFormat), 32), sampleRate,
+                     format.channelCount()};
+    m_planar      = av_sample_fmt_is_planar(sampleFormat) == 1;
+    m_frameSize   = (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) || m_codec->frame_size <= 0
+                      ? DefaultFrameSize
+                      : m_codec->frame_size;
+
+    m_pending.clear();
+    m_samplesEncoded = 0;
+
+    return true;
+}
+
+AudioFormat FFmpegEncoder::inputFormat() const
+{
+    return m_inputFormat;
+}
+
+bool FFmpegEncoder::write(const AudioBuffer& buffer)
+{
+    if(!m_codec || buffer.format() != m_inputFormat) {
+        return fail(u"Audio doesn't match the encoder's format"_s);
+    }
+
+    const auto data = buffer.constData();
+    m_pending.insert(m_pending.end(), data.begin(), data.end());
+
+    const auto frameBytes = static_cast<size_t>(m_inputFormat.bytesForFrames(m_frameSize));
+
+    size_t offset{0};
+    while(m_pending.size() - offset >= frameBytes) {
+        if(!encodeFrame(m_pending.data() + offset, m_frameSize)) {
+            return false;
+        }
+        offset += frameBytes;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(offset));
+
+    return true;
+}
+
+bool FFmpegEncoder::finish()
+{
+    if(!m_codec) {
+        return false;
+    }
+
+    if(!m_pending.empty()) {
+        int frames = m_inputFormat.framesForBytes(static_cast<int>(m_pending.size()));
+        if(!(m_codec->codec->capabilities & (AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_VARIABLE_FRAME_SIZE))) {
+            // Pad the last frame with silence
+            m_pending.resize(static_cast<size_t>(m_inputFormat.bytesForFrames(m_frameSize)), std::byte{0});
+            frames = m_frameSize;
+        }
+        if(!encodeFrame(m_pending.data(), frames)) {
+            return false;
+        }
+        m_pending.clear();
+    }
+
+    if(!sendFrame(nullptr)) {
+        return false;
+    }
+
+    if(const int ret = av_write_trailer(m_context.get()); ret < 0) {
+        return fail(ret);
+    }
+
+    m_context.reset();
+    m_codec.reset();
+
+    return true;
+}
+
+QString FFmpegEncoder::error() const
+{
+    return m_error;
+}
+
+bool FFmpegEncoder::fail(const QString& error)
+{
+    m_error = error;
+    Utils::printError(error);
+    return false;
+}
+
+bool FFmpegEncoder::fail(int error)
+{
+    char errStr[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(error, errStr, AV_ERROR_MAX_STRING_SIZE);
+    return fail(QString::fromUtf8(errStr));
+}
+
+bool FFmpegEncoder::encodeFrame(const std::byte* data, int frames)
+{
+    av_frame_unref(m_frame.get());
+
+    m_frame->nb_samples  = frames;
+    m_frame->format      = m_codec->sample_fmt;
+    m_frame->sample_rate = m_codec->sample_rate;
+#if OLD_CHANNEL_LAYOUT
+    m_frame->channels       = m_codec->channels;
+    m_frame->channel_layout = m_codec->channel_layout;
+#else
+    av_channel_layout_copy(&m_frame->ch_layout, &m_codec->ch_layout);
+#endif
+
+    if(const int ret = av_frame_get_buffer(m_frame.get(), 0); ret < 0) {
+        return fail(ret);
+    }
+
+    const int channels   = m_inputFormat.channelCount();
+    const int sampleSize = m_inputFormat.bytesPerSample();
+
+    if(m_planar) {
+        for(int channel{0}; channel < channels; ++channel) {
+            auto* plane         = reinterpret_cast<std::byte*>(m_frame->extended_data[channel]);
+            const std::byte* in = data + (static_cast<size_t>(channel) * sampleSize);
+            for(int frame{0}; frame < frames; ++frame) {
+                std::memcpy(plane + (static_cast<size_t>(frame) * sampleSize),
+                            in + (static_cast<size_t>(frame) * channels * sampleSize), sampleSize);
+            }
+        }
+    }
+    else {
+        std::memcpy(m_frame->data[0], data, static_cast<size_t>(m_inputFormat.bytesForFrames(frames)));
+    }
+
+    m_frame->pts = m_samplesEncoded;
+    m_samplesEncoded += frames;
+
+    return sendFrame(m_frame.get());
+}
+
+bool FFmpegEncoder::sendFrame(const AVFrame* frame)
+{
+    if(const int ret = avcodec_send_frame(m_codec.get(), frame); ret < 0) {
+        return fail(ret);
+    }
+
+    while(true) {
+        const int ret = avcodec_receive_packet(m_codec.get(), m_packet.get());
+        if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if(ret < 0) {
+            return fail(ret);
+        }
+
+        av_packet_rescale_ts(m_packet.get(), m_codec->time_base, m_stream->time_base);
+        m_packet->stream_index = m_stream->index;
+
+        // Takes ownership of the packet's data
+        if(const int writeRet = av_interleaved_write_frame(m_context.get(), m_packet.get()); writeRet < 0) {
+            return fail(writeRet);
+        }
+    }
+}
+} // namespace Fooyin
@@ -0,0 +1,89 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "ffmpegcodec.h"
+#include "ffmpegutils.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <QString>
+
+#include <vector>
+
+namespace Fooyin {
+struct OutputContextDeleter
+{
+    void operator()(AVFormatContext* context) const;
+};
+using OutputContextPtr = std::unique_ptr<AVFormatContext, OutputContextDeleter>;
+
+/*!
+ * Encodes audio to a file with an FFmpeg encoder, muxed into the container matching the file's extension.
+ * Audio passed to @fn write must be in the format returned by @fn inputFormat: the interleaved format closest to the
+ * one the encoder was opened with that it accepts. Frames are split and deinterleaved as the encoder needs.
+ */
+class FFmpegEncoder
+{
+public:
+    FFmpegEncoder();
+    ~FFmpegEncoder();
+
+    FFmpegEncoder(const FFmpegEncoder&)            = delete;
+    FFmpegEncoder& operator=(const FFmpegEncoder&) = delete;
+
+    /*!
+     * Creates @p filepath, and opens the encoder named @p encoder for audio in @p format.
+     * @p bitrate is in kbps, and @p compressionLevel is codec specific; either is left at the codec's default when
+     * negative or zero.
+     */
+    bool open(const QString& filepath, const QString& encoder, const AudioFormat& format, int bitrate,
+              int compressionLevel);
+    [[nodiscard]] AudioFormat inputFormat() const;
+
+    bool write(const AudioBuffer& buffer);
+    /** Encodes whatever's left, and finalises the file. */
+    bool finish();
+
+    /** Returns a description of the last error. */
+    [[nodiscard]] QString error() const;
+
+private:
+    bool fail(const QString& error);
+    bool fail(int error);
+
+    bool encodeFrame(const std::byte* data, int frames);
+    bool sendFrame(const AVFrame* frame);
+
+    OutputContextPtr m_context;
+    CodecContextPtr m_codec;
+    AVStream* m_stream;
+    FramePtr m_frame;
+    PacketPtr m_packet;
+
+    AudioFormat m_inputFormat;
+    bool m_planar;
+    int m_frameSize;
+    // Interleaved audio not yet making up a whole frame
+    std::vector<std::byte> m_pending;
+    int64_t m_samplesEncoded;
+    QString m_error;
+};
+} // namespace Fooyin
@@ -25,6 +25,8 @@
 #include "ffmpegutils.h"
 #include "internalcoresettings.h"
 
+#include "engine/sampleconverters.h"
+
 #include <core/coresettings.h>
 #include <core/engine/audiobuffer.h>
 #include <utils/worker.h>
@@ -32,6 +34,11 @@
 #include <QDebug>
 #include <QFile>
 #include <QIODevice>
+#include <QThread>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
 
 #if defined(__GNUG__)
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -224,40 +231,10 @@ void parseTag(Fooyin::Track& track, AVDictionaryEntry* tag)
     }
 };
 
-void interleaveSamples(uint8_t** in, Fooyin::AudioBuffer& buffer)
-{
-    const auto format  = buffer.format();
-    const int channels = format.channelCount();
-    const int samples  = buffer.frameCount();
-    const int bps      = format.bytesPerSample();
-    auto* out          = buffer.data();
-
-    const int totalSamples = samples * channels;
-
-    for(int i{0}; i < totalSamples; ++i) {
-        const int sampleIndex  = i / channels;
-        const int channelIndex = i % channels;
-
-        const auto inOffset  = sampleIndex * bps;
-        const auto outOffset = i * bps;
-        std::memmove(out + outOffset, in[channelIndex] + inOffset, bps);
-    }
-}
-
-void interleave(uint8_t** in, Fooyin::AudioBuffer& buffer)
-{
-    if(!buffer.isValid()) {
-        return;
-    }
-
-    if(buffer.format().sampleFormat() != Fooyin::SampleFormat::Unknown) {
-        interleaveSamples(in, buffer);
-    }
-}
-
 int ffRead(void* data, uint8_t* buffer, int size)
 {
-    auto* device        = static_cast<QIODevice*>(data);
+    auto* device = static_cast<QIODevice*>(data);
+
     const auto sizeRead = device->read(std::bit_cast<char*>(buffer), size);
     if(sizeRead == 0) {
         return AVERROR_EOF;
@@ -365,6 +342,9 @@ QByteArray findCover(AVFormatContext* context, Fooyin::Track::Cover type)
 
     return {};
 }
+
+// Codecs open with ParallelDecoding. Offline jobs usually run a decoder per pool thread, so these share the cores.
+std::atomic<int> parallelCodecs{0};
 } // namespace
 
 namespace Fooyin {
@@ -373,23 +353,48 @@ class FFmpegInputPrivate
 public:
     explicit FFmpegInputPrivate(FFmpegDecoder* self)
         : m_self{self}
-    { }
+    {
+        const FySettings settings;
+        m_allExtensions = settings.value(Settings::Core::Internal::FFmpegAllExtensions).toBool();
+        m_decodeThreads = std::max(settings.value(Settings::Core::Internal::FFmpegDecodeThreads, 0).toInt(), 0);
+    }
+
+    ~FFmpegInputPrivate()
+    {
+        reportSpeed();
+        releaseThreads();
+    }
+
+    FFmpegInputPrivate(const FFmpegInputPrivate&)            = delete;
+    FFmpegInputPrivate& operator=(const FFmpegInputPrivate&) = delete;
 
     void reset();
     bool setup(QIODevice* source);
     void checkIsVbr(const Track& track);
 
     bool createCodec(AVStream* avStream);
+    void releaseThreads();
 
     void decodeAudio(const PacketPtr& packet);
     [[nodiscard]] int sendAVPacket(const PacketPtr& packet) const;
     int receiveAVFrames();
 
+    bool fetchPending();
+    [[nodiscard]] uint64_t pendingTime() const;
+    int readPending(std::byte* data, int frames);
+
     void readNext();
     void seek(uint64_t pos);
 
+    void reportSpeed();
+
     FFmpegDecoder* m_self;
 
+    bool m_allExtensions{false};
+    // 0 shares the cores between parallel decoders
+    int m_decodeThreads{0};
+    bool m_countedParallel{false};
+
     IOContextPtr m_ioContext;
     FormatContextPtr m_context;
     Stream m_stream;
@@ -406,33 +411,42 @@ public:
     bool m_returnFrame{false};
 
     AudioDecoder::DecoderOptions m_options;
-    AudioBuffer m_buffer;
     Frame m_frame;
-    int m_bufferPos{0};
+    // Decoded frame not yet read. It shares the codec's buffers, and is only interleaved or copied when read.
+    Frame m_pending;
+    int m_pendingOffset{0};
+    int m_pendingSkipped{0};
+    uint64_t m_pendingStart{0};
     int64_t m_seekPos{0};
     uint64_t m_currentPos{0};
     int m_bitrate{0};
-    int m_skipBytes{0};
+    int m_skipFrames{0};
+
+    // Time spent decoding, and the audio it produced, for the speed reported on reset
+    std::chrono::steady_clock::duration m_decodeTime{0};
+    uint64_t m_decodedFrames{0};
 };
 
 void FFmpegInputPrivate::reset()
 {
+    reportSpeed();
+    releaseThreads();
+
     m_error      = false;
     m_eof        = false;
     m_isDecoding = false;
     m_draining   = false;
     m_isVbr      = false;
     m_bitrate    = 0;
-    m_bufferPos  = 0;
     m_currentPos = 0;
-    m_skipBytes  = 0;
-    m_buffer.clear();
+    m_skipFrames = 0;
 
     m_context.reset();
     m_ioContext.reset();
-    m_stream = {};
-    m_codec  = {};
-    m_buffer = {};
+    m_stream        = {};
+    m_codec         = {};
+    m_pending       = {};
+    m_pendingOffset = 0;
 }
 
 bool FFmpegInputPrivate::setup(QIODevice* source)
@@ -499,6 +513,25 @@ bool FFmpegInputPrivate::createCodec(AVStream* avStream)
 
     avCodecContext.get()->pkt_timebase = m_timeBase;
 
+    // Frame threading delays output by a frame per thread, so playback always decodes on one thread
+    avCodecContext->thread_count = 1;
+
+    if((m_options & AudioDecoder::ParallelDecoding)
+       && (avCodec->capabilities & (AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS))) {
+        releaseThreads();
+        m_countedParallel = true;
+
+        // Several decoders each using every core would only slow each other down
+        const int active    = parallelCodecs.fetch_add(1, std::memory_order_relaxed) + 1;
+        const int available = std::max(QThread::idealThreadCount() / active, 1);
+        const int threads   = m_decodeThreads > 0 ? std::min(m_decodeThreads, available) : available;
+
+        if(threads > 1) {
+            avCodecContext->thread_count = threads;
+            avCodecContext->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        }
+    }
+
     if(avcodec_open2(avCodecContext.get(), avCodec, nullptr) < 0) {
         Utils::printError(u"Could not initialise codec context"_s);
         m_error = true;
@@ -510,6 +543,13 @@ bool FFmpegInputPrivate::createCodec(AVStream* avStream)
     return true;
 }
 
+void FFmpegInputPrivate::releaseThreads()
+{
+    if(std::exchange(m_countedParallel, false)) {
+        parallelCodecs.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
 void FFmpegInputPrivate::decodeAudio(const PacketPtr& packet)
 {
     if(!m_isDecoding) {
@@ -578,40 +618,74 @@ int FFmpegInputPrivate::receiveAVFrames()
     }
 
     if(!m_returnFrame) {
-        const auto sampleCount   = m_audioFormat.bytesPerFrame() * m_frame.sampleCount();
-        const uint64_t startTime = m_codec.context()->codec_id == AV_CODEC_ID_APE ? m_currentPos : m_frame.ptsMs();
+        const int frames = m_frame.sampleCount();
 
-        if(m_codec.isPlanar()) {
-            m_buffer = {m_audioFormat, startTime};
-            m_buffer.resize(static_cast<size_t>(sampleCount));
-            interleave(m_frame.avFrame()->data, m_buffer);
-        }
-        else {
-            m_buffer = {m_frame.avFrame()->data[0], static_cast<size_t>(sampleCount), m_audioFormat, startTime};
-        }
+        m_pending       = m_frame;
+        m_pendingOffset = 0;
+        m_pendingStart  = m_codec.context()->codec_id == AV_CODEC_ID_APE ? m_currentPos : m_frame.ptsMs();
 
         if(!(m_options & AudioDecoder::NoSeeking)) {
             // Handle seeking of APE files
-            if(m_skipBytes > 0) {
-                const auto len = std::min(sampleCount, m_skipBytes);
-                m_skipBytes -= len;
-
-                if(sampleCount - len == 0) {
-                    m_buffer.clear();
-                }
-                else {
-                    std::memmove(m_buffer.data(), m_buffer.data() + len, sampleCount - len);
-                    m_buffer.resize(sampleCount - len);
-                }
+            if(m_skipFrames > 0) {
+                m_pendingOffset = std::min(frames, m_skipFrames);
+                m_skipFrames -= m_pendingOffset;
             }
         }
+        m_pendingSkipped = m_pendingOffset;
 
-        m_currentPos += m_audioFormat.durationForBytes(m_buffer.byteCount());
+        if(m_pendingOffset >= frames) {
+            m_pending = {};
+        }
+
+        m_currentPos += m_audioFormat.durationForFrames(frames - m_pendingSkipped);
     }
 
     return result;
 }
 
+bool FFmpegInputPrivate::fetchPending()
+{
+    while(!m_pending.isValid() && !m_error) {
+        // Once at the end of the file, keep going only while the codec has frames left
+        const bool wasEof = m_eof;
+        readNext();
+        if(wasEof && !m_pending.isValid()) {
+            break;
+        }
+    }
+
+    return m_pending.isValid();
+}
+
+uint64_t FFmpegInputPrivate::pendingTime() const
+{
+    return m_pendingStart + m_audioFormat.durationForFrames(m_pendingOffset - m_pendingSkipped);
+}
+
+int FFmpegInputPrivate::readPending(std::byte* data, int frames)
+{
+    const AVFrame* frame = m_pending.avFrame();
+    const int count      = std::min(frames, frame->nb_samples - m_pendingOffset);
+
+    if(m_codec.isPlanar()) {
+        // Planes past the first 8 channels are only in extended_data
+        Audio::interleave(reinterpret_cast<const std::byte* const*>(frame->extended_data),
+                          m_audioFormat.channelCount(), m_audioFormat.bytesPerSample(), m_pendingOffset, count, data);
+    }
+    else {
+        const int bps = m_audioFormat.bytesPerFrame();
+        std::memcpy(data, frame->data[0] + (static_cast<size_t>(m_pendingOffset) * bps),
+                    static_cast<size_t>(count) * bps);
+    }
+
+    m_pendingOffset += count;
+    if(m_pendingOffset >= frame->nb_samples) {
+        m_pending = {};
+    }
+
+    return count;
+}
+
 void FFmpegInputPrivate::readNext()
 {
     if(!m_isDecoding) {
@@ -658,7 +732,7 @@ void FFmpegInputPrivate::readNext()
 
     if(m_seekPos > 0 && m_codec.context()->codec_id == AV_CODEC_ID_APE) {
         const auto packetPts = av_rescale_q_rnd(packet->pts, m_timeBase, TimeBaseMs, AVRounding::AV_ROUND_DOWN);
-        m_skipBytes          = m_audioFormat.bytesForDuration(std::abs(m_seekPos - packetPts));
+        m_skipFrames         = m_audioFormat.framesForDuration(std::abs(m_seekPos - packetPts));
     }
     m_seekPos = -1;
 
@@ -683,12 +757,27 @@ void FFmpegInputPrivate::seek(uint64_t pos)
     }
     avcodec_flush_buffers(m_codec.context());
 
-    m_bufferPos  = 0;
-    m_buffer     = {};
-    m_eof        = false;
-    m_draining   = false;
-    m_skipBytes  = 0;
-    m_currentPos = pos;
+    m_pending       = {};
+    m_pendingOffset = 0;
+    m_eof           = false;
+    m_draining      = false;
+    m_skipFrames    = 0;
+    m_currentPos    = pos;
+}
+
+void FFmpegInputPrivate::reportSpeed()
+{
+    if(m_decodedFrames > 0 && m_codec.context() && m_audioFormat.sampleRate() > 0) {
+        const double audioSecs  = static_cast<double>(m_decodedFrames) / m_audioFormat.sampleRate();
+        const double decodeSecs = std::chrono::duration<double>{m_decodeTime}.count();
+
+        qCDebug(FFMPEG) << "Decoded" << audioSecs << "s of" << avcodec_get_name(m_codec.context()->codec_id)
+                        << "at" << (decodeSecs > 0 ? audioSecs / decodeSecs : 0.0) << "x realtime using"
+                        << m_codec.context()->thread_count << "thread(s)";
+    }
+
+    m_decodeTime    = {};
+    m_decodedFrames = 0;
 }
 
 FFmpegDecoder::FFmpegDecoder()
@@ -699,8 +788,7 @@ FFmpegDecoder::~FFmpegDecoder() = default;
 
 QStringList FFmpegDecoder::extensions() const
 {
-    const FySettings settings;
-    return fileExtensions(settings.value(Settings::Core::Internal::FFmpegAllExtensions).toBool());
+    return fileExtensions(p->m_allExtensions);
 }
 
 int FFmpegDecoder::bitrate() const
@@ -750,7 +838,10 @@ Frame FFmpegDecoder::readFrame()
     p->m_returnFrame = true;
 
     if(!p->m_eof && !p->m_error) {
+        const auto start = std::chrono::steady_clock::now();
         p->readNext();
+        p->m_decodeTime += std::chrono::steady_clock::now() - start;
+        p->m_decodedFrames += static_cast<uint64_t>(std::max(p->m_frame.sampleCount(), 0));
         return p->m_frame;
     }
 
@@ -763,42 +854,44 @@ AudioBuffer FFmpegDecoder::readBuffer(size_t bytes)
         return {};
     }
 
-    while(!p->m_buffer.isValid() && !p->m_eof && !p->m_error) {
-        p->readNext();
+    const int bps = p->m_audioFormat.bytesPerFrame();
+    if(bps <= 0) {
+        return {};
     }
 
-    AudioBuffer buffer;
+    const int framesRequested = static_cast<int>(bytes) / bps;
 
-    const int bytesRequested = static_cast<int>(bytes);
-    int bytesWritten{0};
+    AudioBuffer buffer;
+    int framesWritten{0};
+    const auto start = std::chrono::steady_clock::now();
 
-    while(p->m_buffer.isValid() && bytesWritten < bytesRequested) {
+    // Decoded frames go straight into the buffer returned, without an intermediate copy
+    while(framesWritten < framesRequested && p->fetchPending()) {
         if(!buffer.isValid()) {
-            buffer = {p->m_buffer.format(), p->m_buffer.startTime()};
-        }
-        const int remaining = bytesRequested - bytesWritten;
-        const int count     = p->m_buffer.byteCount() - p->m_bufferPos;
-        if(count <= remaining) {
-            buffer.append(p->m_buffer.data() + p->m_bufferPos, count);
-            bytesWritten += count;
-            p->m_buffer    = {};
-            p->m_bufferPos = 0;
-            p->readNext();
-        }
-        else {
-            buffer.append(p->m_buffer.data() + p->m_bufferPos, remaining);
-            bytesWritten += remaining;
-            p->m_bufferPos += remaining;
+            buffer = {p->m_audioFormat, p->pendingTime()};
+            buffer.resize(static_cast<size_t>(framesRequested) * bps);
         }
+        framesWritten += p->readPending(buffer.data() + (static_cast<size_t>(framesWritten) * bps),
+                                        framesRequested - framesWritten);
     }
 
+    if(buffer.isValid()) {
+        buffer.resize(static_cast<size_t>(framesWritten) * bps);
+    }
+
+    p->m_decodeTime += std::chrono::steady_clock::now() - start;
+    p->m_decodedFrames += static_cast<uint64_t>(framesWritten);
+
     return buffer;
 }
 
+FFmpegReader::FFmpegReader()
+    : m_allExtensions{FySettings{}.value(Settings::Core::Internal::FFmpegAllExtensions).toBool()}
+{ }
+
 QStringList FFmpegReader::extensions() const
 {
-    const FySettings settings;
-    return fileExtensions(settings.value(Settings::Core::Internal::FFmpegAllExtensions).toBool());
+    return fileExtensions(m_allExtensions);
 }
 
 bool FFmpegReader::canReadCover() const
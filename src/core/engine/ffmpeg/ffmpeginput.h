@@ -59,6 +59,8 @@ private:
 class FFmpegReader : public AudioReader
 {
 public:
+    FFmpegReader();
+
     [[nodiscard]] QStringList extensions() const override;
     [[nodiscard]] bool canReadCover() const override;
     [[nodiscard]] bool canWriteMetaData() const override;
@@ -66,5 +68,8 @@ public:
     [[nodiscard]] bool readTrack(const AudioSource& source, Track& track) override;
     [[nodiscard]] QByteArray readCover(const AudioSource& source, const Track& track, Track::Cover cover) override;
     [[nodiscard]] bool writeTrack(const AudioSource& source, const Track& track, WriteOptions options) override;
+
+private:
+    bool m_allExtensions;
 };
 } // namespace Fooyin
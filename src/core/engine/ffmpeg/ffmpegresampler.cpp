@@ -28,16 +28,56 @@ extern "C"
 #include <libavutil/opt.h>
 }
 
-namespace Fooyin {
-FFmpegResampler::FFmpegResampler(const AudioFormat& inFormat, const AudioFormat& outFormat, uint64_t startTime)
-    : m_inFormat{inFormat}
-    , m_outFormat{outFormat}
-    , m_startTime{startTime}
-    , m_samplesConverted{0}
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+Q_LOGGING_CATEGORY(RESAMPLER, "fy.resampler")
+
+namespace {
+constexpr auto NoTime = std::numeric_limits<uint64_t>::max();
+// Enough for the current and next track in a few formats, without holding on to many filter banks
+constexpr size_t MaxCachedContexts = 8;
+
+void applyQuality(SwrContext* context, Fooyin::ResamplerQuality quality, bool useSoxr)
 {
-    if(!inFormat.isValid() || !outFormat.isValid()) {
-        return;
+    switch(quality) {
+        case(Fooyin::ResamplerQuality::Fast):
+            av_opt_set_int(context, "filter_size", 8, 0);
+            av_opt_set_int(context, "phase_shift", 6, 0);
+            av_opt_set_int(context, "linear_interp", 1, 0);
+            break;
+        case(Fooyin::ResamplerQuality::Standard):
+            // swresample's defaults
+            break;
+        case(Fooyin::ResamplerQuality::High):
+            av_opt_set_int(context, "filter_size", 64, 0);
+            av_opt_set_int(context, "phase_shift", 12, 0);
+            av_opt_set_int(context, "exact_rational", 1, 0);
+            av_opt_set_double(context, "cutoff", 0.98, 0);
+            break;
+        case(Fooyin::ResamplerQuality::Best):
+            if(useSoxr) {
+                av_opt_set_int(context, "resampler", SWR_ENGINE_SOXR, 0);
+                av_opt_set_int(context, "precision", 28, 0);
+            }
+            else {
+                av_opt_set_int(context, "filter_size", 128, 0);
+                av_opt_set_int(context, "phase_shift", 14, 0);
+                av_opt_set_int(context, "exact_rational", 1, 0);
+                av_opt_set_double(context, "cutoff", 0.98, 0);
+            }
+            break;
     }
+}
+
+Fooyin::SwrContextPtr createContext(const Fooyin::AudioFormat& inFormat, const Fooyin::AudioFormat& outFormat,
+                                    Fooyin::ResamplerQuality quality, bool useSoxr = true)
+{
+    using namespace Fooyin;
 
     SwrContext* context{nullptr};
 #if OLD_CHANNEL_LAYOUT
@@ -54,10 +94,104 @@ FFmpegResampler::FFmpegResampler(const AudioFormat& inFormat, const AudioFormat&
     swr_alloc_set_opts2(&context, &outLayout, Utils::sampleFormat(outFormat.sampleFormat()), outFormat.sampleRate(),
                         &inLayout, Utils::sampleFormat(inFormat.sampleFormat()), inFormat.sampleRate(), 0, nullptr);
 #endif
-    if(swr_init(context) < 0) {
+    SwrContextPtr contextPtr{context, SwrContextDeleter()};
+    if(!contextPtr) {
+        return {};
+    }
+
+    applyQuality(contextPtr.get(), quality, useSoxr);
+
+    if(swr_init(contextPtr.get()) < 0) {
+        if(quality == ResamplerQuality::Best && useSoxr) {
+            qCDebug(RESAMPLER) << "SoX resampler unavailable, using swresample";
+            return createContext(inFormat, outFormat, quality, false);
+        }
+        return {};
+    }
+
+    return contextPtr;
+}
+
+class ContextCache
+{
+public:
+    Fooyin::SwrContextPtr take(const Fooyin::AudioFormat& inFormat, const Fooyin::AudioFormat& outFormat,
+                               Fooyin::ResamplerQuality quality)
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        auto it = std::ranges::find_if(m_contexts, [&](const CachedContext& cached) {
+            return cached.quality == quality && cached.inFormat == inFormat && cached.outFormat == outFormat;
+        });
+        if(it == m_contexts.end()) {
+            return {};
+        }
+
+        auto context = std::move(it->context);
+        m_contexts.erase(it);
+        return context;
+    }
+
+    void give(const Fooyin::AudioFormat& inFormat, const Fooyin::AudioFormat& outFormat,
+              Fooyin::ResamplerQuality quality, Fooyin::SwrContextPtr context)
+    {
+        const std::scoped_lock lock{m_mutex};
+
+        if(m_contexts.size() >= MaxCachedContexts) {
+            m_contexts.erase(m_contexts.begin());
+        }
+        m_contexts.push_back({inFormat, outFormat, quality, std::move(context)});
+    }
+
+private:
+    struct CachedContext
+    {
+        Fooyin::AudioFormat inFormat;
+        Fooyin::AudioFormat outFormat;
+        Fooyin::ResamplerQuality quality;
+        Fooyin::SwrContextPtr context;
+    };
+
+    std::mutex m_mutex;
+    std::vector<CachedContext> m_contexts;
+};
+
+ContextCache& contextCache()
+{
+    static ContextCache cache;
+    return cache;
+}
+} // namespace
+
+namespace Fooyin {
+FFmpegResampler::FFmpegResampler(const AudioFormat& inFormat, const AudioFormat& outFormat, uint64_t startTime,
+                                 ResamplerQuality quality)
+    : m_inFormat{inFormat}
+    , m_outFormat{outFormat}
+    , m_quality{quality}
+    , m_startTime{startTime}
+    , m_samplesConverted{0}
+{
+    if(!inFormat.isValid() || !outFormat.isValid()) {
         return;
     }
-    m_context = {context, SwrContextDeleter()};
+
+    m_context = contextCache().take(inFormat, outFormat, quality);
+    // Re-initialising clears any state from the last use, but keeps the filter bank
+    if(m_context && swr_init(m_context.get()) < 0) {
+        m_context.reset();
+    }
+
+    if(!m_context) {
+        m_context = createContext(inFormat, outFormat, quality);
+    }
+}
+
+FFmpegResampler::~FFmpegResampler()
+{
+    if(m_context) {
+        contextCache().give(m_inFormat, m_outFormat, m_quality, std::move(m_context));
+    }
 }
 
 bool FFmpegResampler::canResample() const
@@ -65,24 +199,94 @@ bool FFmpegResampler::canResample() const
     return m_context != nullptr;
 }
 
+AudioFormat FFmpegResampler::inputFormat() const
+{
+    return m_inFormat;
+}
+
+AudioFormat FFmpegResampler::outputFormat() const
+{
+    return m_outFormat;
+}
+
+ResamplerQuality FFmpegResampler::quality() const
+{
+    return m_quality;
+}
+
+void FFmpegResampler::setStartTime(uint64_t startTime)
+{
+    m_startTime = startTime;
+}
+
+void FFmpegResampler::reset()
+{
+    if(m_context && swr_init(m_context.get()) < 0) {
+        m_context.reset();
+    }
+
+    m_startTime        = NoTime;
+    m_samplesConverted = 0;
+}
+
 AudioBuffer FFmpegResampler::resample(const AudioBuffer& buffer)
 {
     AudioBuffer outBuffer{m_outFormat, buffer.startTime()};
+    resample(buffer, outBuffer);
+    return outBuffer;
+}
 
-    const AudioFormat outFormat = outBuffer.format();
+int FFmpegResampler::resample(const AudioBuffer& buffer, AudioBuffer& output)
+{
+    if(m_startTime == NoTime) {
+        m_startTime = buffer.startTime();
+    }
 
-    const int outCount = swr_get_out_samples(m_context.get(), buffer.frameCount());
-    outBuffer.resize(outFormat.bytesForFrames(outCount));
+    if(!output.isValid() || output.format() != m_outFormat) {
+        output = {m_outFormat, buffer.startTime()};
+    }
+
+    const int outCount = std::max(swr_get_out_samples(m_context.get(), buffer.frameCount()), 0);
+    output.resize(m_outFormat.bytesForFrames(outCount));
 
     const auto* in = std::bit_cast<const uint8_t*>(buffer.data());
-    auto* out      = std::bit_cast<uint8_t*>(outBuffer.data());
+    auto* out      = std::bit_cast<uint8_t*>(output.data());
+
+    const int outSamples = std::max(swr_convert(m_context.get(), &out, outCount, &in, buffer.frameCount()), 0);
+    output.resize(m_outFormat.bytesForFrames(outSamples));
 
-    const int outSamples = swr_convert(m_context.get(), &out, outCount, &in, buffer.frameCount());
-    outBuffer.resize(outFormat.bytesForFrames(outSamples));
+    const uint64_t startTime = m_outFormat.durationForFrames(static_cast<int>(m_samplesConverted)) + m_startTime;
+    output.setStartTime(startTime);
+
+    m_samplesConverted += outSamples;
 
-    const uint64_t startTime = outFormat.durationForFrames(static_cast<int>(m_samplesConverted)) + m_startTime;
-    outBuffer.setStartTime(startTime);
+    return outSamples;
+}
+
+AudioBuffer FFmpegResampler::flush()
+{
+    if(!m_context) {
+        return {};
+    }
+
+    const int outCount = std::max(swr_get_out_samples(m_context.get(), 0), 0);
+    if(outCount == 0) {
+        return {};
+    }
+
+    const uint64_t startTime = m_outFormat.durationForFrames(static_cast<int>(m_samplesConverted))
+                             + (m_startTime == NoTime ? 0 : m_startTime);
+
+    AudioBuffer outBuffer{m_outFormat, startTime};
+    outBuffer.resize(m_outFormat.bytesForFrames(outCount));
+
+    auto* out            = std::bit_cast<uint8_t*>(outBuffer.data());
+    const int outSamples = std::max(swr_convert(m_context.get(), &out, outCount, nullptr, 0), 0);
+    if(outSamples == 0) {
+        return {};
+    }
 
+    outBuffer.resize(m_outFormat.bytesForFrames(outSamples));
     m_samplesConverted += outSamples;
 
     return outBuffer;
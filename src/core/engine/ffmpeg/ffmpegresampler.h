@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include "internalcoresettings.h"
+
 #include <core/engine/audiobuffer.h>
 
 #if defined(__GNUG__)
@@ -52,18 +54,51 @@ struct SwrContextDeleter
 };
 using SwrContextPtr = std::unique_ptr<SwrContext, SwrContextDeleter>;
 
+/*!
+ * Converts audio between formats, including sample rate.
+ * Resampling contexts are cached per format pair and quality once a resampler is destroyed. swresample keeps
+ * its polyphase filter bank when a context is re-initialised with the same parameters, so creating another
+ * resampler for a pair already used skips rebuilding it.
+ */
 class FFmpegResampler
 {
 public:
-    FFmpegResampler(const AudioFormat& inFormat, const AudioFormat& outFormat, uint64_t startTime = 0);
+    FFmpegResampler(const AudioFormat& inFormat, const AudioFormat& outFormat, uint64_t startTime = 0,
+                    ResamplerQuality quality = ResamplerQuality::Standard);
+    ~FFmpegResampler();
+
+    FFmpegResampler(const FFmpegResampler&)            = delete;
+    FFmpegResampler& operator=(const FFmpegResampler&) = delete;
 
     [[nodiscard]] bool canResample() const;
+    [[nodiscard]] AudioFormat inputFormat() const;
+    [[nodiscard]] AudioFormat outputFormat() const;
+    [[nodiscard]] ResamplerQuality quality() const;
+
+    void setStartTime(uint64_t startTime);
+    /*!
+     * Drops any buffered samples, e.g. after seeking.
+     * Start times then follow the next buffer passed to @fn resample.
+     */
+    void reset();
 
     AudioBuffer resample(const AudioBuffer& buffer);
+    /*!
+     * Resamples @p buffer into @p output, reusing its storage if it's already in the output format.
+     * Nothing is allocated if @p output has enough capacity reserved.
+     * @returns the number of frames written to @p output.
+     */
+    int resample(const AudioBuffer& buffer, AudioBuffer& output);
+    /*!
+     * Returns samples still held by the resampler once all input has been passed to @fn resample.
+     * Call until an invalid buffer is returned.
+     */
+    AudioBuffer flush();
 
 private:
     AudioFormat m_inFormat;
     AudioFormat m_outFormat;
+    ResamplerQuality m_quality;
     uint64_t m_startTime;
 
     SwrContextPtr m_context;
@@ -0,0 +1,323 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "gainprocessor.h"
+
+#include "sampleconverters.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if(defined(__GNUC__) && defined(__x86_64__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr auto RampDuration    = 0.02;
+constexpr auto ReleaseDuration = 0.15;
+constexpr float Ceiling        = 1.0F;
+
+// Multiplies samples by a constant gain and returns the resulting absolute peak
+float scaleSamples(float* samples, int count, float gain)
+{
+    int i{0};
+    float peak{0.0F};
+
+#if(defined(__GNUC__) && defined(__x86_64__))
+    const __m128 factor  = _mm_set1_ps(gain);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 peaks         = _mm_setzero_ps();
+
+    for(; i + 8 <= count; i += 8) {
+        const __m128 lo = _mm_mul_ps(_mm_loadu_ps(samples + i), factor);
+        const __m128 hi = _mm_mul_ps(_mm_loadu_ps(samples + i + 4), factor);
+        _mm_storeu_ps(samples + i, lo);
+        _mm_storeu_ps(samples + i + 4, hi);
+        peaks = _mm_max_ps(peaks, _mm_max_ps(_mm_and_ps(lo, absMask), _mm_and_ps(hi, absMask)));
+    }
+
+    peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+    peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+    peak  = _mm_cvtss_f32(peaks);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    float32x4_t peaks = vdupq_n_f32(0.0F);
+
+    for(; i + 8 <= count; i += 8) {
+        const float32x4_t lo = vmulq_n_f32(vld1q_f32(samples + i), gain);
+        const float32x4_t hi = vmulq_n_f32(vld1q_f32(samples + i + 4), gain);
+        vst1q_f32(samples + i, lo);
+        vst1q_f32(samples + i + 4, hi);
+        peaks = vmaxq_f32(peaks, vmaxq_f32(vabsq_f32(lo), vabsq_f32(hi)));
+    }
+
+    peak = vmaxvq_f32(peaks);
+#endif
+
+    for(; i < count; ++i) {
+        samples[i] *= gain;
+        peak = std::max(peak, std::abs(samples[i]));
+    }
+
+    return peak;
+}
+} // namespace
+
+namespace Fooyin {
+namespace Audio {
+void applyGain(std::byte* data, SampleFormat format, int sampleCount, float gain)
+{
+    if(data && format == SampleFormat::F64) {
+        // Already wide enough to not need saturating, and narrowing would lose precision
+        for(int i{0}; i < sampleCount; ++i) {
+            double sample;
+            std::memcpy(&sample, data + i * sizeof(double), sizeof(double));
+            sample *= gain;
+            std::memcpy(data + i * sizeof(double), &sample, sizeof(double));
+        }
+        return;
+    }
+
+    const auto toFloat   = findSampleConverter(format, SampleFormat::F32);
+    const auto fromFloat = findSampleConverter(SampleFormat::F32, format);
+    if(!data || !toFloat || !fromFloat) {
+        return;
+    }
+
+    const int bps = AudioFormat{format, 0, 1}.bytesPerSample();
+
+    std::array<float, 1024> block;
+    auto* blockData = reinterpret_cast<std::byte*>(block.data());
+
+    for(int offset{0}; offset < sampleCount;) {
+        const int count    = std::min(static_cast<int>(block.size()), sampleCount - offset);
+        std::byte* samples = data + static_cast<ptrdiff_t>(offset) * bps;
+
+        toFloat(samples, blockData, count);
+        scaleSamples(block.data(), count, gain);
+        fromFloat(blockData, samples, count);
+
+        offset += count;
+    }
+}
+
+void mixSamples(const std::byte* input, std::byte* output, SampleFormat format, int sampleCount)
+{
+    if(input && output && format == SampleFormat::F64) {
+        for(int i{0}; i < sampleCount; ++i) {
+            double in;
+            double out;
+            std::memcpy(&in, input + i * sizeof(double), sizeof(double));
+            std::memcpy(&out, output + i * sizeof(double), sizeof(double));
+            out += in;
+            std::memcpy(output + i * sizeof(double), &out, sizeof(double));
+        }
+        return;
+    }
+
+    const auto toFloat   = findSampleConverter(format, SampleFormat::F32);
+    const auto fromFloat = findSampleConverter(SampleFormat::F32, format);
+    if(!input || !output || !toFloat || !fromFloat) {
+        return;
+    }
+
+    const int bps = AudioFormat{format, 0, 1}.bytesPerSample();
+
+    std::array<float, 1024> inBlock;
+    std::array<float, 1024> outBlock;
+    auto* inData  = reinterpret_cast<std::byte*>(inBlock.data());
+    auto* outData = reinterpret_cast<std::byte*>(outBlock.data());
+
+    for(int offset{0}; offset < sampleCount;) {
+        const int count       = std::min(static_cast<int>(inBlock.size()), sampleCount - offset);
+        const auto byteOffset = static_cast<ptrdiff_t>(offset) * bps;
+
+        toFloat(input + byteOffset, inData, count);
+        toFloat(output + byteOffset, outData, count);
+        for(int i{0}; i < count; ++i) {
+            outBlock[i] += inBlock[i];
+        }
+        fromFloat(outData, output + byteOffset, count);
+
+        offset += count;
+    }
+}
+} // namespace Audio
+
+GainProcessor::GainProcessor()
+    : m_channels{0}
+    , m_currentGain{1.0F}
+    , m_targetGain{1.0F}
+    , m_rampStep{0.0F}
+    , m_rampFrames{0}
+    , m_limiterEnabled{false}
+    , m_limiterGain{1.0F}
+    , m_releaseCoeff{0.0F}
+    , m_block{}
+{ }
+
+void GainProcessor::setFormat(const AudioFormat& format)
+{
+    m_format   = format;
+    m_channels = format.channelCount();
+
+    const int sampleRate = std::max(format.sampleRate(), 1);
+    m_releaseCoeff       = static_cast<float>(std::exp(-1.0 / (ReleaseDuration * sampleRate)));
+
+    reset();
+}
+
+double GainProcessor::gain() const
+{
+    return m_targetGain;
+}
+
+void GainProcessor::setGain(double gain, bool immediate)
+{
+    m_targetGain = static_cast<float>(gain);
+
+    const int rampFrames = static_cast<int>(RampDuration * m_format.sampleRate());
+
+    if(immediate || rampFrames <= 0 || m_targetGain == m_currentGain) {
+        m_currentGain = m_targetGain;
+        m_rampFrames  = 0;
+        m_rampStep    = 0.0F;
+        return;
+    }
+
+    m_rampFrames = rampFrames;
+    m_rampStep   = (m_targetGain - m_currentGain) / static_cast<float>(rampFrames);
+}
+
+void GainProcessor::setLimiterEnabled(bool enabled)
+{
+    m_limiterEnabled = enabled;
+}
+
+void GainProcessor::reset()
+{
+    m_currentGain = m_targetGain;
+    m_rampFrames  = 0;
+    m_rampStep    = 0.0F;
+    m_limiterGain = 1.0F;
+}
+
+bool GainProcessor::isActive() const
+{
+    return m_rampFrames > 0 || m_currentGain != 1.0F || m_limiterGain < 1.0F;
+}
+
+void GainProcessor::process(AudioBuffer& buffer)
+{
+    if(buffer.isValid() && buffer.format() == m_format) {
+        process(buffer.data(), buffer.frameCount());
+    }
+}
+
+void GainProcessor::process(std::byte* data, int frameCount)
+{
+    if(!data || frameCount <= 0 || m_channels <= 0 || !isActive()) {
+        return;
+    }
+
+    const auto toFloat   = Audio::findSampleConverter(m_format.sampleFormat(), SampleFormat::F32);
+    const auto fromFloat = Audio::findSampleConverter(SampleFormat::F32, m_format.sampleFormat());
+    if(!toFloat || !fromFloat) {
+        return;
+    }
+
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int blockFrames   = BlockSamples / m_channels;
+    auto* blockData         = reinterpret_cast<std::byte*>(m_block.data());
+
+    for(int offset{0}; offset < frameCount;) {
+        const int frames   = std::min(blockFrames, frameCount - offset);
+        const int samples  = frames * m_channels;
+        std::byte* current = data + static_cast<ptrdiff_t>(offset) * bytesPerFrame;
+
+        toFloat(current, blockData, samples);
+
+        const float peak = processBlock(frames);
+        if((m_limiterEnabled && peak > Ceiling) || m_limiterGain < 1.0F) {
+            limitBlock(frames);
+        }
+
+        fromFloat(blockData, current, samples);
+
+        offset += frames;
+    }
+}
+
+float GainProcessor::processBlock(int frameCount)
+{
+    float peak{0.0F};
+    int frame{0};
+
+    // Ramps are short, so step the gain a frame at a time
+    for(; m_rampFrames > 0 && frame < frameCount; ++frame) {
+        m_currentGain = --m_rampFrames == 0 ? m_targetGain : m_currentGain + m_rampStep;
+
+        float* samples = m_block.data() + static_cast<ptrdiff_t>(frame) * m_channels;
+        for(int ch{0}; ch < m_channels; ++ch) {
+            samples[ch] *= m_currentGain;
+            peak = std::max(peak, std::abs(samples[ch]));
+        }
+    }
+
+    if(frame < frameCount) {
+        float* samples  = m_block.data() + static_cast<ptrdiff_t>(frame) * m_channels;
+        const int count = (frameCount - frame) * m_channels;
+        peak            = std::max(peak, scaleSamples(samples, count, m_currentGain));
+    }
+
+    return peak;
+}
+
+void GainProcessor::limitBlock(int frameCount)
+{
+    for(int frame{0}; frame < frameCount; ++frame) {
+        float* samples = m_block.data() + static_cast<ptrdiff_t>(frame) * m_channels;
+
+        float peak{0.0F};
+        for(int ch{0}; ch < m_channels; ++ch) {
+            peak = std::max(peak, std::abs(samples[ch]));
+        }
+
+        // Attack instantly so no sample exceeds the ceiling, then release smoothly back to unity
+        const float required = peak > Ceiling ? Ceiling / peak : 1.0F;
+        if(required < m_limiterGain) {
+            m_limiterGain = required;
+        }
+        else {
+            m_limiterGain = required - (required - m_limiterGain) * m_releaseCoeff;
+            if(required == 1.0F && m_limiterGain > 0.9999F) {
+                m_limiterGain = 1.0F;
+            }
+        }
+
+        for(int ch{0}; ch < m_channels; ++ch) {
+            samples[ch] *= m_limiterGain;
+        }
+    }
+}
+} // namespace Fooyin
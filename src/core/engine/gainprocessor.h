@@ -0,0 +1,92 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audioformat.h>
+
+#include <array>
+#include <cstddef>
+
+namespace Fooyin {
+class AudioBuffer;
+
+namespace Audio {
+/*!
+ * Multiplies @p sampleCount samples of @p format in @p data by @p gain.
+ * Integer formats saturate rather than wrap if @p gain is greater than 1.
+ */
+FYCORE_EXPORT void applyGain(std::byte* data, SampleFormat format, int sampleCount, float gain);
+/*!
+ * Adds @p sampleCount samples of @p format in @p input to those in @p output.
+ * Integer formats saturate rather than wrap.
+ */
+FYCORE_EXPORT void mixSamples(const std::byte* input, std::byte* output, SampleFormat format, int sampleCount);
+} // namespace Audio
+
+/*!
+ * Applies gain, and optionally a peak limiter, to interleaved samples in their native format.
+ * Changes in gain are ramped per sample across calls to @fn process, so they can be made during playback
+ * without clicks. Processing never allocates.
+ */
+class FYCORE_EXPORT GainProcessor
+{
+public:
+    GainProcessor();
+
+    void setFormat(const AudioFormat& format);
+
+    [[nodiscard]] double gain() const;
+    /*!
+     * Sets the gain to apply.
+     * @param immediate if true, the gain applies from the next sample rather than ramping from the current gain.
+     */
+    void setGain(double gain, bool immediate = false);
+    /** If enabled, samples which would exceed full scale are limited rather than clipped. */
+    void setLimiterEnabled(bool enabled);
+
+    /** Finishes any ramp and resets the limiter. */
+    void reset();
+
+    /** Returns @c true if @fn process would modify samples. */
+    [[nodiscard]] bool isActive() const;
+
+    void process(AudioBuffer& buffer);
+    void process(std::byte* data, int frameCount);
+
+private:
+    static constexpr int BlockSamples = 1024;
+
+    float processBlock(int frameCount);
+    void limitBlock(int frameCount);
+
+    AudioFormat m_format;
+    int m_channels;
+    float m_currentGain;
+    float m_targetGain;
+    float m_rampStep;
+    int m_rampFrames;
+    bool m_limiterEnabled;
+    float m_limiterGain;
+    float m_releaseCoeff;
+    std::array<float, BlockSamples> m_block;
+};
+} // namespace Fooyin
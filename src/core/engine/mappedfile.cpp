@@ -0,0 +1,284 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/mappedfile.h>
+
+#include <QLoggingCategory>
+#include <QStorageInfo>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#ifdef Q_OS_UNIX
+#include <csetjmp>
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+Q_LOGGING_CATEGORY(MAPPED_FILE, "fy.mappedfile")
+
+namespace {
+// How far ahead of the read position to ask the kernel to load
+constexpr qint64 PrefetchLength = 4LL * 1024 * 1024;
+
+#ifdef Q_OS_UNIX
+void adviseRange(const std::byte* base, qint64 offset, qint64 length, int advice)
+{
+    static const auto pageSize = static_cast<qint64>(sysconf(_SC_PAGESIZE));
+
+    const qint64 start = offset - (offset % pageSize);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    auto* address = const_cast<std::byte*>(base + start);
+    madvise(address, static_cast<size_t>(length + (offset - start)), advice);
+}
+
+// Set only while the current thread is copying out of a mapping
+thread_local sigjmp_buf* copyJump{nullptr};
+struct sigaction previousBusAction{};
+
+void handleBusError(int signal, siginfo_t* info, void* context)
+{
+    if(copyJump) {
+        // The mapped file shrank under us, so abandon the copy
+        siglongjmp(*copyJump, 1);
+    }
+
+    // Not ours, so behave as if we were never installed
+    if(previousBusAction.sa_flags & SA_SIGINFO) {
+        if(previousBusAction.sa_sigaction) {
+            previousBusAction.sa_sigaction(signal, info, context);
+        }
+    }
+    else if(previousBusAction.sa_handler == SIG_DFL) {
+        // Returning re-runs the faulting access, which now takes the default action
+        std::signal(SIGBUS, SIG_DFL);
+    }
+    else if(previousBusAction.sa_handler != SIG_IGN) {
+        previousBusAction.sa_handler(signal);
+    }
+}
+
+void installBusHandler()
+{
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        struct sigaction action{};
+        action.sa_sigaction = handleBusError;
+        action.sa_flags     = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, &previousBusAction);
+    });
+}
+#endif
+
+// Returns false if the source faulted part way through the copy
+bool guardedCopy(char* dest, const std::byte* src, size_t size)
+{
+#ifdef Q_OS_UNIX
+    sigjmp_buf jump;
+    if(sigsetjmp(jump, 1) != 0) {
+        copyJump = nullptr;
+        return false;
+    }
+    copyJump = &jump;
+    // Keep the compiler from moving the copy outside the guarded region
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    std::memcpy(dest, src, size);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    copyJump = nullptr;
+#else
+    // Windows won't let a mapped file be truncated
+    std::memcpy(dest, src, size);
+#endif
+    return true;
+}
+} // namespace
+
+namespace Fooyin {
+MappedFile::MappedFile(const QString& filepath, QObject* parent)
+    : QIODevice{parent}
+    , m_file{filepath}
+    , m_data{nullptr}
+    , m_size{0}
+    , m_prefetchedTo{0}
+{ }
+
+MappedFile::~MappedFile()
+{
+    MappedFile::close();
+}
+
+bool MappedFile::canMap(const QString& filepath)
+{
+    const QStorageInfo storage{filepath};
+    if(!storage.isValid()) {
+        return false;
+    }
+
+    static const QList<QByteArray> networkTypes
+        = {"nfs", "nfs4", "cifs", "smb", "smbfs", "smb3", "afs", "9p", "ceph", "fuse.sshfs", "fuse.rclone", "davfs"};
+
+    const QByteArray type = storage.fileSystemType();
+    return !std::ranges::any_of(networkTypes, [&type](const QByteArray& network) { return type == network; });
+}
+
+bool MappedFile::open(OpenMode mode)
+{
+    if((mode & QIODevice::WriteOnly) || isOpen()) {
+        return false;
+    }
+
+    if(!m_file.open(QIODevice::ReadOnly)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_size = m_file.size();
+    if(m_size > 0) {
+        m_data = reinterpret_cast<const std::byte*>(m_file.map(0, m_size));
+        if(!m_data) {
+            qCDebug(MAPPED_FILE) << "Unable to map" << m_file.fileName() << m_file.errorString();
+            setErrorString(m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    }
+
+#ifdef Q_OS_UNIX
+    if(m_data) {
+        installBusHandler();
+        adviseRange(m_data, 0, m_size, MADV_SEQUENTIAL);
+    }
+#endif
+
+    m_prefetchedTo = 0;
+    prefetch(0);
+
+    // Reads come straight from the mapping, so there's nothing to gain from QIODevice's buffer
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void MappedFile::close()
+{
+    if(!isOpen()) {
+        return;
+    }
+
+    QIODevice::close();
+
+    unmap();
+    m_file.close();
+
+    m_size         = 0;
+    m_prefetchedTo = 0;
+}
+
+bool MappedFile::isMapped() const
+{
+    return m_data != nullptr;
+}
+
+bool MappedFile::isSequential() const
+{
+    return false;
+}
+
+qint64 MappedFile::size() const
+{
+    return m_data ? m_size : m_file.size();
+}
+
+bool MappedFile::seek(qint64 pos)
+{
+    if(pos < 0 || pos > size()) {
+        return false;
+    }
+
+    if(pos < m_prefetchedTo - PrefetchLength || pos > m_prefetchedTo) {
+        // Jumped away from the prefetched region
+        m_prefetchedTo = pos;
+    }
+    prefetch(pos);
+
+    return QIODevice::seek(pos);
+}
+
+qint64 MappedFile::readData(char* data, qint64 maxSize)
+{
+    const qint64 current = pos();
+
+    if(m_data) {
+        const qint64 length = std::min(maxSize, m_size - current);
+        if(length <= 0) {
+            return 0;
+        }
+
+        if(guardedCopy(data, m_data + current, static_cast<size_t>(length))) {
+            prefetch(current + length);
+            return length;
+        }
+
+        qCInfo(MAPPED_FILE) << m_file.fileName() << "was truncated while mapped, reading it directly instead";
+        unmap();
+    }
+
+    if(!m_file.seek(current)) {
+        return 0;
+    }
+    const qint64 bytesRead = m_file.read(data, maxSize);
+    return bytesRead < 0 ? 0 : bytesRead;
+}
+
+qint64 MappedFile::writeData(const char* /*data*/, qint64 /*maxSize*/)
+{
+    return -1;
+}
+
+void MappedFile::unmap()
+{
+    if(m_data) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<std::byte*>(m_data)));
+        m_data = nullptr;
+    }
+}
+
+void MappedFile::prefetch(qint64 pos)
+{
+    // Top up once half of the prefetched region has been read
+    if(!m_data || m_prefetchedTo >= m_size || pos + (PrefetchLength / 2) < m_prefetchedTo) {
+        return;
+    }
+
+    const qint64 start  = std::max(pos, m_prefetchedTo);
+    const qint64 length = std::min(pos + PrefetchLength, m_size) - start;
+    if(length <= 0) {
+        return;
+    }
+
+#ifdef Q_OS_UNIX
+    adviseRange(m_data, start, length, MADV_WILLNEED);
+#endif
+
+    m_prefetchedTo = start + length;
+}
+} // namespace Fooyin
@@ -0,0 +1,955 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sampleconverters.h"
+
+#include <utils/fymath.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if(defined(__GNUC__) && defined(__x86_64__))
+#define FY_CONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define FY_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace Fooyin::Audio;
+
+namespace {
+using ConverterTable = std::array<std::array<SampleConverter, 5>, 5>;
+
+constexpr float S16ScaleF  = 32768.0F;
+constexpr float S32ScaleF  = 2147483648.0F;
+constexpr double S16ScaleD = 32768.0;
+constexpr double S32ScaleD = 2147483648.0;
+
+// Largest float below 2^31, as INT32_MAX itself isn't representable
+constexpr float S32MaxF = 2147483520.0F;
+
+int formatIndex(Fooyin::SampleFormat format)
+{
+    switch(format) {
+        case(Fooyin::SampleFormat::U8):
+            return 0;
+        case(Fooyin::SampleFormat::S16):
+            return 1;
+        case(Fooyin::SampleFormat::S24):
+        case(Fooyin::SampleFormat::S32):
+            return 2;
+        case(Fooyin::SampleFormat::F32):
+            return 3;
+        case(Fooyin::SampleFormat::F64):
+            return 4;
+        case(Fooyin::SampleFormat::Unknown):
+        default:
+            return -1;
+    }
+}
+
+int16_t u8ToS16(uint8_t inSample)
+{
+    return static_cast<int16_t>((inSample - 0x80) * 0x100);
+}
+
+int32_t u8ToS32(uint8_t inSample)
+{
+    return (inSample - 0x80) * 0x1000000;
+}
+
+float u8ToF32(uint8_t inSample)
+{
+    return static_cast<float>(inSample - 0x80) * (1.0F / 128.0F);
+}
+
+double u8ToF64(uint8_t inSample)
+{
+    return static_cast<double>(inSample - 0x80) * (1.0 / 128.0);
+}
+
+uint8_t s16ToU8(int16_t inSample)
+{
+    return static_cast<uint8_t>((inSample >> 8) + 0x80);
+}
+
+int32_t s16ToS32(int16_t inSample)
+{
+    return static_cast<int32_t>(inSample) << 16;
+}
+
+float s16ToF32(int16_t inSample)
+{
+    return static_cast<float>(inSample) * (1.0F / S16ScaleF);
+}
+
+double s16ToF64(int16_t inSample)
+{
+    return static_cast<double>(inSample) * (1.0 / S16ScaleD);
+}
+
+uint8_t s32ToU8(int32_t inSample)
+{
+    return static_cast<uint8_t>((inSample >> 24) + 0x80);
+}
+
+int16_t s32ToS16(int32_t inSample)
+{
+    return static_cast<int16_t>(inSample >> 16);
+}
+
+float s32ToF32(int32_t inSample)
+{
+    return static_cast<float>(inSample) * (1.0F / S32ScaleF);
+}
+
+double s32ToF64(int32_t inSample)
+{
+    return static_cast<double>(inSample) * (1.0 / S32ScaleD);
+}
+
+// Float to integer conversions clamp before rounding, so full scale input can't overflow
+uint8_t f32ToU8(float inSample)
+{
+    return static_cast<uint8_t>(Fooyin::Math::fltToInt(std::clamp(inSample * 128.0F, -128.0F, 127.0F)) + 0x80);
+}
+
+int16_t f32ToS16(float inSample)
+{
+    return static_cast<int16_t>(Fooyin::Math::fltToInt(std::clamp(inSample * S16ScaleF, -S16ScaleF, 32767.0F)));
+}
+
+int32_t f32ToS32(float inSample)
+{
+    return Fooyin::Math::fltToInt(std::clamp(inSample * S32ScaleF, -S32ScaleF, S32MaxF));
+}
+
+double f32ToF64(float inSample)
+{
+    return static_cast<double>(inSample);
+}
+
+uint8_t f64ToU8(double inSample)
+{
+    return static_cast<uint8_t>(Fooyin::Math::fltToInt(std::clamp(inSample * 128.0, -128.0, 127.0)) + 0x80);
+}
+
+int16_t f64ToS16(double inSample)
+{
+    return static_cast<int16_t>(Fooyin::Math::fltToInt(std::clamp(inSample * S16ScaleD, -S16ScaleD, 32767.0)));
+}
+
+int32_t f64ToS32(double inSample)
+{
+    return Fooyin::Math::fltToInt(std::clamp(inSample * S32ScaleD, -S32ScaleD, 2147483647.0));
+}
+
+float f64ToF32(double inSample)
+{
+    return static_cast<float>(inSample);
+}
+
+template <typename T>
+void copySamples(const std::byte* input, std::byte* output, int sampleCount)
+{
+    std::memcpy(output, input, static_cast<size_t>(sampleCount) * sizeof(T));
+}
+
+// Kept free of aliasing and branches so the compiler can vectorise it for the baseline instruction set
+template <typename In, typename Out, Out (*Func)(In)>
+void convertSamples(const std::byte* input, std::byte* output, int sampleCount)
+{
+    for(int i{0}; i < sampleCount; ++i) {
+        In inSample;
+        std::memcpy(&inSample, input + i * sizeof(In), sizeof(In));
+        const Out outSample = Func(inSample);
+        std::memcpy(output + i * sizeof(Out), &outSample, sizeof(Out));
+    }
+}
+
+// Runs a vector kernel, which returns the number of samples it handled, then finishes the tail with the scalar loop
+template <typename In, typename Out, Out (*Func)(In), int (*Kernel)(const std::byte*, std::byte*, int)>
+void convertVector(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const int done = Kernel(input, output, sampleCount);
+    convertSamples<In, Out, Func>(input + done * sizeof(In), output + done * sizeof(Out), sampleCount - done);
+}
+
+ConverterTable scalarTable()
+{
+    ConverterTable table{};
+
+    table[0] = {copySamples<uint8_t>, convertSamples<uint8_t, int16_t, u8ToS16>,
+                convertSamples<uint8_t, int32_t, u8ToS32>, convertSamples<uint8_t, float, u8ToF32>,
+                convertSamples<uint8_t, double, u8ToF64>};
+    table[1] = {convertSamples<int16_t, uint8_t, s16ToU8>, copySamples<int16_t>,
+                convertSamples<int16_t, int32_t, s16ToS32>, convertSamples<int16_t, float, s16ToF32>,
+                convertSamples<int16_t, double, s16ToF64>};
+    table[2] = {convertSamples<int32_t, uint8_t, s32ToU8>, convertSamples<int32_t, int16_t, s32ToS16>,
+                copySamples<int32_t>, convertSamples<int32_t, float, s32ToF32>,
+                convertSamples<int32_t, double, s32ToF64>};
+    table[3] = {convertSamples<float, uint8_t, f32ToU8>, convertSamples<float, int16_t, f32ToS16>,
+                convertSamples<float, int32_t, f32ToS32>, copySamples<float>,
+                convertSamples<float, double, f32ToF64>};
+    table[4] = {convertSamples<double, uint8_t, f64ToU8>, convertSamples<double, int16_t, f64ToS16>,
+                convertSamples<double, int32_t, f64ToS32>, convertSamples<double, float, f64ToF32>,
+                copySamples<double>};
+
+    return table;
+}
+
+#if defined(FY_CONVERT_X86)
+// SSE2 is part of the x86_64 baseline, so these are always available
+
+int s16ToF32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128 scale = _mm_set1_ps(1.0F / S16ScaleF);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+        _mm_storeu_ps(reinterpret_cast<float*>(output + i * 4), _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(reinterpret_cast<float*>(output + i * 4 + 16), _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+int s32ToF32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128 scale = _mm_set1_ps(1.0F / S32ScaleF);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+        _mm_storeu_ps(reinterpret_cast<float*>(output + i * 4), _mm_mul_ps(_mm_cvtepi32_ps(in), scale));
+    }
+    return i;
+}
+
+int f32ToS16Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128 scale = _mm_set1_ps(S16ScaleF);
+    const __m128 min   = _mm_set1_ps(-S16ScaleF);
+    const __m128 max   = _mm_set1_ps(32767.0F);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        __m128 lo = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        __m128 hi = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4 + 16));
+        lo        = _mm_min_ps(_mm_max_ps(_mm_mul_ps(lo, scale), min), max);
+        hi        = _mm_min_ps(_mm_max_ps(_mm_mul_ps(hi, scale), min), max);
+        const __m128i out = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), out);
+    }
+    return i;
+}
+
+int f32ToS32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128 scale = _mm_set1_ps(S32ScaleF);
+    const __m128 min   = _mm_set1_ps(-S32ScaleF);
+    const __m128 max   = _mm_set1_ps(S32MaxF);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        __m128 in = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        in        = _mm_min_ps(_mm_max_ps(_mm_mul_ps(in, scale), min), max);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm_cvtps_epi32(in));
+    }
+    return i;
+}
+
+int f32ToF64Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128 in = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        _mm_storeu_pd(reinterpret_cast<double*>(output + i * 8), _mm_cvtps_pd(in));
+        _mm_storeu_pd(reinterpret_cast<double*>(output + i * 8 + 16), _mm_cvtps_pd(_mm_movehl_ps(in, in)));
+    }
+    return i;
+}
+
+int f64ToF32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(input + i * 8)));
+        const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(input + i * 8 + 16)));
+        _mm_storeu_ps(reinterpret_cast<float*>(output + i * 4), _mm_movelh_ps(lo, hi));
+    }
+    return i;
+}
+
+int s16ToS32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm_unpacklo_epi16(zero, in));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), _mm_unpackhi_epi16(zero, in));
+    }
+    return i;
+}
+
+int s32ToS16Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4 + 16));
+        const __m128i out = _mm_packs_epi32(_mm_srai_epi32(lo, 16), _mm_srai_epi32(hi, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), out);
+    }
+    return i;
+}
+
+int s32ToF64Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128d scale = _mm_set1_pd(1.0 / S32ScaleD);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+        const __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(in), scale);
+        const __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(in, in)), scale);
+        _mm_storeu_pd(reinterpret_cast<double*>(output + i * 8), lo);
+        _mm_storeu_pd(reinterpret_cast<double*>(output + i * 8 + 16), hi);
+    }
+    return i;
+}
+
+int f64ToS32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128d scale = _mm_set1_pd(S32ScaleD);
+    const __m128d min   = _mm_set1_pd(-S32ScaleD);
+    const __m128d max   = _mm_set1_pd(2147483647.0);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        __m128d lo = _mm_loadu_pd(reinterpret_cast<const double*>(input + i * 8));
+        __m128d hi = _mm_loadu_pd(reinterpret_cast<const double*>(input + i * 8 + 16));
+        lo         = _mm_min_pd(_mm_max_pd(_mm_mul_pd(lo, scale), min), max);
+        hi         = _mm_min_pd(_mm_max_pd(_mm_mul_pd(hi, scale), min), max);
+        const __m128i out = _mm_unpacklo_epi64(_mm_cvtpd_epi32(lo), _mm_cvtpd_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), out);
+    }
+    return i;
+}
+
+int u8ToS16Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        const __m128i in = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_unpacklo_epi8(zero, in));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2 + 16), _mm_unpackhi_epi8(zero, in));
+    }
+    return i;
+}
+
+int u8ToS32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        const __m128i in = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), bias);
+        const __m128i lo = _mm_unpacklo_epi8(zero, in);
+        const __m128i hi = _mm_unpackhi_epi8(zero, in);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm_unpacklo_epi16(zero, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), _mm_unpackhi_epi16(zero, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 32), _mm_unpacklo_epi16(zero, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 48), _mm_unpackhi_epi16(zero, hi));
+    }
+    return i;
+}
+
+int u8ToF32Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128 scale = _mm_set1_ps(1.0F / 128.0F);
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        const __m128i in = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), bias);
+        const __m128i words[2] = {_mm_srai_epi16(_mm_unpacklo_epi8(in, in), 8),
+                                  _mm_srai_epi16(_mm_unpackhi_epi8(in, in), 8)};
+        for(int w{0}; w < 2; ++w) {
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words[w], words[w]), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words[w], words[w]), 16);
+            auto* out        = reinterpret_cast<float*>(output + (i + w * 8) * 4);
+            _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+    }
+    return i;
+}
+
+int s16ToU8Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        const __m128i lo  = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2)), 8);
+        const __m128i hi  = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2 + 16)), 8);
+        const __m128i out = _mm_xor_si128(_mm_packs_epi16(lo, hi), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), out);
+    }
+    return i;
+}
+
+int s32ToU8Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        __m128i in[4];
+        for(int v{0}; v < 4; ++v) {
+            const auto* src = reinterpret_cast<const __m128i*>(input + i * 4 + v * 16);
+            in[v]           = _mm_srai_epi32(_mm_loadu_si128(src), 24);
+        }
+        const __m128i words = _mm_packs_epi16(_mm_packs_epi32(in[0], in[1]), _mm_packs_epi32(in[2], in[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(words, bias));
+    }
+    return i;
+}
+
+int f32ToU8Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128 scale = _mm_set1_ps(128.0F);
+    const __m128 min   = _mm_set1_ps(-128.0F);
+    const __m128 max   = _mm_set1_ps(127.0F);
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        __m128i in[4];
+        for(int v{0}; v < 4; ++v) {
+            const __m128 samples = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4 + v * 16));
+            in[v]                = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(samples, scale), min), max));
+        }
+        const __m128i words = _mm_packs_epi16(_mm_packs_epi32(in[0], in[1]), _mm_packs_epi32(in[2], in[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(words, bias));
+    }
+    return i;
+}
+
+int s16ToF64Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128d scale = _mm_set1_pd(1.0 / S16ScaleD);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        const __m128i ints[2] = {_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16),
+                                 _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16)};
+        for(int v{0}; v < 2; ++v) {
+            auto* out = reinterpret_cast<double*>(output + (i + v * 4) * 8);
+            _mm_storeu_pd(out, _mm_mul_pd(_mm_cvtepi32_pd(ints[v]), scale));
+            _mm_storeu_pd(out + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(ints[v], ints[v])), scale));
+        }
+    }
+    return i;
+}
+
+int f64ToS16Sse2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m128d scale = _mm_set1_pd(S16ScaleD);
+    const __m128d min   = _mm_set1_pd(-S16ScaleD);
+    const __m128d max   = _mm_set1_pd(32767.0);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        __m128i in[4];
+        for(int v{0}; v < 4; ++v) {
+            const __m128d samples = _mm_loadu_pd(reinterpret_cast<const double*>(input + i * 8 + v * 16));
+            in[v]                 = _mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(_mm_mul_pd(samples, scale), min), max));
+        }
+        const __m128i lo = _mm_unpacklo_epi64(in[0], in[1]);
+        const __m128i hi = _mm_unpacklo_epi64(in[2], in[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+ConverterTable sse2Table()
+{
+    ConverterTable table = scalarTable();
+
+    table[0][1] = convertVector<uint8_t, int16_t, u8ToS16, u8ToS16Sse2>;
+    table[0][2] = convertVector<uint8_t, int32_t, u8ToS32, u8ToS32Sse2>;
+    table[0][3] = convertVector<uint8_t, float, u8ToF32, u8ToF32Sse2>;
+    table[1][0] = convertVector<int16_t, uint8_t, s16ToU8, s16ToU8Sse2>;
+    table[1][2] = convertVector<int16_t, int32_t, s16ToS32, s16ToS32Sse2>;
+    table[1][3] = convertVector<int16_t, float, s16ToF32, s16ToF32Sse2>;
+    table[1][4] = convertVector<int16_t, double, s16ToF64, s16ToF64Sse2>;
+    table[2][0] = convertVector<int32_t, uint8_t, s32ToU8, s32ToU8Sse2>;
+    table[2][1] = convertVector<int32_t, int16_t, s32ToS16, s32ToS16Sse2>;
+    table[2][3] = convertVector<int32_t, float, s32ToF32, s32ToF32Sse2>;
+    table[2][4] = convertVector<int32_t, double, s32ToF64, s32ToF64Sse2>;
+    table[3][0] = convertVector<float, uint8_t, f32ToU8, f32ToU8Sse2>;
+    table[3][1] = convertVector<float, int16_t, f32ToS16, f32ToS16Sse2>;
+    table[3][2] = convertVector<float, int32_t, f32ToS32, f32ToS32Sse2>;
+    table[3][4] = convertVector<float, double, f32ToF64, f32ToF64Sse2>;
+    table[4][1] = convertVector<double, int16_t, f64ToS16, f64ToS16Sse2>;
+    table[4][2] = convertVector<double, int32_t, f64ToS32, f64ToS32Sse2>;
+    table[4][3] = convertVector<double, float, f64ToF32, f64ToF32Sse2>;
+
+    return table;
+}
+
+// AVX2 kernels are compiled for the extension individually and only selected if the CPU supports it at runtime
+
+__attribute__((target("avx2"))) int s16ToF32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256 scale = _mm256_set1_ps(1.0F / S16ScaleF);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i in  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        const __m256 out = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(in)), scale);
+        _mm256_storeu_ps(reinterpret_cast<float*>(output + i * 4), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int s32ToF32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256 scale = _mm256_set1_ps(1.0F / S32ScaleF);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * 4));
+        _mm256_storeu_ps(reinterpret_cast<float*>(output + i * 4), _mm256_mul_ps(_mm256_cvtepi32_ps(in), scale));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int f32ToS16Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256 scale = _mm256_set1_ps(S16ScaleF);
+    const __m256 min   = _mm256_set1_ps(-S16ScaleF);
+    const __m256 max   = _mm256_set1_ps(32767.0F);
+
+    int i{0};
+    for(; i + 16 <= sampleCount; i += 16) {
+        __m256 lo = _mm256_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        __m256 hi = _mm256_loadu_ps(reinterpret_cast<const float*>(input + i * 4 + 32));
+        lo        = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(lo, scale), min), max);
+        hi        = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(hi, scale), min), max);
+        // Packing works per 128-bit lane, so restore sample order afterwards
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+        const __m256i out    = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 2), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int f32ToS32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256 scale = _mm256_set1_ps(S32ScaleF);
+    const __m256 min   = _mm256_set1_ps(-S32ScaleF);
+    const __m256 max   = _mm256_set1_ps(S32MaxF);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        __m256 in = _mm256_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        in        = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(in, scale), min), max);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 4), _mm256_cvtps_epi32(in));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int f32ToF64Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128 in = _mm_loadu_ps(reinterpret_cast<const float*>(input + i * 4));
+        _mm256_storeu_pd(reinterpret_cast<double*>(output + i * 8), _mm256_cvtps_pd(in));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int f64ToF32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m256d in = _mm256_loadu_pd(reinterpret_cast<const double*>(input + i * 8));
+        _mm_storeu_ps(reinterpret_cast<float*>(output + i * 4), _mm256_cvtpd_ps(in));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int s16ToS32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        const __m256i out = _mm256_slli_epi32(_mm256_cvtepi16_epi32(in), 16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 4), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int s32ToF64Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256d scale = _mm256_set1_pd(1.0 / S32ScaleD);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+        _mm256_storeu_pd(reinterpret_cast<double*>(output + i * 8), _mm256_mul_pd(_mm256_cvtepi32_pd(in), scale));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) int f64ToS32Avx2(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const __m256d scale = _mm256_set1_pd(S32ScaleD);
+    const __m256d min   = _mm256_set1_pd(-S32ScaleD);
+    const __m256d max   = _mm256_set1_pd(2147483647.0);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        __m256d in = _mm256_loadu_pd(reinterpret_cast<const double*>(input + i * 8));
+        in         = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(in, scale), min), max);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm256_cvtpd_epi32(in));
+    }
+    return i;
+}
+
+ConverterTable avx2Table()
+{
+    ConverterTable table = sse2Table();
+
+    table[1][2] = convertVector<int16_t, int32_t, s16ToS32, s16ToS32Avx2>;
+    table[1][3] = convertVector<int16_t, float, s16ToF32, s16ToF32Avx2>;
+    table[2][3] = convertVector<int32_t, float, s32ToF32, s32ToF32Avx2>;
+    table[2][4] = convertVector<int32_t, double, s32ToF64, s32ToF64Avx2>;
+    table[3][1] = convertVector<float, int16_t, f32ToS16, f32ToS16Avx2>;
+    table[3][2] = convertVector<float, int32_t, f32ToS32, f32ToS32Avx2>;
+    table[3][4] = convertVector<float, double, f32ToF64, f32ToF64Avx2>;
+    table[4][2] = convertVector<double, int32_t, f64ToS32, f64ToS32Avx2>;
+    table[4][3] = convertVector<double, float, f64ToF32, f64ToF32Avx2>;
+
+    return table;
+}
+
+bool hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#elif defined(FY_CONVERT_NEON)
+int s16ToF32Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const int16x8_t in = vld1q_s16(reinterpret_cast<const int16_t*>(input + i * 2));
+        const float32x4_t lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(in))), 1.0F / S16ScaleF);
+        const float32x4_t hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(in)), 1.0F / S16ScaleF);
+        vst1q_f32(reinterpret_cast<float*>(output + i * 4), lo);
+        vst1q_f32(reinterpret_cast<float*>(output + i * 4 + 16), hi);
+    }
+    return i;
+}
+
+int s32ToF32Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const int32x4_t in = vld1q_s32(reinterpret_cast<const int32_t*>(input + i * 4));
+        vst1q_f32(reinterpret_cast<float*>(output + i * 4), vmulq_n_f32(vcvtq_f32_s32(in), 1.0F / S32ScaleF));
+    }
+    return i;
+}
+
+int f32ToS16Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const float32x4_t min = vdupq_n_f32(-S16ScaleF);
+    const float32x4_t max = vdupq_n_f32(32767.0F);
+
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        float32x4_t lo = vld1q_f32(reinterpret_cast<const float*>(input + i * 4));
+        float32x4_t hi = vld1q_f32(reinterpret_cast<const float*>(input + i * 4 + 16));
+        lo             = vminq_f32(vmaxq_f32(vmulq_n_f32(lo, S16ScaleF), min), max);
+        hi             = vminq_f32(vmaxq_f32(vmulq_n_f32(hi, S16ScaleF), min), max);
+        const int16x8_t out = vcombine_s16(vmovn_s32(vcvtnq_s32_f32(lo)), vmovn_s32(vcvtnq_s32_f32(hi)));
+        vst1q_s16(reinterpret_cast<int16_t*>(output + i * 2), out);
+    }
+    return i;
+}
+
+int f32ToS32Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    const float32x4_t min = vdupq_n_f32(-S32ScaleF);
+    const float32x4_t max = vdupq_n_f32(S32MaxF);
+
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        float32x4_t in = vld1q_f32(reinterpret_cast<const float*>(input + i * 4));
+        in             = vminq_f32(vmaxq_f32(vmulq_n_f32(in, S32ScaleF), min), max);
+        vst1q_s32(reinterpret_cast<int32_t*>(output + i * 4), vcvtnq_s32_f32(in));
+    }
+    return i;
+}
+
+int f32ToF64Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const float32x4_t in = vld1q_f32(reinterpret_cast<const float*>(input + i * 4));
+        vst1q_f64(reinterpret_cast<double*>(output + i * 8), vcvt_f64_f32(vget_low_f32(in)));
+        vst1q_f64(reinterpret_cast<double*>(output + i * 8 + 16), vcvt_high_f64_f32(in));
+    }
+    return i;
+}
+
+int f64ToF32Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 4 <= sampleCount; i += 4) {
+        const float64x2_t lo = vld1q_f64(reinterpret_cast<const double*>(input + i * 8));
+        const float64x2_t hi = vld1q_f64(reinterpret_cast<const double*>(input + i * 8 + 16));
+        vst1q_f32(reinterpret_cast<float*>(output + i * 4), vcvt_high_f32_f64(vcvt_f32_f64(lo), hi));
+    }
+    return i;
+}
+
+int s16ToS32Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const int16x8_t in = vld1q_s16(reinterpret_cast<const int16_t*>(input + i * 2));
+        vst1q_s32(reinterpret_cast<int32_t*>(output + i * 4), vshll_n_s16(vget_low_s16(in), 16));
+        vst1q_s32(reinterpret_cast<int32_t*>(output + i * 4 + 16), vshll_high_n_s16(in, 16));
+    }
+    return i;
+}
+
+int s32ToS16Neon(const std::byte* input, std::byte* output, int sampleCount)
+{
+    int i{0};
+    for(; i + 8 <= sampleCount; i += 8) {
+        const int32x4_t lo = vld1q_s32(reinterpret_cast<const int32_t*>(input + i * 4));
+        const int32x4_t hi = vld1q_s32(reinterpret_cast<const int32_t*>(input + i * 4 + 16));
+        vst1q_s16(reinterpret_cast<int16_t*>(output + i * 2), vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+    }
+    return i;
+}
+
+ConverterTable neonTable()
+{
+    ConverterTable table = scalarTable();
+
+    table[1][2] = convertVector<int16_t, int32_t, s16ToS32, s16ToS32Neon>;
+    table[1][3] = convertVector<int16_t, float, s16ToF32, s16ToF32Neon>;
+    table[2][1] = convertVector<int32_t, int16_t, s32ToS16, s32ToS16Neon>;
+    table[2][3] = convertVector<int32_t, float, s32ToF32, s32ToF32Neon>;
+    table[3][1] = convertVector<float, int16_t, f32ToS16, f32ToS16Neon>;
+    table[3][2] = convertVector<float, int32_t, f32ToS32, f32ToS32Neon>;
+    table[3][4] = convertVector<float, double, f32ToF64, f32ToF64Neon>;
+    table[4][3] = convertVector<double, float, f64ToF32, f64ToF32Neon>;
+
+    return table;
+}
+#endif
+
+template <typename T>
+void interleaveScalar(const std::byte* const* planes, int channels, int offset, int start, int frameCount,
+                      std::byte* output)
+{
+    for(int channel{0}; channel < channels; ++channel) {
+        const std::byte* in = planes[channel] + (static_cast<size_t>(offset) * sizeof(T));
+        for(int frame{start}; frame < frameCount; ++frame) {
+            std::memcpy(output + ((static_cast<size_t>(frame) * channels + channel) * sizeof(T)),
+                        in + (static_cast<size_t>(frame) * sizeof(T)), sizeof(T));
+        }
+    }
+}
+
+#if defined(FY_CONVERT_X86) || defined(FY_CONVERT_NEON)
+// Interleaves as many stereo frames as fit in whole vectors, returning the number done
+int interleaveStereo(const std::byte* left, const std::byte* right, int sampleSize, int frameCount, std::byte* output)
+{
+    int i{0};
+
+#if defined(FY_CONVERT_X86)
+    const auto load  = [](const std::byte* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); };
+    const auto store = [](std::byte* data, __m128i value) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), value);
+    };
+
+    const int perVector = 16 / sampleSize;
+    for(; i + perVector <= frameCount; i += perVector) {
+        const __m128i l = load(left + (i * sampleSize));
+        const __m128i r = load(right + (i * sampleSize));
+        std::byte* out  = output + (i * sampleSize * 2);
+
+        switch(sampleSize) {
+            case(1):
+                store(out, _mm_unpacklo_epi8(l, r));
+                store(out + 16, _mm_unpackhi_epi8(l, r));
+                break;
+            case(2):
+                store(out, _mm_unpacklo_epi16(l, r));
+                store(out + 16, _mm_unpackhi_epi16(l, r));
+                break;
+            case(4):
+                store(out, _mm_unpacklo_epi32(l, r));
+                store(out + 16, _mm_unpackhi_epi32(l, r));
+                break;
+            case(8):
+                store(out, _mm_unpacklo_epi64(l, r));
+                store(out + 16, _mm_unpackhi_epi64(l, r));
+                break;
+            default:
+                return i;
+        }
+    }
+#elif defined(FY_CONVERT_NEON)
+    const int perVector = 16 / sampleSize;
+    for(; i + perVector <= frameCount; i += perVector) {
+        const auto* l = reinterpret_cast<const uint8_t*>(left + (i * sampleSize));
+        const auto* r = reinterpret_cast<const uint8_t*>(right + (i * sampleSize));
+        auto* out     = reinterpret_cast<uint8_t*>(output + (i * sampleSize * 2));
+
+        switch(sampleSize) {
+            case(1):
+                vst2q_u8(out, {vld1q_u8(l), vld1q_u8(r)});
+                break;
+            case(2):
+                vst2q_u16(reinterpret_cast<uint16_t*>(out), {vld1q_u16(reinterpret_cast<const uint16_t*>(l)),
+                                                             vld1q_u16(reinterpret_cast<const uint16_t*>(r))});
+                break;
+            case(4):
+                vst2q_u32(reinterpret_cast<uint32_t*>(out), {vld1q_u32(reinterpret_cast<const uint32_t*>(l)),
+                                                             vld1q_u32(reinterpret_cast<const uint32_t*>(r))});
+                break;
+            case(8):
+                vst2q_u64(reinterpret_cast<uint64_t*>(out), {vld1q_u64(reinterpret_cast<const uint64_t*>(l)),
+                                                             vld1q_u64(reinterpret_cast<const uint64_t*>(r))});
+                break;
+            default:
+                return i;
+        }
+    }
+#endif
+
+    return i;
+}
+#endif
+
+const ConverterTable& dispatchTable()
+{
+#if defined(FY_CONVERT_X86)
+    static const ConverterTable table = hasAvx2() ? avx2Table() : sse2Table();
+#elif defined(FY_CONVERT_NEON)
+    static const ConverterTable table = neonTable();
+#else
+    static const ConverterTable table = scalarTable();
+#endif
+    return table;
+}
+
+SampleConverter lookup(const ConverterTable& table, Fooyin::SampleFormat inputFormat,
+                       Fooyin::SampleFormat outputFormat)
+{
+    const int in  = formatIndex(inputFormat);
+    const int out = formatIndex(outputFormat);
+
+    if(in < 0 || out < 0) {
+        return nullptr;
+    }
+
+    return table.at(in).at(out);
+}
+} // namespace
+
+namespace Fooyin::Audio {
+SampleConverter findSampleConverter(SampleFormat inputFormat, SampleFormat outputFormat)
+{
+    return lookup(dispatchTable(), inputFormat, outputFormat);
+}
+
+SampleConverter findScalarConverter(SampleFormat inputFormat, SampleFormat outputFormat)
+{
+    static const ConverterTable table = scalarTable();
+    return lookup(table, inputFormat, outputFormat);
+}
+
+void interleave(const std::byte* const* planes, int channels, int sampleSize, int offset, int frameCount,
+                std::byte* output)
+{
+    if(!planes || channels <= 0 || frameCount <= 0) {
+        return;
+    }
+
+    int done{0};
+#if defined(FY_CONVERT_X86) || defined(FY_CONVERT_NEON)
+    if(channels == 2) {
+        const auto planeOffset = static_cast<size_t>(offset) * sampleSize;
+        done = interleaveStereo(planes[0] + planeOffset, planes[1] + planeOffset, sampleSize, frameCount, output);
+    }
+#endif
+
+    switch(sampleSize) {
+        case(1):
+            interleaveScalar<uint8_t>(planes, channels, offset, done, frameCount, output);
+            break;
+        case(2):
+            interleaveScalar<uint16_t>(planes, channels, offset, done, frameCount, output);
+            break;
+        case(4):
+            interleaveScalar<uint32_t>(planes, channels, offset, done, frameCount, output);
+            break;
+        case(8):
+            interleaveScalar<uint64_t>(planes, channels, offset, done, frameCount, output);
+            break;
+        default:
+            break;
+    }
+}
+
+const char* sampleConverterIsa()
+{
+#if defined(FY_CONVERT_X86)
+    return hasAvx2() ? "AVX2" : "SSE2";
+#elif defined(FY_CONVERT_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+} // namespace Fooyin::Audio
@@ -0,0 +1,54 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <core/engine/audioformat.h>
+
+#include <cstddef>
+
+namespace Fooyin::Audio {
+/*!
+ * Converts @p sampleCount contiguous samples from @p input to @p output.
+ * Float to integer conversions round using the current floating point rounding mode.
+ */
+using SampleConverter = void (*)(const std::byte* input, std::byte* output, int sampleCount);
+
+/*!
+ * Returns the fastest converter from @p inputFormat to @p outputFormat supported by the CPU,
+ * or @c nullptr if either format is unknown.
+ */
+FYCORE_EXPORT SampleConverter findSampleConverter(SampleFormat inputFormat, SampleFormat outputFormat);
+/*!
+ * Returns the portable scalar converter from @p inputFormat to @p outputFormat.
+ * Produces the same output as @fn findSampleConverter.
+ */
+FYCORE_EXPORT SampleConverter findScalarConverter(SampleFormat inputFormat, SampleFormat outputFormat);
+/*!
+ * Interleaves @p frameCount frames from @p channels separate @p planes into @p output, starting @p offset frames into
+ * each plane. @p sampleSize is the size of a sample in bytes, and must be 1, 2, 4 or 8.
+ * Stereo is vectorised where supported by the CPU.
+ */
+FYCORE_EXPORT void interleave(const std::byte* const* planes, int channels, int sampleSize, int offset, int frameCount,
+                              std::byte* output);
+/** Returns the name of the instruction set used by @fn findSampleConverter. */
+FYCORE_EXPORT const char* sampleConverterIsa();
+} // namespace Fooyin::Audio
@@ -48,6 +48,7 @@ CoreSettings::CoreSettings(SettingsManager* settingsManager)
     using namespace Settings::Core;
 
     qRegisterMetaType<FadingIntervals>("FadingIntervals");
+    qRegisterMetaType<DspPreset>("DspPreset");
 
     m_settings->createTempSetting<FirstRun>(true);
     m_settings->createTempSetting<Version>(QString::fromLatin1(VERSION));
@@ -90,6 +91,13 @@ CoreSettings::CoreSettings(SettingsManager* settingsManager)
     m_settings->createSetting<Internal::FadingIntervals>(QVariant::fromValue(FadingIntervals{}),
                                                          u"Engine/FadingIntervals"_s);
     m_settings->createSetting<Internal::VBRUpdateInterval>(1000, u"Engine/VBRUpdateInterval"_s);
+    m_settings->createSetting<Internal::EngineCrossfading>(false, u"Engine/Crossfading"_s);
+    m_settings->createSetting<Internal::ActiveDsps>(QVariant::fromValue(DspPreset{}), u"Engine/DspChain"_s);
+    m_settings->createSetting<Internal::DecodeReadAhead>(5000, u"Engine/DecodeReadAhead"_s);
+    m_settings->createSetting<Internal::DecodeRealtime>(false, u"Engine/DecodeRealtime"_s);
+    m_settings->createSetting<Internal::BitPerfect>(false, u"Engine/BitPerfect"_s);
+    m_settings->createSetting<Internal::ResamplerQuality>(static_cast<int>(ResamplerQuality::Standard),
+                                                          u"Engine/ResamplerQuality"_s);
 
     m_settings->set<FirstRun>(!QFileInfo::exists(Core::settingsPath()));
 
@@ -34,6 +34,15 @@ enum class ReplayGainType : uint8_t
     PlaybackOrder
 };
 
+enum class ResamplerQuality : uint8_t
+{
+    Fast = 0,
+    Standard,
+    High,
+    // Uses SoX's resampler where FFmpeg was built with it
+    Best
+};
+
 struct FadingIntervals
 {
     int inPauseStop{1000};
@@ -66,6 +75,28 @@ struct FadingIntervals
     }
 };
 
+// A DSP node in the active chain, and the settings it was saved with
+struct DspPresetEntry
+{
+    QString name;
+    QByteArray settings;
+
+    friend QDataStream& operator<<(QDataStream& stream, const DspPresetEntry& entry)
+    {
+        stream << entry.name;
+        stream << entry.settings;
+        return stream;
+    }
+
+    friend QDataStream& operator>>(QDataStream& stream, DspPresetEntry& entry)
+    {
+        stream >> entry.name;
+        stream >> entry.settings;
+        return stream;
+    }
+};
+using DspPreset = QList<DspPresetEntry>;
+
 namespace Settings::Core::Internal {
 Q_NAMESPACE_EXPORT(FYCORE_EXPORT)
 
@@ -82,7 +113,10 @@ constexpr auto LibraryRestrictTypes    = "Library/RestrictTypes";
 constexpr auto LibraryExcludeTypes     = "Library/ExcludeTypes";
 constexpr auto ExternalRestrictTypes   = "Library/ExternalRestrictTypes";
 constexpr auto ExternalExcludeTypes    = "Library/ExternalExcludeTypes";
+constexpr auto LibraryScanThreads      = "Library/ScanThreads";
+constexpr auto LibrarySkipUnchanged    = "Library/SkipUnchangedDirectories";
 constexpr auto FFmpegAllExtensions     = "Engine/FFmpegAllExtensions";
+constexpr auto FFmpegDecodeThreads     = "Engine/FFmpegDecodeThreads";
 
 enum CoreInternalSettings : uint32_t
 {
@@ -92,6 +126,12 @@ enum CoreInternalSettings : uint32_t
     EngineFading      = 3 | Type::Bool,
     FadingIntervals   = 4 | Type::Variant,
     VBRUpdateInterval = 5 | Type::Int,
+    EngineCrossfading = 6 | Type::Bool,
+    ActiveDsps        = 7 | Type::Variant,
+    DecodeReadAhead   = 8 | Type::Int,
+    DecodeRealtime    = 9 | Type::Bool,
+    BitPerfect        = 10 | Type::Bool,
+    ResamplerQuality  = 11 | Type::Int,
 };
 Q_ENUM_NS(CoreInternalSettings)
 } // namespace Settings::Core::Internal
@@ -108,3 +148,4 @@ private:
 } // namespace Fooyin
 
 Q_DECLARE_METATYPE(Fooyin::FadingIntervals)
+Q_DECLARE_METATYPE(Fooyin::DspPreset)
@@ -0,0 +1,170 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "directoryindex.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+
+#include <algorithm>
+#include <ranges>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+bool readDirectoryState(const QString& path, Fooyin::IndexedDirectory& dir)
+{
+    const QFileInfo info{path};
+    if(!info.isDir()) {
+        return false;
+    }
+
+    dir.path = path;
+
+    const QDateTime modifiedTime = info.lastModified();
+    dir.modifiedTime             = modifiedTime.isValid() ? static_cast<uint64_t>(modifiedTime.toMSecsSinceEpoch()) : 0;
+
+#ifdef Q_OS_UNIX
+    // Catches a directory being replaced by another with the same modified time (e.g. restored from a backup)
+    struct stat dirStat{};
+    if(::stat(QFile::encodeName(path).constData(), &dirStat) == 0) {
+        dir.inode = static_cast<uint64_t>(dirStat.st_ino);
+    }
+#endif
+
+    return true;
+}
+
+bool isBelow(const QString& path, const QString& root)
+{
+    return path == root || (path.startsWith(root) && path.at(root.size()) == u'/');
+}
+} // namespace
+
+namespace Fooyin {
+DirectoryIndex::DirectoryIndex(IndexedDirectoryMap directories)
+    : m_previous{std::move(directories)}
+    , m_unchangedFiles{0}
+{
+    for(const auto& path : m_previous | std::views::keys) {
+        m_children[QFileInfo{path}.path()].push_back(path);
+    }
+}
+
+QFileInfoList DirectoryIndex::walk(const QStringList& paths, const QStringList& wildcards, bool skipUnchanged)
+{
+    QFileInfoList files;
+    QStringList pending;
+
+    for(const QString& path : paths) {
+        const QString dirPath = QDir::cleanPath(QFileInfo{path}.absoluteFilePath());
+        m_roots.push_back(dirPath);
+        pending.push_back(dirPath);
+    }
+
+    while(!pending.empty()) {
+        const QString dirPath = pending.takeLast();
+
+        if(m_visited.contains(dirPath)) {
+            continue;
+        }
+        m_visited.emplace(dirPath);
+
+        IndexedDirectory current;
+        if(!readDirectoryState(dirPath, current)) {
+            // Left out of the visited set so it is dropped from the index
+            m_visited.erase(dirPath);
+            continue;
+        }
+
+        if(skipUnchanged) {
+            const auto previous = m_previous.find(dirPath);
+            if(previous != m_previous.cend() && previous->second.modifiedTime == current.modifiedTime
+               && previous->second.inode == current.inode) {
+                m_unchanged.emplace(dirPath);
+                m_unchangedFiles += previous->second.entryCount;
+                if(const auto children = m_children.find(dirPath); children != m_children.cend()) {
+                    pending.append(children->second);
+                }
+                continue;
+            }
+        }
+
+        // Only this directory's entries; subdirectories are checked against the index in turn
+        QDirIterator dirIt{dirPath, wildcards, QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot};
+        while(dirIt.hasNext()) {
+            dirIt.next();
+            const QFileInfo info = dirIt.fileInfo();
+
+            if(info.isDir()) {
+                if(!info.isSymLink()) {
+                    pending.push_back(info.absoluteFilePath());
+                }
+            }
+            else if(info.size() > 0) {
+                files.append(info);
+                ++current.entryCount;
+            }
+        }
+
+        m_changed.push_back(current);
+    }
+
+    return files;
+}
+
+bool DirectoryIndex::isUnchanged(const QString& dir) const
+{
+    return m_unchanged.contains(dir);
+}
+
+int DirectoryIndex::unchangedDirectoryCount() const
+{
+    return static_cast<int>(m_unchanged.size());
+}
+
+int DirectoryIndex::unchangedFileCount() const
+{
+    return m_unchangedFiles;
+}
+
+std::vector<IndexedDirectory> DirectoryIndex::changedDirectories() const
+{
+    return m_changed;
+}
+
+QStringList DirectoryIndex::removedDirectories() const
+{
+    QStringList removed;
+
+    for(const auto& path : m_previous | std::views::keys) {
+        if(m_visited.contains(path)) {
+            continue;
+        }
+        if(std::ranges::any_of(m_roots, [&path](const QString& root) { return isBelow(path, root); })) {
+            removed.push_back(path);
+        }
+    }
+
+    return removed;
+}
+} // namespace Fooyin
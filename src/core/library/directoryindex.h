@@ -0,0 +1,79 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "fycore_export.h"
+
+#include <QFileInfoList>
+#include <QStringList>
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace Fooyin {
+/*!
+ * The state of a library directory as of the last completed scan.
+ */
+struct IndexedDirectory
+{
+    QString path;
+    uint64_t modifiedTime{0};
+    uint64_t inode{0};
+    // Number of files matching the library's file types
+    int entryCount{0};
+};
+using IndexedDirectoryMap = std::unordered_map<QString, IndexedDirectory>;
+
+/*!
+ * Finds the files to scan below a set of directories, skipping the listing of any directory whose
+ * modified time and inode match the previous scan. Subdirectories of an unchanged directory are taken
+ * from the index, so only directories themselves are stat'd.
+ *
+ * A directory's modified time only changes when entries are added, removed or renamed, so files which
+ * are rewritten in place are not picked up within an unchanged directory.
+ */
+class FYCORE_EXPORT DirectoryIndex
+{
+public:
+    explicit DirectoryIndex(IndexedDirectoryMap directories = {});
+
+    [[nodiscard]] QFileInfoList walk(const QStringList& paths, const QStringList& wildcards, bool skipUnchanged);
+
+    [[nodiscard]] bool isUnchanged(const QString& dir) const;
+    [[nodiscard]] int unchangedDirectoryCount() const;
+    [[nodiscard]] int unchangedFileCount() const;
+
+    /** Directories listed during the walk, to be written back to the index. */
+    [[nodiscard]] std::vector<IndexedDirectory> changedDirectories() const;
+    /** Indexed directories below the walked paths which no longer exist. */
+    [[nodiscard]] QStringList removedDirectories() const;
+
+private:
+    IndexedDirectoryMap m_previous;
+    std::unordered_map<QString, QStringList> m_children;
+
+    QStringList m_roots;
+    std::set<QString> m_visited;
+    std::set<QString> m_unchanged;
+    std::vector<IndexedDirectory> m_changed;
+    int m_unchangedFiles;
+};
+} // namespace Fooyin
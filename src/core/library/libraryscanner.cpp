@@ -19,8 +19,11 @@
 
 #include "libraryscanner.h"
 
+#include "database/librarydatabase.h"
 #include "database/trackdatabase.h"
+#include "directoryindex.h"
 #include "internalcoresettings.h"
+#include "libraryutils.h"
 #include "librarywatcher.h"
 #include "playlist/playlistloader.h"
 
@@ -31,7 +34,7 @@
 #include <core/track.h>
 #include <utils/database/dbconnectionhandler.h>
 #include <utils/database/dbconnectionpool.h>
-#include <utils/fileutils.h>
+#include <utils/database/dbfastimport.h>
 #include <utils/timer.h>
 #include <utils/utils.h>
 
@@ -40,17 +43,56 @@
 #include <QDirIterator>
 #include <QFileSystemWatcher>
 #include <QLoggingCategory>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
+#include <optional>
 #include <ranges>
+#include <unordered_set>
 
 Q_LOGGING_CATEGORY(LIB_SCANNER, "fy.scanner")
 
 using namespace Qt::StringLiterals;
 
-constexpr auto BatchSize   = 250;
-constexpr auto ArchivePath = R"(unpack://%1|%2|file://%3!)";
+constexpr auto BatchSize      = 1000;
+constexpr auto ReadWindowSize = 500;
+// Scans reading at least this many files tune the database for bulk writes
+constexpr auto FastImportSize = 5000;
+constexpr auto ArchivePath    = R"(unpack://%1|%2|file://%3!)";
 
 namespace {
+// A file queued for reading by the tag reader pool
+struct ReadJob
+{
+    enum class Type : uint8_t
+    {
+        Skip = 0,
+        Update,
+        New,
+        // Archives are read on the scanner thread as they report their own progress
+        Sequential,
+    };
+
+    QString filepath;
+    Type type{Type::Skip};
+    uint64_t modifiedTime{0};
+    Fooyin::TrackList tracks;
+    bool read{false};
+    // Set for new files whose content matches a missing track, in which case the tags aren't read
+    QString fingerprint;
+    bool moved{false};
+};
+
+QString fileFingerprint(const QString& filepath)
+{
+    QFile file{filepath};
+    if(!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return Fooyin::Utils::contentFingerprint(&file);
+}
+
 void sortFiles(QFileInfoList& files)
 {
     std::ranges::sort(files, {}, &QFileInfo::filePath);
@@ -173,7 +215,7 @@ public:
     void checkBatchFinished();
     void removeMissingTrack(const Track& track);
 
-    [[nodiscard]] TrackList readTracks(const QString& filepath);
+    [[nodiscard]] TrackList readTracks(const QString& filepath, const QString& fingerprint = {});
     [[nodiscard]] TrackList readArchiveTracks(const QString& filepath);
     [[nodiscard]] TrackList readPlaylist(const QString& filepath);
     [[nodiscard]] TrackList readPlaylistTracks(const QString& filepath, bool addMissing = false);
@@ -187,12 +229,30 @@ public:
     void setTrackProps(Track& track, const QString& file);
 
     void updateExistingTrack(Track& track, const QString& file);
+    void storeNewTracks(TrackList tracks, const QString& file);
+    bool relocateMovedTracks(const QString& fingerprint, const QString& file);
     void readNewTrack(const QString& file);
 
     void readFile(const QString& file, bool onlyModified);
-    void populateExistingTracks(const TrackList& tracks, bool includeMissing = true);
+
+    [[nodiscard]] ReadJob planRead(const QFileInfo& file, bool onlyModified) const;
+    void runRead(ReadJob& job, const std::unordered_set<QString>& missingFingerprints);
+    void finishRead(ReadJob& job, bool onlyModified);
+    bool readFiles(const QFileInfoList& files, bool onlyModified);
+
+    void populateExistingTracks(const TrackList& tracks, bool includeMissing = true,
+                                const DirectoryIndex* index = nullptr);
+    [[nodiscard]] QStringList libraryWildcards() const;
+    bool readLibraryFiles(const QFileInfoList& files, bool onlyModified);
+    void markMissing(const Track& track);
+    void storeRemainingTracks();
+    void saveDirectoryIndex(const DirectoryIndex& index);
     bool getAndSaveAllTracks(const QStringList& paths, const TrackList& tracks, bool onlyModified);
 
+    void moveTracks(const QString& from, const QString& to, std::set<QString>& files, QStringList& dirs);
+    void removeTracks(const QString& path);
+    bool applyLibraryChanges(const LibraryChanges& changes, const TrackList& tracks);
+
     void changeLibraryStatus(LibraryInfo::Status status);
 
     LibraryScanner* m_self;
@@ -207,6 +267,7 @@ public:
     bool m_monitor{false};
     LibraryInfo m_currentLibrary;
     TrackDatabase m_trackDatabase;
+    LibraryDatabase m_libraryDatabase;
 
     TrackList m_tracksToStore;
     TrackList m_tracksToUpdate;
@@ -215,6 +276,7 @@ public:
     std::unordered_map<QString, TrackList> m_existingArchives;
     std::unordered_map<QString, TrackList> m_missingFiles;
     std::unordered_map<QString, Track> m_missingHashes;
+    std::unordered_map<QString, TrackList> m_missingFingerprints;
     std::unordered_map<QString, TrackList> m_existingCueTracks;
     std::unordered_map<QString, TrackList> m_missingCueTracks;
     std::set<QString> m_cueFilesScanned;
@@ -223,6 +285,9 @@ public:
     size_t m_totalFiles{0};
 
     std::unordered_map<int, LibraryWatcher> m_watchers;
+
+    // Declared last so reader threads (and their thread-local readers) finish before the loader is released
+    QThreadPool m_readPool;
 };
 
 void LibraryScannerPrivate::finishScan()
@@ -247,6 +312,7 @@ void LibraryScannerPrivate::cleanupScan()
     m_existingArchives.clear();
     m_missingFiles.clear();
     m_missingHashes.clear();
+    m_missingFingerprints.clear();
     m_existingCueTracks.clear();
     m_missingCueTracks.clear();
     m_cueFilesScanned.clear();
@@ -254,19 +320,11 @@ void LibraryScannerPrivate::cleanupScan()
 
 void LibraryScannerPrivate::addWatcher(const LibraryInfo& library)
 {
-    auto watchPaths = [this, library](const QString& path) {
-        QStringList dirs = Utils::File::getAllSubdirectories(path);
-        dirs.append(path);
-        m_watchers[library.id].addPaths(dirs);
-    };
+    auto& watcher = m_watchers[library.id];
+    watcher.watch(library.path);
 
-    watchPaths(library.path);
-
-    QObject::connect(&m_watchers.at(library.id), &LibraryWatcher::libraryDirsChanged, m_self,
-                     [this, watchPaths, library](const QStringList& dirs) {
-                         std::ranges::for_each(dirs, watchPaths);
-                         emit m_self->directoriesChanged(library, dirs);
-                     });
+    QObject::connect(&watcher, &LibraryWatcher::libraryChanged, m_self,
+                     [this, library](const LibraryChanges& changes) { emit m_self->libraryChanged(library, changes); });
 }
 
 void LibraryScannerPrivate::reportProgress(const QString& file) const
@@ -302,13 +360,10 @@ Track LibraryScannerPrivate::matchMissingTrack(const Track& track)
 
 void LibraryScannerPrivate::checkBatchFinished()
 {
-    if(m_tracksToStore.size() >= BatchSize || m_tracksToUpdate.size() > BatchSize) {
-        if(m_tracksToStore.size() >= BatchSize) {
-            m_trackDatabase.storeTracks(m_tracksToStore);
-        }
-        if(m_tracksToUpdate.size() >= BatchSize) {
-            m_trackDatabase.updateTracks(m_tracksToUpdate);
-        }
+    if(m_tracksToStore.size() >= BatchSize || m_tracksToUpdate.size() >= BatchSize) {
+        // Both lists are cleared below, so both must be written
+        m_trackDatabase.storeTracks(m_tracksToStore);
+        m_trackDatabase.updateTracks(m_tracksToUpdate);
         emit m_self->scanUpdate({.addedTracks = m_tracksToStore, .updatedTracks = m_tracksToUpdate});
         m_tracksToStore.clear();
         m_tracksToUpdate.clear();
@@ -325,9 +380,18 @@ void LibraryScannerPrivate::removeMissingTrack(const Track& track)
             m_missingFiles.erase(track.filename());
         }
     }
+
+    if(const auto fingerprintIt = m_missingFingerprints.find(track.fingerprint());
+       fingerprintIt != m_missingFingerprints.end()) {
+        auto& missingTracks = fingerprintIt->second;
+        std::erase_if(missingTracks, [&track](const Track& missingTrack) { return missingTrack.id() == track.id(); });
+        if(missingTracks.empty()) {
+            m_missingFingerprints.erase(fingerprintIt);
+        }
+    }
 }
 
-TrackList LibraryScannerPrivate::readTracks(const QString& filepath)
+TrackList LibraryScannerPrivate::readTracks(const QString& filepath, const QString& fingerprint)
 {
     if(m_audioLoader->isArchive(filepath)) {
         return readArchiveTracks(filepath);
@@ -343,6 +407,10 @@ TrackList LibraryScannerPrivate::readTracks(const QString& filepath)
         qCInfo(LIB_SCANNER) << "Failed to open file:" << filepath;
         return {};
     }
+
+    const QString contentFingerprint = fingerprint.isEmpty() ? Utils::contentFingerprint(&file) : fingerprint;
+    file.seek(0);
+
     const AudioSource source{filepath, &file, nullptr};
 
     if(!tagReader->init(source)) {
@@ -356,6 +424,7 @@ TrackList LibraryScannerPrivate::readTracks(const QString& filepath)
     for(int subIndex{0}; subIndex < subsongCount; ++subIndex) {
         Track subTrack{filepath, subIndex};
         subTrack.setFileSize(file.size());
+        subTrack.setFingerprint(contentFingerprint);
 
         source.device->seek(0);
         if(tagReader->readTrack(source, subTrack)) {
@@ -673,13 +742,8 @@ void LibraryScannerPrivate::updateExistingTrack(Track& track, const QString& fil
     }
 }
 
-void LibraryScannerPrivate::readNewTrack(const QString& file)
+void LibraryScannerPrivate::storeNewTracks(TrackList tracks, const QString& file)
 {
-    TrackList tracks = readTracks(file);
-    if(tracks.empty()) {
-        return;
-    }
-
     for(Track& track : tracks) {
         Track refoundTrack = matchMissingTrack(track);
         if(refoundTrack.isInLibrary() || refoundTrack.isInDatabase()) {
@@ -687,6 +751,7 @@ void LibraryScannerPrivate::readNewTrack(const QString& file)
             removeMissingTrack(refoundTrack);
 
             setTrackProps(refoundTrack, file);
+            refoundTrack.setFingerprint(track.fingerprint());
             m_tracksToUpdate.push_back(refoundTrack);
         }
         else {
@@ -707,6 +772,47 @@ void LibraryScannerPrivate::readNewTrack(const QString& file)
     }
 }
 
+bool LibraryScannerPrivate::relocateMovedTracks(const QString& fingerprint, const QString& file)
+{
+    const auto fingerprintIt = m_missingFingerprints.find(fingerprint);
+    if(fingerprintIt == m_missingFingerprints.end()) {
+        return false;
+    }
+
+    // Copies of a file share a fingerprint, so prefer one which kept its name
+    const TrackList& candidates = fingerprintIt->second;
+    const QString filename      = QFileInfo{file}.fileName();
+    auto matchIt                = std::ranges::find_if(candidates, [&filename](const Track& candidate) {
+        return QFileInfo{candidate.filepath()}.fileName() == filename;
+    });
+    if(matchIt == candidates.end()) {
+        matchIt = candidates.begin();
+    }
+
+    const QString oldPath = matchIt->filepath();
+
+    TrackList movedTracks;
+    std::ranges::copy_if(candidates, std::back_inserter(movedTracks),
+                         [&oldPath](const Track& candidate) { return candidate.filepath() == oldPath; });
+
+    qCDebug(LIB_SCANNER) << "Matched moved file" << oldPath << "to" << file;
+
+    for(Track& track : movedTracks) {
+        m_missingHashes.erase(track.hash());
+        removeMissingTrack(track);
+
+        setTrackProps(track, file);
+        m_tracksToUpdate.push_back(track);
+    }
+
+    return true;
+}
+
+void LibraryScannerPrivate::readNewTrack(const QString& file)
+{
+    storeNewTracks(readTracks(file), file);
+}
+
 void LibraryScannerPrivate::readFile(const QString& file, bool onlyModified)
 {
     if(!m_self->mayRun()) {
@@ -734,6 +840,7 @@ void LibraryScannerPrivate::readFile(const QString& file, bool onlyModified)
             if(!m_audioLoader->readTrackMetadata(changedTrack)) {
                 return;
             }
+            changedTrack.setFingerprint(fileFingerprint(file));
 
             if(lastModifiedTime.isValid()) {
                 changedTrack.setModifiedTime(lastModified);
@@ -758,8 +865,178 @@ void LibraryScannerPrivate::readFile(const QString& file, bool onlyModified)
     }
 }
 
-void LibraryScannerPrivate::populateExistingTracks(const TrackList& tracks, bool includeMissing)
+ReadJob LibraryScannerPrivate::planRead(const QFileInfo& file, bool onlyModified) const
+{
+    ReadJob job;
+    job.filepath = file.absoluteFilePath();
+
+    if(m_cueFilesScanned.contains(job.filepath)) {
+        return job;
+    }
+
+    if(m_existingArchives.contains(job.filepath) || m_audioLoader->isArchive(job.filepath)) {
+        job.type = ReadJob::Type::Sequential;
+        return job;
+    }
+
+    const QDateTime lastModifiedTime{file.lastModified()};
+    if(lastModifiedTime.isValid()) {
+        job.modifiedTime = static_cast<uint64_t>(lastModifiedTime.toMSecsSinceEpoch());
+    }
+
+    if(m_trackPaths.contains(job.filepath)) {
+        const Track& libraryTrack = m_trackPaths.at(job.filepath).front();
+
+        if(!libraryTrack.isEnabled() || libraryTrack.libraryId() != m_currentLibrary.id
+           || libraryTrack.modifiedTime() < job.modifiedTime || !onlyModified) {
+            job.type = ReadJob::Type::Update;
+            job.tracks.push_back(libraryTrack);
+        }
+        return job;
+    }
+
+    job.type = ReadJob::Type::New;
+    return job;
+}
+
+void LibraryScannerPrivate::runRead(ReadJob& job, const std::unordered_set<QString>& missingFingerprints)
 {
+    // Called from the reader pool, so must only touch the job, the (thread-local) readers and the
+    // fingerprint snapshot
+    if(!m_self->mayRun()) {
+        return;
+    }
+
+    switch(job.type) {
+        case(ReadJob::Type::Update):
+            job.read = m_audioLoader->readTrackMetadata(job.tracks.front());
+            if(job.read) {
+                job.tracks.front().setFingerprint(fileFingerprint(job.filepath));
+            }
+            break;
+        case(ReadJob::Type::New):
+            if(!missingFingerprints.empty() && !m_audioLoader->isArchive(job.filepath)) {
+                job.fingerprint = fileFingerprint(job.filepath);
+                if(missingFingerprints.contains(job.fingerprint)) {
+                    job.moved = true;
+                    break;
+                }
+            }
+            job.tracks = readTracks(job.filepath, job.fingerprint);
+            job.read   = !job.tracks.empty();
+            break;
+        case(ReadJob::Type::Skip):
+        case(ReadJob::Type::Sequential):
+            break;
+    }
+}
+
+void LibraryScannerPrivate::finishRead(ReadJob& job, bool onlyModified)
+{
+    switch(job.type) {
+        case(ReadJob::Type::Update):
+            if(job.read) {
+                Track& changedTrack = job.tracks.front();
+                if(job.modifiedTime > 0) {
+                    changedTrack.setModifiedTime(job.modifiedTime);
+                }
+                updateExistingTrack(changedTrack, job.filepath);
+            }
+            break;
+        case(ReadJob::Type::New):
+            if(job.moved) {
+                if(relocateMovedTracks(job.fingerprint, job.filepath)) {
+                    break;
+                }
+                // An earlier file with the same content already claimed the missing track
+                job.tracks = readTracks(job.filepath, job.fingerprint);
+                job.read   = !job.tracks.empty();
+            }
+            if(job.read) {
+                storeNewTracks(std::move(job.tracks), job.filepath);
+            }
+            break;
+        case(ReadJob::Type::Sequential):
+            readFile(job.filepath, onlyModified);
+            break;
+        case(ReadJob::Type::Skip):
+            break;
+    }
+
+    fileScanned(job.filepath);
+    checkBatchFinished();
+}
+
+bool LibraryScannerPrivate::readFiles(const QFileInfoList& files, bool onlyModified)
+{
+    // Tags are read by the pool a window at a time while the previous window is merged (and written) here in
+    // file order, as matching missing and cue tracks depends on the state built up by earlier files.
+    std::vector<ReadJob> jobs;
+    jobs.reserve(files.size());
+    for(const auto& file : files) {
+        jobs.push_back(planRead(file, onlyModified));
+    }
+
+    const int threads = m_settings.value(Settings::Core::Internal::LibraryScanThreads, 0).toInt();
+    m_readPool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+
+    // New files are fingerprinted against this snapshot on the pool, and matches resolved here
+    std::unordered_set<QString> missingFingerprints;
+    for(const auto& fingerprint : m_missingFingerprints | std::views::keys) {
+        missingFingerprints.emplace(fingerprint);
+    }
+
+    const auto startWindow = [this, &jobs, &missingFingerprints](size_t start) {
+        const auto begin = jobs.begin() + static_cast<std::ptrdiff_t>(start);
+        const auto end   = jobs.begin() + static_cast<std::ptrdiff_t>(std::min(start + ReadWindowSize, jobs.size()));
+        return QtConcurrent::map(&m_readPool, begin, end,
+                                 [this, &missingFingerprints](ReadJob& job) { runRead(job, missingFingerprints); });
+    };
+
+    size_t start{0};
+    QFuture<void> current = startWindow(start);
+
+    while(start < jobs.size()) {
+        current.waitForFinished();
+
+        const size_t end = std::min(start + ReadWindowSize, jobs.size());
+
+        QFuture<void> next;
+        if(end < jobs.size()) {
+            next = startWindow(end);
+        }
+
+        for(size_t i{start}; i < end; ++i) {
+            if(!m_self->mayRun()) {
+                next.cancel();
+                next.waitForFinished();
+                return false;
+            }
+
+            finishRead(jobs[i], onlyModified);
+            jobs[i] = {};
+        }
+
+        current = next;
+        start   = end;
+    }
+
+    return true;
+}
+
+void LibraryScannerPrivate::populateExistingTracks(const TrackList& tracks, bool includeMissing,
+                                                   const DirectoryIndex* index)
+{
+    const auto exists = [this, index](const Track& track, const QString& path) {
+        // Enabled tracks of this library were found by the scan which indexed their directory,
+        // and an unchanged directory still has the same entries
+        if(index && track.isEnabled() && track.libraryId() == m_currentLibrary.id
+           && index->isUnchanged(QFileInfo{path}.absolutePath())) {
+            return true;
+        }
+        return QFileInfo::exists(path);
+    };
+
     for(const Track& track : tracks) {
         m_trackPaths[track.filepath()].push_back(track);
         if(track.isInArchive()) {
@@ -770,19 +1047,22 @@ void LibraryScannerPrivate::populateExistingTracks(const TrackList& tracks, bool
             if(track.hasCue()) {
                 const auto cuePath = track.cuePath() == "Embedded"_L1 ? track.filepath() : track.cuePath();
                 m_existingCueTracks[cuePath].emplace_back(track);
-                if(!QFileInfo::exists(cuePath)) {
+                if(!exists(track, cuePath)) {
                     m_missingCueTracks[cuePath].emplace_back(track);
                 }
             }
 
             if(!track.isInArchive()) {
-                if(!QFileInfo::exists(track.filepath())) {
+                if(!exists(track, track.filepath())) {
                     m_missingFiles[track.filename()].push_back(track);
                     m_missingHashes.emplace(track.hash(), track);
+                    if(!track.hasCue() && !track.fingerprint().isEmpty()) {
+                        m_missingFingerprints[track.fingerprint()].push_back(track);
+                    }
                 }
             }
             else {
-                if(!QFileInfo::exists(track.archivePath())) {
+                if(!exists(track, track.archivePath())) {
                     m_missingFiles[track.filename()].push_back(track);
                     m_missingHashes.emplace(track.hash(), track);
                 }
@@ -791,10 +1071,8 @@ void LibraryScannerPrivate::populateExistingTracks(const TrackList& tracks, bool
     }
 }
 
-bool LibraryScannerPrivate::getAndSaveAllTracks(const QStringList& paths, const TrackList& tracks, bool onlyModified)
+QStringList LibraryScannerPrivate::libraryWildcards() const
 {
-    populateExistingTracks(tracks);
-
     using namespace Settings::Core::Internal;
 
     QStringList restrictExtensions      = m_settings.value(LibraryRestrictTypes).toStringList();
@@ -805,19 +1083,31 @@ bool LibraryScannerPrivate::getAndSaveAllTracks(const QStringList& paths, const
         restrictExtensions.append(u"cue"_s);
     }
 
-    const auto files = getFiles(paths, restrictExtensions, excludeExtensions, {});
+    for(const auto& ext : excludeExtensions) {
+        restrictExtensions.removeAll(ext);
+    }
 
+    return Utils::extensionsToWildcards(restrictExtensions);
+}
+
+bool LibraryScannerPrivate::readLibraryFiles(const QFileInfoList& files, bool onlyModified)
+{
     m_totalFiles = files.size();
     reportProgress({});
 
-    for(const auto& file : files) {
+    // Cue sheets are sorted first and must be read before the files they reference
+    const auto firstFile = std::ranges::find_if(files, [](const QFileInfo& file) {
+        return file.suffix().compare("cue"_L1, Qt::CaseInsensitive) != 0;
+    });
+
+    for(auto it = files.cbegin(); it != firstFile; ++it) {
         if(!m_self->mayRun()) {
             return false;
         }
 
-        const QString filepath = file.absoluteFilePath();
+        const QString filepath = it->absoluteFilePath();
 
-        if(file.suffix() == "cue"_L1) {
+        if(it->suffix() == "cue"_L1) {
             readCue(filepath, onlyModified);
         }
         else {
@@ -828,25 +1118,235 @@ bool LibraryScannerPrivate::getAndSaveAllTracks(const QStringList& paths, const
         checkBatchFinished();
     }
 
-    for(const auto& missingTracks : m_missingFiles | std::views::values) {
-        for(const auto& missingTrack : missingTracks) {
-            if(missingTrack.isInLibrary() || missingTrack.isEnabled()) {
-                qCDebug(LIB_SCANNER) << "Track not found:" << missingTrack.prettyFilepath();
-
-                Track disabledTrack{missingTrack};
-                disabledTrack.setLibraryId(-1);
-                disabledTrack.setIsEnabled(false);
-                m_tracksToUpdate.push_back(disabledTrack);
-            }
-        }
+    return readFiles({firstFile, files.cend()}, onlyModified);
+}
+
+void LibraryScannerPrivate::markMissing(const Track& track)
+{
+    if(track.isInLibrary() || track.isEnabled()) {
+        qCDebug(LIB_SCANNER) << "Track not found:" << track.prettyFilepath();
+
+        Track disabledTrack{track};
+        disabledTrack.setLibraryId(-1);
+        disabledTrack.setIsEnabled(false);
+        m_tracksToUpdate.push_back(disabledTrack);
     }
+}
 
+void LibraryScannerPrivate::storeRemainingTracks()
+{
     m_trackDatabase.storeTracks(m_tracksToStore);
     m_trackDatabase.updateTracks(m_tracksToUpdate);
 
     if(!m_tracksToStore.empty() || !m_tracksToUpdate.empty()) {
         emit m_self->scanUpdate({m_tracksToStore, m_tracksToUpdate});
     }
+}
+
+void LibraryScannerPrivate::saveDirectoryIndex(const DirectoryIndex& index)
+{
+    // Only written once the scan has completed, otherwise unread files could be skipped by the next scan
+    if(m_currentLibrary.id >= 0) {
+        m_libraryDatabase.storeDirectories(m_currentLibrary.id, index.changedDirectories());
+        m_libraryDatabase.removeDirectories(m_currentLibrary.id, index.removedDirectories());
+    }
+}
+
+bool LibraryScannerPrivate::getAndSaveAllTracks(const QStringList& paths, const TrackList& tracks, bool onlyModified)
+{
+    using namespace Settings::Core::Internal;
+
+    // A full rescan always lists every directory, but still refreshes the index
+    const bool skipUnchanged = onlyModified && m_settings.value(LibrarySkipUnchanged, true).toBool();
+
+    IndexedDirectoryMap indexedDirs;
+    if(m_currentLibrary.id >= 0) {
+        m_libraryDatabase.getDirectories(m_currentLibrary.id, indexedDirs);
+    }
+
+    DirectoryIndex index{std::move(indexedDirs)};
+    QFileInfoList files = index.walk(paths, libraryWildcards(), skipUnchanged);
+    sortFiles(files);
+
+    if(index.unchangedDirectoryCount() > 0) {
+        qCDebug(LIB_SCANNER) << "Skipped" << index.unchangedDirectoryCount() << "unchanged directories containing"
+                             << index.unchangedFileCount() << "files";
+    }
+
+    populateExistingTracks(tracks, true, &index);
+
+    std::optional<DbFastImport> fastImport;
+    if(files.size() >= FastImportSize) {
+        fastImport.emplace(m_trackDatabase.db());
+    }
+
+    if(!readLibraryFiles(files, onlyModified)) {
+        return false;
+    }
+
+    for(const auto& missingTracks : m_missingFiles | std::views::values) {
+        std::ranges::for_each(missingTracks, [this](const Track& track) { markMissing(track); });
+    }
+
+    storeRemainingTracks();
+    saveDirectoryIndex(index);
+
+    return true;
+}
+
+void LibraryScannerPrivate::moveTracks(const QString& from, const QString& to, std::set<QString>& files,
+                                       QStringList& dirs)
+{
+    const auto isMoved = [&from](const QString& path) {
+        return path == from || (path.startsWith(from) && path.at(from.size()) == u'/');
+    };
+    const auto movedPath = [&from, &to](const QString& path) {
+        return to + path.sliced(from.size());
+    };
+
+    bool foundTracks{false};
+
+    QStringList paths;
+    for(const auto& path : m_trackPaths | std::views::keys) {
+        if(isMoved(path)) {
+            paths.push_back(path);
+        }
+    }
+
+    for(const QString& path : paths) {
+        foundTracks = true;
+
+        const QString newPath = movedPath(path);
+        auto tracks           = m_trackPaths.extract(path);
+
+        if(m_trackPaths.contains(newPath)) {
+            // Moved over an existing file, so treat it as that file being rewritten
+            std::ranges::for_each(tracks.mapped(), [this](const Track& track) { markMissing(track); });
+            files.emplace(newPath);
+            continue;
+        }
+
+        for(Track& track : tracks.mapped()) {
+            // The hash is kept so the track's statistics still apply
+            track.setFilePath(newPath);
+            if(track.hasCue() && track.cuePath() != "Embedded"_L1 && isMoved(track.cuePath())) {
+                track.setCuePath(movedPath(track.cuePath()));
+            }
+            m_tracksToUpdate.push_back(track);
+        }
+
+        tracks.key() = newPath;
+        m_trackPaths.insert(std::move(tracks));
+    }
+
+    // Archive paths are part of each track's path, so these are read again from the new location
+    QStringList archives;
+    for(const auto& [archivePath, tracks] : m_existingArchives) {
+        if(isMoved(archivePath)) {
+            std::ranges::for_each(tracks, [this](const Track& track) { markMissing(track); });
+            archives.push_back(archivePath);
+        }
+    }
+    for(const QString& archivePath : archives) {
+        foundTracks = true;
+        m_existingArchives.erase(archivePath);
+        files.emplace(movedPath(archivePath));
+    }
+
+    if(!foundTracks) {
+        // Not part of the library yet (e.g. renamed from an unsupported file type)
+        if(QFileInfo{to}.isDir()) {
+            dirs.push_back(to);
+        }
+        else {
+            files.emplace(to);
+        }
+    }
+}
+
+void LibraryScannerPrivate::removeTracks(const QString& path)
+{
+    const auto isRemoved = [&path](const QString& trackPath) {
+        return trackPath == path || (trackPath.startsWith(path) && trackPath.at(path.size()) == u'/');
+    };
+
+    std::erase_if(m_trackPaths, [this, &isRemoved](const auto& entry) {
+        if(isRemoved(entry.first) && !QFileInfo::exists(entry.first)) {
+            std::ranges::for_each(entry.second, [this](const Track& track) { markMissing(track); });
+            return true;
+        }
+        return false;
+    });
+
+    std::erase_if(m_existingArchives, [this, &isRemoved](const auto& entry) {
+        if(isRemoved(entry.first) && !QFileInfo::exists(entry.first)) {
+            std::ranges::for_each(entry.second, [this](const Track& track) { markMissing(track); });
+            return true;
+        }
+        return false;
+    });
+}
+
+bool LibraryScannerPrivate::applyLibraryChanges(const LibraryChanges& changes, const TrackList& tracks)
+{
+    populateExistingTracks(tracks, false);
+
+    std::set<QString> files{changes.modified.cbegin(), changes.modified.cend()};
+    QStringList dirs{changes.dirs};
+
+    for(const auto& [from, to] : changes.moved) {
+        moveTracks(from, to, files, dirs);
+    }
+    std::ranges::for_each(changes.removed, [this](const QString& path) { removeTracks(path); });
+
+    const QStringList wildcards = libraryWildcards();
+    const bool skipUnchanged    = m_settings.value(Settings::Core::Internal::LibrarySkipUnchanged, true).toBool();
+
+    IndexedDirectoryMap indexedDirs;
+    if(m_currentLibrary.id >= 0) {
+        m_libraryDatabase.getDirectories(m_currentLibrary.id, indexedDirs);
+    }
+
+    DirectoryIndex index{std::move(indexedDirs)};
+    QFileInfoList filesToRead = index.walk(dirs, wildcards, skipUnchanged);
+
+    // Only changed directories report removed files, so check what they used to contain
+    std::set<QString> listedFiles;
+    for(const QFileInfo& file : std::as_const(filesToRead)) {
+        listedFiles.emplace(file.absoluteFilePath());
+    }
+    std::set<QString> listedDirs;
+    for(const IndexedDirectory& dir : index.changedDirectories()) {
+        listedDirs.emplace(dir.path);
+    }
+    for(const QString& dir : index.removedDirectories()) {
+        listedDirs.emplace(dir);
+    }
+    std::erase_if(m_trackPaths, [this, &listedDirs, &listedFiles](const auto& entry) {
+        if(listedDirs.contains(QFileInfo{entry.first}.absolutePath()) && !listedFiles.contains(entry.first)
+           && !QFileInfo::exists(entry.first)) {
+            std::ranges::for_each(entry.second, [this](const Track& track) { markMissing(track); });
+            return true;
+        }
+        return false;
+    });
+
+    for(const QString& file : files) {
+        const QFileInfo info{file};
+        if(!listedFiles.contains(info.absoluteFilePath()) && info.isFile() && info.size() > 0
+           && QDir::match(wildcards, info.fileName())) {
+            filesToRead.append(info);
+        }
+    }
+
+    sortFiles(filesToRead);
+
+    if(!readLibraryFiles(filesToRead, true)) {
+        return false;
+    }
+
+    storeRemainingTracks();
+    saveDirectoryIndex(index);
 
     return true;
 }
@@ -872,6 +1372,7 @@ void LibraryScanner::initialiseThread()
 
     p->m_dbHandler = std::make_unique<DbConnectionHandler>(p->m_dbPool);
     p->m_trackDatabase.initialise(DbConnectionProvider{p->m_dbPool});
+    p->m_libraryDatabase.initialise(DbConnectionProvider{p->m_dbPool});
 }
 
 void LibraryScanner::stopThread()
@@ -945,16 +1446,21 @@ void LibraryScanner::scanLibrary(const LibraryInfo& library, const TrackList& tr
     }
 }
 
-void LibraryScanner::scanLibraryDirectoies(const LibraryInfo& library, const QStringList& dirs, const TrackList& tracks)
+void LibraryScanner::scanLibraryChanges(const LibraryInfo& library, const LibraryChanges& changes,
+                                        const TrackList& tracks)
 {
     setState(Running);
 
     p->m_currentLibrary = library;
     p->changeLibraryStatus(LibraryInfo::Status::Scanning);
 
-    p->getAndSaveAllTracks(dirs, tracks, true);
+    const Timer timer;
+
+    p->applyLibraryChanges(changes, tracks);
     p->cleanupScan();
 
+    qCDebug(LIB_SCANNER) << "Applying changes to" << library.name << "took" << timer.elapsedFormatted();
+
     if(state() == Paused) {
         p->changeLibraryStatus(LibraryInfo::Status::Pending);
     }
@@ -1002,6 +1508,7 @@ void LibraryScanner::scanTracks(const TrackList& /*libraryTracks*/, const TrackL
         Track updatedTrack{track.filepath()};
 
         if(p->m_audioLoader->readTrackMetadata(updatedTrack)) {
+            updatedTrack.setFingerprint(fileFingerprint(track.filepath()));
             updatedTrack.setId(track.id());
             updatedTrack.setLibraryId(track.libraryId());
             updatedTrack.setAddedTime(track.addedTime());
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include "librarywatcher.h"
+
 #include <core/library/libraryinfo.h>
 #include <core/track.h>
 #include <utils/database/dbconnectionpool.h>
@@ -55,14 +57,14 @@ signals:
     void scanUpdate(const Fooyin::ScanResult& result);
     void scannedTracks(const Fooyin::TrackList& tracks);
     void playlistLoaded(const Fooyin::TrackList& tracks);
-    void directoriesChanged(const Fooyin::LibraryInfo& library, const QStringList& dirs);
+    void libraryChanged(const Fooyin::LibraryInfo& library, const Fooyin::LibraryChanges& changes);
 
 public slots:
     void setMonitorLibraries(bool enabled);
     void setupWatchers(const Fooyin::LibraryInfoMap& libraries, bool enabled);
     void scanLibrary(const Fooyin::LibraryInfo& library, const Fooyin::TrackList& tracks, bool onlyModified);
-    void scanLibraryDirectoies(const Fooyin::LibraryInfo& library, const QStringList& dirs,
-                               const Fooyin::TrackList& tracks);
+    void scanLibraryChanges(const Fooyin::LibraryInfo& library, const Fooyin::LibraryChanges& changes,
+                            const Fooyin::TrackList& tracks);
     void scanTracks(const Fooyin::TrackList& libraryTracks, const Fooyin::TrackList& tracks, bool onlyModified);
     void scanFiles(const Fooyin::TrackList& libraryTracks, const QList<QUrl>& urls);
     void scanPlaylist(const Fooyin::TrackList& libraryTracks, const QList<QUrl>& urls);
@@ -57,7 +57,7 @@ struct LibraryScanRequest
     int id;
     ScanRequest::Type type;
     LibraryInfo library;
-    QStringList dirs;
+    LibraryChanges changes;
     QList<QUrl> files;
     TrackList tracks;
     bool onlyModified{true};
@@ -73,13 +73,13 @@ public:
     void scanLibrary(const LibraryScanRequest& request);
     void scanTracks(const LibraryScanRequest& request);
     void scanFiles(const LibraryScanRequest& request);
-    void scanDirectory(const LibraryScanRequest& request);
+    void scanChanges(const LibraryScanRequest& request);
     void scanPlaylist(const LibraryScanRequest& request);
 
     ScanRequest addLibraryScanRequest(const LibraryInfo& libraryInfo, bool onlyModified);
     ScanRequest addTracksScanRequest(const TrackList& tracks, bool onlyModified);
     ScanRequest addFilesScanRequest(const QList<QUrl>& files);
-    ScanRequest addDirectoryScanRequest(const LibraryInfo& libraryInfo, const QStringList& dirs);
+    ScanRequest addChangesScanRequest(const LibraryInfo& libraryInfo, const LibraryChanges& changes);
     ScanRequest addPlaylistRequest(const QList<QUrl>& files);
 
     [[nodiscard]] std::optional<LibraryScanRequest> currentRequest() const;
@@ -159,10 +159,10 @@ void LibraryThreadHandlerPrivate::scanFiles(const LibraryScanRequest& request)
                               [this, request]() { m_scanner.scanFiles(m_library->tracks(), request.files); });
 }
 
-void LibraryThreadHandlerPrivate::scanDirectory(const LibraryScanRequest& request)
+void LibraryThreadHandlerPrivate::scanChanges(const LibraryScanRequest& request)
 {
     QMetaObject::invokeMethod(&m_scanner, [this, request]() {
-        m_scanner.scanLibraryDirectoies(request.library, request.dirs, m_library->tracks());
+        m_scanner.scanLibraryChanges(request.library, request.changes, m_library->tracks());
     });
 }
 
@@ -252,8 +252,8 @@ ScanRequest LibraryThreadHandlerPrivate::addFilesScanRequest(const QList<QUrl>&
     return request;
 }
 
-ScanRequest LibraryThreadHandlerPrivate::addDirectoryScanRequest(const LibraryInfo& libraryInfo,
-                                                                 const QStringList& dirs)
+ScanRequest LibraryThreadHandlerPrivate::addChangesScanRequest(const LibraryInfo& libraryInfo,
+                                                               const LibraryChanges& changes)
 {
     const int id = nextRequestId();
 
@@ -265,7 +265,7 @@ ScanRequest LibraryThreadHandlerPrivate::addDirectoryScanRequest(const LibraryIn
     libraryRequest.id      = id;
     libraryRequest.type    = ScanRequest::Library;
     libraryRequest.library = libraryInfo;
-    libraryRequest.dirs    = dirs;
+    libraryRequest.changes = changes;
 
     m_scanRequests.emplace_back(libraryRequest);
 
@@ -333,11 +333,11 @@ void LibraryThreadHandlerPrivate::execNextRequest()
             scanTracks(request);
             break;
         case(ScanRequest::Library):
-            if(request.dirs.isEmpty()) {
+            if(request.changes.empty()) {
                 scanLibrary(request);
             }
             else {
-                scanDirectory(request);
+                scanChanges(request);
             }
             break;
         case(ScanRequest::Playlist):
@@ -416,9 +416,9 @@ LibraryThreadHandler::LibraryThreadHandler(DbConnectionPoolPtr dbPool, MusicLibr
                      [this](const TrackList& tracks) { emit playlistLoaded(p->m_currentRequestId, tracks); });
     QObject::connect(&p->m_scanner, &LibraryScanner::statusChanged, this, &LibraryThreadHandler::statusChanged);
     QObject::connect(&p->m_scanner, &LibraryScanner::scanUpdate, this, &LibraryThreadHandler::scanUpdate);
-    QObject::connect(&p->m_scanner, &LibraryScanner::directoriesChanged, this,
-                     [this](const LibraryInfo& libraryInfo, const QStringList& dirs) {
-                         p->addDirectoryScanRequest(libraryInfo, dirs);
+    QObject::connect(&p->m_scanner, &LibraryScanner::libraryChanged, this,
+                     [this](const LibraryInfo& libraryInfo, const LibraryChanges& changes) {
+                         p->addChangesScanRequest(libraryInfo, changes);
                      });
 
     QMetaObject::invokeMethod(&p->m_scanner, &Worker::initialiseThread);
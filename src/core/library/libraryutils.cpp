@@ -19,6 +19,137 @@
 
 #include "libraryutils.h"
 
+#include <QCryptographicHash>
+#include <QIODevice>
+#include <QtEndian>
+
+namespace {
+constexpr qint64 FingerprintChunkSize = 64LL * 1024;
+
+struct PayloadRange
+{
+    qint64 start{0};
+    qint64 end{0};
+};
+
+QByteArray readAt(QIODevice* device, qint64 pos, qint64 size)
+{
+    if(pos < 0 || !device->seek(pos)) {
+        return {};
+    }
+    return device->read(size);
+}
+
+PayloadRange findMp4Payload(QIODevice* device, const PayloadRange& range)
+{
+    qint64 pos = range.start;
+
+    while(pos + 8 <= range.end) {
+        const QByteArray atom = readAt(device, pos, 16);
+        if(atom.size() < 8) {
+            break;
+        }
+
+        qint64 size       = qFromBigEndian<quint32>(atom.constData());
+        qint64 headerSize = 8;
+        if(size == 1 && atom.size() >= 16) {
+            size       = static_cast<qint64>(qFromBigEndian<quint64>(atom.constData() + 8));
+            headerSize = 16;
+        }
+        else if(size == 0) {
+            size = range.end - pos;
+        }
+        if(size < headerSize) {
+            break;
+        }
+
+        if(atom.mid(4, 4) == "mdat") {
+            return {.start = pos + headerSize, .end = std::min(pos + size, range.end)};
+        }
+        pos += size;
+    }
+
+    return range;
+}
+
+PayloadRange findRiffPayload(QIODevice* device, const PayloadRange& range)
+{
+    qint64 pos = range.start + 12;
+
+    while(pos + 8 <= range.end) {
+        const QByteArray chunk = readAt(device, pos, 8);
+        if(chunk.size() < 8) {
+            break;
+        }
+
+        const qint64 size = qFromLittleEndian<quint32>(chunk.constData() + 4);
+        if(chunk.startsWith("data")) {
+            return {.start = pos + 8, .end = std::min(pos + 8 + size, range.end)};
+        }
+        // Chunks are padded to an even size
+        pos += 8 + size + (size % 2);
+    }
+
+    return range;
+}
+
+PayloadRange findPayload(QIODevice* device)
+{
+    PayloadRange range{.start = 0, .end = device->size()};
+
+    QByteArray header = readAt(device, 0, 12);
+    if(header.size() >= 10 && header.startsWith("ID3")) {
+        const auto syncsafe = [&header](int offset) {
+            return ((header.at(offset) & 0x7f) << 21) | ((header.at(offset + 1) & 0x7f) << 14)
+                 | ((header.at(offset + 2) & 0x7f) << 7) | (header.at(offset + 3) & 0x7f);
+        };
+        const bool hasFooter = header.at(5) & 0x10;
+        range.start          = 10 + syncsafe(6) + (hasFooter ? 10 : 0);
+        header               = readAt(device, range.start, 12);
+    }
+
+    if(header.startsWith("RIFF") && header.mid(8, 4) == "WAVE") {
+        return findRiffPayload(device, range);
+    }
+    if(header.mid(4, 4) == "ftyp") {
+        return findMp4Payload(device, range);
+    }
+    if(header.startsWith("fLaC")) {
+        qint64 pos{range.start + 4};
+        bool last{false};
+        while(!last && pos < range.end) {
+            const QByteArray block = readAt(device, pos, 4);
+            if(block.size() < 4) {
+                break;
+            }
+            last = block.at(0) & 0x80;
+            pos += 4 + (qFromBigEndian<quint32>(block.constData()) & 0xffffff);
+        }
+        range.start = pos;
+    }
+
+    if(range.end >= 128 && readAt(device, range.end - 128, 3) == "TAG") {
+        range.end -= 128;
+    }
+
+    const QByteArray apeFooter = readAt(device, range.end - 32, 32);
+    if(apeFooter.size() == 32 && apeFooter.startsWith("APETAGEX")) {
+        const qint64 tagSize = qFromLittleEndian<quint32>(apeFooter.constData() + 12);
+        const quint32 flags  = qFromLittleEndian<quint32>(apeFooter.constData() + 20);
+        const bool hasHeader = flags & 0x80000000;
+
+        range.end -= tagSize + (hasHeader ? 32 : 0);
+    }
+
+    if(range.start < 0 || range.start >= range.end) {
+        // Malformed tags, so fall back to the whole file
+        return {.start = 0, .end = device->size()};
+    }
+
+    return range;
+}
+} // namespace
+
 namespace Fooyin::Utils {
 std::vector<int> updateCommonTracks(TrackList& tracks, const TrackList& updatedTracks, CommonOperation operation)
 {
@@ -45,4 +176,40 @@ std::vector<int> updateCommonTracks(TrackList& tracks, const TrackList& updatedT
     tracks = result;
     return indexes;
 }
+
+QString contentFingerprint(QIODevice* device)
+{
+    if(!device || !device->isOpen() || device->isSequential()) {
+        return {};
+    }
+
+    const PayloadRange range = findPayload(device);
+    const qint64 length      = range.end - range.start;
+    if(length <= 0) {
+        return {};
+    }
+
+    QCryptographicHash hash{QCryptographicHash::Md5};
+
+    const auto addRange = [device, &hash](qint64 pos, qint64 size) {
+        const QByteArray data = readAt(device, pos, size);
+        if(data.size() != size) {
+            return false;
+        }
+        hash.addData(data);
+        return true;
+    };
+
+    const qint64 headSize = std::min(length, FingerprintChunkSize);
+    if(!addRange(range.start, headSize)) {
+        return {};
+    }
+
+    const qint64 tailStart = std::max(range.start + headSize, range.end - FingerprintChunkSize);
+    if(tailStart < range.end && !addRange(tailStart, range.end - tailStart)) {
+        return {};
+    }
+
+    return QString::number(length) + u':' + QString::fromLatin1(hash.result().toHex());
+}
 } // namespace Fooyin::Utils
@@ -26,6 +26,8 @@
 #include <cstdint>
 #include <vector>
 
+class QIODevice;
+
 namespace Fooyin::Utils {
 enum class FYCORE_EXPORT CommonOperation : uint8_t
 {
@@ -35,4 +37,14 @@ enum class FYCORE_EXPORT CommonOperation : uint8_t
 
 FYCORE_EXPORT std::vector<int> updateCommonTracks(TrackList& tracks, const TrackList& updatedTracks,
                                                   CommonOperation operation);
+
+/*!
+ * Generates a fingerprint of the audio payload of @p device.
+ * Tags at the start (ID3v2, FLAC metadata) and end (ID3v1, APEv2) of the file are skipped, as are the
+ * non-audio atoms/chunks of MP4 and RIFF files, so the fingerprint survives both moves and tag edits.
+ * Only the first and last 64 KiB of the payload are hashed.
+ * @returns the fingerprint, or an empty string if the device could not be read.
+ * @note the position of @p device is left unspecified.
+ */
+FYCORE_EXPORT QString contentFingerprint(QIODevice* device);
 } // namespace Fooyin::Utils
@@ -19,37 +19,369 @@
 
 #include "librarywatcher.h"
 
-#include <QTimer>
+#include <utils/fileutils.h>
+
+#include <QDirIterator>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QLoggingCategory>
+#include <QSocketNotifier>
 #include <QTimerEvent>
 
+#include <array>
+#include <ranges>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+Q_LOGGING_CATEGORY(LIB_WATCHER, "fy.librarywatcher")
+
 using namespace std::chrono_literals;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-constexpr auto Interval = 1000ms;
+constexpr auto Interval   = 1000ms;
+constexpr auto MaxLatency = 5000ms;
 #else
-constexpr auto Interval = 1000;
+constexpr auto Interval   = 1000;
+constexpr auto MaxLatency = 5000;
 #endif
 
+namespace {
+#ifdef Q_OS_LINUX
+// Writes are reported once the file is closed rather than for every write
+constexpr uint32_t WatchMask
+    = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW;
+#endif
+
+bool isBelow(const QString& path, const QString& dir)
+{
+    return path == dir || (path.startsWith(dir) && path.at(dir.size()) == u'/');
+}
+
+QString rebase(const QString& path, const QString& from, const QString& to)
+{
+    return to + path.sliced(from.size());
+}
+} // namespace
+
 namespace Fooyin {
 LibraryWatcher::LibraryWatcher(QObject* parent)
-    : QFileSystemWatcher{parent}
+    : QObject{parent}
+    , m_fd{-1}
+    , m_notifier{nullptr}
+    , m_limitReached{false}
+    , m_fallback{nullptr}
 {
-    QObject::connect(this, &QFileSystemWatcher::directoryChanged, this, [this](const QString& path) {
-        m_dirs.emplace(path);
-        m_timer.start(Interval, this);
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_fd >= 0) {
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        QObject::connect(m_notifier, &QSocketNotifier::activated, this, &LibraryWatcher::readEvents);
+        return;
+    }
+    qCWarning(LIB_WATCHER) << "Failed to initialise inotify:" << qt_error_string(errno);
+#endif
+
+    m_fallback = new QFileSystemWatcher(this);
+    QObject::connect(m_fallback, &QFileSystemWatcher::directoryChanged, this, [this](const QString& path) {
+        // Pick up any new subdirectories
+        const QStringList dirs = Utils::File::getAllSubdirectories(path);
+        if(!dirs.empty()) {
+            m_fallback->addPaths(dirs);
+        }
+        dirChanged(path);
     });
 }
 
+LibraryWatcher::~LibraryWatcher()
+{
+#ifdef Q_OS_LINUX
+    if(m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+void LibraryWatcher::watch(const QString& path)
+{
+    m_root = path;
+    addDirectory(path);
+}
+
 void LibraryWatcher::timerEvent(QTimerEvent* event)
 {
     if(event->timerId() == m_timer.timerId()) {
+        // Nothing has arrived to pair with these, so they were moved out of the library
+        removeMoveSources();
         m_timer.stop();
+        reportChanges();
+    }
+    else if(event->timerId() == m_maxTimer.timerId()) {
+        // Changes are still arriving (e.g. a large copy), so report what we have rather than waiting for them to stop.
+        // Unpaired moves are kept, as the other half may yet arrive.
+        reportChanges();
+    }
+    QObject::timerEvent(event);
+}
 
-        const QStringList paths{m_dirs.cbegin(), m_dirs.cend()};
-        m_dirs.clear();
-        emit libraryDirsChanged(paths);
+void LibraryWatcher::scheduleUpdate()
+{
+    m_timer.start(Interval, this);
+    if(!m_maxTimer.isActive()) {
+        m_maxTimer.start(MaxLatency, this);
     }
-    QFileSystemWatcher::timerEvent(event);
+}
+
+void LibraryWatcher::reportChanges()
+{
+    m_maxTimer.stop();
+
+    LibraryChanges changes;
+    changes.modified = {m_modified.cbegin(), m_modified.cend()};
+    changes.removed  = {m_removed.cbegin(), m_removed.cend()};
+    changes.moved    = std::exchange(m_moved, {});
+    changes.dirs     = {m_dirs.cbegin(), m_dirs.cend()};
+
+    m_modified.clear();
+    m_removed.clear();
+    m_dirs.clear();
+
+    if(!changes.empty()) {
+        emit libraryChanged(changes);
+    }
+}
+
+void LibraryWatcher::addDirectory(const QString& path)
+{
+    if(m_fallback) {
+        QStringList dirs = Utils::File::getAllSubdirectories(path);
+        dirs.append(path);
+        m_fallback->addPaths(dirs);
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    if(m_limitReached) {
+        return;
+    }
+
+    auto addWatch = [this](const QString& dir) {
+        const int wd = inotify_add_watch(m_fd, QFile::encodeName(dir).constData(), WatchMask);
+        if(wd >= 0) {
+            m_watches[wd] = dir;
+            return true;
+        }
+
+        if(errno == ENOSPC) {
+            m_limitReached = true;
+            qCWarning(LIB_WATCHER) << "Reached the inotify watch limit, changes in some directories of" << m_root
+                                   << "will only be found when scanning for changes. The limit can be raised "
+                                      "with the fs.inotify.max_user_watches sysctl.";
+            return false;
+        }
+
+        qCDebug(LIB_WATCHER) << "Failed to watch" << dir << ":" << qt_error_string(errno);
+        return true;
+    };
+
+    if(!addWatch(path)) {
+        return;
+    }
+
+    QDirIterator dirIt{path, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories};
+    while(dirIt.hasNext()) {
+        dirIt.next();
+        if(!dirIt.fileInfo().isSymLink() && !addWatch(dirIt.filePath())) {
+            return;
+        }
+    }
+#endif
+}
+
+void LibraryWatcher::removeDirectory(const QString& path)
+{
+#ifdef Q_OS_LINUX
+    std::erase_if(m_watches, [this, &path](const auto& watch) {
+        if(isBelow(watch.second, path)) {
+            inotify_rm_watch(m_fd, watch.first);
+            return true;
+        }
+        return false;
+    });
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+void LibraryWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) std::array<char, 16384> buffer;
+
+    while(true) {
+        const ssize_t length = ::read(m_fd, buffer.data(), buffer.size());
+        if(length <= 0) {
+            break;
+        }
+
+        for(ssize_t offset{0}; offset < length;) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                qCInfo(LIB_WATCHER) << "Events were lost, rescanning" << m_root;
+                dirChanged(m_root);
+                continue;
+            }
+
+            if(event->mask & IN_IGNORED) {
+                m_watches.erase(event->wd);
+                continue;
+            }
+
+            const auto watch = m_watches.find(event->wd);
+            if(watch == m_watches.cend() || event->len == 0) {
+                continue;
+            }
+
+            const QString path = watch->second + u'/' + QFile::decodeName(event->name);
+            const bool isDir   = event->mask & IN_ISDIR;
+
+            if(event->mask & IN_MOVED_FROM) {
+                m_moveSources[event->cookie] = {path, isDir};
+                // Wait a while for the other half
+                scheduleUpdate();
+                continue;
+            }
+
+            if(event->mask & IN_MOVED_TO) {
+                const auto source = m_moveSources.find(event->cookie);
+                if(source != m_moveSources.cend()) {
+                    const auto [from, fromDir] = source->second;
+                    m_moveSources.erase(source);
+                    fileMoved(from, path, fromDir);
+                    continue;
+                }
+            }
+
+            // Whatever was moved away from here isn't coming back to the same place
+            removeMoveSources(path);
+
+            if(event->mask & IN_MOVED_TO) {
+                if(isDir) {
+                    addDirectory(path);
+                    dirChanged(path);
+                }
+                else {
+                    fileChanged(path);
+                }
+            }
+            else if(event->mask & IN_CREATE) {
+                if(isDir) {
+                    // Anything created before the watch was added is found by listing the directory
+                    addDirectory(path);
+                    dirChanged(path);
+                }
+                else {
+                    fileChanged(path);
+                }
+            }
+            else if(event->mask & IN_CLOSE_WRITE) {
+                fileChanged(path);
+            }
+            else if(event->mask & IN_DELETE) {
+                fileRemoved(path);
+            }
+        }
+    }
+#endif
+}
+
+void LibraryWatcher::removeMoveSources(const QString& path)
+{
+    std::erase_if(m_moveSources, [this, &path](const auto& source) {
+        const auto& [from, isDir] = source.second;
+        if(!path.isEmpty() && from != path) {
+            return false;
+        }
+        if(isDir) {
+            removeDirectory(from);
+        }
+        fileRemoved(from);
+        return true;
+    });
+}
+
+void LibraryWatcher::fileChanged(const QString& path)
+{
+    m_removed.erase(path);
+    m_modified.emplace(path);
+    scheduleUpdate();
+}
+
+void LibraryWatcher::fileRemoved(const QString& path)
+{
+    std::erase_if(m_modified, [&path](const QString& file) { return isBelow(file, path); });
+    std::erase_if(m_dirs, [&path](const QString& dir) { return isBelow(dir, path); });
+    m_removed.emplace(path);
+    scheduleUpdate();
+}
+
+void LibraryWatcher::fileMoved(const QString& from, const QString& to, bool isDir)
+{
+    scheduleUpdate();
+
+    if(isDir) {
+        for(auto& dir : m_watches | std::views::values) {
+            if(isBelow(dir, from)) {
+                dir = rebase(dir, from, to);
+            }
+        }
+    }
+
+    m_removed.erase(to);
+
+    // Written then renamed into place, e.g. by a tag editor saving to a temporary file.
+    // It may also have been a library file saved and then renamed, so the old path goes too if it was known.
+    if(!isDir && m_modified.contains(from)) {
+        m_modified.erase(from);
+        m_modified.emplace(to);
+        m_removed.emplace(from);
+        return;
+    }
+
+    std::set<QString> modified;
+    for(const QString& file : m_modified) {
+        modified.emplace(isBelow(file, from) ? rebase(file, from, to) : file);
+    }
+    m_modified = std::move(modified);
+
+    std::set<QString> dirs;
+    for(const QString& dir : m_dirs) {
+        dirs.emplace(isBelow(dir, from) ? rebase(dir, from, to) : dir);
+    }
+    m_dirs = std::move(dirs);
+
+    // Collapse a chain of renames into a single move
+    for(auto& move : m_moved) {
+        if(move.second == from) {
+            move.second = to;
+            return;
+        }
+    }
+
+    m_moved.emplace_back(from, to);
+}
+
+void LibraryWatcher::dirChanged(const QString& path)
+{
+    m_dirs.emplace(path);
+    scheduleUpdate();
 }
 } // namespace Fooyin
 
@@ -20,26 +20,92 @@
 #pragma once
 
 #include <QBasicTimer>
-#include <QFileSystemWatcher>
+#include <QObject>
+#include <QStringList>
 
 #include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
 
 namespace Fooyin {
-class LibraryWatcher : public QFileSystemWatcher
+/*!
+ * Changes to a library's files, coalesced over a short interval.
+ */
+struct LibraryChanges
+{
+    // Files which were created or written to
+    QStringList modified;
+    // Files or directories which no longer exist
+    QStringList removed;
+    // Files or directories renamed within the library, as (from, to)
+    std::vector<std::pair<QString, QString>> moved;
+    // Directories which need to be listed in full (e.g. created, moved in, or where events were lost)
+    QStringList dirs;
+
+    [[nodiscard]] bool empty() const
+    {
+        return modified.empty() && removed.empty() && moved.empty() && dirs.empty();
+    }
+};
+
+/*!
+ * Recursively watches a library directory.
+ *
+ * On Linux, inotify is used directly so that individual files which are created, written, moved or removed are
+ * reported, with renames paired up so they can be applied without re-reading the files. Elsewhere (or if inotify
+ * is unavailable), QFileSystemWatcher is used and only changed directories are reported.
+ */
+class LibraryWatcher : public QObject
 {
     Q_OBJECT
 
 public:
     explicit LibraryWatcher(QObject* parent = nullptr);
+    ~LibraryWatcher() override;
+
+    void watch(const QString& path);
 
 signals:
-    void libraryDirsChanged(const QStringList& paths);
+    void libraryChanged(const Fooyin::LibraryChanges& changes);
 
 protected:
     void timerEvent(QTimerEvent* event) override;
 
 private:
+    void addDirectory(const QString& path);
+    void removeDirectory(const QString& path);
+    void readEvents();
+    void removeMoveSources(const QString& path = {});
+    void scheduleUpdate();
+    void reportChanges();
+
+    void fileChanged(const QString& path);
+    void fileRemoved(const QString& path);
+    void fileMoved(const QString& from, const QString& to, bool isDir);
+    void dirChanged(const QString& path);
+
+    QString m_root;
     QBasicTimer m_timer;
+    // Caps how long a constant stream of changes can hold up reporting
+    QBasicTimer m_maxTimer;
+
+    std::set<QString> m_modified;
+    std::set<QString> m_removed;
+    std::vector<std::pair<QString, QString>> m_moved;
     std::set<QString> m_dirs;
+
+    int m_fd;
+    QSocketNotifier* m_notifier;
+    std::unordered_map<int, QString> m_watches;
+    // Paths of unpaired IN_MOVED_FROM events, by cookie. The matching IN_MOVED_TO may not have been queued yet,
+    // so these are only treated as removed once the timer fires.
+    std::unordered_map<uint32_t, std::pair<QString, bool>> m_moveSources;
+    bool m_limitReached;
+
+    QFileSystemWatcher* m_fallback;
 };
 } // namespace Fooyin
@@ -86,6 +86,7 @@ public:
     bool enabled{true};
     int id{-1};
     QString hash;
+    QString fingerprint;
     QString codec;
     QString filepath;
     QString directory;
@@ -299,6 +300,11 @@ QString Track::hash() const
     return p->hash;
 }
 
+QString Track::fingerprint() const
+{
+    return p->fingerprint;
+}
+
 QString Track::albumHash() const
 {
     QStringList hash;
@@ -879,6 +885,11 @@ void Track::setHash(const QString& hash)
     p->hash = hash;
 }
 
+void Track::setFingerprint(const QString& fingerprint)
+{
+    p->fingerprint = fingerprint;
+}
+
 void Track::setFilePath(const QString& path)
 {
     if(path.isEmpty()) {
@@ -35,11 +35,13 @@
 #include <QFileInfo>
 #include <QGridLayout>
 #include <QGroupBox>
+#include <QHBoxLayout>
 #include <QHeaderView>
 #include <QInputDialog>
 #include <QLabel>
 #include <QMenu>
 #include <QPushButton>
+#include <QSpinBox>
 
 using namespace Qt::StringLiterals;
 
@@ -105,9 +107,11 @@ private:
 
     QLineEdit* m_restrictTypes;
     QLineEdit* m_excludeTypes;
+    QSpinBox* m_scanThreads;
 
     QCheckBox* m_autoRefresh;
     QCheckBox* m_monitorLibraries;
+    QCheckBox* m_skipUnchanged;
     QCheckBox* m_markUnavailable;
     QCheckBox* m_markUnavailableStart;
     QCheckBox* m_useVariousCompilations;
@@ -124,8 +128,10 @@ LibraryGeneralPageWidget::LibraryGeneralPageWidget(ActionManager* actionManager,
     , m_model{new LibraryModel(m_libraryManager, this)}
     , m_restrictTypes{new QLineEdit(this)}
     , m_excludeTypes{new QLineEdit(this)}
+    , m_scanThreads{new QSpinBox(this)}
     , m_autoRefresh{new QCheckBox(tr("Auto refresh on startup"), this)}
     , m_monitorLibraries{new QCheckBox(tr("Monitor libraries"), this)}
+    , m_skipUnchanged{new QCheckBox(tr("Skip unchanged folders when scanning for changes"), this)}
     , m_markUnavailable{new QCheckBox(tr("Mark unavailable tracks on playback"), this)}
     , m_markUnavailableStart{new QCheckBox(tr("Mark unavailable tracks on startup"), this)}
     , m_useVariousCompilations{new QCheckBox(tr("Use 'Various Artists' for compilations"), this)}
@@ -143,6 +149,9 @@ LibraryGeneralPageWidget::LibraryGeneralPageWidget(ActionManager* actionManager,
 
     m_autoRefresh->setToolTip(tr("Scan libraries for changes on startup"));
     m_monitorLibraries->setToolTip(tr("Monitor libraries for external changes"));
+    m_skipUnchanged->setToolTip(tr("Only look for changed files in folders which have had files added, removed or "
+                                   "renamed since the last scan. Use 'Reload tracks' to pick up files which were "
+                                   "edited in place."));
 
     auto* fileTypesGroup  = new QGroupBox(tr("File Types"), this);
     auto* fileTypesLayout = new QGridLayout(fileTypesGroup);
@@ -155,13 +164,28 @@ LibraryGeneralPageWidget::LibraryGeneralPageWidget(ActionManager* actionManager,
     fileTypesLayout->addWidget(new QLabel(u"🛈 e.g. \"mp3;m4a\""_s, this), row++, 1);
     fileTypesLayout->setColumnStretch(1, 1);
 
+    m_scanThreads->setRange(0, 64);
+    m_scanThreads->setSpecialValueText(tr("Automatic"));
+
+    const auto threadsToolTip = tr("Threads used to read file metadata when scanning libraries");
+    auto* threadsLabel        = new QLabel(tr("Scanning threads") + ":"_L1, this);
+    threadsLabel->setToolTip(threadsToolTip);
+    m_scanThreads->setToolTip(threadsToolTip);
+
+    auto* threadsLayout = new QHBoxLayout();
+    threadsLayout->addWidget(threadsLabel);
+    threadsLayout->addWidget(m_scanThreads);
+    threadsLayout->addStretch();
+
     auto* mainLayout = new QGridLayout(this);
 
     row = 0;
     mainLayout->addWidget(m_libraryView, row++, 0, 1, 2);
     mainLayout->addWidget(fileTypesGroup, row++, 0, 1, 2);
+    mainLayout->addLayout(threadsLayout, row++, 0, 1, 2);
     mainLayout->addWidget(m_autoRefresh, row++, 0, 1, 2);
     mainLayout->addWidget(m_monitorLibraries, row++, 0, 1, 2);
+    mainLayout->addWidget(m_skipUnchanged, row++, 0, 1, 2);
     mainLayout->addWidget(m_markUnavailable, row++, 0, 1, 2);
     mainLayout->addWidget(m_markUnavailableStart, row++, 0, 1, 2);
     mainLayout->addWidget(m_useVariousCompilations, row++, 0, 1, 2);
@@ -185,9 +209,11 @@ void LibraryGeneralPageWidget::load()
 
     m_restrictTypes->setText(restrictExtensions.join(u';'));
     m_excludeTypes->setText(excludeExtensions.join(u';'));
+    m_scanThreads->setValue(m_settings->fileValue(Settings::Core::Internal::LibraryScanThreads, 0).toInt());
 
     m_autoRefresh->setChecked(m_settings->value<Settings::Core::AutoRefresh>());
     m_monitorLibraries->setChecked(m_settings->value<Settings::Core::Internal::MonitorLibraries>());
+    m_skipUnchanged->setChecked(m_settings->fileValue(Settings::Core::Internal::LibrarySkipUnchanged, true).toBool());
     m_markUnavailable->setChecked(m_settings->fileValue(Settings::Core::Internal::MarkUnavailable, false).toBool());
     m_markUnavailableStart->setChecked(
         m_settings->fileValue(Settings::Core::Internal::MarkUnavailableStartup, false).toBool());
@@ -204,9 +230,11 @@ void LibraryGeneralPageWidget::apply()
                         m_restrictTypes->text().split(u';', Qt::SkipEmptyParts));
     m_settings->fileSet(Settings::Core::Internal::LibraryExcludeTypes,
                         m_excludeTypes->text().split(u';', Qt::SkipEmptyParts));
+    m_settings->fileSet(Settings::Core::Internal::LibraryScanThreads, m_scanThreads->value());
 
     m_settings->set<Settings::Core::AutoRefresh>(m_autoRefresh->isChecked());
     m_settings->set<Settings::Core::Internal::MonitorLibraries>(m_monitorLibraries->isChecked());
+    m_settings->fileSet(Settings::Core::Internal::LibrarySkipUnchanged, m_skipUnchanged->isChecked());
     m_settings->fileSet(Settings::Core::Internal::MarkUnavailable, m_markUnavailable->isChecked());
     m_settings->fileSet(Settings::Core::Internal::MarkUnavailableStartup, m_markUnavailableStart->isChecked());
     m_settings->set<Settings::Core::UseVariousForCompilations>(m_useVariousCompilations->isChecked());
@@ -218,9 +246,11 @@ void LibraryGeneralPageWidget::reset()
 {
     m_settings->fileRemove(Settings::Core::Internal::LibraryRestrictTypes);
     m_settings->fileRemove(Settings::Core::Internal::LibraryExcludeTypes);
+    m_settings->fileRemove(Settings::Core::Internal::LibraryScanThreads);
 
     m_settings->reset<Settings::Core::AutoRefresh>();
     m_settings->reset<Settings::Core::Internal::MonitorLibraries>();
+    m_settings->fileRemove(Settings::Core::Internal::LibrarySkipUnchanged);
     m_settings->fileRemove(Settings::Core::Internal::MarkUnavailable);
     m_settings->fileRemove(Settings::Core::Internal::MarkUnavailableStartup);
     m_settings->reset<Settings::Core::UseVariousForCompilations>();
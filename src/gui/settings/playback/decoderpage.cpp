@@ -31,6 +31,7 @@
 #include <QGroupBox>
 #include <QLabel>
 #include <QListView>
+#include <QSpinBox>
 
 using namespace Qt::StringLiterals;
 
@@ -79,6 +80,7 @@ private:
     DecoderModel* m_readerModel;
 
     QCheckBox* m_ffmpegAllExts;
+    QSpinBox* m_ffmpegThreads;
 };
 
 DecoderPageWidget::DecoderPageWidget(AudioLoader* audioLoader, SettingsManager* settings)
@@ -89,6 +91,7 @@ DecoderPageWidget::DecoderPageWidget(AudioLoader* audioLoader, SettingsManager*
     , m_readerList{new QListView(this)}
     , m_readerModel{new DecoderModel(this)}
     , m_ffmpegAllExts{new QCheckBox(tr("Enable all supported extensions"), this)}
+    , m_ffmpegThreads{new QSpinBox(this)}
 {
     auto setupModel = [](QAbstractItemView* view) {
         view->setDragDropMode(QAbstractItemView::InternalMove);
@@ -107,7 +110,20 @@ DecoderPageWidget::DecoderPageWidget(AudioLoader* audioLoader, SettingsManager*
     auto* ffmpegGroup       = new QGroupBox(u"FFmpeg"_s, this);
     auto* ffmpegGroupLayout = new QGridLayout(ffmpegGroup);
 
-    ffmpegGroupLayout->addWidget(m_ffmpegAllExts);
+    m_ffmpegThreads->setRange(0, 64);
+    m_ffmpegThreads->setSpecialValueText(tr("Automatic"));
+
+    const auto threadsToolTip = tr("Threads used when scanning or converting files with codecs which support it. "
+                                   "Files decoded at the same time share the available cores between them. "
+                                   "Playback always decodes on a single thread.");
+    auto* threadsLabel        = new QLabel(tr("Decoding threads") + ":"_L1, this);
+    threadsLabel->setToolTip(threadsToolTip);
+    m_ffmpegThreads->setToolTip(threadsToolTip);
+
+    ffmpegGroupLayout->addWidget(m_ffmpegAllExts, 0, 0, 1, 3);
+    ffmpegGroupLayout->addWidget(threadsLabel, 1, 0);
+    ffmpegGroupLayout->addWidget(m_ffmpegThreads, 1, 1);
+    ffmpegGroupLayout->setColumnStretch(2, 1);
 
     auto* layout = new QGridLayout(this);
     layout->addWidget(new QLabel(tr("Decoders") + ":"_L1, this), 0, 0);
@@ -126,6 +142,7 @@ void DecoderPageWidget::load()
     m_decoderModel->setup(m_audioLoader->decoders());
     m_readerModel->setup(m_audioLoader->readers());
     m_ffmpegAllExts->setChecked(m_settings->fileValue(Settings::Core::Internal::FFmpegAllExtensions).toBool());
+    m_ffmpegThreads->setValue(m_settings->fileValue(Settings::Core::Internal::FFmpegDecodeThreads, 0).toInt());
 }
 
 void DecoderPageWidget::apply()
@@ -144,6 +161,7 @@ void DecoderPageWidget::apply()
         m_audioLoader->reloadDecoderExtensions(u"FFmpeg"_s);
         m_audioLoader->reloadReaderExtensions(u"FFmpeg"_s);
     }
+    m_settings->fileSet(Settings::Core::Internal::FFmpegDecodeThreads, m_ffmpegThreads->value());
 
     load();
 }
@@ -152,6 +170,7 @@ void DecoderPageWidget::reset()
 {
     m_audioLoader->reset();
     m_settings->fileRemove(Settings::Core::Internal::FFmpegAllExtensions);
+    m_settings->fileRemove(Settings::Core::Internal::FFmpegDecodeThreads);
 }
 
 DecoderPage::DecoderPage(AudioLoader* audioLoader, SettingsManager* settings, QObject* parent)
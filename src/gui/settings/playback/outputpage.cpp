@@ -60,12 +60,20 @@ private:
 
     QCheckBox* m_gaplessPlayback;
     QSpinBox* m_bufferSize;
+    QSpinBox* m_readAhead;
+    QCheckBox* m_realtimeDecode;
+    QComboBox* m_resamplerQuality;
+    QCheckBox* m_bitPerfect;
 
     QGroupBox* m_fadingBox;
     QSpinBox* m_fadingStopIn;
     QSpinBox* m_fadingStopOut;
     // QSpinBox* m_fadingSeekIn;
     // QSpinBox* m_fadingSeekOut;
+
+    QGroupBox* m_crossfadingBox;
+    QSpinBox* m_crossfadingIn;
+    QSpinBox* m_crossfadingOut;
 };
 
 OutputPageWidget::OutputPageWidget(EngineController* engine, SettingsManager* settings)
@@ -75,11 +83,18 @@ OutputPageWidget::OutputPageWidget(EngineController* engine, SettingsManager* se
     , m_deviceBox{new ExpandingComboBox(this)}
     , m_gaplessPlayback{new QCheckBox(tr("Gapless playback"), this)}
     , m_bufferSize{new QSpinBox(this)}
+    , m_readAhead{new QSpinBox(this)}
+    , m_realtimeDecode{new QCheckBox(tr("Real-time decoding priority"), this)}
+    , m_resamplerQuality{new QComboBox(this)}
+    , m_bitPerfect{new QCheckBox(tr("Bit-perfect playback"), this)}
     , m_fadingBox{new QGroupBox(tr("Fading"), this)}
     , m_fadingStopIn{new QSpinBox(this)}
     , m_fadingStopOut{new QSpinBox(this)}
 // , m_fadingSeekIn{new QSpinBox(this)}
 // , m_fadingSeekOut{new QSpinBox(this)}
+    , m_crossfadingBox{new QGroupBox(tr("Crossfading"), this)}
+    , m_crossfadingIn{new QSpinBox(this)}
+    , m_crossfadingOut{new QSpinBox(this)}
 {
     auto* generalBox    = new QGroupBox(tr("General"), this);
     auto* generalLayout = new QGridLayout(generalBox);
@@ -97,6 +112,31 @@ OutputPageWidget::OutputPageWidget(EngineController* engine, SettingsManager* se
     generalLayout->addWidget(new QLabel(tr("Buffer length") + u":"_s, this), 1, 0);
     generalLayout->addWidget(m_bufferSize, 1, 1);
 
+    m_readAhead->setToolTip(tr("Audio to decode ahead of the buffer, to ride out slow reads from network storage"));
+    m_readAhead->setSuffix(u" ms"_s);
+    m_readAhead->setSingleStep(500);
+    m_readAhead->setMinimum(2000);
+    m_readAhead->setMaximum(10000);
+
+    generalLayout->addWidget(new QLabel(tr("Read-ahead") + u":"_s, this), 2, 0);
+    generalLayout->addWidget(m_readAhead, 2, 1);
+
+    m_realtimeDecode->setToolTip(tr("Request real-time scheduling for the decoding thread, where permitted"));
+    generalLayout->addWidget(m_realtimeDecode, 3, 0, 1, 3);
+
+    m_bitPerfect->setToolTip(tr("Open the device at each track's native format, bypassing ReplayGain, DSPs, fading "
+                                "and software volume. Requires a hardware device, such as ALSA's hw: devices"));
+    m_resamplerQuality->setToolTip(tr("Quality of sample rate conversion, where the device doesn't support a "
+                                      "track's sample rate. Higher qualities use more CPU"));
+    m_resamplerQuality->addItem(tr("Fast"), static_cast<int>(ResamplerQuality::Fast));
+    m_resamplerQuality->addItem(tr("Standard"), static_cast<int>(ResamplerQuality::Standard));
+    m_resamplerQuality->addItem(tr("High"), static_cast<int>(ResamplerQuality::High));
+    m_resamplerQuality->addItem(tr("Best"), static_cast<int>(ResamplerQuality::Best));
+
+    generalLayout->addWidget(new QLabel(tr("Resampling") + u":"_s, this), 4, 0);
+    generalLayout->addWidget(m_resamplerQuality, 4, 1);
+    generalLayout->addWidget(m_bitPerfect, 5, 0, 1, 3);
+
     generalLayout->setColumnStretch(2, 1);
 
     m_fadingBox->setCheckable(true);
@@ -127,6 +167,26 @@ OutputPageWidget::OutputPageWidget(EngineController* engine, SettingsManager* se
     // fadingLayout->addWidget(m_fadingSeekOut, 2, 2);
     fadingLayout->setColumnStretch(3, 1);
 
+    m_crossfadingBox->setCheckable(true);
+    m_crossfadingBox->setToolTip(tr("Fade between consecutive tracks of the same format"));
+    auto* crossfadingLayout = new QGridLayout(m_crossfadingBox);
+
+    m_crossfadingIn->setSuffix(u"ms"_s);
+    m_crossfadingOut->setSuffix(u"ms"_s);
+
+    m_crossfadingIn->setMaximum(10000);
+    m_crossfadingOut->setMaximum(10000);
+
+    m_crossfadingIn->setSingleStep(100);
+    m_crossfadingOut->setSingleStep(100);
+
+    crossfadingLayout->addWidget(new QLabel(tr("Fade In"), this), 0, 1);
+    crossfadingLayout->addWidget(new QLabel(tr("Fade Out"), this), 0, 2);
+    crossfadingLayout->addWidget(new QLabel(tr("Track change"), this), 1, 0);
+    crossfadingLayout->addWidget(m_crossfadingIn, 1, 1);
+    crossfadingLayout->addWidget(m_crossfadingOut, 1, 2);
+    crossfadingLayout->setColumnStretch(3, 1);
+
     auto* mainLayout = new QGridLayout(this);
     mainLayout->addWidget(new QLabel(tr("Output") + u":"_s, this), 0, 0);
     mainLayout->addWidget(m_outputBox, 0, 1);
@@ -134,6 +194,7 @@ OutputPageWidget::OutputPageWidget(EngineController* engine, SettingsManager* se
     mainLayout->addWidget(m_deviceBox, 1, 1);
     mainLayout->addWidget(generalBox, 2, 0, 1, 2);
     mainLayout->addWidget(m_fadingBox, 3, 0, 1, 2);
+    mainLayout->addWidget(m_crossfadingBox, 4, 0, 1, 2);
 
     mainLayout->setColumnStretch(1, 1);
     mainLayout->setRowStretch(mainLayout->rowCount(), 1);
@@ -155,6 +216,11 @@ void OutputPageWidget::load()
     setupDevices(m_outputBox->currentText());
     m_gaplessPlayback->setChecked(m_settings->value<Settings::Core::GaplessPlayback>());
     m_bufferSize->setValue(m_settings->value<Settings::Core::BufferLength>());
+    m_readAhead->setValue(m_settings->value<Settings::Core::Internal::DecodeReadAhead>());
+    m_realtimeDecode->setChecked(m_settings->value<Settings::Core::Internal::DecodeRealtime>());
+    m_resamplerQuality->setCurrentIndex(
+        m_resamplerQuality->findData(m_settings->value<Settings::Core::Internal::ResamplerQuality>()));
+    m_bitPerfect->setChecked(m_settings->value<Settings::Core::Internal::BitPerfect>());
 
     m_fadingBox->setChecked(m_settings->value<Settings::Core::Internal::EngineFading>());
     const auto fadingValues = m_settings->value<Settings::Core::Internal::FadingIntervals>().value<FadingIntervals>();
@@ -162,6 +228,10 @@ void OutputPageWidget::load()
     m_fadingStopOut->setValue(fadingValues.outPauseStop);
     // m_fadingSeekIn->setValue(fadingValues.inSeek);
     // m_fadingSeekOut->setValue(fadingValues.outSeek);
+
+    m_crossfadingBox->setChecked(m_settings->value<Settings::Core::Internal::EngineCrossfading>());
+    m_crossfadingIn->setValue(fadingValues.inChange);
+    m_crossfadingOut->setValue(fadingValues.outChange);
 }
 
 void OutputPageWidget::apply()
@@ -170,14 +240,21 @@ void OutputPageWidget::apply()
     m_settings->set<Settings::Core::AudioOutput>(output);
     m_settings->set<Settings::Core::GaplessPlayback>(m_gaplessPlayback->isChecked());
     m_settings->set<Settings::Core::BufferLength>(m_bufferSize->value());
+    m_settings->set<Settings::Core::Internal::DecodeReadAhead>(m_readAhead->value());
+    m_settings->set<Settings::Core::Internal::DecodeRealtime>(m_realtimeDecode->isChecked());
+    m_settings->set<Settings::Core::Internal::ResamplerQuality>(m_resamplerQuality->currentData().toInt());
+    m_settings->set<Settings::Core::Internal::BitPerfect>(m_bitPerfect->isChecked());
 
     FadingIntervals fadingValues;
     fadingValues.inPauseStop  = m_fadingStopIn->value();
     fadingValues.outPauseStop = m_fadingStopOut->value();
     // fadingValues.inSeek       = m_fadingSeekIn->value();
     // fadingValues.outSeek      = m_fadingSeekOut->value();
+    fadingValues.inChange     = m_crossfadingIn->value();
+    fadingValues.outChange    = m_crossfadingOut->value();
 
     m_settings->set<Settings::Core::Internal::EngineFading>(m_fadingBox->isChecked());
+    m_settings->set<Settings::Core::Internal::EngineCrossfading>(m_crossfadingBox->isChecked());
     m_settings->set<Settings::Core::Internal::FadingIntervals>(QVariant::fromValue(fadingValues));
 }
 
@@ -186,7 +263,12 @@ void OutputPageWidget::reset()
     m_settings->reset<Settings::Core::AudioOutput>();
     m_settings->reset<Settings::Core::GaplessPlayback>();
     m_settings->reset<Settings::Core::BufferLength>();
+    m_settings->reset<Settings::Core::Internal::DecodeReadAhead>();
+    m_settings->reset<Settings::Core::Internal::DecodeRealtime>();
+    m_settings->reset<Settings::Core::Internal::ResamplerQuality>();
+    m_settings->reset<Settings::Core::Internal::BitPerfect>();
     m_settings->reset<Settings::Core::Internal::EngineFading>();
+    m_settings->reset<Settings::Core::Internal::EngineCrossfading>();
     m_settings->reset<Settings::Core::Internal::FadingIntervals>();
 }
 
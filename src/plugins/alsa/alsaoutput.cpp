@@ -26,7 +26,14 @@
 #include <QDebug>
 #include <QLoggingCategory>
 
+#include <algorithm>
+#include <cstring>
 #include <ranges>
+#include <utility>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 Q_LOGGING_CATEGORY(ALSA, "fy.alsa")
 
@@ -153,6 +160,50 @@ struct CtlHandleDeleter
     }
 };
 using CtlHandleUPtr = std::unique_ptr<snd_ctl_t, CtlHandleDeleter>;
+
+/*!
+ * Transfers up to @p frames straight into the hardware buffer of an interleaved mmap PCM.
+ * @p fill is given each contiguous region of the ring to write into, and returns the number of frames it wrote.
+ * @returns the number of frames committed, or a negative error code if nothing was.
+ */
+template <typename Fill>
+snd_pcm_sframes_t mmapTransfer(snd_pcm_t* handle, int bytesPerFrame, snd_pcm_uframes_t frames, Fill&& fill)
+{
+    snd_pcm_sframes_t transferred{0};
+
+    while(frames > 0) {
+        const snd_pcm_channel_area_t* areas{nullptr};
+        snd_pcm_uframes_t offset{0};
+        snd_pcm_uframes_t size{frames};
+
+        const int err = snd_pcm_mmap_begin(handle, &areas, &offset, &size);
+        if(err < 0) {
+            return transferred > 0 ? transferred : err;
+        }
+        if(size == 0) {
+            break;
+        }
+
+        // Interleaved, so the first area covers every channel
+        auto* dst = static_cast<std::byte*>(areas[0].addr) + (areas[0].first / 8) + (offset * areas[0].step / 8);
+        const auto filled = static_cast<snd_pcm_uframes_t>(
+            std::clamp<snd_pcm_sframes_t>(fill(std::span{dst, size * bytesPerFrame}), 0, size));
+
+        const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(handle, offset, filled);
+        if(committed < 0) {
+            return transferred > 0 ? transferred : committed;
+        }
+
+        transferred += committed;
+        frames -= static_cast<snd_pcm_uframes_t>(committed);
+
+        if(std::cmp_less(committed, size)) {
+            break;
+        }
+    }
+
+    return transferred;
+}
 } // namespace
 
 namespace Fooyin::Alsa {
@@ -160,10 +211,16 @@ AlsaOutput::AlsaOutput()
     : m_initialised{false}
     , m_pausable{true}
     , m_started{false}
+    , m_paused{false}
+    , m_mmap{false}
+    , m_bitPerfect{false}
     , m_device{u"default"_s}
     , m_volume{1.0}
     , m_bufferSize{8192}
     , m_periodSize{1024}
+    , m_xruns{0}
+    , m_quit{false}
+    , m_wakeFd{-1}
 { }
 
 AlsaOutput::~AlsaOutput()
@@ -175,11 +232,17 @@ bool AlsaOutput::init(const AudioFormat& format)
 {
     m_format = format;
 
+    m_xruns = 0;
+
     if(!initAlsa()) {
         uninit();
         return false;
     }
 
+    if(m_renderCallback) {
+        startPullThread();
+    }
+
     m_initialised = true;
     return true;
 }
@@ -192,6 +255,8 @@ void AlsaOutput::uninit()
 
 void AlsaOutput::reset()
 {
+    const std::scoped_lock lock{m_pcmMutex};
+
     checkError(snd_pcm_drop(m_pcmHandle.get()), "ALSA drop error");
     checkError(snd_pcm_prepare(m_pcmHandle.get()), "ALSA prepare error");
 
@@ -201,12 +266,23 @@ void AlsaOutput::reset()
 
 void AlsaOutput::start()
 {
-    m_started = true;
-    snd_pcm_start(m_pcmHandle.get());
+    {
+        const std::scoped_lock lock{m_pcmMutex};
+        m_started = true;
+        if(m_renderCallback) {
+            // The pull thread fills the buffer before starting the device
+            m_paused = false;
+        }
+        else {
+            snd_pcm_start(m_pcmHandle.get());
+        }
+    }
+    m_pullCond.notify_all();
 }
 
 void AlsaOutput::drain()
 {
+    const std::scoped_lock lock{m_pcmMutex};
     snd_pcm_drain(m_pcmHandle.get());
 }
 
@@ -227,6 +303,8 @@ int AlsaOutput::bufferSize() const
 
 OutputState AlsaOutput::currentState()
 {
+    const std::scoped_lock lock{m_pcmMutex};
+
     OutputState state;
 
     recoverState(&state);
@@ -246,12 +324,47 @@ OutputDevices AlsaOutput::getAllDevices(bool /*isCurrentOutput*/)
 
 int AlsaOutput::write(const AudioBuffer& buffer)
 {
+    const std::scoped_lock lock{m_pcmMutex};
+
     if(!m_pcmHandle || !recoverState()) {
         return 0;
     }
 
     const int frameCount = buffer.frameCount();
 
+    if(m_mmap) {
+        const snd_pcm_sframes_t avail = availableFrames();
+        if(avail <= 0) {
+            return 0;
+        }
+
+        const int bps     = m_format.bytesPerFrame();
+        const auto input  = buffer.constData();
+        const auto frames = std::min(static_cast<snd_pcm_uframes_t>(frameCount), static_cast<snd_pcm_uframes_t>(avail));
+
+        size_t offset{0};
+        const snd_pcm_sframes_t written
+            = mmapTransfer(m_pcmHandle.get(), bps, frames, [this, bps, &input, &offset](std::span<std::byte> data) {
+                  // Volume is applied as the samples are copied in, rather than to a copy of the buffer
+                  std::memcpy(data.data(), input.data() + offset, data.size());
+                  Audio::scale(data, m_format.sampleFormat(), m_volume);
+                  offset += data.size();
+                  return static_cast<snd_pcm_sframes_t>(data.size() / bps);
+              });
+
+        if(checkError(static_cast<int>(written), "Write error")) {
+            return 0;
+        }
+        if(written != frameCount) {
+            qCWarning(ALSA) << "Unexpected partial write";
+        }
+        return static_cast<int>(written);
+    }
+
+    if(availableFrames() < 0) {
+        return 0;
+    }
+
     AudioBuffer adjustedBuff{buffer};
     adjustedBuff.scale(m_volume);
 
@@ -266,8 +379,22 @@ int AlsaOutput::write(const AudioBuffer& buffer)
     return static_cast<int>(err);
 }
 
+bool AlsaOutput::setRenderCallback(const AudioRenderCallback& callback)
+{
+    m_renderCallback = callback;
+    return true;
+}
+
+bool AlsaOutput::setBitPerfect(bool enabled)
+{
+    m_bitPerfect = enabled;
+    return true;
+}
+
 void AlsaOutput::setPaused(bool pause)
 {
+    const std::scoped_lock lock{m_pcmMutex};
+
     if(!m_pausable) {
         return;
     }
@@ -283,6 +410,9 @@ void AlsaOutput::setPaused(bool pause)
     else if(state == SND_PCM_STATE_PAUSED && !pause) {
         checkError(snd_pcm_pause(m_pcmHandle.get(), 0), "Couldn't unpause device");
     }
+
+    m_paused = pause;
+    m_pullCond.notify_all();
 }
 
 void AlsaOutput::setVolume(double volume)
@@ -309,6 +439,8 @@ AudioFormat AlsaOutput::format() const
 
 void AlsaOutput::resetAlsa()
 {
+    stopPullThread();
+
     if(m_pcmHandle) {
         m_pcmHandle.reset();
     }
@@ -329,6 +461,12 @@ bool AlsaOutput::initAlsa()
     }
     snd_pcm_t* handle = m_pcmHandle.get();
 
+    if(m_bitPerfect && snd_pcm_type(handle) != SND_PCM_TYPE_HW) {
+        // Plugin devices (default, plughw, dmix) may convert or mix behind our back
+        checkError(-ENODEV, "Bit-perfect playback needs a hardware (hw:) device");
+        return false;
+    }
+
     snd_pcm_hw_params_t* hwParams;
     snd_pcm_hw_params_alloca(&hwParams);
 
@@ -339,16 +477,22 @@ bool AlsaOutput::initAlsa()
 
     m_pausable = snd_pcm_hw_params_can_pause(hwParams);
 
-    err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
-    if(checkError(err, "Failed to set access mode")) {
-        return false;
+    // Write straight into the hardware buffer where the device allows it
+    m_mmap = m_settings.value(MmapAccessSetting, DefaultMmapAccess).toBool()
+          && snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0;
+    if(!m_mmap) {
+        err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+        if(checkError(err, "Failed to set access mode")) {
+            return false;
+        }
     }
+    qCDebug(ALSA) << "Using" << (m_mmap ? "mmap" : "read/write") << "access";
 
     if(!setAlsaFormat(hwParams)) {
         return false;
     }
 
-    err = snd_pcm_hw_params_set_rate_resample(handle, hwParams, 1);
+    err = snd_pcm_hw_params_set_rate_resample(handle, hwParams, m_bitPerfect ? 0 : 1);
     if(checkError(err, "Failed to setup resampling")) {
         return false;
     }
@@ -361,6 +505,10 @@ bool AlsaOutput::initAlsa()
     }
 
     if(std::cmp_not_equal(sampleRate, m_format.sampleRate())) {
+        if(m_bitPerfect) {
+            checkError(-EINVAL, "Sample rate not supported by device for bit-perfect playback");
+            return false;
+        }
         qCDebug(ALSA) << "Sample rate not supported:" << m_format.sampleRate() << "Hz";
         qCDebug(ALSA) << "Using sample rate:" << sampleRate << "Hz";
         m_format.setSampleRate(static_cast<int>(sampleRate));
@@ -374,6 +522,10 @@ bool AlsaOutput::initAlsa()
     }
 
     if(std::cmp_not_equal(channelCount, m_format.channelCount())) {
+        if(m_bitPerfect) {
+            checkError(-EINVAL, "Channel count not supported by device for bit-perfect playback");
+            return false;
+        }
         qCDebug(ALSA) << "Using channels:" << channelCount;
         m_format.setChannelCount(static_cast<int>(channelCount));
     }
@@ -410,6 +562,10 @@ bool AlsaOutput::initAlsa()
         return false;
     }
 
+    // The device may not give us exactly what we asked for
+    snd_pcm_hw_params_get_buffer_size(hwParams, &m_bufferSize);
+    snd_pcm_hw_params_get_period_size(hwParams, &m_periodSize, nullptr);
+
     snd_pcm_sw_params_t* swParams;
     snd_pcm_sw_params_alloca(&swParams);
 
@@ -445,6 +601,12 @@ bool AlsaOutput::initAlsa()
         return false;
     }
 
+    // Wake the pull thread once a period has been played
+    err = snd_pcm_sw_params_set_avail_min(handle, swParams, m_periodSize);
+    if(checkError(err, "Unable to set minimum available frames")) {
+        return false;
+    }
+
     err = snd_pcm_sw_params(handle, swParams);
     if(checkError(err, "Failed to apply software parameters")) {
         return false;
@@ -470,6 +632,11 @@ bool AlsaOutput::setAlsaFormat(snd_pcm_hw_params_t* hwParams)
     const int err   = snd_pcm_hw_params_set_format(m_pcmHandle.get(), hwParams, alsaFormat);
 
     if(err < 0) {
+        if(m_bitPerfect) {
+            checkError(err, "Sample format not supported by device for bit-perfect playback");
+            return false;
+        }
+
         qCDebug(ALSA) << "Format not supported:" << m_format.prettyFormat();
         qCDebug(ALSA) << "Trying all supported formats";
 
@@ -591,6 +758,9 @@ bool AlsaOutput::attemptRecovery(snd_pcm_status_t* status)
         }
         int err = snd_pcm_status(m_pcmHandle.get(), status);
         if(err == -EPIPE || err == -EINTR || err == -ESTRPIPE) {
+            if(err == -EPIPE) {
+                ++m_xruns;
+            }
             if(!autoRecoverAttempted) {
                 autoRecoverAttempted = true;
                 snd_pcm_recover(m_pcmHandle.get(), err, 1);
@@ -620,8 +790,11 @@ bool AlsaOutput::attemptRecovery(snd_pcm_status_t* status)
 
         switch(pcmst) {
             // Underrun
-            case(SND_PCM_STATE_DRAINING):
             case(SND_PCM_STATE_XRUN):
+                ++m_xruns;
+                qCDebug(ALSA) << "Buffer underrun";
+                [[fallthrough]];
+            case(SND_PCM_STATE_DRAINING):
                 checkError(snd_pcm_prepare(m_pcmHandle.get()), "ALSA prepare error");
                 continue;
             // Hardware suspend
@@ -673,8 +846,192 @@ bool AlsaOutput::recoverState(OutputState* state)
         // Align to period size
         state->freeSamples   = static_cast<int>(state->freeSamples / m_periodSize * m_periodSize);
         state->queuedSamples = static_cast<int>(m_bufferSize) - state->freeSamples;
+        state->xruns         = m_xruns;
     }
 
     return recovered;
 }
+
+snd_pcm_sframes_t AlsaOutput::availableFrames()
+{
+    snd_pcm_t* handle = m_pcmHandle.get();
+
+    const snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+    if(avail < 0) {
+        if(avail == -EPIPE) {
+            ++m_xruns;
+        }
+        checkError(snd_pcm_recover(handle, static_cast<int>(avail), 1), "Unable to recover from underrun");
+        return avail;
+    }
+
+    const auto bufferSize = static_cast<snd_pcm_sframes_t>(m_bufferSize);
+    if(avail > bufferSize && snd_pcm_state(handle) == SND_PCM_STATE_RUNNING) {
+        // The device never stops, so an underrun shows up as the hardware having played past our writes.
+        // Skip over the silence it played so we don't write into the past.
+        ++m_xruns;
+        qCDebug(ALSA) << "Buffer underrun";
+        snd_pcm_forward(handle, static_cast<snd_pcm_uframes_t>(avail - bufferSize));
+        return bufferSize;
+    }
+
+    return avail;
+}
+
+void AlsaOutput::startPullThread()
+{
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_wakeFd < 0) {
+        qCWarning(ALSA) << "Unable to create wake event:" << std::strerror(errno);
+        return;
+    }
+
+    if(!m_mmap) {
+        // Allocate upfront so the pull thread never has to
+        m_pullBuffer.resize(static_cast<size_t>(m_format.bytesForFrames(static_cast<int>(m_bufferSize))));
+    }
+
+    m_quit       = false;
+    m_paused     = false;
+    m_pullThread = std::thread{[this]() { pullLoop(); }};
+}
+
+void AlsaOutput::stopPullThread()
+{
+    if(!m_pullThread.joinable()) {
+        return;
+    }
+
+    {
+        const std::scoped_lock lock{m_pcmMutex};
+        m_quit = true;
+    }
+    m_pullCond.notify_all();
+
+    // Interrupt the poll
+    const uint64_t value{1};
+    if(::write(m_wakeFd, &value, sizeof(value)) < 0) {
+        qCWarning(ALSA) << "Unable to wake pull thread:" << std::strerror(errno);
+    }
+
+    m_pullThread.join();
+
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+    m_pullBuffer.clear();
+}
+
+void AlsaOutput::pullLoop()
+{
+    snd_pcm_t* handle = m_pcmHandle.get();
+
+    const int count = snd_pcm_poll_descriptors_count(handle);
+    if(count <= 0) {
+        qCWarning(ALSA) << "No poll descriptors for device";
+        return;
+    }
+
+    // The first descriptor is our wake event, followed by the device's
+    std::vector<pollfd> fds(static_cast<size_t>(count) + 1);
+    fds[0] = {.fd = m_wakeFd, .events = POLLIN, .revents = 0};
+    snd_pcm_poll_descriptors(handle, fds.data() + 1, static_cast<unsigned int>(count));
+
+    while(true) {
+        {
+            std::unique_lock lock{m_pcmMutex};
+            m_pullCond.wait(lock, [this]() { return m_quit || (m_started && !m_paused); });
+            if(m_quit) {
+                return;
+            }
+        }
+
+        if(::poll(fds.data(), fds.size(), -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            qCWarning(ALSA) << "Unable to poll device:" << std::strerror(errno);
+            return;
+        }
+
+        if(fds[0].revents & POLLIN) {
+            uint64_t value{0};
+            [[maybe_unused]] const auto ret = ::read(m_wakeFd, &value, sizeof(value));
+            continue;
+        }
+
+        const std::scoped_lock lock{m_pcmMutex};
+        if(m_quit || !m_started || m_paused) {
+            continue;
+        }
+
+        unsigned short revents{0};
+        snd_pcm_poll_descriptors_revents(handle, fds.data() + 1, static_cast<unsigned int>(count), &revents);
+
+        if(revents & POLLERR) {
+            recoverState();
+        }
+        else if(revents & POLLOUT) {
+            pullAudio();
+        }
+    }
+}
+
+void AlsaOutput::pullAudio()
+{
+    snd_pcm_t* handle = m_pcmHandle.get();
+
+    const snd_pcm_sframes_t avail = availableFrames();
+    if(avail <= 0) {
+        return;
+    }
+
+    // Everything still in the hardware buffer plays before what's about to be written
+    snd_pcm_sframes_t queued{0};
+    if(snd_pcm_delay(handle, &queued) < 0) {
+        queued = -1;
+    }
+
+    const int bps        = m_format.bytesPerFrame();
+    const auto silence   = m_format.sampleFormat() == SampleFormat::U8 ? std::byte{0x80} : std::byte{0};
+    const auto renderAll = [this, bps, silence, &queued](std::span<std::byte> data) {
+        const int frames   = static_cast<int>(data.size()) / bps;
+        const double delay = queued >= 0 ? static_cast<double>(queued) / m_format.sampleRate() : -1.0;
+        const int rendered = std::clamp(m_renderCallback(data, delay), 0, frames);
+        const auto size    = static_cast<size_t>(rendered) * bps;
+
+        Audio::scale(data.first(size), m_format.sampleFormat(), m_volume);
+        // Pad any underrun with silence
+        std::ranges::fill(data.subspan(size), silence);
+
+        if(queued >= 0) {
+            queued += frames;
+        }
+
+        return static_cast<snd_pcm_sframes_t>(frames);
+    };
+
+    snd_pcm_sframes_t written{0};
+
+    if(m_mmap) {
+        written = mmapTransfer(handle, bps, static_cast<snd_pcm_uframes_t>(avail), renderAll);
+    }
+    else {
+        const auto capacity = static_cast<snd_pcm_sframes_t>(m_pullBuffer.size()) / bps;
+        const auto frames   = std::min(avail, capacity);
+        renderAll({m_pullBuffer.data(), static_cast<size_t>(frames) * bps});
+        written = snd_pcm_writei(handle, m_pullBuffer.data(), static_cast<snd_pcm_uframes_t>(frames));
+    }
+
+    if(written < 0) {
+        if(written == -EPIPE) {
+            ++m_xruns;
+        }
+        checkError(snd_pcm_recover(handle, static_cast<int>(written), 1), "Write error");
+        return;
+    }
+
+    if(snd_pcm_state(handle) == SND_PCM_STATE_PREPARED) {
+        checkError(snd_pcm_start(handle), "Unable to start device");
+    }
+}
 } // namespace Fooyin::Alsa
@@ -24,6 +24,12 @@
 
 #include <alsa/asoundlib.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace Fooyin::Alsa {
 struct PcmHandleDeleter
 {
@@ -55,6 +61,8 @@ public:
     [[nodiscard]] OutputDevices getAllDevices(bool isCurrentOutput) override;
 
     int write(const AudioBuffer& buffer) override;
+    bool setRenderCallback(const AudioRenderCallback& callback) override;
+    bool setBitPerfect(bool enabled) override;
     void setPaused(bool pause) override;
     void setVolume(double volume) override;
     void setDevice(const QString& device) override;
@@ -71,6 +79,12 @@ private:
     void getHardwareDevices(OutputDevices& devices);
     bool attemptRecovery(snd_pcm_status_t* status);
     bool recoverState(OutputState* state = nullptr);
+    snd_pcm_sframes_t availableFrames();
+
+    void startPullThread();
+    void stopPullThread();
+    void pullLoop();
+    void pullAudio();
 
     FySettings m_settings;
     AudioFormat m_format;
@@ -78,13 +92,26 @@ private:
     bool m_initialised;
     bool m_pausable;
     bool m_started;
+    bool m_paused;
+    bool m_mmap;
+    bool m_bitPerfect;
 
     QString m_device;
-    double m_volume;
+    std::atomic<double> m_volume;
     QString m_error;
 
     PcmHandleUPtr m_pcmHandle;
     snd_pcm_uframes_t m_bufferSize;
     snd_pcm_uframes_t m_periodSize;
+    std::atomic<int> m_xruns;
+
+    AudioRenderCallback m_renderCallback;
+    std::vector<std::byte> m_pullBuffer;
+    std::thread m_pullThread;
+    // Guards the PCM against concurrent use from the pull thread
+    std::mutex m_pcmMutex;
+    std::condition_variable m_pullCond;
+    bool m_quit;
+    int m_wakeFd;
 };
 } // namespace Fooyin::Alsa
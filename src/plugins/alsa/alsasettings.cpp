@@ -19,6 +19,7 @@
 
 #include "alsasettings.h"
 
+#include <QCheckBox>
 #include <QDialogButtonBox>
 #include <QGridLayout>
 #include <QLabel>
@@ -31,6 +32,7 @@ AlsaSettings::AlsaSettings(QWidget* parent)
     : QDialog{parent}
     , m_bufferLength{new QSpinBox(this)}
     , m_periodLength{new QSpinBox(this)}
+    , m_mmapAccess{new QCheckBox(tr("Write directly to device buffer (mmap)"), this)}
 {
     setWindowTitle(tr("%1 Settings").arg(u"ALSA"_s));
     setModal(true);
@@ -47,6 +49,8 @@ AlsaSettings::AlsaSettings(QWidget* parent)
     m_periodLength->setRange(20, 5000);
     m_periodLength->setSuffix(u" ms"_s);
 
+    m_mmapAccess->setToolTip(tr("Falls back to normal writes if the device doesn't support it"));
+
     auto* layout = new QGridLayout(this);
     layout->setSizeConstraint(QLayout::SetFixedSize);
 
@@ -55,16 +59,19 @@ AlsaSettings::AlsaSettings(QWidget* parent)
     layout->addWidget(m_bufferLength, row++, 1);
     layout->addWidget(periodLabel, row, 0);
     layout->addWidget(m_periodLength, row++, 1);
+    layout->addWidget(m_mmapAccess, row++, 0, 1, 2);
     layout->addWidget(buttons, row++, 0, 1, 2, Qt::AlignBottom);
 
     m_bufferLength->setValue(m_settings.value(BufferLengthSetting, DefaultBufferLength).toInt());
     m_periodLength->setValue(m_settings.value(PeriodLengthSetting, DefaultPeriodLength).toInt());
+    m_mmapAccess->setChecked(m_settings.value(MmapAccessSetting, DefaultMmapAccess).toBool());
 }
 
 void AlsaSettings::accept()
 {
     m_settings.setValue(BufferLengthSetting, m_bufferLength->value());
     m_settings.setValue(PeriodLengthSetting, m_periodLength->value());
+    m_settings.setValue(MmapAccessSetting, m_mmapAccess->isChecked());
 
     done(Accepted);
 }
@@ -23,6 +23,7 @@
 
 #include <QDialog>
 
+class QCheckBox;
 class QSpinBox;
 
 namespace Fooyin {
@@ -30,6 +31,8 @@ constexpr auto BufferLengthSetting = "ALSA/BufferLength";
 constexpr auto DefaultBufferLength = 200;
 constexpr auto PeriodLengthSetting = "ALSA/PeriodLength";
 constexpr auto DefaultPeriodLength = 40;
+constexpr auto MmapAccessSetting   = "ALSA/MmapAccess";
+constexpr auto DefaultMmapAccess   = true;
 
 class AlsaSettings : public QDialog
 {
@@ -44,5 +47,6 @@ private:
     FySettings m_settings;
     QSpinBox* m_bufferLength;
     QSpinBox* m_periodLength;
+    QCheckBox* m_mmapAccess;
 };
 } // namespace Fooyin
@@ -46,6 +46,7 @@
 using namespace Qt::StringLiterals;
 
 constexpr auto BufferLength = 200; // ms
+constexpr auto PullLatency  = 20;  // ms
 
 namespace {
 spa_audio_format findSpaFormat(const Fooyin::SampleFormat& format)
@@ -213,12 +214,19 @@ OutputState PipeWireOutput::currentState()
     state.queuedSamples = m_buffer.frameCount();
     state.freeSamples   = bufferSize() - state.queuedSamples;
 
+    if(m_stream) {
+        const double streamDelay = m_stream->delay(m_format);
+        if(streamDelay >= 0) {
+            state.delay = streamDelay + (static_cast<double>(state.queuedSamples) / m_format.sampleRate());
+        }
+    }
+
     return state;
 }
 
 int PipeWireOutput::bufferSize() const
 {
-    return m_format.framesForDuration(BufferLength);
+    return m_format.framesForDuration(m_renderCallback ? PullLatency : BufferLength);
 }
 
 int PipeWireOutput::write(const AudioBuffer& buffer)
@@ -231,6 +239,18 @@ int PipeWireOutput::write(const AudioBuffer& buffer)
     return buffer.sampleCount();
 }
 
+bool PipeWireOutput::setRenderCallback(const AudioRenderCallback& callback)
+{
+    m_renderCallback = callback;
+    return true;
+}
+
+bool PipeWireOutput::setBitPerfect(bool enabled)
+{
+    m_bitPerfect = enabled;
+    return true;
+}
+
 void PipeWireOutput::setPaused(bool pause)
 {
     const ThreadLoopGuard guard{m_loop.get()};
@@ -317,7 +337,10 @@ bool PipeWireOutput::initStream()
 
     const auto dev = m_device != "default"_L1 ? m_device : QString{};
 
-    m_stream = std::make_unique<PipewireStream>(m_core.get(), m_format, dev);
+    // Audio is requested on demand in pull mode, so a much smaller quantum can be used
+    const int latency = m_renderCallback ? m_format.framesForDuration(PullLatency) : 0;
+
+    m_stream = std::make_unique<PipewireStream>(m_core.get(), m_format, dev, latency, m_bitPerfect);
     m_stream->addListener(streamEvents, this);
 
     const spa_audio_format spaFormat = findSpaFormat(m_format.sampleFormat());
@@ -379,10 +402,54 @@ void PipeWireOutput::uninitCore()
     m_bufferPos = 0;
 }
 
+void PipeWireOutput::pullAudio()
+{
+    auto* pwBuffer = m_stream->dequeueBuffer();
+    if(!pwBuffer) {
+        qCWarning(PIPEWIRE) << "No available output buffers";
+        return;
+    }
+
+    spa_data& data = pwBuffer->buffer->datas[0];
+    if(!data.data) {
+        m_stream->queueBuffer(pwBuffer);
+        return;
+    }
+
+    const auto bps  = static_cast<uint32_t>(m_format.bytesPerFrame());
+    uint32_t frames = data.maxsize / bps;
+#if PW_CHECK_VERSION(0, 3, 49)
+    if(pwBuffer->requested > 0) {
+        frames = std::min(frames, static_cast<uint32_t>(pwBuffer->requested));
+    }
+#endif
+
+    const uint32_t size = frames * bps;
+    auto* dst           = static_cast<std::byte*>(data.data);
+
+    const double delay      = m_stream->delay(m_format);
+    const int rendered      = std::clamp(m_renderCallback({dst, size}, delay), 0, static_cast<int>(frames));
+    const uint32_t dataSize = static_cast<uint32_t>(rendered) * bps;
+
+    // Pad any underrun with silence
+    std::memset(dst + dataSize, m_format.sampleFormat() == SampleFormat::U8 ? 0x80 : 0, size - dataSize);
+
+    data.chunk->offset = 0;
+    data.chunk->stride = static_cast<int32_t>(bps);
+    data.chunk->size   = size;
+
+    m_stream->queueBuffer(pwBuffer);
+}
+
 void PipeWireOutput::process(void* userData)
 {
     auto* self = static_cast<PipeWireOutput*>(userData);
 
+    if(self->m_renderCallback) {
+        self->pullAudio();
+        return;
+    }
+
     if(!self->m_bufferPos) {
         self->m_loop->signal(false);
         return;
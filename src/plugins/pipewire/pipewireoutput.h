@@ -46,6 +46,8 @@ public:
     OutputState currentState() override;
     [[nodiscard]] int bufferSize() const override;
     int write(const AudioBuffer& buffer) override;
+    bool setRenderCallback(const AudioRenderCallback& callback) override;
+    bool setBitPerfect(bool enabled) override;
     void setPaused(bool pause) override;
 
     void setVolume(double volume) override;
@@ -58,6 +60,7 @@ private:
     bool initCore();
     bool initStream();
     void uninitCore();
+    void pullAudio();
     static void process(void* userData);
     static void handleStateChanged(void* userdata, pw_stream_state old, pw_stream_state state, const char* /*error*/);
     static void drained(void* userdata);
@@ -68,6 +71,8 @@ private:
 
     AudioBuffer m_buffer;
     uint32_t m_bufferPos{0};
+    AudioRenderCallback m_renderCallback;
+    bool m_bitPerfect{false};
 
     std::unique_ptr<PipewireThreadLoop> m_loop;
     std::unique_ptr<PipewireContext> m_context;
@@ -24,16 +24,20 @@
 #include <core/engine/audiobuffer.h>
 
 #include <pipewire/keys.h>
+#include <pipewire/version.h>
 #include <spa/param/props.h>
 
 #include <QDebug>
 
+#include <algorithm>
+
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wgnu-statement-expression-from-macro-expansion"
 #endif
 
 namespace Fooyin::Pipewire {
-PipewireStream::PipewireStream(PipewireCore* core, const AudioFormat& format, const QString& device)
+PipewireStream::PipewireStream(PipewireCore* core, const AudioFormat& format, const QString& device, int latency,
+                               bool bitPerfect)
 {
     struct pw_properties* props = pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Playback",
                                                     PW_KEY_MEDIA_ROLE, "Music", PW_KEY_APP_ID, "fooyin",
@@ -41,6 +45,20 @@ PipewireStream::PipewireStream(PipewireCore* core, const AudioFormat& format, co
 
     pw_properties_setf(props, PW_KEY_NODE_RATE, "1/%u", format.sampleRate());
 
+    if(bitPerfect) {
+        // Switch the graph to our rate rather than only suggesting it, and leave the samples alone.
+        // The rate must be listed in the server's clock.allowed-rates to be used.
+        pw_properties_setf(props, "node.force-rate", "%u", format.sampleRate());
+        pw_properties_set(props, "node.lock-rate", "true");
+        pw_properties_set(props, PW_KEY_STREAM_DONT_REMIX, "true");
+        pw_properties_set(props, "resample.disable", "true");
+        pw_properties_set(props, "channelmix.disable", "true");
+    }
+
+    if(latency > 0) {
+        pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", latency, format.sampleRate());
+    }
+
     if(!device.isEmpty()) {
         pw_properties_setf(props, PW_KEY_TARGET_OBJECT, "%s", device.toUtf8().constData());
     }
@@ -74,6 +92,30 @@ void PipewireStream::setVolume(float volume)
     }
 }
 
+double PipewireStream::delay(const AudioFormat& format)
+{
+    pw_time time{};
+#if PW_CHECK_VERSION(0, 3, 50)
+    const int result = pw_stream_get_time_n(m_stream.get(), &time, sizeof(time));
+#else
+    const int result = pw_stream_get_time(m_stream.get(), &time);
+#endif
+    if(result < 0 || time.rate.denom == 0 || format.sampleRate() <= 0 || format.bytesPerFrame() <= 0) {
+        return -1.0;
+    }
+
+    // Delay through the graph to the device, in units of the graph's rate
+    const double graphDelay = static_cast<double>(time.delay) * time.rate.num / time.rate.denom;
+
+    // Plus anything queued in the stream which the graph hasn't taken yet
+    auto queued = static_cast<double>(time.queued / static_cast<uint64_t>(format.bytesPerFrame()));
+#if PW_CHECK_VERSION(0, 3, 50)
+    queued += static_cast<double>(time.buffered);
+#endif
+
+    return std::max(graphDelay, 0.0) + (queued / format.sampleRate());
+}
+
 pw_buffer* PipewireStream::dequeueBuffer()
 {
     return pw_stream_dequeue_buffer(m_stream.get());
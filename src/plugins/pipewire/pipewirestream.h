@@ -35,7 +35,8 @@ namespace Pipewire {
 class PipewireStream
 {
 public:
-    PipewireStream(PipewireCore* core, const AudioFormat& format, const QString& device = {});
+    PipewireStream(PipewireCore* core, const AudioFormat& format, const QString& device = {}, int latency = 0,
+                   bool bitPerfect = false);
     ~PipewireStream();
 
     pw_stream_state state();
@@ -43,6 +44,12 @@ public:
     void setActive(bool active);
     void setVolume(float volume);
 
+    /*!
+     * Returns the time until audio queued next would be heard, in seconds, or a negative value if the stream
+     * hasn't been scheduled yet. Safe to call from the process callback.
+     */
+    double delay(const AudioFormat& format);
+
     pw_buffer* dequeueBuffer();
     void queueBuffer(pw_buffer* buffer);
     void flush(bool drain);
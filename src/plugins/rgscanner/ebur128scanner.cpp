@@ -172,13 +172,6 @@ void Ebur128Scanner::calculateByAlbumTags(const TrackList& tracks, const QString
 void Ebur128Scanner::scanTrack(Track& track, bool truePeak, const QString& album)
 {
     if(!mayRun()) {
-        m_audioLoader->destroyThreadInstance();
-        return;
-    }
-
-    auto* decoder = m_audioLoader->decoderForTrack(track);
-    if(!decoder) {
-        m_audioLoader->destroyThreadInstance();
         return;
     }
 
@@ -187,14 +180,20 @@ void Ebur128Scanner::scanTrack(Track& track, bool truePeak, const QString& album
     QFile file{source.filepath};
     if(!file.open(QIODevice::ReadOnly)) {
         qCWarning(EBUR128) << "Failed to open" << source.filepath;
-        m_audioLoader->destroyThreadInstance();
         return;
     }
     source.device = &file;
 
-    auto format = decoder->init(source, track, AudioDecoder::NoSeeking | AudioDecoder::NoInfiniteLooping);
+    // Stopped and returned to the pool for the next track once done, before the file is closed
+    const auto decoder = m_audioLoader->acquireDecoder(track);
+    if(!decoder) {
+        return;
+    }
+
+    auto format = decoder->init(source, track,
+                                AudioDecoder::NoSeeking | AudioDecoder::NoInfiniteLooping
+                                    | AudioDecoder::ParallelDecoding);
     if(!format) {
-        m_audioLoader->destroyThreadInstance();
         return;
     }
 
@@ -207,7 +206,6 @@ void Ebur128Scanner::scanTrack(Track& track, bool truePeak, const QString& album
     AudioBuffer buffer;
     while((buffer = decoder->readBuffer(BufferSize)).isValid()) {
         if(!mayRun()) {
-            m_audioLoader->destroyThreadInstance();
             return;
         }
 
@@ -219,7 +217,6 @@ void Ebur128Scanner::scanTrack(Track& track, bool truePeak, const QString& album
     }
 
     if(!mayRun()) {
-        m_audioLoader->destroyThreadInstance();
         return;
     }
 
@@ -255,8 +252,6 @@ void Ebur128Scanner::scanTrack(Track& track, bool truePeak, const QString& album
         const std::scoped_lock lock{m_mutex};
         m_albumStates[album].emplace_back(std::move(state));
     }
-
-    m_audioLoader->destroyThreadInstance();
 }
 
 void Ebur128Scanner::scanAlbum(bool truePeak)
@@ -56,7 +56,8 @@ Q_LOGGING_CATEGORY(REPLAYGAIN, "fy.ffmpegscanner")
 using namespace Qt::StringLiterals;
 
 constexpr auto FrameFlags   = AV_BUFFERSRC_FLAG_KEEP_REF | AV_BUFFERSRC_FLAG_NO_CHECK_FORMAT | AV_BUFFERSRC_FLAG_PUSH;
-constexpr auto DecoderFlags = Fooyin::AudioDecoder::NoSeeking | Fooyin::AudioDecoder::NoLooping;
+constexpr auto DecoderFlags
+    = Fooyin::AudioDecoder::NoSeeking | Fooyin::AudioDecoder::NoLooping | Fooyin::AudioDecoder::ParallelDecoding;
 
 namespace {
 struct FilterContextDeleter
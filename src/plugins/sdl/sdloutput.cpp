@@ -25,6 +25,10 @@
 #include <QLoggingCategory>
 #include <QTimerEvent>
 
+#include <bit>
+#include <cmath>
+#include <cstring>
+
 Q_LOGGING_CATEGORY(SDL, "fy.sdl")
 
 using namespace std::chrono_literals;
@@ -91,7 +95,8 @@ bool SdlOutput::init(const AudioFormat& format)
     m_desiredSpec.format   = findFormat(format.sampleFormat());
     m_desiredSpec.channels = format.channelCount();
     m_desiredSpec.samples  = m_bufferSize;
-    m_desiredSpec.callback = nullptr;
+    m_desiredSpec.callback = m_renderCallback ? &SdlOutput::pullAudio : nullptr;
+    m_desiredSpec.userdata = this;
 
     if(m_device == u"default"_s) {
         m_audioDeviceId = SDL_OpenAudioDevice(nullptr, 0, &m_desiredSpec, &m_obtainedSpec, SDL_AUDIO_ALLOW_ANY_CHANGE);
@@ -121,6 +126,11 @@ bool SdlOutput::init(const AudioFormat& format)
         m_format.setChannelCount(m_obtainedSpec.channels);
     }
 
+    if(m_renderCallback) {
+        // Allocate upfront so the audio callback never has to
+        m_pullBuffer.resize(m_obtainedSpec.size);
+    }
+
     m_initialised = true;
     return true;
 }
@@ -171,6 +181,8 @@ OutputState SdlOutput::currentState()
 
     state.queuedSamples = static_cast<int>(SDL_GetQueuedAudioSize(m_audioDeviceId) / m_format.bytesPerFrame());
     state.freeSamples   = m_bufferSize - state.queuedSamples;
+    // SDL doesn't report the device's latency, so the best there is to go on is its buffer
+    state.delay = static_cast<double>(state.queuedSamples + m_obtainedSpec.samples) / m_format.sampleRate();
 
     return state;
 }
@@ -212,6 +224,12 @@ int SdlOutput::write(const AudioBuffer& buffer)
     return 0;
 }
 
+bool SdlOutput::setRenderCallback(const AudioRenderCallback& callback)
+{
+    m_renderCallback = callback;
+    return true;
+}
+
 void SdlOutput::setPaused(bool pause)
 {
     SDL_PauseAudioDevice(m_audioDeviceId, pause);
@@ -249,6 +267,31 @@ void SdlOutput::timerEvent(QTimerEvent* event)
     AudioOutput::timerEvent(event);
 }
 
+void SdlOutput::pullAudio(void* userData, Uint8* stream, int len)
+{
+    auto* self = static_cast<SdlOutput*>(userData);
+
+    std::memset(stream, self->m_obtainedSpec.silence, len);
+
+    const int bps = self->m_format.bytesPerFrame();
+    if(bps <= 0 || len <= 0) {
+        return;
+    }
+
+    // Filled while the device plays its previous buffer
+    const double delay = static_cast<double>(self->m_obtainedSpec.samples) / self->m_format.sampleRate();
+
+    const auto size  = std::min(static_cast<size_t>(len), self->m_pullBuffer.size());
+    const int frames = std::clamp(self->m_renderCallback({self->m_pullBuffer.data(), size}, delay), 0,
+                                  static_cast<int>(size) / bps);
+
+    if(frames > 0) {
+        const auto volume = static_cast<int>(std::round(self->m_volume * SDL_MIX_MAXVOLUME));
+        SDL_MixAudioFormat(stream, std::bit_cast<const Uint8*>(self->m_pullBuffer.data()),
+                           self->m_obtainedSpec.format, static_cast<Uint32>(frames * bps), volume);
+    }
+}
+
 void SdlOutput::checkEvents()
 {
     while(SDL_PollEvent(&m_event)) {
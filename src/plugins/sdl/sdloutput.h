@@ -27,6 +27,9 @@
 #include <QBasicTimer>
 #include <QString>
 
+#include <atomic>
+#include <vector>
+
 namespace Fooyin::Sdl {
 class SdlOutput : public AudioOutput
 {
@@ -46,6 +49,7 @@ public:
     [[nodiscard]] OutputDevices getAllDevices(bool isCurrentOutput) override;
 
     int write(const AudioBuffer& buffer) override;
+    bool setRenderCallback(const AudioRenderCallback& callback) override;
     void setPaused(bool pause) override;
     void setVolume(double volume) override;
     void setDevice(const QString& device) override;
@@ -58,12 +62,16 @@ protected:
 
 private:
     void checkEvents();
+    static void pullAudio(void* userData, Uint8* stream, int len);
 
     AudioFormat m_format;
     int m_bufferSize;
     bool m_initialised;
     QString m_device;
-    double m_volume;
+    std::atomic<double> m_volume;
+
+    AudioRenderCallback m_renderCallback;
+    std::vector<std::byte> m_pullBuffer;
 
     SDL_AudioSpec m_desiredSpec;
     SDL_AudioSpec m_obtainedSpec;
@@ -22,11 +22,9 @@
 #include "vumetercolours.h"
 #include "vumetersettings.h"
 
-#include <core/engine/audiobuffer.h>
-#include <core/engine/audioconverter.h>
+#include <core/engine/audioanalyser.h>
 #include <core/player/playercontroller.h>
 #include <gui/guisettings.h>
-#include <utils/async.h>
 #include <utils/settings/settingsdialogcontroller.h>
 #include <utils/settings/settingsmanager.h>
 
@@ -88,11 +86,17 @@ namespace Fooyin::VuMeter {
 class VuMeterWidgetPrivate
 {
 public:
-    explicit VuMeterWidgetPrivate(VuMeterWidget* self, VuMeterWidget::Type type, PlayerController* playerController,
-                                  SettingsManager* settings);
+    VuMeterWidgetPrivate(VuMeterWidget* self, VuMeterWidget::Type type, AudioAnalyser* analyser,
+                         PlayerController* playerController, SettingsManager* settings);
+    ~VuMeterWidgetPrivate();
+
+    VuMeterWidgetPrivate(const VuMeterWidgetPrivate&)            = delete;
+    VuMeterWidgetPrivate& operator=(const VuMeterWidgetPrivate&) = delete;
 
     void reset();
     void updateSize();
+    void readLevels();
+    void setAnalysing(bool analysing);
     void calculatePeak();
     void updateChannelLevels(int channel, qint64 elapsedTime, qint64 peakTime, float falloff, bool& zeroLevel);
     QRect calculateUpdateRect(int channel);
@@ -117,6 +121,7 @@ public:
     void playStateChanged(Player::PlayState state);
 
     VuMeterWidget* m_self;
+    AudioAnalyser* m_analyser;
     PlayerController* m_playerController;
     SettingsManager* m_settings;
 
@@ -142,6 +147,7 @@ public:
     bool m_drawLegend{false};
     bool m_changingTrack{false};
     bool m_stopping{false};
+    bool m_analysing{false};
 
     Colours m_colours;
     QLinearGradient m_gradient;
@@ -153,8 +159,10 @@ public:
 };
 
 VuMeterWidgetPrivate::VuMeterWidgetPrivate(VuMeterWidget* self, VuMeterWidget::Type type,
-                                           PlayerController* playerController, SettingsManager* settings)
+                                           AudioAnalyser* analyser, PlayerController* playerController,
+                                           SettingsManager* settings)
     : m_self{self}
+    , m_analyser{analyser}
     , m_playerController{playerController}
     , m_settings{settings}
     , m_type{type}
@@ -178,6 +186,11 @@ VuMeterWidgetPrivate::VuMeterWidgetPrivate(VuMeterWidget* self, VuMeterWidget::T
     updateSize();
 }
 
+VuMeterWidgetPrivate::~VuMeterWidgetPrivate()
+{
+    setAnalysing(false);
+}
+
 void VuMeterWidgetPrivate::reset()
 {
     std::ranges::fill(m_channelDbLevels, MinDb);
@@ -221,8 +234,56 @@ void VuMeterWidgetPrivate::updateSize()
     createGradient();
 }
 
+void VuMeterWidgetPrivate::readLevels()
+{
+    const AudioAnalysis analysis = m_analyser->latest();
+    if(!analysis.isValid()) {
+        return;
+    }
+
+    const int channels = std::min(analysis.channels, MaxChannels);
+
+    m_format.setSampleRate(analysis.sampleRate);
+    m_format.setChannelCount(channels);
+    m_lastPeakTimers.resize(channels);
+
+    const auto& levels = m_type == VuMeterWidget::Type::Peak ? analysis.peak : analysis.rms;
+
+    for(int channel{0}; channel < channels; ++channel) {
+        const float levelDb = dbOnRange(20 * std::log10(levels.at(channel)));
+
+        float& channelLevel = m_channelDbLevels.at(channel);
+        float& channelPeak  = m_channelPeaks.at(channel);
+
+        channelLevel = std::max(channelLevel, levelDb);
+        if(levelDb > channelPeak) {
+            channelPeak = levelDb;
+            m_lastPeakTimers.at(channel).start();
+        }
+    }
+}
+
+void VuMeterWidgetPrivate::setAnalysing(bool analysing)
+{
+    if(std::exchange(m_analysing, analysing) == analysing) {
+        return;
+    }
+
+    if(analysing) {
+        m_analyser->acquire();
+    }
+    else {
+        m_analyser->release();
+    }
+}
+
 void VuMeterWidgetPrivate::calculatePeak()
 {
+    if(!m_stopping) {
+        // Levels are analysed by the engine, so there's only the latest results to pick up here
+        readLevels();
+    }
+
     const qint64 elapsedTime = m_elapsedTimer.restart();
     const auto peakTime      = static_cast<qint64>(m_settings->value<Settings::VuMeter::PeakHoldTime>() * 1000);
     const auto falloff       = static_cast<float>(m_settings->value<Settings::VuMeter::FalloffTime>() / 1000.0);
@@ -582,13 +643,16 @@ void VuMeterWidgetPrivate::playStateChanged(Player::PlayState state)
 
     switch(state) {
         case(Player::PlayState::Playing):
+            setAnalysing(true);
             m_updateTimer.start(UpdateInterval, m_self);
             m_elapsedTimer.start();
             break;
         case(Player::PlayState::Paused):
+            setAnalysing(false);
             m_updateTimer.stop();
             break;
         case(Player::PlayState::Stopped):
+            setAnalysing(false);
             if(m_updateTimer.isActive()) {
                 m_stopping = true;
             }
@@ -596,9 +660,10 @@ void VuMeterWidgetPrivate::playStateChanged(Player::PlayState state)
     }
 }
 
-VuMeterWidget::VuMeterWidget(Type type, PlayerController* playerController, SettingsManager* settings, QWidget* parent)
+VuMeterWidget::VuMeterWidget(Type type, AudioAnalyser* analyser, PlayerController* playerController,
+                             SettingsManager* settings, QWidget* parent)
     : FyWidget{parent}
-    , p{std::make_unique<VuMeterWidgetPrivate>(this, type, playerController, settings)}
+    , p{std::make_unique<VuMeterWidgetPrivate>(this, type, analyser, playerController, settings)}
 {
     setObjectName(VuMeterWidget::name());
 
@@ -650,68 +715,6 @@ void VuMeterWidget::loadLayoutData(const QJsonObject& layout)
     }
 }
 
-void VuMeterWidget::renderBuffer(const AudioBuffer& buffer)
-{
-    p->m_format.setSampleRate(buffer.format().sampleRate());
-    const int channels = buffer.format().channelCount();
-    p->m_format.setChannelCount(channels);
-
-    const AudioBuffer normalisedBuffer = Audio::convert(buffer, p->m_format);
-
-    p->m_lastPeakTimers.resize(channels);
-
-    auto calculatePeaks = Utils::asyncExec([this, normalisedBuffer, channels]() {
-        const int totalSamples = normalisedBuffer.sampleCount();
-        const int bps          = normalisedBuffer.format().bytesPerSample();
-
-        std::array<float, MaxChannels> peaks{0.0F};
-        std::array<int, MaxChannels> sampleCounts{0};
-
-        for(int i{0}; i < totalSamples; ++i) {
-            const int sampleIndex  = i / channels;
-            const int channelIndex = i % channels;
-
-            float sample;
-            const auto offset = (sampleIndex * channels + channelIndex) * bps;
-            std::memcpy(&sample, normalisedBuffer.data() + offset, bps);
-
-            if(p->m_type == Type::Peak) {
-                peaks.at(channelIndex) = std::max(peaks.at(channelIndex), std::abs(sample));
-            }
-            else {
-                peaks.at(channelIndex) += sample * sample;
-                sampleCounts.at(channelIndex)++;
-            }
-        }
-
-        if(p->m_type == Type::Rms) {
-            for(int i{0}; i < channels; ++i) {
-                peaks.at(i) = std::sqrt(peaks.at(i) / static_cast<float>(sampleCounts.at(i)));
-            }
-        }
-
-        return peaks;
-    });
-
-    calculatePeaks.then(this, [this, channels](const std::array<float, MaxChannels>& peaks) {
-        for(int i{0}; i < channels; ++i) {
-            const float bufferRMS = peaks.at(i);
-            const float bufferDb  = dbOnRange(20 * std::log10(bufferRMS));
-
-            float& channelLevel = p->m_channelDbLevels.at(i);
-            float& channelPeak  = p->m_channelPeaks.at(i);
-
-            if(bufferDb > channelLevel) {
-                channelLevel = bufferDb;
-            }
-            if(bufferDb > channelPeak) {
-                channelPeak = bufferDb;
-                p->m_lastPeakTimers.at(i).start();
-            }
-        }
-    });
-}
-
 void VuMeterWidget::setOrientation(Qt::Orientation orientation)
 {
     p->m_orientation = orientation;
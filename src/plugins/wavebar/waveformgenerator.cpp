@@ -104,7 +104,6 @@ WaveformGenerator::WaveformGenerator(std::shared_ptr<AudioLoader> audioLoader, D
                                      QObject* parent)
     : Worker{parent}
     , m_audioLoader{std::move(audioLoader)}
-    , m_decoder{nullptr}
     , m_dbPool{std::move(dbPool)}
 {
     m_requiredFormat.setSampleFormat(SampleFormat::F32);
@@ -217,9 +216,8 @@ void WaveformGenerator::generate(const Track& track, int samplesPerChannel, bool
 
 QString WaveformGenerator::setup(const Track& track, int samplesPerChannel)
 {
-    if(m_decoder) {
-        m_decoder->stop();
-    }
+    // Back to the pool, ready for the next track
+    m_decoder.reset();
     m_data = {};
 
     if(!track.isValid()) {
@@ -230,7 +228,7 @@ QString WaveformGenerator::setup(const Track& track, int samplesPerChannel)
         return {};
     }
 
-    m_decoder = m_audioLoader->decoderForTrack(track);
+    m_decoder = m_audioLoader->acquireDecoder(track);
     if(!m_decoder) {
         return {};
     }
@@ -246,7 +244,8 @@ QString WaveformGenerator::setup(const Track& track, int samplesPerChannel)
         source.device = m_file.get();
     }
 
-    const auto format = m_decoder->init(source, track, AudioDecoder::NoSeeking | AudioDecoder::NoInfiniteLooping);
+    const auto format = m_decoder->init(
+        source, track, AudioDecoder::NoSeeking | AudioDecoder::NoInfiniteLooping | AudioDecoder::ParallelDecoding);
     if(!format) {
         return {};
     }
@@ -22,6 +22,7 @@
 #include "wavebardatabase.h"
 
 #include <core/engine/audioinput.h>
+#include <core/engine/audioloader.h>
 #include <core/track.h>
 #include <utils/database/dbconnectionhandler.h>
 #include <utils/database/dbconnectionpool.h>
@@ -33,8 +34,6 @@
 Q_DECLARE_LOGGING_CATEGORY(WAVEBAR)
 
 namespace Fooyin {
-class AudioLoader;
-
 namespace WaveBar {
 class WaveformGenerator : public Worker
 {
@@ -58,7 +57,7 @@ private:
 
     std::shared_ptr<AudioLoader> m_audioLoader;
     std::unique_ptr<QIODevice> m_file;
-    AudioDecoder* m_decoder;
+    AudioLoader::PooledDecoder m_decoder;
     DbConnectionPoolPtr m_dbPool;
     std::unique_ptr<DbConnectionHandler> m_dbHandler;
     WaveBarDatabase m_waveDb;
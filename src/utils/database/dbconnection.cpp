@@ -78,6 +78,8 @@ bool DbConnection::open()
 
 void DbConnection::close()
 {
+    clearCachedQueries();
+
     auto db = this->db();
     if(db.isOpen()) {
         if(db.rollback()) {
@@ -96,4 +98,24 @@ QSqlDatabase DbConnection::db() const
 {
     return QSqlDatabase::database(m_name);
 }
+
+QSqlQuery* DbConnection::cachedQuery(const QString& statement)
+{
+    if(const auto it = m_cachedQueries.find(statement); it != m_cachedQueries.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+QSqlQuery* DbConnection::cacheQuery(const QString& statement, QSqlQuery query)
+{
+    auto [it, inserted] = m_cachedQueries.insert_or_assign(statement, std::move(query));
+    return &it->second;
+}
+
+void DbConnection::clearCachedQueries()
+{
+    // Prepared statements must be finalised before the connection is closed
+    m_cachedQueries.clear();
+}
 } // namespace Fooyin
@@ -54,4 +54,20 @@ QSqlDatabase DbConnectionProvider::db() const
 
     return connection->db();
 }
+
+DbConnection* DbConnectionProvider::connection() const
+{
+    if(!m_connectionPool) {
+        qCWarning(DB_CONPROV) << "No connection pool";
+        return nullptr;
+    }
+
+    DbConnection* connection = m_connectionPool->threadConnection();
+
+    if(!connection) {
+        qCWarning(DB_CONPROV) << "Thread connection not found";
+    }
+
+    return connection;
+}
 } // namespace Fooyin
@@ -0,0 +1,117 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <utils/database/dbfastimport.h>
+
+#include <QLoggingCategory>
+#include <QSqlError>
+#include <QSqlQuery>
+
+Q_LOGGING_CATEGORY(DB_IMPORT, "fy.db")
+
+using namespace Qt::StringLiterals;
+
+// Negative sizes are in KiB
+constexpr auto ImportCacheSize = "-65536";
+
+namespace {
+QString pragmaValue(const QSqlDatabase& database, const QString& pragma)
+{
+    QSqlQuery query{database};
+    if(!query.exec(u"PRAGMA %1;"_s.arg(pragma)) || !query.next()) {
+        qCWarning(DB_IMPORT) << "Failed to read" << pragma << ":" << query.lastError();
+        return {};
+    }
+    return query.value(0).toString();
+}
+
+QString setPragma(const QSqlDatabase& database, const QString& pragma, const QString& value)
+{
+    QSqlQuery query{database};
+    if(!query.exec(u"PRAGMA %1 = %2;"_s.arg(pragma, value))) {
+        qCWarning(DB_IMPORT) << "Failed to set" << pragma << "to" << value << ":" << query.lastError();
+        return {};
+    }
+    // Only some pragmas (e.g. journal_mode) report the resulting value
+    return query.next() ? query.value(0).toString() : value;
+}
+
+void setJournalMode(const QSqlDatabase& database, const QString& mode)
+{
+    const QString result = setPragma(database, u"journal_mode"_s, mode);
+    if(result.compare(mode, Qt::CaseInsensitive) != 0) {
+        // Changing the journal mode requires exclusive access, so can fail while other connections are busy
+        qCInfo(DB_IMPORT) << "Could not change journal mode to" << mode << "on" << database.connectionName();
+    }
+}
+} // namespace
+
+namespace Fooyin {
+DbFastImport::DbFastImport(const QSqlDatabase& database)
+    : m_database{database}
+    , m_isActive{false}
+{
+    if(!m_database.isOpen()) {
+        qCWarning(DB_IMPORT) << "Failed to enable fast import on" << m_database.connectionName()
+                             << ": No open connection";
+        return;
+    }
+
+    m_journalMode = pragmaValue(m_database, u"journal_mode"_s);
+    m_synchronous = pragmaValue(m_database, u"synchronous"_s);
+    m_tempStore   = pragmaValue(m_database, u"temp_store"_s);
+    m_cacheSize   = pragmaValue(m_database, u"cache_size"_s);
+
+    if(m_journalMode.isEmpty() || m_synchronous.isEmpty() || m_tempStore.isEmpty() || m_cacheSize.isEmpty()) {
+        return;
+    }
+
+    // NORMAL is still safe against corruption in WAL mode, only the last commits may be lost on power failure
+    setJournalMode(m_database, u"WAL"_s);
+    setPragma(m_database, u"synchronous"_s, u"NORMAL"_s);
+    setPragma(m_database, u"temp_store"_s, u"MEMORY"_s);
+    setPragma(m_database, u"cache_size"_s, QString::fromLatin1(ImportCacheSize));
+
+    m_isActive = true;
+}
+
+DbFastImport::~DbFastImport()
+{
+    restore();
+}
+
+DbFastImport::operator bool() const
+{
+    return m_isActive;
+}
+
+void DbFastImport::restore()
+{
+    if(!m_isActive || !m_database.isOpen()) {
+        return;
+    }
+
+    m_isActive = false;
+
+    setPragma(m_database, u"cache_size"_s, m_cacheSize);
+    setPragma(m_database, u"temp_store"_s, m_tempStore);
+    setPragma(m_database, u"synchronous"_s, m_synchronous);
+    setJournalMode(m_database, m_journalMode);
+}
+} // namespace Fooyin
@@ -19,10 +19,14 @@
 
 #include <utils/database/dbquery.h>
 
+#include <utils/database/dbconnection.h>
+
 #include <QLoggingCategory>
 #include <QRegularExpression>
 #include <QSqlError>
 
+#include <utility>
+
 Q_LOGGING_CATEGORY(DB_QRY, "fy.db")
 
 using namespace Qt::StringLiterals;
@@ -67,26 +71,75 @@ QString lastExecutedQuery(const QSqlQuery& query)
 
 namespace Fooyin {
 DbQuery::DbQuery()
-    : m_status{Status::None}
+    : m_cachedQuery{nullptr}
+    , m_status{Status::None}
 { }
 
 DbQuery::DbQuery(const QSqlDatabase& database, const QString& statement)
     : m_query{database}
+    , m_cachedQuery{nullptr}
     , m_status{Status::None}
 {
     if(prepareQuery(m_query, statement)) {
         m_status = Status::Prepared;
     }
-    else if(lastError().isValid() && lastError().type() != QSqlError::NoError) {
-        if(lastError().databaseText().startsWith(u"duplicate column name: "_s)) {
-            // Re-applying previous migration
-            m_status = Status::Ignored;
-        }
-        else {
-            qCWarning(DB_QRY) << "Failed to prepare" << statement << ":" << lastError();
-            m_status = Status::Error;
+    else {
+        handlePrepareError(statement);
+    }
+}
+
+DbQuery::DbQuery(DbConnection* connection, const QString& statement)
+    : m_cachedQuery{nullptr}
+    , m_status{Status::None}
+{
+    if(!connection) {
+        qCWarning(DB_QRY) << "Failed to prepare" << statement << ": No connection";
+        m_status = Status::Error;
+        return;
+    }
+
+    if(auto* cachedQuery = connection->cachedQuery(statement)) {
+        cachedQuery->finish();
+        m_cachedQuery = cachedQuery;
+        m_status      = Status::Prepared;
+        return;
+    }
+
+    m_query = QSqlQuery{connection->db()};
+    if(prepareQuery(m_query, statement)) {
+        m_cachedQuery = connection->cacheQuery(statement, std::move(m_query));
+        m_status      = Status::Prepared;
+    }
+    else {
+        handlePrepareError(statement);
+    }
+}
+
+DbQuery::~DbQuery()
+{
+    if(m_cachedQuery) {
+        // Reset the statement so it doesn't hold a read lock while cached
+        m_cachedQuery->finish();
+    }
+}
+
+DbQuery::DbQuery(DbQuery&& other) noexcept
+    : m_query{std::move(other.m_query)}
+    , m_cachedQuery{std::exchange(other.m_cachedQuery, nullptr)}
+    , m_status{other.m_status}
+{ }
+
+DbQuery& DbQuery::operator=(DbQuery&& other) noexcept
+{
+    if(this != &other) {
+        if(m_cachedQuery) {
+            m_cachedQuery->finish();
         }
+        m_query       = std::move(other.m_query);
+        m_cachedQuery = std::exchange(other.m_cachedQuery, nullptr);
+        m_status      = other.m_status;
     }
+    return *this;
 }
 
 DbQuery::Status DbQuery::status() const
@@ -96,48 +149,72 @@ DbQuery::Status DbQuery::status() const
 
 QSqlError DbQuery::lastError() const
 {
-    return m_query.lastError();
+    return query().lastError();
 }
 
 void DbQuery::bindValue(const QString& placeholder, const QVariant& value)
 {
-    m_query.bindValue(placeholder, value);
+    query().bindValue(placeholder, value);
 }
 
 QString DbQuery::executedQuery() const
 {
-    return m_query.executedQuery();
+    return query().executedQuery();
 }
 
 bool DbQuery::exec()
 {
-    if(m_query.exec()) {
+    if(query().exec()) {
         m_status = Status::Success;
         return true;
     }
 
-    qCWarning(DB_QRY) << "Failed to execute" << lastExecutedQuery(m_query) << ":" << lastError();
+    qCWarning(DB_QRY) << "Failed to execute" << lastExecutedQuery(query()) << ":" << lastError();
     m_status = Status::Error;
     return false;
 }
 
 int DbQuery::numRowsAffected() const
 {
-    return m_query.numRowsAffected();
+    return query().numRowsAffected();
 }
 
 QVariant DbQuery::lastInsertId() const
 {
-    return m_query.lastInsertId();
+    return query().lastInsertId();
 }
 
 bool DbQuery::next()
 {
-    return m_query.next();
+    return query().next();
 }
 
 QVariant DbQuery::value(int index) const
 {
-    return m_query.value(index);
+    return query().value(index);
+}
+
+void DbQuery::handlePrepareError(const QString& statement)
+{
+    if(lastError().isValid() && lastError().type() != QSqlError::NoError) {
+        if(lastError().databaseText().startsWith(u"duplicate column name: "_s)) {
+            // Re-applying previous migration
+            m_status = Status::Ignored;
+        }
+        else {
+            qCWarning(DB_QRY) << "Failed to prepare" << statement << ":" << lastError();
+            m_status = Status::Error;
+        }
+    }
+}
+
+QSqlQuery& DbQuery::query()
+{
+    return m_cachedQuery ? *m_cachedQuery : m_query;
+}
+
+const QSqlQuery& DbQuery::query() const
+{
+    return m_cachedQuery ? *m_cachedQuery : m_query;
 }
 } // namespace Fooyin
@@ -0,0 +1,92 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/audioanalyser.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace {
+constexpr int SampleRate = 48000;
+
+// A stereo sine at @p frequency, with the right channel at half the amplitude of the left
+Fooyin::AudioBuffer stereoSine(float frequency, float amplitude, int frames)
+{
+    std::vector<float> samples(static_cast<size_t>(frames) * 2);
+    for(int frame{0}; frame < frames; ++frame) {
+        const auto phase = 2.0 * std::numbers::pi * frequency * frame / SampleRate;
+        const auto value = static_cast<float>(amplitude * std::sin(phase));
+
+        samples.at(frame * 2)     = value;
+        samples.at(frame * 2 + 1) = value / 2;
+    }
+
+    return {std::as_bytes(std::span{samples}), {Fooyin::SampleFormat::F32, SampleRate, 2}, 0};
+}
+} // namespace
+
+namespace Fooyin::Testing {
+TEST(AudioAnalyserTest, EmptyBufferIsInvalid)
+{
+    AudioAnalyser analyser{nullptr};
+
+    EXPECT_FALSE(analyser.latest().isValid());
+    EXPECT_FALSE(analyser.analyse({}).isValid());
+}
+
+TEST(AudioAnalyserTest, MeasuresLevels)
+{
+    AudioAnalyser analyser{nullptr};
+
+    const AudioAnalysis analysis = analyser.analyse(stereoSine(1000.0F, 0.5F, SampleRate / 10));
+    ASSERT_TRUE(analysis.isValid());
+    EXPECT_EQ(2, analysis.channels);
+    EXPECT_EQ(SampleRate, analysis.sampleRate);
+    EXPECT_EQ(100, analysis.position);
+
+    EXPECT_NEAR(0.5F, analysis.peak.at(0), 0.001F);
+    EXPECT_NEAR(0.25F, analysis.peak.at(1), 0.001F);
+    EXPECT_NEAR(0.5F / std::numbers::sqrt2_v<float>, analysis.rms.at(0), 0.005F);
+    EXPECT_NEAR(0.25F / std::numbers::sqrt2_v<float>, analysis.rms.at(1), 0.005F);
+}
+
+TEST(AudioAnalyserTest, SpectrumPeaksAtFrequency)
+{
+    AudioAnalyser analyser{nullptr};
+
+    const AudioAnalysis analysis = analyser.analyse(stereoSine(1000.0F, 0.5F, AudioAnalyser::FftSize));
+    ASSERT_TRUE(analysis.isValid());
+
+    // Band holding 1kHz
+    const auto range = std::log(AudioAnalysis::MaxFrequency / AudioAnalysis::MinFrequency);
+    const auto band
+        = static_cast<int>(AudioAnalysis::SpectrumBands * std::log(1000.0F / AudioAnalysis::MinFrequency) / range);
+
+    const auto loudest = std::ranges::max_element(analysis.spectrum);
+    EXPECT_EQ(band, std::distance(analysis.spectrum.cbegin(), loudest));
+
+    // Channels are mixed, so 0.375 of full scale, less what's lost to the window between bins
+    EXPECT_NEAR(20.0F * std::log10(0.375F), *loudest, 2.0F);
+    EXPECT_LT(analysis.spectrum.front(), -60.0F);
+}
+} // namespace Fooyin::Testing
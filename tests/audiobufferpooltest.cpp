@@ -0,0 +1,108 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/audiobufferpool.h"
+
+#include <core/engine/audiobuffer.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace Fooyin::Testing {
+TEST(AudioBufferPoolTest, ReusesReleasedStorage)
+{
+    AudioBufferPool pool;
+
+    auto storage = pool.acquire(3000);
+    EXPECT_GE(storage.capacity(), 3000);
+    const auto* data = storage.data();
+    pool.release(std::move(storage));
+
+    EXPECT_EQ(1, pool.stats().pooledBuffers);
+
+    // Any request in the same class can use it
+    const auto reused = pool.acquire(2500);
+    EXPECT_EQ(data, reused.data());
+    EXPECT_TRUE(reused.empty());
+
+    const auto stats = pool.stats();
+    EXPECT_EQ(1, stats.allocations);
+    EXPECT_EQ(1, stats.reuses);
+    EXPECT_EQ(0, stats.pooledBuffers);
+}
+
+TEST(AudioBufferPoolTest, GrowingKeepsContents)
+{
+    AudioBufferPool pool;
+
+    auto storage = pool.acquire(1024);
+    storage.assign(1024, std::byte{7});
+
+    pool.reserve(storage, 10000);
+    EXPECT_GE(storage.capacity(), 10000);
+    ASSERT_EQ(1024, storage.size());
+    EXPECT_EQ(std::byte{7}, storage.back());
+
+    // The smaller storage was returned to the pool
+    EXPECT_EQ(1, pool.stats().pooledBuffers);
+}
+
+TEST(AudioBufferPoolTest, RespectsLimit)
+{
+    AudioBufferPool pool{4096};
+
+    auto first  = pool.acquire(4096);
+    auto second = pool.acquire(4096);
+    pool.release(std::move(first));
+    pool.release(std::move(second));
+
+    const auto stats = pool.stats();
+    EXPECT_EQ(1, stats.pooledBuffers);
+    EXPECT_LE(stats.pooledBytes, 4096);
+}
+
+TEST(AudioBufferPoolTest, SteadyStateDoesNotAllocate)
+{
+    const AudioFormat format{SampleFormat::F32, 44100, 2};
+    const std::vector<std::byte> chunk(static_cast<size_t>(format.bytesForFrames(4096)), std::byte{1});
+
+    // Simulate a decoder producing a chunk, converting it and handing a copy on
+    const auto runChunk = [&]() {
+        AudioBuffer decoded{chunk, format, 0};
+        AudioBuffer appended{format, 0};
+        appended.append(decoded.constData());
+        AudioBuffer copy{appended};
+        copy.detach();
+    };
+
+    for(int i{0}; i < 10; ++i) {
+        runChunk();
+    }
+
+    const auto before = AudioBufferPool::instance().stats();
+    for(int i{0}; i < 1000; ++i) {
+        runChunk();
+    }
+    const auto after = AudioBufferPool::instance().stats();
+
+    EXPECT_EQ(before.allocations, after.allocations);
+    EXPECT_GT(after.reuses, before.reuses);
+}
+} // namespace Fooyin::Testing
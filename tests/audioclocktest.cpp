@@ -0,0 +1,82 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/audioclock.h"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace Fooyin::Testing {
+class AudioClockTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_clock.setPaused(false);
+        m_start = AudioClock::Clock::now();
+        m_clock.sync(m_start, 1000);
+    }
+
+    AudioClock m_clock;
+    AudioClock::TimePoint m_start;
+};
+
+TEST_F(AudioClockTest, RunsInRealTime)
+{
+    EXPECT_EQ(1500, m_clock.positionFromTime(m_start + 500ms));
+}
+
+TEST_F(AudioClockTest, SlewsSmallDrift)
+{
+    // Output is 20ms behind
+    ASSERT_TRUE(m_clock.correct(m_start + 500ms, 1480));
+
+    // Doesn't jump back, but gradually runs slower
+    EXPECT_EQ(1480, m_clock.positionFromTime(m_start + 500ms));
+    const uint64_t later = m_clock.positionFromTime(m_start + 1500ms);
+    EXPECT_LT(later, 2480);
+    EXPECT_GT(later, 2450);
+}
+
+TEST_F(AudioClockTest, JumpsToLargeErrors)
+{
+    // Output delay not accounted for when synced
+    ASSERT_TRUE(m_clock.correct(m_start + 500ms, 1300));
+    EXPECT_EQ(1300, m_clock.positionFromTime(m_start + 500ms));
+    EXPECT_EQ(1800, m_clock.positionFromTime(m_start + 1000ms));
+}
+
+TEST_F(AudioClockTest, IgnoresUnrelatedPositions)
+{
+    EXPECT_FALSE(m_clock.correct(m_start + 500ms, 60000));
+    EXPECT_EQ(1500, m_clock.positionFromTime(m_start + 500ms));
+
+    m_clock.setPaused(true);
+    EXPECT_FALSE(m_clock.correct(m_start + 500ms, 1300));
+}
+
+TEST_F(AudioClockTest, SyncResetsRate)
+{
+    ASSERT_TRUE(m_clock.correct(m_start + 500ms, 1480));
+
+    m_clock.sync(m_start + 500ms, 0);
+    EXPECT_EQ(1000, m_clock.positionFromTime(m_start + 1500ms));
+}
+} // namespace Fooyin::Testing
@@ -0,0 +1,115 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/audiofader.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Fooyin::Testing {
+TEST(AudioFaderTest, CurveEndpoints)
+{
+    for(const auto curve : {FadeCurve::Linear, FadeCurve::Erf, FadeCurve::EqualPower}) {
+        EXPECT_NEAR(0.0F, AudioFader::curveLevel(curve, 0.0), 1e-6F);
+        EXPECT_NEAR(1.0F, AudioFader::curveLevel(curve, 1.0), 1e-6F);
+        EXPECT_LT(AudioFader::curveLevel(curve, 0.25), AudioFader::curveLevel(curve, 0.75));
+    }
+}
+
+TEST(AudioFaderTest, FadeOutEndsOnExactFrame)
+{
+    AudioFader fader;
+    fader.setFormat({SampleFormat::F32, 48000, 2});
+    fader.fadeOut(1000, FadeCurve::Linear);
+
+    // Split unevenly so the fade spans several calls
+    std::vector<float> samples(2400, 1.0F);
+    int offset{0};
+    for(const int frames : {7, 300, 512, 381}) {
+        fader.process(reinterpret_cast<std::byte*>(samples.data() + static_cast<ptrdiff_t>(offset) * 2), frames);
+        offset += frames;
+    }
+
+    EXPECT_TRUE(fader.isSilent());
+    EXPECT_GT(samples.at(998 * 2), 0.0F);
+    EXPECT_EQ(0.0F, samples.at(999 * 2));
+    EXPECT_EQ(0.0F, samples.back());
+
+    for(size_t i{2}; i < samples.size(); ++i) {
+        EXPECT_LE(samples.at(i), samples.at(i - 2));
+    }
+}
+
+TEST(AudioFaderTest, FadeInStartsFromSilence)
+{
+    AudioFader fader;
+    fader.setFormat({SampleFormat::S16, 44100, 1});
+    fader.fadeIn(100, FadeCurve::EqualPower);
+
+    std::vector<int16_t> samples(200, 10000);
+    fader.process(reinterpret_cast<std::byte*>(samples.data()), 200);
+
+    EXPECT_FALSE(fader.isFading());
+    EXPECT_LT(samples.front(), 1000);
+    EXPECT_EQ(10000, samples.at(99));
+    EXPECT_TRUE(std::all_of(samples.cbegin() + 100, samples.cend(), [](int16_t sample) { return sample == 10000; }));
+}
+
+TEST(AudioFaderTest, ReversesFromCurrentLevel)
+{
+    AudioFader fader;
+    fader.setFormat({SampleFormat::F32, 44100, 1});
+    fader.fadeOut(1000, FadeCurve::Erf);
+
+    std::vector<float> samples(500, 1.0F);
+    fader.process(reinterpret_cast<std::byte*>(samples.data()), 500);
+
+    const float level = fader.level();
+    EXPECT_GT(level, 0.0F);
+    EXPECT_LT(level, 1.0F);
+
+    // Fading back in part way through should not jump back to silence
+    fader.fadeIn(1000, FadeCurve::Linear);
+    EXPECT_NEAR(level, fader.level(), 0.01F);
+
+    std::vector<float> next(1, 1.0F);
+    fader.process(reinterpret_cast<std::byte*>(next.data()), 1);
+    EXPECT_NEAR(level, next.front(), 0.01F);
+    EXPECT_LT(fader.framesRemaining(), 1000);
+}
+
+TEST(AudioFaderTest, ResetRestoresFullLevel)
+{
+    AudioFader fader;
+    fader.setFormat({SampleFormat::F32, 44100, 1});
+    fader.fadeOut(0, FadeCurve::Linear);
+    EXPECT_TRUE(fader.isSilent());
+
+    fader.reset();
+
+    std::vector<float> samples(16, 0.5F);
+    fader.process(reinterpret_cast<std::byte*>(samples.data()), 16);
+
+    EXPECT_FALSE(fader.isSilent());
+    EXPECT_TRUE(std::ranges::all_of(samples, [](float sample) { return sample == 0.5F; }));
+}
+} // namespace Fooyin::Testing
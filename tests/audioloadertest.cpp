@@ -0,0 +1,121 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/audioloader.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+class StubDecoder : public Fooyin::AudioDecoder
+{
+public:
+    explicit StubDecoder(QStringList extensions, std::atomic<int>* stopped)
+        : m_extensions{std::move(extensions)}
+        , m_stopped{stopped}
+    { }
+
+    [[nodiscard]] QStringList extensions() const override
+    {
+        return m_extensions;
+    }
+
+    [[nodiscard]] bool isSeekable() const override
+    {
+        return false;
+    }
+
+    std::optional<Fooyin::AudioFormat> init(const Fooyin::AudioSource& /*source*/, const Fooyin::Track& /*track*/,
+                                            DecoderOptions /*options*/) override
+    {
+        return {};
+    }
+
+    void stop() override
+    {
+        ++(*m_stopped);
+    }
+
+    void seek(uint64_t /*pos*/) override { }
+
+    Fooyin::AudioBuffer readBuffer(size_t /*bytes*/) override
+    {
+        return {};
+    }
+
+private:
+    QStringList m_extensions;
+    std::atomic<int>* m_stopped;
+};
+} // namespace
+
+namespace Fooyin::Testing {
+class AudioLoaderTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_loader.addDecoder(u"Stub"_s, [this]() {
+            return std::make_unique<StubDecoder>(QStringList{u"stub"_s}, &m_stopped);
+        });
+    }
+
+    std::atomic<int> m_stopped{0};
+    AudioLoader m_loader;
+};
+
+TEST_F(AudioLoaderTest, ReusesReleasedDecoders)
+{
+    auto decoder = m_loader.acquireDecoder(u"/music/track.stub"_s);
+    ASSERT_TRUE(decoder);
+    AudioDecoder* instance = decoder.get();
+
+    decoder.reset();
+    EXPECT_EQ(1, m_stopped.load());
+
+    const auto reused = m_loader.acquireDecoder(u"/music/other.STUB"_s);
+    EXPECT_EQ(instance, reused.get());
+}
+
+TEST_F(AudioLoaderTest, ChecksOutDistinctDecoders)
+{
+    const auto first  = m_loader.acquireDecoder(u"/music/first.stub"_s);
+    const auto second = m_loader.acquireDecoder(u"/music/second.stub"_s);
+
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_NE(first.get(), second.get());
+}
+
+TEST_F(AudioLoaderTest, FollowsDecoderChanges)
+{
+    EXPECT_FALSE(m_loader.acquireDecoder(u"/music/track.flac"_s));
+    EXPECT_TRUE(m_loader.acquireDecoder(u"/music/track.stub"_s));
+
+    m_loader.setDecoderEnabled(u"Stub"_s, false);
+    EXPECT_FALSE(m_loader.acquireDecoder(u"/music/track.stub"_s));
+    EXPECT_EQ(nullptr, m_loader.decoderForFile(u"/music/track.stub"_s));
+
+    m_loader.setDecoderEnabled(u"Stub"_s, true);
+    EXPECT_TRUE(m_loader.acquireDecoder(u"/music/track.stub"_s));
+}
+} // namespace Fooyin::Testing
@@ -0,0 +1,151 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/audiotap.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// A counting sequence of mono S16 samples, starting at @p first
+std::vector<int16_t> countingSamples(int first, int count)
+{
+    std::vector<int16_t> samples(static_cast<size_t>(count));
+    for(int i{0}; i < count; ++i) {
+        samples.at(i) = static_cast<int16_t>(first + i);
+    }
+    return samples;
+}
+
+std::span<const std::byte> asBytes(const std::vector<int16_t>& samples)
+{
+    return std::as_bytes(std::span{samples});
+}
+
+int16_t firstSample(const Fooyin::AudioBuffer& buffer)
+{
+    int16_t sample{0};
+    std::memcpy(&sample, buffer.constData().data(), sizeof(sample));
+    return sample;
+}
+} // namespace
+
+namespace Fooyin::Testing {
+class AudioTapTest : public ::testing::Test
+{
+protected:
+    const AudioFormat m_format{SampleFormat::S16, 1000, 1};
+    const AudioTap::TimePoint m_start{AudioTap::Clock::now()};
+};
+
+TEST_F(AudioTapTest, ReadsWhatIsAudible)
+{
+    AudioTap tap;
+    AudioBuffer buffer;
+    EXPECT_FALSE(tap.readAudible(100, buffer, m_start));
+
+    tap.setFormat(m_format);
+    tap.write(asBytes(countingSamples(0, 1000)), 5000, m_start);
+
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 500ms));
+    EXPECT_EQ(m_format, buffer.format());
+    EXPECT_EQ(100, buffer.frameCount());
+    EXPECT_EQ(400, firstSample(buffer));
+    EXPECT_EQ(5400, buffer.startTime());
+
+    // Only what's been heard so far
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 50ms));
+    EXPECT_EQ(50, buffer.frameCount());
+    EXPECT_EQ(0, firstSample(buffer));
+
+    // Can't read ahead of what's been written
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 5s));
+    EXPECT_EQ(900, firstSample(buffer));
+}
+
+TEST_F(AudioTapTest, ReadsEarlierWrites)
+{
+    AudioTap tap;
+    tap.setFormat(m_format);
+    tap.write(asBytes(countingSamples(0, 1000)), 0, m_start);
+    tap.write(asBytes(countingSamples(1000, 1000)), 1000, m_start + 1s);
+
+    AudioBuffer buffer;
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 250ms));
+    EXPECT_EQ(150, firstSample(buffer));
+    EXPECT_EQ(150, buffer.startTime());
+}
+
+TEST_F(AudioTapTest, KeepsOnlyLength)
+{
+    AudioTap tap{500};
+    tap.setFormat(m_format);
+    for(int i{0}; i < 4; ++i) {
+        tap.write(asBytes(countingSamples(i * 250, 250)), i * 250, m_start + (i * 250ms));
+    }
+
+    AudioBuffer buffer;
+    ASSERT_TRUE(tap.readAudible(1000, buffer, m_start + 1s));
+    EXPECT_EQ(500, buffer.frameCount());
+    EXPECT_EQ(500, firstSample(buffer));
+
+    // Overwritten long ago
+    EXPECT_FALSE(tap.readAudible(100, buffer, m_start + 100ms));
+}
+
+TEST_F(AudioTapTest, ClearDiscardsAudio)
+{
+    AudioTap tap;
+    tap.setFormat(m_format);
+    tap.write(asBytes(countingSamples(0, 1000)), 0, m_start);
+
+    tap.clear();
+
+    AudioBuffer buffer;
+    EXPECT_FALSE(tap.readAudible(100, buffer, m_start + 500ms));
+
+    tap.write(asBytes(countingSamples(3000, 1000)), 3000, m_start + 1s);
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 1500ms));
+    EXPECT_EQ(3400, firstSample(buffer));
+}
+
+TEST_F(AudioTapTest, FormatChangesOnFirstWrite)
+{
+    AudioTap tap;
+    tap.setFormat(m_format);
+    tap.write(asBytes(countingSamples(0, 1000)), 0, m_start);
+
+    const AudioFormat stereo{SampleFormat::S16, 1000, 2};
+    tap.setFormat(stereo);
+    EXPECT_EQ(m_format, tap.format());
+
+    tap.write(asBytes(countingSamples(0, 2000)), 0, m_start + 1s);
+    EXPECT_EQ(stereo, tap.format());
+
+    AudioBuffer buffer;
+    ASSERT_TRUE(tap.readAudible(100, buffer, m_start + 1500ms));
+    EXPECT_EQ(stereo, buffer.format());
+    EXPECT_EQ(100, buffer.frameCount());
+    EXPECT_EQ(800, firstSample(buffer));
+}
+} // namespace Fooyin::Testing
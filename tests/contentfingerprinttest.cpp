@@ -0,0 +1,121 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/library/libraryutils.h"
+
+#include <QBuffer>
+
+#include <gtest/gtest.h>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+QByteArray audioData(int size, char seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for(int i{0}; i < size; ++i) {
+        data[i] = static_cast<char>((i * 31 + seed) % 251);
+    }
+    return data;
+}
+
+QByteArray id3v2Tag(int size)
+{
+    QByteArray tag{"ID3\x03\x00\x00", 6};
+    tag.append(static_cast<char>((size >> 21) & 0x7f));
+    tag.append(static_cast<char>((size >> 14) & 0x7f));
+    tag.append(static_cast<char>((size >> 7) & 0x7f));
+    tag.append(static_cast<char>(size & 0x7f));
+    tag.append(QByteArray(size, 'x'));
+    return tag;
+}
+
+QByteArray id3v1Tag()
+{
+    return QByteArray{"TAG"} + QByteArray(125, 'y');
+}
+
+QByteArray flacFile(const QByteArray& audio, int commentSize)
+{
+    QByteArray file{"fLaC"};
+    // STREAMINFO
+    file.append(QByteArray{"\x00\x00\x00\x22", 4});
+    file.append(QByteArray(34, 's'));
+    // Last block: VORBIS_COMMENT
+    file.append(static_cast<char>(0x84));
+    file.append(static_cast<char>((commentSize >> 16) & 0xff));
+    file.append(static_cast<char>((commentSize >> 8) & 0xff));
+    file.append(static_cast<char>(commentSize & 0xff));
+    file.append(QByteArray(commentSize, 'c'));
+    file.append(audio);
+    return file;
+}
+
+QString fingerprint(QByteArray data)
+{
+    QBuffer buffer{&data};
+    if(!buffer.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return Fooyin::Utils::contentFingerprint(&buffer);
+}
+} // namespace
+
+namespace Fooyin::Testing {
+TEST(ContentFingerprintTest, SameContentMatches)
+{
+    const QByteArray audio = audioData(200000, 1);
+
+    const QString result = fingerprint(audio);
+    EXPECT_FALSE(result.isEmpty());
+    EXPECT_EQ(result, fingerprint(audio));
+}
+
+TEST(ContentFingerprintTest, ChangedAudioDiffers)
+{
+    const QByteArray audio = audioData(200000, 1);
+
+    QByteArray changedTail = audio;
+    changedTail[changedTail.size() - 1] = 'z';
+    EXPECT_NE(fingerprint(audio), fingerprint(changedTail));
+
+    EXPECT_NE(fingerprint(audioData(1000, 1)), fingerprint(audioData(1000, 2)));
+}
+
+TEST(ContentFingerprintTest, IgnoresId3Tags)
+{
+    const QByteArray audio = audioData(200000, 3);
+
+    EXPECT_EQ(fingerprint(audio), fingerprint(id3v2Tag(100) + audio));
+    EXPECT_EQ(fingerprint(audio), fingerprint(id3v2Tag(4000) + audio + id3v1Tag()));
+}
+
+TEST(ContentFingerprintTest, IgnoresFlacMetadata)
+{
+    const QByteArray audio = audioData(1000, 4);
+
+    EXPECT_EQ(fingerprint(flacFile(audio, 10)), fingerprint(flacFile(audio, 5000)));
+    EXPECT_NE(fingerprint(flacFile(audio, 10)), fingerprint(flacFile(audioData(1000, 5), 10)));
+}
+
+TEST(ContentFingerprintTest, EmptyDevice)
+{
+    EXPECT_TRUE(fingerprint({}).isEmpty());
+}
+} // namespace Fooyin::Testing
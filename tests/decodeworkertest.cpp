@@ -0,0 +1,246 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/decodeworker.h"
+
+#include <core/engine/audioinput.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// Produces a counting sequence of mono S16 samples
+class CountingDecoder : public Fooyin::AudioDecoder
+{
+public:
+    CountingDecoder(const Fooyin::AudioFormat& format, int totalFrames)
+        : m_format{format}
+        , m_totalFrames{totalFrames}
+        , m_position{0}
+    { }
+
+    [[nodiscard]] QStringList extensions() const override
+    {
+        return {};
+    }
+
+    [[nodiscard]] bool isSeekable() const override
+    {
+        return true;
+    }
+
+    std::optional<Fooyin::AudioFormat> init(const Fooyin::AudioSource& /*source*/, const Fooyin::Track& /*track*/,
+                                            DecoderOptions /*options*/) override
+    {
+        return m_format;
+    }
+
+    void stop() override { }
+
+    void seek(uint64_t pos) override
+    {
+        m_position = m_format.framesForDuration(pos);
+    }
+
+    Fooyin::AudioBuffer readBuffer(size_t bytes) override
+    {
+        const int frames = std::min(m_format.framesForBytes(static_cast<int>(bytes)), m_totalFrames - m_position);
+        if(frames <= 0) {
+            return {};
+        }
+
+        std::vector<int16_t> samples(static_cast<size_t>(frames));
+        for(int i{0}; i < frames; ++i) {
+            samples.at(i) = static_cast<int16_t>(m_position + i);
+        }
+
+        Fooyin::AudioBuffer buffer{reinterpret_cast<const uint8_t*>(samples.data()), samples.size() * sizeof(int16_t),
+                                   m_format, m_format.durationForFrames(m_position)};
+        m_position += frames;
+        m_framesDecoded += frames;
+
+        return buffer;
+    }
+
+    [[nodiscard]] int framesDecoded() const
+    {
+        return m_framesDecoded;
+    }
+
+private:
+    Fooyin::AudioFormat m_format;
+    int m_totalFrames;
+    int m_position;
+    std::atomic<int> m_framesDecoded{0};
+};
+
+template <typename Predicate>
+bool waitFor(Predicate predicate)
+{
+    for(int i{0}; i < 500; ++i) {
+        if(predicate()) {
+            return true;
+        }
+        std::this_thread::sleep_for(2ms);
+    }
+    return predicate();
+}
+} // namespace
+
+namespace Fooyin::Testing {
+TEST(DecodeWorkerTest, ReadsAllAudioInOrder)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 12000};
+
+    DecodeWorker worker;
+    worker.setReadAhead(2000);
+    worker.start(&decoder, format);
+
+    std::vector<int16_t> samples;
+    while(!worker.atEnd()) {
+        const auto buffer = worker.read(static_cast<size_t>(format.bytesForFrames(300)));
+        if(!buffer.isValid()) {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+
+        EXPECT_EQ(samples.size(), buffer.startTime());
+
+        const auto offset = samples.size();
+        samples.resize(offset + static_cast<size_t>(buffer.frameCount()));
+        std::memcpy(samples.data() + offset, buffer.constData().data(), buffer.constData().size());
+    }
+
+    ASSERT_EQ(12000, samples.size());
+    for(size_t i{0}; i < samples.size(); ++i) {
+        ASSERT_EQ(static_cast<int16_t>(i), samples.at(i));
+    }
+}
+
+TEST(DecodeWorkerTest, StopsAtReadAhead)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 60000};
+
+    DecodeWorker worker;
+    worker.setReadAhead(3000);
+    worker.start(&decoder, format);
+
+    ASSERT_TRUE(waitFor([&worker]() { return worker.bufferedDuration() >= 3000; }));
+    std::this_thread::sleep_for(20ms);
+
+    // Nothing more is decoded until there's room
+    EXPECT_EQ(3000, decoder.framesDecoded());
+
+    EXPECT_TRUE(worker.read(static_cast<size_t>(format.bytesForFrames(500))).isValid());
+    EXPECT_TRUE(waitFor([&decoder]() { return decoder.framesDecoded() == 3500; }));
+}
+
+TEST(DecodeWorkerTest, ClearDiscardsDecodedAudio)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 60000};
+
+    DecodeWorker worker;
+    worker.start(&decoder, format);
+    ASSERT_TRUE(waitFor([&worker]() { return worker.bufferedDuration() > 0; }));
+
+    worker.clear();
+    EXPECT_EQ(0, worker.bufferedDuration());
+    EXPECT_FALSE(worker.read(100).isValid());
+
+    // The decoder is ours again until decoding restarts
+    decoder.seek(30000);
+    worker.start(&decoder, format);
+    ASSERT_TRUE(waitFor([&worker]() { return worker.bufferedDuration() > 0; }));
+
+    const auto buffer = worker.read(2);
+    ASSERT_TRUE(buffer.isValid());
+    EXPECT_EQ(30000, buffer.startTime());
+
+    int16_t sample{0};
+    std::memcpy(&sample, buffer.constData().data(), sizeof(sample));
+    EXPECT_EQ(static_cast<int16_t>(30000), sample);
+}
+
+TEST(DecodeWorkerTest, PreparesOnDecodeThread)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 60000};
+
+    DecodeWorker worker;
+
+    std::atomic<std::thread::id> prepareThread;
+    worker.prepare(&decoder, [&]() -> std::optional<DecodeWorker::Prepared> {
+        prepareThread = std::this_thread::get_id();
+        return DecodeWorker::Prepared{.format = format};
+    });
+
+    ASSERT_TRUE(waitFor([&worker]() { return !worker.isPreparing(); }));
+    EXPECT_NE(std::this_thread::get_id(), prepareThread.load());
+    EXPECT_EQ(format, worker.format());
+    EXPECT_EQ(&decoder, worker.decoder());
+
+    // Decoding starts straight away, and carries on when started with the same decoder
+    ASSERT_TRUE(waitFor([&worker]() { return worker.bufferedDuration() > 0; }));
+    worker.start(&decoder, format);
+
+    const auto buffer = worker.read(2);
+    ASSERT_TRUE(buffer.isValid());
+    EXPECT_EQ(0, buffer.startTime());
+}
+
+TEST(DecodeWorkerTest, HasBufferedAtEndOfShortTrack)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 500};
+
+    DecodeWorker worker;
+    EXPECT_FALSE(worker.hasBuffered(1000));
+
+    worker.start(&decoder, format);
+
+    // Less than asked for, but it's all there will be
+    ASSERT_TRUE(waitFor([&worker]() { return worker.hasBuffered(1000); }));
+    EXPECT_EQ(500, worker.bufferedDuration());
+}
+
+TEST(DecodeWorkerTest, FailedPrepareLeavesNoFormat)
+{
+    const AudioFormat format{SampleFormat::S16, 1000, 1};
+    CountingDecoder decoder{format, 60000};
+
+    DecodeWorker worker;
+    worker.prepare(&decoder, []() -> std::optional<DecodeWorker::Prepared> { return {}; });
+
+    ASSERT_TRUE(waitFor([&worker]() { return !worker.isPreparing(); }));
+    EXPECT_FALSE(worker.format().isValid());
+    EXPECT_FALSE(worker.isActive());
+    EXPECT_EQ(0, decoder.framesDecoded());
+}
+} // namespace Fooyin::Testing
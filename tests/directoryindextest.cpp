@@ -0,0 +1,166 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/library/directoryindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <tuple>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+void createFile(const QString& path)
+{
+    QFile file{path};
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("data");
+}
+
+// Filesystem timestamps can be coarser than the test, so move the directory's time forward explicitly
+void bumpModifiedTime(const QString& path)
+{
+    const std::filesystem::path dir{path.toStdString()};
+    std::filesystem::last_write_time(dir, std::filesystem::last_write_time(dir) + std::chrono::seconds{2});
+}
+
+Fooyin::IndexedDirectoryMap toMap(const std::vector<Fooyin::IndexedDirectory>& dirs)
+{
+    Fooyin::IndexedDirectoryMap map;
+    for(const auto& dir : dirs) {
+        map.emplace(dir.path, dir);
+    }
+    return map;
+}
+} // namespace
+
+namespace Fooyin::Testing {
+class DirectoryIndexTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(m_dir.isValid());
+
+        const QDir root{m_dir.path()};
+        ASSERT_TRUE(root.mkpath(u"a/b"_s));
+        ASSERT_TRUE(root.mkpath(u"c"_s));
+
+        createFile(root.filePath(u"root.flac"_s));
+        createFile(root.filePath(u"a/one.flac"_s));
+        createFile(root.filePath(u"a/b/two.mp3"_s));
+        createFile(root.filePath(u"a/b/cover.jpg"_s));
+        createFile(root.filePath(u"c/three.flac"_s));
+    }
+
+    [[nodiscard]] QString path(const QString& relative) const
+    {
+        return QDir::cleanPath(QDir{m_dir.path()}.absoluteFilePath(relative));
+    }
+
+    QTemporaryDir m_dir;
+    const QStringList m_wildcards{u"*.flac"_s, u"*.mp3"_s};
+};
+
+TEST_F(DirectoryIndexTest, ListsAllFilesWithoutIndex)
+{
+    DirectoryIndex index;
+    const QFileInfoList files = index.walk({m_dir.path()}, m_wildcards, true);
+
+    EXPECT_EQ(4, files.size());
+    EXPECT_EQ(4U, index.changedDirectories().size());
+    EXPECT_EQ(0, index.unchangedDirectoryCount());
+}
+
+TEST_F(DirectoryIndexTest, SkipsUnchangedDirectories)
+{
+    DirectoryIndex first;
+    std::ignore = first.walk({m_dir.path()}, m_wildcards, true);
+
+    DirectoryIndex second{toMap(first.changedDirectories())};
+    const QFileInfoList files = second.walk({m_dir.path()}, m_wildcards, true);
+
+    EXPECT_TRUE(files.empty());
+    EXPECT_EQ(4, second.unchangedDirectoryCount());
+    EXPECT_EQ(4, second.unchangedFileCount());
+    EXPECT_TRUE(second.isUnchanged(path(u"a/b"_s)));
+    EXPECT_TRUE(second.changedDirectories().empty());
+    EXPECT_TRUE(second.removedDirectories().empty());
+}
+
+TEST_F(DirectoryIndexTest, ListsOnlyChangedDirectories)
+{
+    DirectoryIndex first;
+    std::ignore = first.walk({m_dir.path()}, m_wildcards, true);
+
+    createFile(path(u"a/b/four.flac"_s));
+    bumpModifiedTime(path(u"a/b"_s));
+
+    DirectoryIndex second{toMap(first.changedDirectories())};
+    const QFileInfoList files = second.walk({m_dir.path()}, m_wildcards, true);
+
+    ASSERT_EQ(2, files.size());
+    for(const auto& file : files) {
+        EXPECT_EQ(path(u"a/b"_s), file.absolutePath());
+    }
+
+    EXPECT_FALSE(second.isUnchanged(path(u"a/b"_s)));
+    EXPECT_TRUE(second.isUnchanged(path(u"a"_s)));
+    ASSERT_EQ(1U, second.changedDirectories().size());
+    EXPECT_EQ(2, second.changedDirectories().front().entryCount);
+}
+
+TEST_F(DirectoryIndexTest, ListsEverythingWhenNotSkipping)
+{
+    DirectoryIndex first;
+    std::ignore = first.walk({m_dir.path()}, m_wildcards, true);
+
+    DirectoryIndex second{toMap(first.changedDirectories())};
+    const QFileInfoList files = second.walk({m_dir.path()}, m_wildcards, false);
+
+    EXPECT_EQ(4, files.size());
+    EXPECT_EQ(0, second.unchangedDirectoryCount());
+}
+
+TEST_F(DirectoryIndexTest, ReportsRemovedDirectories)
+{
+    DirectoryIndex first;
+    std::ignore = first.walk({m_dir.path()}, m_wildcards, true);
+
+    ASSERT_TRUE(QDir{path(u"a"_s)}.removeRecursively());
+    bumpModifiedTime(m_dir.path());
+
+    DirectoryIndex second{toMap(first.changedDirectories())};
+    const QFileInfoList files = second.walk({m_dir.path()}, m_wildcards, true);
+
+    // The root lost an entry so is listed again, but 'c' is untouched
+    ASSERT_EQ(1, files.size());
+    EXPECT_EQ(u"root.flac"_s, files.front().fileName());
+
+    QStringList removed = second.removedDirectories();
+    removed.sort();
+    EXPECT_EQ((QStringList{path(u"a"_s), path(u"a/b"_s)}), removed);
+}
+} // namespace Fooyin::Testing
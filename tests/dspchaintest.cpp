@@ -0,0 +1,262 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/dsp/equaliser.h"
+#include "core/engine/dsp/limiter.h"
+#include "core/engine/dspchain.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+class ScaleNode : public Fooyin::DspNode
+{
+public:
+    ScaleNode(float scale, std::vector<Fooyin::SampleFormat> formats = {Fooyin::SampleFormat::F32}, int latency = 0)
+        : m_scale{scale}
+        , m_formats{std::move(formats)}
+        , m_latency{latency}
+    { }
+
+    [[nodiscard]] QString name() const override
+    {
+        return u"Scale"_s;
+    }
+
+    [[nodiscard]] std::vector<Fooyin::SampleFormat> supportedFormats() const override
+    {
+        return m_formats;
+    }
+
+    [[nodiscard]] int latency() const override
+    {
+        return m_latency;
+    }
+
+    void prepare(const Fooyin::AudioFormat& format) override
+    {
+        m_format = format;
+    }
+
+    void process(Fooyin::AudioBuffer& buffer) override
+    {
+        ASSERT_EQ(m_format, buffer.format());
+        ASSERT_EQ(Fooyin::SampleFormat::F32, buffer.format().sampleFormat());
+
+        auto* samples = reinterpret_cast<float*>(buffer.data());
+        for(int i{0}; i < buffer.sampleCount(); ++i) {
+            samples[i] *= m_scale;
+        }
+    }
+
+private:
+    float m_scale;
+    std::vector<Fooyin::SampleFormat> m_formats;
+    int m_latency;
+    Fooyin::AudioFormat m_format;
+};
+
+template <typename T>
+Fooyin::AudioBuffer makeBuffer(const Fooyin::AudioFormat& format, const std::vector<T>& samples)
+{
+    return {reinterpret_cast<const uint8_t*>(samples.data()), samples.size() * sizeof(T), format, 0};
+}
+
+template <typename T>
+std::vector<T> samplesOf(const Fooyin::AudioBuffer& buffer)
+{
+    std::vector<T> samples(static_cast<size_t>(buffer.sampleCount()));
+    std::memcpy(samples.data(), buffer.constData().data(), buffer.constData().size());
+    return samples;
+}
+
+std::vector<float> sine(int frames, double frequency, double amplitude, int sampleRate)
+{
+    std::vector<float> samples(static_cast<size_t>(frames));
+    for(int i{0}; i < frames; ++i) {
+        samples[i] = static_cast<float>(amplitude * std::sin(2.0 * std::numbers::pi * frequency * i / sampleRate));
+    }
+    return samples;
+}
+} // namespace
+
+namespace Fooyin::Testing {
+TEST(DspChainTest, NegotiatesCommonFormat)
+{
+    const AudioFormat input{SampleFormat::S16, 44100, 2};
+
+    DspNodeList nodes;
+    nodes.push_back(std::make_unique<ScaleNode>(1.0F, std::vector{SampleFormat::S16, SampleFormat::F64}));
+    nodes.push_back(std::make_unique<ScaleNode>(1.0F, std::vector{SampleFormat::F32, SampleFormat::F64}));
+    EXPECT_EQ(SampleFormat::F64, DspChain::negotiateFormat(nodes, input).sampleFormat());
+
+    nodes.pop_back();
+    EXPECT_EQ(input, DspChain::negotiateFormat(nodes, input));
+
+    EXPECT_EQ(input, DspChain::negotiateFormat({}, input));
+}
+
+TEST(DspChainTest, EmptyChainIsUntouched)
+{
+    const AudioFormat format{SampleFormat::S16, 44100, 1};
+
+    DspChain chain;
+    chain.setFormat(format);
+
+    const std::vector<int16_t> input{0, 1, -1, 32767, -32768};
+    AudioBuffer buffer = makeBuffer(format, input);
+    chain.process(buffer);
+
+    EXPECT_TRUE(chain.isEmpty());
+    EXPECT_EQ(input, samplesOf<int16_t>(buffer));
+}
+
+TEST(DspChainTest, ConvertsToWorkingFormat)
+{
+    const AudioFormat format{SampleFormat::S16, 44100, 1};
+
+    DspChain chain;
+    chain.setFormat(format);
+
+    DspNodeList nodes;
+    nodes.push_back(std::make_unique<ScaleNode>(0.5F, std::vector{SampleFormat::F32}, 10));
+    nodes.push_back(std::make_unique<ScaleNode>(0.5F, std::vector{SampleFormat::F32}, 5));
+    chain.replaceNodes(chain.prepareNodes(std::move(nodes)));
+    chain.reset();
+
+    EXPECT_EQ(SampleFormat::F32, chain.workingFormat().sampleFormat());
+    EXPECT_EQ(15, chain.latency());
+
+    AudioBuffer buffer = makeBuffer(format, std::vector<int16_t>(64, 16000));
+    chain.process(buffer);
+
+    for(const int16_t sample : samplesOf<int16_t>(buffer)) {
+        EXPECT_EQ(4000, sample);
+    }
+}
+
+TEST(DspChainTest, ReplacingNodesFades)
+{
+    const AudioFormat format{SampleFormat::F32, 48000, 1};
+    const int transition = format.framesForDuration(10);
+
+    DspChain chain;
+    chain.setFormat(format);
+
+    DspNodeList nodes;
+    nodes.push_back(std::make_unique<ScaleNode>(0.0F));
+    chain.replaceNodes(chain.prepareNodes(std::move(nodes)));
+
+    std::vector<float> output;
+    for(int i{0}; i < 4; ++i) {
+        AudioBuffer buffer = makeBuffer(format, std::vector<float>(transition / 3, 1.0F));
+        chain.process(buffer);
+        const auto samples = samplesOf<float>(buffer);
+        output.insert(output.end(), samples.cbegin(), samples.cend());
+    }
+
+    // The old (empty) chain fades out as the muted chain fades in
+    EXPECT_GT(output.front(), 0.99F);
+    for(size_t i{1}; i < output.size(); ++i) {
+        EXPECT_LE(output.at(i), output.at(i - 1));
+        EXPECT_LT(output.at(i - 1) - output.at(i), 0.01F);
+    }
+    EXPECT_EQ(0.0F, output.back());
+
+    EXPECT_TRUE(chain.takeRetiredNodes().empty());
+    chain.replaceNodes(chain.prepareNodes({}));
+    EXPECT_TRUE(chain.isEmpty());
+}
+
+TEST(DspChainTest, FlatEqualiserIsTransparent)
+{
+    const AudioFormat format{SampleFormat::F32, 44100, 1};
+
+    Equaliser equaliser;
+    equaliser.prepare(format);
+
+    const auto input   = sine(1024, 1000.0, 0.5, format.sampleRate());
+    AudioBuffer buffer = makeBuffer(format, input);
+    equaliser.process(buffer);
+
+    EXPECT_EQ(input, samplesOf<float>(buffer));
+}
+
+TEST(DspChainTest, EqualiserBoostsBand)
+{
+    const AudioFormat format{SampleFormat::F32, 44100, 1};
+
+    Equaliser::Gains gains{};
+    gains.at(5) = 6.0;
+
+    Equaliser equaliser;
+    equaliser.setGains(gains);
+
+    Equaliser restored;
+    ASSERT_TRUE(restored.loadSettings(equaliser.saveSettings()));
+    EXPECT_EQ(gains, restored.gains());
+
+    restored.prepare(format);
+
+    const int frames   = 8820;
+    AudioBuffer buffer = makeBuffer(format, sine(frames, Equaliser::bandFrequency(5), 0.25, format.sampleRate()));
+    restored.process(buffer);
+
+    // Skip the filter settling in
+    const auto samples = samplesOf<float>(buffer);
+    const float peak   = *std::max_element(samples.cbegin() + frames / 2, samples.cend());
+    EXPECT_NEAR(0.5F, peak, 0.02F);
+}
+
+TEST(DspChainTest, LimiterKeepsBelowThreshold)
+{
+    const AudioFormat format{SampleFormat::F32, 44100, 2};
+
+    Limiter limiter;
+    limiter.setThreshold(-6.0);
+    limiter.prepare(format);
+
+    const float ceiling = std::pow(10.0F, -6.0F / 20.0F);
+    EXPECT_EQ(format.framesForDuration(5), limiter.latency());
+
+    auto input = sine(4096, 440.0, 0.3, format.sampleRate());
+    // Sudden peak well above the ceiling on one channel
+    input.at(2001) = 1.0F;
+
+    AudioBuffer buffer = makeBuffer(format, input);
+    limiter.process(buffer);
+
+    const auto samples = samplesOf<float>(buffer);
+    for(const float sample : samples) {
+        EXPECT_LE(std::abs(sample), ceiling + 1e-6F);
+    }
+
+    // Audio below the threshold passes through delayed
+    const int delay = limiter.latency() * format.channelCount();
+    EXPECT_FLOAT_EQ(input.at(100), samples.at(100 + delay));
+}
+} // namespace Fooyin::Testing
@@ -0,0 +1,129 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/gainprocessor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Fooyin::Testing {
+TEST(GainProcessorTest, UnityIsInactive)
+{
+    GainProcessor processor;
+    processor.setFormat({SampleFormat::S16, 44100, 2});
+
+    EXPECT_FALSE(processor.isActive());
+
+    std::vector<int16_t> samples(64, 1000);
+    processor.process(reinterpret_cast<std::byte*>(samples.data()), 32);
+
+    EXPECT_TRUE(std::ranges::all_of(samples, [](int16_t sample) { return sample == 1000; }));
+}
+
+TEST(GainProcessorTest, ImmediateGain)
+{
+    GainProcessor processor;
+    processor.setFormat({SampleFormat::F32, 44100, 2});
+    processor.setGain(0.5, true);
+
+    std::vector<float> samples(2048, 0.5F);
+    processor.process(reinterpret_cast<std::byte*>(samples.data()), 1024);
+
+    EXPECT_TRUE(std::ranges::all_of(samples, [](float sample) { return sample == 0.25F; }));
+}
+
+TEST(GainProcessorTest, RampsAcrossCalls)
+{
+    constexpr int SampleRate = 48000;
+
+    GainProcessor processor;
+    processor.setFormat({SampleFormat::F32, SampleRate, 1});
+    processor.setGain(0.0, false);
+
+    // Process in small chunks so the ramp spans several calls
+    std::vector<float> samples(SampleRate / 10, 1.0F);
+    for(size_t offset{0}; offset < samples.size(); offset += 100) {
+        processor.process(reinterpret_cast<std::byte*>(samples.data() + offset), 100);
+    }
+
+    for(size_t i{1}; i < samples.size(); ++i) {
+        EXPECT_LE(samples.at(i), samples.at(i - 1));
+        EXPECT_LT(samples.at(i - 1) - samples.at(i), 0.01F);
+    }
+    EXPECT_LT(samples.front(), 1.0F);
+    EXPECT_EQ(0.0F, samples.back());
+}
+
+TEST(GainProcessorTest, IntegerSaturates)
+{
+    GainProcessor processor;
+    processor.setFormat({SampleFormat::S16, 44100, 1});
+    processor.setGain(4.0, true);
+
+    std::vector<int16_t> samples{20000, -20000, 1000};
+    processor.process(reinterpret_cast<std::byte*>(samples.data()), 3);
+
+    EXPECT_EQ(32767, samples.at(0));
+    EXPECT_EQ(-32768, samples.at(1));
+    EXPECT_EQ(4000, samples.at(2));
+}
+
+TEST(GainProcessorTest, LimiterPreventsClipping)
+{
+    GainProcessor processor;
+    processor.setFormat({SampleFormat::F32, 44100, 2});
+    processor.setGain(2.0, true);
+    processor.setLimiterEnabled(true);
+
+    std::vector<float> samples(4096);
+    for(size_t i{0}; i < samples.size(); ++i) {
+        samples.at(i) = 0.9F * std::sin(static_cast<float>(i) * 0.05F);
+    }
+
+    processor.process(reinterpret_cast<std::byte*>(samples.data()), 2048);
+
+    EXPECT_TRUE(std::ranges::all_of(samples, [](float sample) { return std::abs(sample) <= 1.0F; }));
+}
+
+TEST(GainProcessorTest, ScaleU8AroundMidpoint)
+{
+    std::vector<uint8_t> samples{0x80, 0xC0, 0x40};
+    Audio::applyGain(reinterpret_cast<std::byte*>(samples.data()), SampleFormat::U8, 3, 0.5F);
+
+    EXPECT_EQ(0x80, samples.at(0));
+    EXPECT_EQ(0xA0, samples.at(1));
+    EXPECT_EQ(0x60, samples.at(2));
+}
+
+TEST(GainProcessorTest, MixSaturates)
+{
+    const std::vector<int16_t> input{1000, 30000, -30000};
+    std::vector<int16_t> output{-500, 10000, -10000};
+    Audio::mixSamples(reinterpret_cast<const std::byte*>(input.data()), reinterpret_cast<std::byte*>(output.data()),
+                      SampleFormat::S16, 3);
+
+    EXPECT_EQ(500, output.at(0));
+    EXPECT_EQ(32767, output.at(1));
+    EXPECT_EQ(-32768, output.at(2));
+}
+} // namespace Fooyin::Testing
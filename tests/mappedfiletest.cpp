@@ -0,0 +1,101 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/engine/mappedfile.h>
+
+#include <QTemporaryFile>
+
+#include <gtest/gtest.h>
+
+namespace {
+QByteArray testData()
+{
+    QByteArray data;
+    for(int i{0}; i < 10000; ++i) {
+        data.append(static_cast<char>(i % 251));
+    }
+    return data;
+}
+} // namespace
+
+namespace Fooyin::Testing {
+class MappedFileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(m_temp.open());
+        m_temp.write(testData());
+        m_temp.flush();
+    }
+
+    QTemporaryFile m_temp;
+};
+
+TEST_F(MappedFileTest, ReadsLikeFile)
+{
+    MappedFile file{m_temp.fileName()};
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+
+    const QByteArray data = testData();
+    EXPECT_EQ(data.size(), file.size());
+    EXPECT_FALSE(file.isSequential());
+
+    EXPECT_EQ(data.left(100), file.read(100));
+    EXPECT_EQ(100, file.pos());
+
+    ASSERT_TRUE(file.seek(9000));
+    EXPECT_EQ(data.mid(9000), file.readAll());
+    EXPECT_TRUE(file.atEnd());
+
+    EXPECT_FALSE(file.seek(data.size() + 1));
+}
+
+TEST_F(MappedFileTest, SurvivesTruncation)
+{
+#ifndef Q_OS_UNIX
+    GTEST_SKIP() << "Mapped files can't be truncated on this platform";
+#endif
+
+    MappedFile file{m_temp.fileName()};
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    ASSERT_TRUE(file.isMapped());
+
+    const QByteArray data = testData();
+
+    // Shrink the file as a tag writer rewriting it in place might
+    ASSERT_TRUE(m_temp.resize(100));
+
+    ASSERT_TRUE(file.seek(9000));
+    EXPECT_TRUE(file.read(100).isEmpty());
+    EXPECT_FALSE(file.isMapped());
+    EXPECT_EQ(100, file.size());
+
+    ASSERT_TRUE(file.seek(0));
+    EXPECT_EQ(data.left(100), file.readAll());
+}
+
+TEST_F(MappedFileTest, CannotWrite)
+{
+    MappedFile file{m_temp.fileName()};
+    EXPECT_FALSE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_EQ(-1, file.write("test"));
+}
+} // namespace Fooyin::Testing
@@ -0,0 +1,89 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/sampleconverters.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Reports the throughput of the scalar and dispatched sample converters for every format pair
+
+namespace {
+using Fooyin::SampleFormat;
+
+constexpr int SampleCount = 1 << 16;
+constexpr int Iterations  = 2000;
+
+struct NamedFormat
+{
+    SampleFormat format;
+    const char* name;
+    int size;
+};
+
+constexpr std::array Formats = {NamedFormat{SampleFormat::U8, "U8", 1}, NamedFormat{SampleFormat::S16, "S16", 2},
+                                NamedFormat{SampleFormat::S32, "S32", 4}, NamedFormat{SampleFormat::F32, "F32", 4},
+                                NamedFormat{SampleFormat::F64, "F64", 8}};
+
+double measure(Fooyin::Audio::SampleConverter converter, const std::vector<std::byte>& input,
+               std::vector<std::byte>& output)
+{
+    // Warm up caches and the dispatch table
+    converter(input.data(), output.data(), SampleCount);
+
+    const auto start = std::chrono::steady_clock::now();
+    for(int i{0}; i < Iterations; ++i) {
+        converter(input.data(), output.data(), SampleCount);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double samples = static_cast<double>(SampleCount) * Iterations;
+    return samples / elapsed.count() / 1e6;
+}
+} // namespace
+
+int main()
+{
+    std::printf("Dispatch: %s\n", Fooyin::Audio::sampleConverterIsa());
+    std::printf("%-12s %14s %14s %8s\n", "Conversion", "Scalar (MS/s)", "Active (MS/s)", "Speedup");
+
+    for(const auto& in : Formats) {
+        // Mid-scale values keep float inputs in range
+        std::vector<std::byte> input(static_cast<size_t>(SampleCount) * in.size, std::byte{0x3C});
+
+        for(const auto& out : Formats) {
+            if(in.format == out.format) {
+                continue;
+            }
+
+            std::vector<std::byte> output(static_cast<size_t>(SampleCount) * out.size);
+
+            const double scalar = measure(Fooyin::Audio::findScalarConverter(in.format, out.format), input, output);
+            const double active = measure(Fooyin::Audio::findSampleConverter(in.format, out.format), input, output);
+
+            char name[16];
+            std::snprintf(name, sizeof(name), "%s -> %s", in.name, out.name);
+            std::printf("%-12s %14.1f %14.1f %7.2fx\n", name, scalar, active, active / scalar);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * Fooyin
+ * Copyright © 2024, Luke Taylor <LukeT1@proton.me>
+ *
+ * Fooyin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Fooyin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Fooyin.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "core/engine/sampleconverters.h"
+
+#include <core/engine/audioconverter.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr std::array Formats
+    = {Fooyin::SampleFormat::U8, Fooyin::SampleFormat::S16, Fooyin::SampleFormat::S32, Fooyin::SampleFormat::F32,
+       Fooyin::SampleFormat::F64};
+
+int sampleSize(Fooyin::SampleFormat format)
+{
+    switch(format) {
+        case(Fooyin::SampleFormat::U8):
+            return 1;
+        case(Fooyin::SampleFormat::S16):
+            return 2;
+        case(Fooyin::SampleFormat::S24):
+        case(Fooyin::SampleFormat::S32):
+        case(Fooyin::SampleFormat::F32):
+            return 4;
+        case(Fooyin::SampleFormat::F64):
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+bool isFloat(Fooyin::SampleFormat format)
+{
+    return format == Fooyin::SampleFormat::F32 || format == Fooyin::SampleFormat::F64;
+}
+
+// Fills with noise, including out of range and full scale values for float formats
+std::vector<std::byte> makeInput(Fooyin::SampleFormat format, int sampleCount)
+{
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<double> dist{-1.25, 1.25};
+
+    std::vector<std::byte> data(static_cast<size_t>(sampleCount * sampleSize(format)));
+
+    for(int i{0}; i < sampleCount; ++i) {
+        std::byte* out = data.data() + i * sampleSize(format);
+        double value   = dist(rng);
+        if(i % 7 == 0) {
+            value = i % 2 == 0 ? 1.0 : -1.0;
+        }
+
+        switch(format) {
+            case(Fooyin::SampleFormat::F32): {
+                const auto sample = static_cast<float>(value);
+                std::memcpy(out, &sample, sizeof(sample));
+                break;
+            }
+            case(Fooyin::SampleFormat::F64):
+                std::memcpy(out, &value, sizeof(value));
+                break;
+            default: {
+                const auto bits = static_cast<uint32_t>(rng());
+                std::memcpy(out, &bits, sampleSize(format));
+                break;
+            }
+        }
+    }
+
+    return data;
+}
+
+int64_t readInteger(Fooyin::SampleFormat format, const std::byte* data)
+{
+    switch(format) {
+        case(Fooyin::SampleFormat::U8): {
+            uint8_t sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample;
+        }
+        case(Fooyin::SampleFormat::S16): {
+            int16_t sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample;
+        }
+        default: {
+            int32_t sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample;
+        }
+    }
+}
+} // namespace
+
+namespace Fooyin::Testing {
+TEST(SampleConverterTest, MatchesScalar)
+{
+    // Odd length so vector kernels also run their scalar tail
+    constexpr int SampleCount = 1027;
+
+    for(const auto inFormat : Formats) {
+        const auto input = makeInput(inFormat, SampleCount);
+
+        for(const auto outFormat : Formats) {
+            const auto converter = Audio::findSampleConverter(inFormat, outFormat);
+            const auto reference = Audio::findScalarConverter(inFormat, outFormat);
+            ASSERT_TRUE(converter);
+            ASSERT_TRUE(reference);
+
+            const auto outSize = static_cast<size_t>(SampleCount * sampleSize(outFormat));
+            std::vector<std::byte> output(outSize);
+            std::vector<std::byte> expected(outSize);
+
+            converter(input.data(), output.data(), SampleCount);
+            reference(input.data(), expected.data(), SampleCount);
+
+            if(isFloat(inFormat) && !isFloat(outFormat)) {
+                // Rounding of exact halves may differ between instruction sets
+                for(int i{0}; i < SampleCount; ++i) {
+                    const auto offset = i * sampleSize(outFormat);
+                    EXPECT_NEAR(readInteger(outFormat, expected.data() + offset),
+                                readInteger(outFormat, output.data() + offset), 1)
+                        << "sample " << i << " of format " << static_cast<int>(inFormat) << " -> "
+                        << static_cast<int>(outFormat);
+                }
+            }
+            else {
+                EXPECT_EQ(expected, output) << "format " << static_cast<int>(inFormat) << " -> "
+                                            << static_cast<int>(outFormat);
+            }
+        }
+    }
+}
+
+TEST(SampleConverterTest, FullScale)
+{
+    const std::array<float, 5> input{1.0F, -1.0F, 2.0F, -2.0F, 0.0F};
+
+    std::array<int32_t, 5> s32{};
+    Audio::findSampleConverter(SampleFormat::F32, SampleFormat::S32)(reinterpret_cast<const std::byte*>(input.data()),
+                                                                      reinterpret_cast<std::byte*>(s32.data()), 5);
+    EXPECT_EQ(2147483520, s32.at(0));
+    EXPECT_EQ(-2147483648, s32.at(1));
+    EXPECT_EQ(2147483520, s32.at(2));
+    EXPECT_EQ(-2147483648, s32.at(3));
+    EXPECT_EQ(0, s32.at(4));
+
+    std::array<int16_t, 5> s16{};
+    Audio::findSampleConverter(SampleFormat::F32, SampleFormat::S16)(reinterpret_cast<const std::byte*>(input.data()),
+                                                                      reinterpret_cast<std::byte*>(s16.data()), 5);
+    EXPECT_EQ(32767, s16.at(0));
+    EXPECT_EQ(-32768, s16.at(1));
+    EXPECT_EQ(0, s16.at(4));
+
+    std::array<uint8_t, 5> u8{};
+    Audio::findSampleConverter(SampleFormat::F32, SampleFormat::U8)(reinterpret_cast<const std::byte*>(input.data()),
+                                                                     reinterpret_cast<std::byte*>(u8.data()), 5);
+    EXPECT_EQ(255, u8.at(0));
+    EXPECT_EQ(0, u8.at(1));
+    EXPECT_EQ(128, u8.at(4));
+}
+
+TEST(SampleConverterTest, UnsignedToSigned)
+{
+    const std::array<uint8_t, 3> input{0, 0x80, 0xFF};
+
+    std::array<int32_t, 3> s32{};
+    Audio::findSampleConverter(SampleFormat::U8, SampleFormat::S32)(reinterpret_cast<const std::byte*>(input.data()),
+                                                                     reinterpret_cast<std::byte*>(s32.data()), 3);
+    EXPECT_EQ(-2147483648, s32.at(0));
+    EXPECT_EQ(0, s32.at(1));
+    EXPECT_EQ(0x7F000000, s32.at(2));
+}
+
+TEST(SampleConverterTest, ChannelMismatch)
+{
+    const AudioFormat inFormat{SampleFormat::S16, 44100, 2};
+    const AudioFormat outFormat{SampleFormat::F32, 44100, 1};
+
+    const std::array<int16_t, 4> input{16384, -16384, -8192, 8192};
+    std::array<float, 2> output{};
+
+    ASSERT_TRUE(Audio::convert(inFormat, reinterpret_cast<const std::byte*>(input.data()), outFormat,
+                               reinterpret_cast<std::byte*>(output.data()), 2));
+    EXPECT_FLOAT_EQ(0.5F, output.at(0));
+    EXPECT_FLOAT_EQ(-0.25F, output.at(1));
+}
+
+TEST(SampleConverterTest, Interleave)
+{
+    // Odd frame counts and an offset, so both the vector and scalar paths are covered
+    constexpr int Frames = 37;
+    constexpr int Offset = 3;
+
+    for(const int sampleSize : {1, 2, 4, 8}) {
+        for(const int channels : {1, 2, 6, 10}) {
+            std::vector<std::vector<std::byte>> planes(static_cast<size_t>(channels));
+            std::vector<const std::byte*> planePtrs;
+            for(int channel{0}; channel < channels; ++channel) {
+                auto& plane = planes.at(channel);
+                plane.resize(static_cast<size_t>((Frames + Offset) * sampleSize));
+                for(size_t i{0}; i < plane.size(); ++i) {
+                    plane.at(i) = static_cast<std::byte>((channel * 31) + i);
+                }
+                planePtrs.push_back(plane.data());
+            }
+
+            std::vector<std::byte> output(static_cast<size_t>(Frames * channels * sampleSize));
+            Audio::interleave(planePtrs.data(), channels, sampleSize, Offset, Frames, output.data());
+
+            for(int frame{0}; frame < Frames; ++frame) {
+                for(int channel{0}; channel < channels; ++channel) {
+                    const auto* expected = planes.at(channel).data() + ((frame + Offset) * sampleSize);
+                    const auto* actual   = output.data() + (((frame * channels) + channel) * sampleSize);
+                    ASSERT_EQ(0, std::memcmp(expected, actual, static_cast<size_t>(sampleSize)))
+                        << "size " << sampleSize << ", channels " << channels << ", frame " << frame;
+                }
+            }
+        }
+    }
+}
+} // namespace Fooyin::Testing